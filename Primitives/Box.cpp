@@ -60,8 +60,8 @@ std::vector<uint8_t> Box::rawData() const
 	//std::vector<uint8_t> boxData(sizeof(float) + sizeof(glm::vec3)); // some strange sizeof() values for memory alignment on GPU side
 	//memcpy(boxData.data() + sizeof(float), &_size, sizeof(glm::vec3));
 	//rawData.insert(rawData.end(), boxData.begin(), boxData.end());
-	std::vector<uint8_t> boxData(2 * sizeof(float) + sizeof(glm::vec3)); // some strange sizeof() values for memory alignment on GPU side
-	memcpy(boxData.data() + sizeof(float), &_size, sizeof(glm::vec3));
+	std::vector<uint8_t> boxData(sizeof(glm::vec3) + sizeof(float)); // some strange sizeof() values for memory alignment on GPU side
+	memcpy(boxData.data(), &_size, sizeof(glm::vec3));
 	rawData.insert(rawData.end(), boxData.begin(), boxData.end());
 
 	return rawData;
@@ -0,0 +1,52 @@
+#include "renderer/opengl/Primitives/CSGArena.hpp"
+
+#include <cstdint>
+
+CSGArena::CSGArena(const size_t chunkSize) :
+	_chunkSize{chunkSize}
+{
+}
+
+void* CSGArena::allocate(const size_t size, const size_t alignment)
+{
+	auto alignUp = [alignment](std::byte* pointer)
+	{
+		const uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		return reinterpret_cast<std::byte*>((address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+	};
+
+	std::byte* start = _current != nullptr ? alignUp(_current) : nullptr;
+	if (start == nullptr || start + size > _end)
+	{
+		// Objects bigger than a chunk get a chunk of their own
+		const size_t chunkSize = std::max(_chunkSize, size + alignment);
+		_chunks.push_back(std::make_unique<std::byte[]>(chunkSize));
+		_current = _chunks.back().get();
+		_end = _current + chunkSize;
+		start = alignUp(_current);
+	}
+
+	_current = start + size;
+	_allocatedBytes += size;
+	return start;
+}
+
+CSGNode::NodePtr CSGArena::makeUnion(const CSGNode::NodePtr& first, const CSGNode::NodePtr& second)
+{
+	return std::allocate_shared<CSGNode>(Allocator<CSGNode>{*this}, CSGNode::NodeType::Union, first, second);
+}
+
+CSGNode::NodePtr CSGArena::makeIntersection(const CSGNode::NodePtr& first, const CSGNode::NodePtr& second)
+{
+	return std::allocate_shared<CSGNode>(Allocator<CSGNode>{*this}, CSGNode::NodeType::Intersection, first, second);
+}
+
+CSGNode::NodePtr CSGArena::makeDifference(const CSGNode::NodePtr& first, const CSGNode::NodePtr& second)
+{
+	return std::allocate_shared<CSGNode>(Allocator<CSGNode>{*this}, CSGNode::NodeType::Difference, first, second);
+}
+
+CSGNode::NodePtr CSGArena::makeComplement(const CSGNode::NodePtr& child)
+{
+	return std::allocate_shared<CSGNode>(Allocator<CSGNode>{*this}, CSGNode::NodeType::Complement, child, nullptr);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+/*
+* Bump allocator for building large CSG trees.
+* Nodes and primitives are created with std::allocate_shared, so each one (object and shared_ptr control block together) is a single
+* bump in a contiguous chunk instead of two heap allocations. Releasing a node only runs its destructor: the chunks are freed all at once
+* with the arena.
+* The arena must outlive every node it created, and it is not thread safe: build a tree from a single thread.
+*/
+class CSGArena
+{
+public:
+	static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+	explicit CSGArena(size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+	CSGArena(const CSGArena&) = delete;
+	CSGArena& operator=(const CSGArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+
+	[[nodiscard]] size_t getNbChunk() const { return _chunks.size(); }
+	[[nodiscard]] size_t getAllocatedBytes() const { return _allocatedBytes; }
+
+	/*
+	* Standard allocator handing out memory of an arena, deallocate() does nothing
+	*/
+	template<typename T>
+	class Allocator
+	{
+	public:
+		using value_type = T;
+
+		explicit Allocator(CSGArena& arena) : _arena{&arena} {}
+		template<typename U>
+		Allocator(const Allocator<U>& other) : _arena{other._arena} {}
+
+		T* allocate(const size_t n) { return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T*, size_t) {}
+
+		template<typename U>
+		bool operator==(const Allocator<U>& other) const { return _arena == other._arena; }
+		template<typename U>
+		bool operator!=(const Allocator<U>& other) const { return _arena != other._arena; }
+
+	private:
+		template<typename U>
+		friend class Allocator;
+
+		CSGArena* _arena;
+	};
+
+	// Arena counterparts of the CSGNode factories
+	template<typename PrimitiveType, typename... Args>
+	CSGNode::NodePtr makePrimitive(Args&&... args)
+	{
+		auto primitive = std::allocate_shared<PrimitiveType>(Allocator<PrimitiveType>{*this}, std::forward<Args>(args)...);
+		return std::allocate_shared<CSGNode>(Allocator<CSGNode>{*this}, std::static_pointer_cast<Primitive>(primitive));
+	}
+
+	CSGNode::NodePtr makeUnion(const CSGNode::NodePtr& first, const CSGNode::NodePtr& second);
+	CSGNode::NodePtr makeIntersection(const CSGNode::NodePtr& first, const CSGNode::NodePtr& second);
+	CSGNode::NodePtr makeDifference(const CSGNode::NodePtr& first, const CSGNode::NodePtr& second);
+	CSGNode::NodePtr makeComplement(const CSGNode::NodePtr& child);
+
+private:
+	size_t _chunkSize;
+	std::vector<std::unique_ptr<std::byte[]>> _chunks;
+	std::byte* _current = nullptr; // Next free byte of the last chunk
+	std::byte* _end = nullptr;
+	size_t _allocatedBytes = 0;
+};
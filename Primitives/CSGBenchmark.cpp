@@ -0,0 +1,938 @@
+#include "renderer/opengl/Primitives/CSGBenchmark.hpp"
+
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+#include "renderer/opengl/Primitives/SphereMarcher.hpp"
+#include "renderer/opengl/Primitives/Sphere.hpp"
+#include "renderer/opengl/Primitives/Box.hpp"
+#include "renderer/opengl/Primitives/Cylinder.hpp"
+#include "renderer/opengl/Primitives/Torus.hpp"
+#include "renderer/opengl/Primitives/CSGBinaryScene.hpp"
+#include "renderer/opengl/Primitives/CSGStreamingLoader.hpp"
+#include "renderer/opengl/Primitives/CSGArena.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveStore.hpp"
+#include "renderer/opengl/Primitives/CSGCompactScene.hpp"
+#include "renderer/opengl/Primitives/CSGExpression.hpp"
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGNaryNodes.hpp"
+#include "renderer/opengl/Primitives/CSGShortCircuit.hpp"
+#include "renderer/opengl/Primitives/CSGPointQuery.hpp"
+#include "renderer/opengl/Primitives/CSGMesher.hpp"
+#include "renderer/opengl/Primitives/CSGRayQuery.hpp"
+#include "renderer/opengl/Primitives/CSGRayTracer.hpp"
+#include "renderer/opengl/Primitives/CSGSceneGenerator.hpp"
+#include "renderer/opengl/Primitives/CSGTreeTest.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <functional>
+#include <random>
+#include <tuple>
+
+CSGTree CSGBenchmark::buildGridScene(const int nbPrimitive) const
+{
+	const int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nbPrimitive))));
+
+	CSGNode::NodePtr root;
+	for (int i = 0; i < nbPrimitive; i++)
+	{
+		const glm::vec3 position{2.5f * static_cast<float>(i % gridSize - gridSize / 2), 0.f, -2.5f * static_cast<float>(i / gridSize)};
+		const glm::vec3 color{(i % 3) / 2.f, (i % 5) / 4.f, (i % 7) / 6.f};
+
+		CSGNode::NodePtr node;
+		switch (i % 4)
+		{
+		case 0:
+			node = CSGNode::makePrimitive(std::make_shared<Sphere>(position, color, 1.f));
+			break;
+		case 1:
+			node = CSGNode::makePrimitive(std::make_shared<Torus>(position, color, 0.8f, 0.25f));
+			break;
+		case 2:
+			node = CSGNode::makePrimitive(std::make_shared<Cylinder>(position, color, 0.9f, 0.6f));
+			break;
+		default:
+			// Box drilled by a thinner cylinder
+			node = CSGNode::makeDifference(CSGNode::makePrimitive(std::make_shared<Box>(position, color, glm::vec3(0.8f))),
+				CSGNode::makePrimitive(std::make_shared<Cylinder>(position, 1.f, 0.4f)));
+			break;
+		}
+		root = root ? CSGNode::makeUnion(root, node) : node;
+	}
+	return CSGTree{ root };
+}
+
+CameraParameters CSGBenchmark::buildGridCamera(const int nbPrimitive) const
+{
+	const float gridSize = std::ceil(std::sqrt(static_cast<float>(nbPrimitive)));
+
+	CameraParameters camera;
+	camera.viewMat = glm::lookAt(glm::vec3(0.f, 1.5f * gridSize, 2.5f * gridSize), glm::vec3(0.f, 0.f, -1.25f * gridSize), glm::vec3(0.f, 1.f, 0.f));
+	return camera;
+}
+
+void CSGBenchmark::performAllBenchmarks() const
+{
+	std::cout << "\nStarted executing CSG benchmarks\n___________________________________________________________________________\n" << std::endl;
+	benchmarkHitShading();
+	benchmarkStreamingLoad();
+	benchmarkTreeAllocation();
+	benchmarkPrimitiveStore();
+	benchmarkCompactScene();
+	benchmarkExpression();
+	benchmarkCompiledEvaluator();
+	benchmarkNaryNodes();
+	benchmarkShortCircuit();
+	benchmarkPointQuery();
+	benchmarkMesher();
+	benchmarkRayQuery();
+	benchmarkRayTracer();
+	benchmarkStepMethods();
+	std::cout << "\nFinished CSG benchmarks\n___________________________________________________________________________\n" << std::endl;
+}
+
+CSGSceneData CSGBenchmark::buildLargeFlatScene(const int nbPrimitive) const
+{
+	const int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nbPrimitive))));
+
+	std::vector<CSGNode::ShaderNodeData> nodes;
+	std::vector<SphereData> spheres;
+	std::vector<BoxData> boxes;
+	nodes.reserve(2 * static_cast<size_t>(nbPrimitive));
+
+	// Postorder serialization of a balanced union over the primitives [first, last[
+	std::function<int(int, int)> buildRange = [&](const int first, const int last) -> int
+	{
+		if (last - first == 1)
+		{
+			const glm::vec3 position{2.5f * static_cast<float>(first % gridSize), 0.f, 2.5f * static_cast<float>(first / gridSize)};
+			const glm::mat4 inverseTransform = glm::translate(glm::mat4(1.f), -position);
+			const glm::vec3 color{(first % 3) / 2.f, (first % 5) / 4.f, (first % 7) / 6.f};
+			if (first % 2 == 0)
+			{
+				SphereData sphere{};
+				setInverseTransform(sphere, inverseTransform);
+				sphere.color = color;
+				sphere.radius = 1.f;
+				spheres.push_back(sphere);
+				nodes.push_back(CSGNode::ShaderNodeData{SHADER_TYPE_SPHERE, -1, -1, static_cast<int>(spheres.size()) - 1});
+			}
+			else
+			{
+				BoxData box{};
+				setInverseTransform(box, inverseTransform);
+				box.color = color;
+				box.size = glm::vec3(0.8f);
+				boxes.push_back(box);
+				nodes.push_back(CSGNode::ShaderNodeData{SHADER_TYPE_BOX, -1, -1, static_cast<int>(boxes.size()) - 1});
+			}
+			return static_cast<int>(nodes.size()) - 1;
+		}
+
+		const int middle = first + (last - first) / 2;
+		const int left = buildRange(first, middle);
+		const int right = buildRange(middle, last);
+		nodes.push_back(CSGNode::ShaderNodeData{SHADER_TYPE_UNION, left, right, -1});
+		return static_cast<int>(nodes.size()) - 1;
+	};
+	if (nbPrimitive > 0)
+		buildRange(0, nbPrimitive);
+
+	return CSGSceneData{std::move(nodes), std::move(spheres), {}, {}, std::move(boxes)};
+}
+
+void CSGBenchmark::benchmarkTreeAllocation(const int nbNode) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int nbPrimitive = (nbNode + 1) / 2;
+
+	// Balanced union of spheres and boxes, created through 'makeSphere', 'makeBox' and 'makeUnion'
+	auto buildTree = [nbPrimitive](auto makeSphere, auto makeBox, auto makeUnion)
+	{
+		std::function<CSGNode::NodePtr(int, int)> buildRange = [&](const int first, const int last) -> CSGNode::NodePtr
+		{
+			if (last - first == 1)
+			{
+				const glm::vec3 position{2.5f * static_cast<float>(first % 1024), 0.f, 2.5f * static_cast<float>(first / 1024)};
+				return first % 2 == 0 ? makeSphere(position) : makeBox(position);
+			}
+			const int middle = first + (last - first) / 2;
+			return makeUnion(buildRange(first, middle), buildRange(middle, last));
+		};
+		return CSGTree{ buildRange(0, nbPrimitive) };
+	};
+
+	std::cout << "Tree allocation, " << 2 * nbPrimitive - 1 << " nodes:" << std::endl;
+	{
+		Clock::time_point start = Clock::now();
+		auto tree = std::make_unique<CSGTree>(buildTree(
+			[](const glm::vec3& position) { return CSGNode::makePrimitive(std::make_shared<Sphere>(position, 1.f)); },
+			[](const glm::vec3& position) { return CSGNode::makePrimitive(std::make_shared<Box>(position, glm::vec3(1.f), glm::vec3(0.8f))); },
+			[](const CSGNode::NodePtr& a, const CSGNode::NodePtr& b) { return CSGNode::makeUnion(a, b); }));
+		const double build = milliseconds(start);
+
+		start = Clock::now();
+		tree.reset();
+		const double destroy = milliseconds(start);
+		std::cout << "  shared_ptr heap   build " << std::fixed << std::setprecision(1) << std::setw(8) << build << " ms, destroy " << std::setw(8) << destroy << " ms" << std::endl;
+	}
+	{
+		Clock::time_point start = Clock::now();
+		auto arena = std::make_unique<CSGArena>();
+		auto tree = std::make_unique<CSGTree>(buildTree(
+			[&arena](const glm::vec3& position) { return arena->makePrimitive<Sphere>(position, 1.f); },
+			[&arena](const glm::vec3& position) { return arena->makePrimitive<Box>(position, glm::vec3(1.f), glm::vec3(0.8f)); },
+			[&arena](const CSGNode::NodePtr& a, const CSGNode::NodePtr& b) { return arena->makeUnion(a, b); }));
+		const double build = milliseconds(start);
+		const size_t nbChunk = arena->getNbChunk();
+
+		start = Clock::now();
+		tree.reset();
+		arena.reset();
+		const double destroy = milliseconds(start);
+		std::cout << "  arena             build " << std::fixed << std::setprecision(1) << std::setw(8) << build << " ms, destroy " << std::setw(8) << destroy
+			<< " ms, " << nbChunk << " chunks of " << CSGArena::DEFAULT_CHUNK_SIZE / 1024 << " kB" << std::endl;
+	}
+}
+
+void CSGBenchmark::benchmarkPrimitiveStore(const int nbPrimitive) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int nbRepeat = 20;
+
+	const CSGTree tree = buildGridScene(nbPrimitive);
+	const CSGPrimitiveStore store{tree};
+	std::cout << "Primitive store, " << tree.nbNode() << " nodes:" << std::endl;
+
+	// Serialization: virtual rawData() of each primitive reached through the tree, against one loop per type over the arrays
+	Clock::time_point start = Clock::now();
+	uint64_t hash = 0;
+	for (int i = 0; i < nbRepeat; i++)
+		hash ^= CSGSceneData{tree}.contentHash();
+	const double treeSerialization = milliseconds(start) / nbRepeat;
+
+	start = Clock::now();
+	for (int i = 0; i < nbRepeat; i++)
+		hash ^= store.sceneData().contentHash();
+	const double storeSerialization = milliseconds(start) / nbRepeat;
+
+	std::cout << "  serialization     tree " << std::fixed << std::setprecision(2) << std::setw(8) << treeSerialization << " ms, store "
+		<< std::setw(8) << storeSerialization << " ms" << (hash == 0 ? " (same buffers)" : " (different buffers)") << std::endl;
+
+	// Evaluation along a line crossing the grid: node interpreter against per type loops followed by the operation pass
+	const CSGSceneData scene{tree};
+	const CSGEvaluator evaluator{scene.view()};
+	const CSGStoreEvaluator storeEvaluator{store};
+	const int nbPoint = 2000;
+	auto point = [nbPrimitive, nbPoint](const int i) { return glm::vec3(0.01f * static_cast<float>(i) - 10.f, 0.5f, -0.001f * static_cast<float>(i * nbPrimitive) / nbPoint); };
+
+	float checksum = 0.f;
+	start = Clock::now();
+	for (int i = 0; i < nbPoint; i++)
+		checksum += evaluator.scanSDF(point(i)).dist;
+	const double interpreter = milliseconds(start);
+	const float interpreterChecksum = checksum;
+
+	checksum = 0.f;
+	start = Clock::now();
+	for (int i = 0; i < nbPoint; i++)
+		checksum += storeEvaluator.scanSDF(point(i)).dist;
+	const double perType = milliseconds(start);
+
+	std::cout << "  evaluation   interpreter " << std::setw(8) << 1e3 * interpreter / nbPoint << " us/point, store "
+		<< std::setw(8) << 1e3 * perType / nbPoint << " us/point" << (checksum == interpreterChecksum ? " (same distances)" : " (different distances)") << std::endl;
+}
+
+void CSGBenchmark::benchmarkCompactScene() const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int nbPoint = 4000;
+
+	CSGSceneGenerator generator{7};
+	const std::vector<std::pair<CSGTree, std::string>> scenes = {
+		{buildGridScene(256), "grid 256"},
+		{buildGridScene(4096), "grid 4096"},
+		{generator.randomTree(256, 12), "random 256 (rotated, scaled)"}};
+
+	std::cout << "Compact scene:" << std::endl;
+	for (const auto& [tree, name] : scenes)
+	{
+		const CSGSceneData scene{tree};
+		const CSGCompactScene compactScene{scene.view()};
+		const size_t fullSize = sizeof(SphereData) * scene.getSpheres().size() + sizeof(TorusData) * scene.getToruses().size()
+			+ sizeof(CylinderData) * scene.getCylinders().size() + sizeof(BoxData) * scene.getBoxes().size();
+
+		// Points around the primitives, in the translation bounds of the compact scene
+		std::mt19937 random{3};
+		std::uniform_real_distribution<float> unit{0.f, 1.f};
+		const glm::vec3 origin = compactScene.getOrigin() - glm::vec3(2.f);
+		const glm::vec3 extent = compactScene.getExtent() + glm::vec3(4.f);
+		std::vector<glm::vec3> points(nbPoint);
+		for (glm::vec3& point : points)
+			point = origin + extent * glm::vec3(unit(random), unit(random), unit(random));
+
+		const CSGEvaluator evaluator{scene.view()};
+		const CSGCompactEvaluator compactEvaluator{compactScene};
+		std::vector<float> distances(nbPoint);
+
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < nbPoint; i++)
+			distances[i] = evaluator.scanSDF(points[i]).dist;
+		const double full = milliseconds(start);
+
+		double errorSum = 0.;
+		float maxError = 0.f;
+		start = Clock::now();
+		for (int i = 0; i < nbPoint; i++)
+		{
+			const float error = std::abs(compactEvaluator.scanSDF(points[i]).dist - distances[i]);
+			errorSum += error;
+			maxError = std::max(maxError, error);
+		}
+		const double compact = milliseconds(start);
+
+		std::cout << "  " << std::left << std::setw(30) << name << std::right << " records " << std::setw(8) << fullSize << " -> "
+			<< std::setw(8) << compactScene.primitiveByteSize() << " bytes, full " << std::fixed << std::setprecision(3) << std::setw(7)
+			<< 1e3 * full / nbPoint << " us/point, compact " << std::setw(7) << 1e3 * compact / nbPoint << " us/point, |error| mean "
+			<< std::scientific << std::setprecision(1) << errorSum / nbPoint << " max " << maxError << std::defaultfloat << std::endl;
+	}
+}
+
+void CSGBenchmark::benchmarkExpression() const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	namespace expr = CSGExpression;
+	using Fastener = expr::Union<expr::Difference<expr::Intersection<expr::Box, expr::Cylinder>, expr::Cylinder>, expr::Difference<expr::Cylinder, expr::Torus>>;
+
+	// Hexagonal-ish nut (box cut by a cylinder, drilled) and a bolt shank with a groove
+	const glm::vec3 grey{0.6f};
+	auto nut = CSGNode::makeDifference(
+		CSGNode::makeIntersection(CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(0.f), grey, glm::vec3(1.f, 0.4f, 1.f))),
+			CSGNode::makePrimitive(std::make_shared<Cylinder>(glm::vec3(0.f), grey, 0.4f, 1.2f))),
+		CSGNode::makePrimitive(std::make_shared<Cylinder>(glm::vec3(0.f), 1.f, 0.55f)));
+	auto bolt = CSGNode::makeDifference(CSGNode::makePrimitive(std::make_shared<Cylinder>(glm::vec3(0.f, -1.f, 0.f), grey, 2.f, 0.5f)),
+		CSGNode::makePrimitive(std::make_shared<Torus>(glm::vec3(0.f, -2.f, 0.f), grey, 0.5f, 0.1f)));
+	const CSGSceneData scene{CSGTree{ CSGNode::makeUnion(nut, bolt) }};
+
+	Fastener fastener;
+	std::string error;
+	if (!expr::bindScene(scene.view(), fastener, error))
+	{
+		std::cout << "Expression: " << error << std::endl;
+		return;
+	}
+
+	const CSGEvaluator evaluator{scene.view()};
+	const int nbPoint = 1 << 21;
+	auto point = [](const int i) { return glm::vec3(static_cast<float>(i % 128) / 32.f - 2.f, static_cast<float>((i / 128) % 128) / 32.f - 3.f, static_cast<float>(i / 16384) / 32.f - 2.f); };
+
+	float interpreterSum = 0.f;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < nbPoint; i++)
+		interpreterSum += evaluator.scanSDF(point(i)).dist;
+	const double interpreter = milliseconds(start);
+
+	float expressionSum = 0.f;
+	start = Clock::now();
+	for (int i = 0; i < nbPoint; i++)
+		expressionSum += fastener.evaluate(point(i)).dist;
+	const double expression = milliseconds(start);
+
+	float distanceSum = 0.f;
+	start = Clock::now();
+	for (int i = 0; i < nbPoint; i++)
+		distanceSum += fastener.distance(point(i));
+	const double distanceOnly = milliseconds(start);
+
+	std::cout << "Expression " << Fastener::name() << ", " << Fastener::NB_NODE << " nodes:" << std::endl;
+	std::cout << "  interpreter " << std::fixed << std::setprecision(1) << std::setw(8) << 1e6 * interpreter / nbPoint << " ns/point" << std::endl;
+	std::cout << "  expression  " << std::setw(8) << 1e6 * expression / nbPoint << " ns/point with color, " << std::setw(8)
+		<< 1e6 * distanceOnly / nbPoint << " ns/point distance only"
+		<< (interpreterSum == expressionSum && expressionSum == distanceSum ? " (same distances)" : " (different distances)") << std::endl;
+}
+
+void CSGBenchmark::benchmarkCompiledEvaluator(const int nbPrimitive) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+	auto compare = [&milliseconds](const std::string& name, const CSGSceneData& scene, const int nbPoint, const float extent)
+	{
+		std::vector<glm::vec3> positions(nbPoint);
+		for (int i = 0; i < nbPoint; i++)
+			positions[i] = glm::vec3(extent * (static_cast<float>(i % 97) / 48.f - 1.f), static_cast<float>((i / 97) % 13) / 6.f - 1.f, -extent * static_cast<float>(i) / nbPoint);
+
+		// Compilation, then the lookup of another scene with the same topology
+		CSGProgramCache cache;
+		Clock::time_point start = Clock::now();
+		const auto program = cache.getProgram(scene.view());
+		const double compilation = milliseconds(start);
+		start = Clock::now();
+		cache.getProgram(scene.view());
+		const double lookup = milliseconds(start);
+
+		const CSGEvaluator evaluator{scene.view()};
+		float interpreterSum = 0.f;
+		start = Clock::now();
+		for (const glm::vec3& pos : positions)
+			interpreterSum += evaluator.scanSDF(pos).dist;
+		const double interpreter = milliseconds(start);
+
+		const CSGCompiledEvaluator compiledEvaluator{scene.view(), program};
+		std::vector<float> distances(nbPoint);
+		start = Clock::now();
+		compiledEvaluator.distances(positions.data(), nbPoint, distances.data());
+		const double compiled = milliseconds(start);
+
+		// The transform is rounded differently, compare the sums with a tolerance
+		float compiledSum = 0.f;
+		for (const float dist : distances)
+			compiledSum += dist;
+		const bool same = std::abs(compiledSum - interpreterSum) <= 1e-4f * std::abs(interpreterSum) + 1e-2f;
+
+		std::cout << "  " << std::left << std::setw(22) << name << std::right << " " << std::setw(6) << scene.view().nbNode << " nodes, "
+			<< program->getNbRegister() << " registers: interpreter " << std::fixed << std::setprecision(1) << std::setw(8) << 1e6 * interpreter / nbPoint
+			<< " ns/point, compiled " << std::setw(8) << 1e6 * compiled / nbPoint << " ns/point (x" << std::setprecision(2) << interpreter / compiled
+			<< ", compilation " << std::setprecision(3) << compilation << " ms, cached " << lookup << " ms)" << (same ? " (same distances)" : " (different distances)") << std::endl;
+	};
+
+	std::cout << "Compiled evaluator, " << CSGCompiledProgram::BATCH_SIZE << " points per batch:" << std::endl;
+	compare("buildComplexTree", CSGSceneData{CSGTreeTest{}.buildComplexTree()}, 1 << 20, 2.f);
+	compare(std::to_string(nbPrimitive) + " primitive grid", CSGSceneData{buildGridScene(nbPrimitive)}, 1 << 13, 40.f);
+}
+
+void CSGBenchmark::benchmarkNaryNodes(const int nbPrimitive) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int nbPoint = 1 << 13;
+
+	// Interpreter and compiled program on points over the scene, and the leaves intersected by vertical rays
+	auto measure = [&milliseconds](const CSGSceneView& scene, const std::vector<glm::vec3>& points, const std::vector<Ray>& rays,
+		float& distanceSum, double& interpreter, double& compiled, double& leafPerRay)
+	{
+		const CSGEvaluator evaluator{scene};
+		distanceSum = 0.f;
+		Clock::time_point start = Clock::now();
+		for (const glm::vec3& pos : points)
+			distanceSum += evaluator.scanSDF(pos).dist;
+		interpreter = 1e6 * milliseconds(start) / static_cast<double>(points.size());
+
+		const CSGCompiledEvaluator compiledEvaluator{scene, std::make_shared<const CSGCompiledProgram>(scene)};
+		std::vector<float> distances(points.size());
+		start = Clock::now();
+		compiledEvaluator.distances(points.data(), static_cast<int>(points.size()), distances.data());
+		compiled = 1e6 * milliseconds(start) / static_cast<double>(points.size());
+
+		const CSGRayQuery query{scene};
+		for (const Ray& ray : rays)
+			query.intervals(ray);
+		leafPerRay = static_cast<double>(query.getNbLeafIntersection()) / static_cast<double>(query.getNbRay());
+	};
+
+	auto compare = [&](const std::string& name, const CSGSceneData& scene)
+	{
+		const AABB bounds = CSGBounds::nodeBounds(scene.view()).back();
+		std::vector<glm::vec3> points(nbPoint);
+		std::vector<Ray> rays;
+		for (int i = 0; i < nbPoint; i++)
+		{
+			const glm::vec3 t{static_cast<float>(i % 97) / 96.f, static_cast<float>((i / 97) % 13) / 12.f, static_cast<float>(i) / nbPoint};
+			points[i] = bounds.min + t * (bounds.max - bounds.min);
+			if (i % 8 == 0)
+				rays.push_back(Ray{glm::vec3(points[i].x, bounds.max.y + 1.f, points[i].z), glm::vec3(0.f, -1.f, 0.f)});
+		}
+
+		Clock::time_point start = Clock::now();
+		const std::vector<CSGNode::ShaderNodeData> nodes = CSGNaryNodes::collapseChains(scene.view());
+		const double collapse = milliseconds(start);
+		CSGSceneView collapsedView = scene.view();
+		collapsedView.nodes = nodes.data();
+		collapsedView.nbNode = static_cast<int>(nodes.size());
+
+		float binarySum, narySum;
+		double binaryInterpreter, naryInterpreter, binaryCompiled, naryCompiled, binaryLeaves, naryLeaves;
+		measure(scene.view(), points, rays, binarySum, binaryInterpreter, binaryCompiled, binaryLeaves);
+		measure(collapsedView, points, rays, narySum, naryInterpreter, naryCompiled, naryLeaves);
+
+		std::cout << "  " << std::left << std::setw(28) << name << std::right << " " << std::setw(7) << scene.view().nbNode << " -> " << std::setw(7)
+			<< collapsedView.nbNode << " nodes (" << std::fixed << std::setprecision(3) << collapse << " ms): interpreter " << std::setprecision(1)
+			<< std::setw(8) << binaryInterpreter << " -> " << std::setw(8) << naryInterpreter << " ns/point, compiled " << std::setw(8) << binaryCompiled
+			<< " -> " << std::setw(8) << naryCompiled << " ns/point, ray " << std::setw(6) << binaryLeaves << " -> " << std::setw(6) << naryLeaves
+			<< " leaves" << (binarySum == narySum ? " (same distances)" : " (different distances)") << std::endl;
+	};
+
+	std::cout << "N-ary nodes, binary -> collapsed:" << std::endl;
+	compare(std::to_string(nbPrimitive) + " primitive grid", CSGSceneData{buildGridScene(nbPrimitive)});
+	compare(std::to_string(nbPrimitive) + " primitive balanced union", buildLargeFlatScene(nbPrimitive));
+}
+
+void CSGBenchmark::benchmarkShortCircuit(const int nbPrimitive) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int nbPoint = 1 << 14;
+
+	// Points spread over the bounds of the scene, twice as large as them
+	auto compare = [&](const std::string& name, const CSGSceneData& scene)
+	{
+		const AABB bounds = CSGBounds::nodeBounds(scene.view()).back();
+		const glm::vec3 center = 0.5f * (bounds.min + bounds.max);
+		std::vector<glm::vec3> points(nbPoint);
+		for (int i = 0; i < nbPoint; i++)
+		{
+			const glm::vec3 t{static_cast<float>(i % 97) / 96.f, static_cast<float>((i / 97) % 13) / 12.f, static_cast<float>(i) / nbPoint};
+			points[i] = center + (2.f * t - 1.f) * (bounds.max - bounds.min);
+		}
+
+		const CSGEvaluator evaluator{scene.view()};
+		const CSGShortCircuit plan{scene.view()};
+		float fullSum = 0.f;
+		Clock::time_point start = Clock::now();
+		for (const glm::vec3& pos : points)
+			fullSum += evaluator.scanSDF(pos).dist;
+		const double full = 1e6 * milliseconds(start) / nbPoint;
+
+		evaluator.scanSDFShortCircuit(points[0]); // Builds the plan
+		const long long nbSkippedBefore = evaluator.getNbSkippedNode();
+		float shortCircuitSum = 0.f;
+		start = Clock::now();
+		for (const glm::vec3& pos : points)
+			shortCircuitSum += evaluator.scanSDFShortCircuit(pos).dist;
+		const double shortCircuit = 1e6 * milliseconds(start) / nbPoint;
+		const double skipped = 100. * static_cast<double>(evaluator.getNbSkippedNode() - nbSkippedBefore) / (static_cast<double>(scene.view().nbNode) * nbPoint);
+
+		std::cout << "  " << std::left << std::setw(28) << name << std::right << " " << std::setw(6) << scene.view().nbNode << " nodes, "
+			<< std::setw(4) << plan.getNbGuard() << " guards: " << std::fixed << std::setprecision(1) << std::setw(5) << skipped
+			<< " % of the nodes skipped, " << std::setw(8) << full << " -> " << std::setw(8) << shortCircuit << " ns/point"
+			<< (fullSum == shortCircuitSum ? " (same distances)" : " (different distances)") << std::endl;
+	};
+
+	CSGSceneGenerator generator;
+	std::cout << "Short-circuit evaluation, full -> short-circuit:" << std::endl;
+	compare("counterbored plate 8x8", CSGSceneData{generator.counterboredPlate(8, 8)});
+	compare("difference chain 64", CSGSceneData{generator.differenceChain(64)});
+	compare("instanced grid 8x8x4", CSGSceneData{generator.instancedGrid(8, 8, 4)});
+	compare(std::to_string(nbPrimitive) + " primitive grid", CSGSceneData{buildGridScene(nbPrimitive)});
+}
+
+void CSGBenchmark::benchmarkPointQuery(const int nbPoint) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int nbPrimitive = 64;
+
+	// Points in random order over the whole grid, as an occupancy map or a collision query would send them
+	const CSGSceneData scene{buildGridScene(nbPrimitive)};
+	std::mt19937 generator{42};
+	std::uniform_real_distribution<float> uniform{0.f, 1.f};
+	std::vector<glm::vec3> points(nbPoint);
+	for (glm::vec3& point : points)
+		point = glm::vec3(22.f * uniform(generator) - 12.f, 3.f * uniform(generator) - 1.5f, -22.f * uniform(generator) + 1.5f);
+
+	std::cout << "Point query, " << nbPoint << " points, " << scene.view().nbNode << " nodes:" << std::endl;
+
+	const CSGEvaluator evaluator{scene.view()};
+	std::vector<float> expected(nbPoint);
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < nbPoint; i++)
+		expected[i] = evaluator.scanSDF(points[i]).dist;
+	const double interpreter = milliseconds(start);
+	std::cout << "  interpreter loop                 " << std::fixed << std::setprecision(1) << std::setw(8) << interpreter << " ms" << std::endl;
+
+	CSGProgramCache cache;
+	std::vector<float> distances(nbPoint);
+	for (const int nbThread : {1, 0})
+	{
+		for (const bool spatialSorting : {false, true})
+		{
+			CSGPointQuery query{scene.view(), nbThread, &cache};
+			query.setSpatialSorting(spatialSorting);
+			start = Clock::now();
+			query.distances(points.data(), points.size(), distances.data());
+			const double batch = milliseconds(start);
+
+			bool same = true;
+			for (int i = 0; i < nbPoint; i++)
+				same = same && std::abs(distances[i] - expected[i]) <= 1e-5f * (1.f + std::abs(expected[i]));
+			std::cout << "  " << (nbThread == 1 ? "1 thread,  " : "all threads,") << (spatialSorting ? " sorted  " : " unsorted") << "          "
+				<< std::setw(8) << batch << " ms (x" << std::setprecision(2) << interpreter / batch << std::setprecision(1) << ")"
+				<< (same ? " (same distances)" : " (different distances)") << std::endl;
+		}
+	}
+}
+
+void CSGBenchmark::benchmarkMesher(const int nbPrimitive, const int resolution) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+	const CSGSceneData scene{buildGridScene(nbPrimitive)};
+	std::cout << "Mesher, " << scene.view().nbNode << " nodes at " << resolution << "^3:" << std::endl;
+
+	for (const bool sharpFeatures : {false, true})
+	{
+		CSGMesher mesher{scene.view()};
+		mesher.setResolution(resolution);
+		mesher.setSharpFeatures(sharpFeatures);
+
+		// Triangles are counted and dropped, as a streaming writer would do
+		size_t largestChunk = 0;
+		MeshStatistics statistics;
+		std::string error;
+		resetPeakResidentMemory();
+		const Clock::time_point start = Clock::now();
+		if (!mesher.extract([&largestChunk](const MeshChunk& chunk) { largestChunk = std::max(largestChunk, chunk.triangles.size() / 3); }, error, &statistics))
+		{
+			std::cout << "  " << error << std::endl;
+			return;
+		}
+		const double extraction = milliseconds(start);
+
+		std::cout << "  " << (sharpFeatures ? "sharp features " : "mass point     ") << std::fixed << std::setprecision(1) << std::setw(8) << extraction << " ms, "
+			<< statistics.nbTriangle << " triangles, " << statistics.nbSurfaceCell << " surface cells, " << statistics.nbEvaluation << " evaluations, "
+			<< statistics.nbCulledBrick << "/" << statistics.nbBrick << " branches culled, largest chunk " << largestChunk << " triangles, peak memory "
+			<< peakResidentMemory() / (1024 * 1024) << " MB" << std::endl;
+	}
+}
+
+long long CSGBenchmark::peakResidentMemory()
+{
+#ifdef __linux__
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.rfind("VmHWM:", 0) == 0)
+			return std::stoll(line.substr(6)) * 1024; // Given in kB
+	}
+#endif
+	return -1;
+}
+
+void CSGBenchmark::resetPeakResidentMemory()
+{
+#ifdef __linux__
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5"; // Reset the peak resident set size to the current one
+#endif
+}
+
+void CSGBenchmark::benchmarkStreamingLoad(const int nbPrimitive) const
+{
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](const Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	auto megabytes = [](const long long bytes) { return bytes < 0 ? std::string("n/a") : std::to_string(bytes / (1024 * 1024)) + " MB"; };
+
+	const std::string path = (std::filesystem::temp_directory_path() / "csgStreamingBenchmark.csgb").string();
+	std::string error;
+	{
+		const CSGSceneData scene = buildLargeFlatScene(nbPrimitive);
+		if (!CSGBinaryScene::save(path, scene.view(), error))
+		{
+			std::cout << "Streaming load: " << error << std::endl;
+			return;
+		}
+		std::cout << "Streaming load, " << scene.view().nbNode << " nodes, " << std::filesystem::file_size(path) / (1024 * 1024) << " MB file:" << std::endl;
+	}
+
+	const int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nbPrimitive))));
+	const float gridExtent = 2.5f * static_cast<float>(gridSize);
+	CameraParameters camera;
+	camera.viewMat = glm::lookAt(glm::vec3(0.5f * gridExtent, 0.8f * gridExtent, 1.6f * gridExtent), glm::vec3(0.5f * gridExtent, 0.f, 0.5f * gridExtent), glm::vec3(0.f, 1.f, 0.f));
+
+	// Streaming: first frame on the bounding boxes of the first chunk, while the rest loads in the background
+	resetPeakResidentMemory();
+	const long long baseMemory = peakResidentMemory();
+	{
+		const Clock::time_point start = Clock::now();
+		CSGStreamingLoader loader;
+		if (!loader.open(path, error) || !loader.loadChunk())
+		{
+			std::cout << "  streaming: " << (error.empty() ? loader.getError() : error) << std::endl;
+			return;
+		}
+		loader.startBackgroundLoad();
+
+		const CSGSceneData preview = loader.buildPreview(64);
+		const double previewReady = milliseconds(start);
+		RenderedImage image{160, 120};
+		SphereMarcher{preview.view()}.render(camera, image);
+		const double firstFrame = milliseconds(start);
+
+		const CSGSceneData scene = loader.takeScene();
+		const double complete = milliseconds(start);
+		std::cout << "  streaming loader      preview ready " << std::fixed << std::setprecision(1) << previewReady << " ms, first frame " << firstFrame
+			<< " ms (" << preview.view().nbBox << " boxes, 160x120), complete " << complete << " ms, peak RSS +" << megabytes(peakResidentMemory() - baseMemory)
+			<< ", " << (scene.view().nbNode > 0 ? "ok" : loader.getError()) << std::endl;
+	}
+
+	// Reference: rebuild the shared_ptr tree, then serialize it again, before anything can be rendered
+	resetPeakResidentMemory();
+	{
+		const Clock::time_point start = Clock::now();
+		CSGBinaryScene mappedScene;
+		if (!mappedScene.open(path, error))
+		{
+			std::cout << "  tree: " << error << std::endl;
+			return;
+		}
+		const CSGSceneData scene{mappedScene.tree()};
+		const double ready = milliseconds(start);
+		std::cout << "  shared_ptr tree       scene ready " << std::fixed << std::setprecision(1) << ready << " ms (before the first frame), peak RSS +"
+			<< megabytes(peakResidentMemory() - baseMemory) << std::endl;
+	}
+
+	std::filesystem::remove(path);
+}
+
+void CSGBenchmark::benchmarkHitShading() const
+{
+	constexpr int nbPrimitive = 16;
+	constexpr int width = 256;
+	constexpr int height = 256;
+	constexpr int nbRepetition = 5;
+
+	const CSGSceneData scene{buildGridScene(nbPrimitive)};
+	const CameraParameters camera = buildGridCamera(nbPrimitive);
+	const SphereMarcher marcher{scene.view(), 1};
+	const CSGEvaluator evaluator{scene.view()};
+
+	// Only the shading of the hit points is measured, not the marching that leads to them
+	std::vector<MarchResult> hits;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			const MarchResult march = marcher.marchRay(evaluator, camera.rayThroughPixel(x, y, width, height), width, height);
+			if (march.hit)
+				hits.push_back(march);
+		}
+	}
+
+	std::cout << "Hit shading, " << nbPrimitive << " primitives, " << hits.size() << " hit pixels:" << std::endl;
+	if (hits.empty())
+		return;
+
+	const std::pair<SphereMarcher::NormalMethod, const char*> methods[] = {
+		{SphereMarcher::NormalMethod::AnalyticGradient, "analytic gradient"},
+		{SphereMarcher::NormalMethod::ForwardDifference, "forward differences"},
+		{SphereMarcher::NormalMethod::Tetrahedral, "tetrahedral"},
+		{SphereMarcher::NormalMethod::BatchedTetrahedral, "batched tetrahedral"},
+	};
+
+	for (const auto& [method, name] : methods)
+	{
+		std::vector<glm::vec3> normals(hits.size());
+		const long long firstEvaluation = evaluator.getNbEvaluation();
+		const auto start = std::chrono::steady_clock::now();
+		for (int repetition = 0; repetition < nbRepetition; repetition++)
+		{
+			for (size_t i = 0; i < hits.size(); i++)
+				normals[i] = SphereMarcher::estimateGradient(evaluator, method, hits[i].position, hits[i].evaluation.dist, hits[i].epsilon);
+		}
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		const long long nbEvaluation = evaluator.getNbEvaluation() - firstEvaluation;
+
+		// Mean angle with the analytic normal
+		double angleSum = 0.;
+		for (size_t i = 0; i < hits.size(); i++)
+		{
+			const glm::vec3 reference = glm::normalize(evaluator.scanSDFGradient(hits[i].position).gradient);
+			angleSum += std::acos(glm::clamp(glm::dot(glm::normalize(normals[i]), reference), -1.f, 1.f));
+		}
+
+		const double nbShading = static_cast<double>(hits.size()) * nbRepetition;
+		std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(9) << elapsed.count() / nbShading << " ns/pixel, "
+			<< std::setprecision(2) << static_cast<double>(nbEvaluation) / nbShading << " points evaluated/pixel, "
+			<< std::setprecision(3) << glm::degrees(angleSum / static_cast<double>(hits.size())) << " deg mean error" << std::endl;
+	}
+}
+
+void CSGBenchmark::benchmarkRayQuery(const int nbPrimitive) const
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr int width = 256;
+	constexpr int height = 256;
+
+	const CSGSceneData scene{buildGridScene(nbPrimitive)};
+	const CameraParameters camera = buildGridCamera(nbPrimitive);
+	const SphereMarcher marcher{scene.view(), 1};
+	const CSGEvaluator evaluator{scene.view()};
+	const CSGRayQuery query{scene.view()};
+	std::vector<Ray> rays;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+			rays.push_back(camera.rayThroughPixel(x, y, width, height));
+	}
+
+	std::cout << "Ray query, " << scene.view().nbNode << " nodes, " << rays.size() << " rays:" << std::endl;
+
+	// Time per ray, then the distance to the surface at the hit points (measured outside of the timing)
+	std::vector<glm::vec3> marchPositions;
+	Clock::time_point start = Clock::now();
+	for (const Ray& ray : rays)
+	{
+		const MarchResult march = marcher.marchRay(evaluator, ray, width, height);
+		if (march.hit)
+			marchPositions.push_back(march.position);
+	}
+	const double marchTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / static_cast<double>(rays.size());
+
+	std::vector<glm::vec3> queryPositions;
+	start = Clock::now();
+	for (const Ray& ray : rays)
+	{
+		const RayHit hit = query.intersect(ray);
+		if (hit.hit)
+			queryPositions.push_back(hit.position);
+	}
+	const double queryTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / static_cast<double>(rays.size());
+
+	auto printPrecision = [&evaluator](const char* name, const double time, const std::vector<glm::vec3>& positions)
+	{
+		double sumError = 0.;
+		float maxError = 0.f;
+		for (const glm::vec3& position : positions)
+		{
+			const float error = std::abs(evaluator.scanSDF(position).dist);
+			sumError += error;
+			maxError = std::max(maxError, error);
+		}
+		std::cout << "  " << name << std::fixed << std::setprecision(2) << std::setw(8) << time << " us/ray, " << positions.size() << " hits, |distance| at hit mean "
+			<< std::scientific << std::setprecision(1) << (positions.empty() ? 0. : sumError / static_cast<double>(positions.size())) << " max " << maxError << std::defaultfloat << std::endl;
+	};
+	printPrecision("sphere marching       ", marchTime, marchPositions);
+	printPrecision("analytic ray query    ", queryTime, queryPositions);
+	std::cout << "  " << std::fixed << std::setprecision(1) << static_cast<double>(query.getNbLeafIntersection()) / static_cast<double>(query.getNbRay())
+		<< " leaf intersections per ray out of " << nbPrimitive << " primitives" << std::defaultfloat << std::endl;
+}
+
+void CSGBenchmark::benchmarkRayTracer(const int nbPrimitive) const
+{
+	constexpr int width = 256;
+	constexpr int height = 256;
+	const int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nbPrimitive))));
+
+	// Thin features: wire tori, rods and thin plates on the same grid, where marching crawls along the surfaces
+	CSGNode::NodePtr thinRoot;
+	for (int i = 0; i < nbPrimitive; i++)
+	{
+		const glm::vec3 position{2.5f * static_cast<float>(i % gridSize - gridSize / 2), 0.f, -2.5f * static_cast<float>(i / gridSize)};
+		const glm::vec3 color{(i % 3) / 2.f, (i % 5) / 4.f, (i % 7) / 6.f};
+		CSGNode::NodePtr node;
+		if (i % 3 == 0)
+			node = CSGNode::makePrimitive(std::make_shared<Torus>(position, color, 0.9f, 0.02f));
+		else if (i % 3 == 1)
+			node = CSGNode::makePrimitive(std::make_shared<Cylinder>(position, color, 1.f, 0.03f));
+		else
+			node = CSGNode::makePrimitive(std::make_shared<Box>(position, color, glm::vec3(1.f, 0.02f, 1.f)));
+		thinRoot = thinRoot ? CSGNode::makeUnion(thinRoot, node) : node;
+	}
+
+	const std::pair<CSGTree, const char*> scenes[] = {{buildGridScene(nbPrimitive), "grid"}, {CSGTree{ thinRoot }, "thin features"}};
+	const CameraParameters camera = buildGridCamera(nbPrimitive);
+	for (const auto& [tree, name] : scenes)
+	{
+		const CSGSceneData scene{tree};
+		std::cout << "Ray tracer, " << name << " scene, " << scene.view().nbNode << " nodes, " << width << "x" << height << ", 1 thread:" << std::endl;
+
+		RenderedImage marchedImage{width, height};
+		MarchStatistics marchStatistics;
+		auto start = std::chrono::steady_clock::now();
+		SphereMarcher{scene.view(), 1}.render(camera, marchedImage, &marchStatistics);
+		const std::chrono::duration<double, std::milli> marchTime = std::chrono::steady_clock::now() - start;
+
+		RenderedImage tracedImage{width, height};
+		TraceStatistics traceStatistics;
+		start = std::chrono::steady_clock::now();
+		CSGRayTracer{scene.view(), 1}.render(camera, tracedImage, &traceStatistics);
+		const std::chrono::duration<double, std::milli> traceTime = std::chrono::steady_clock::now() - start;
+
+		std::cout << "  sphere marching  " << std::fixed << std::setprecision(1) << std::setw(8) << marchTime.count() << " ms, "
+			<< std::setprecision(2) << marchStatistics.meanStepPerPixel() << " steps/pixel, " << marchStatistics.nbHit << " hits, "
+			<< marchStatistics.nbOutOfSteps << " out of steps" << std::endl;
+		std::cout << "  ray tracing      " << std::setprecision(1) << std::setw(8) << traceTime.count() << " ms, "
+			<< std::setprecision(2) << traceStatistics.meanLeafIntersectionPerPixel() << " leaf intersections/pixel, " << traceStatistics.nbHit << " hits (x"
+			<< marchTime.count() / traceTime.count() << ")" << std::defaultfloat << std::endl;
+	}
+}
+
+void CSGBenchmark::benchmarkStepMethods() const
+{
+	constexpr int width = 256;
+	constexpr int height = 256;
+	const CSGSceneGenerator generator;
+
+	// Ellipsoids and boxes stretched or squashed along y: the min column length correction underestimates the distance of the first
+	// ones and overestimates the distance of the others
+	std::vector<CSGNode::NodePtr> scaledPrimitives;
+	for (int i = 0; i < 64; i++)
+	{
+		const glm::vec3 position{2.5f * static_cast<float>(i % 8 - 4), 0.f, -2.5f * static_cast<float>(i / 8)};
+		const glm::vec3 scale = i % 2 == 0 ? glm::vec3(1.f, 3.f, 1.f) : glm::vec3(1.f, 0.3f, 1.f);
+		const glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.f), position), scale);
+		const glm::vec3 color{(i % 3) / 2.f, (i % 5) / 4.f, (i % 7) / 6.f};
+		scaledPrimitives.push_back(i % 4 < 2 ? CSGNode::makePrimitive(std::make_shared<Sphere>(transform, color, 0.8f))
+			: CSGNode::makePrimitive(std::make_shared<Box>(transform, color, glm::vec3(0.7f))));
+	}
+
+	CameraParameters closeCamera;
+	closeCamera.viewMat = glm::lookAt(glm::vec3(0.f, 6.f, 12.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+	const std::tuple<CSGTree, CameraParameters, const char*> scenes[] = {
+		{buildGridScene(256), buildGridCamera(256), "grid"},
+		{generator.instancedGrid(4, 1, 4), closeCamera, "instanced parts"},
+		{generator.differenceChain(64), closeCamera, "difference chain"},
+		{CSGTree{ CSGSceneGenerator::balancedUnion(scaledPrimitives) }, buildGridCamera(64), "scaled primitives"}};
+
+	for (const auto& [tree, camera, name] : scenes)
+	{
+		const CSGSceneData scene{tree};
+		SphereMarcher marcher{scene.view(), 1};
+		const DistanceBound bound = CSGDistanceBounds::rootBound(scene.view());
+		std::cout << "Step methods, " << name << " scene, " << scene.view().nbNode << " nodes, Lipschitz " << std::setprecision(3) << bound.lipschitz
+			<< (bound.exactOutside ? ", exact outside" : "") << (bound.exactInside ? ", exact inside" : "") << ", " << width << "x" << height << ", 1 thread:" << std::endl;
+
+		std::vector<MarchDiagnostics> diagnostics(2);
+		double referenceTime = 0.;
+		for (const SphereMarcher::StepMethod method : {SphereMarcher::StepMethod::Overstep, SphereMarcher::StepMethod::Relaxed})
+		{
+			MarchDiagnostics& methodDiagnostics = diagnostics[method == SphereMarcher::StepMethod::Overstep ? 0 : 1];
+			marcher.setStepMethod(method);
+			RenderedImage image{width, height};
+			MarchStatistics statistics;
+			const auto start = std::chrono::steady_clock::now();
+			marcher.render(camera, image, &statistics, &methodDiagnostics);
+			const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+			if (method == SphereMarcher::StepMethod::Overstep)
+				referenceTime = time.count();
+
+			long long nbEvaluation = 0;
+			for (const PixelDiagnostics& pixel : methodDiagnostics.pixels)
+				nbEvaluation += pixel.nbEvaluation;
+			std::cout << (method == SphereMarcher::StepMethod::Overstep ? "  overstep " : "  relaxed  ") << std::fixed << std::setprecision(1) << std::setw(8) << time.count() << " ms, "
+				<< std::setprecision(2) << std::setw(6) << statistics.meanStepPerPixel() << " steps/pixel, " << std::setw(6)
+				<< static_cast<double>(nbEvaluation) / static_cast<double>(statistics.nbPixel) << " evaluations/pixel, " << statistics.nbHit << " hits, "
+				<< statistics.nbOutOfSteps << " out of steps (x" << referenceTime / time.count() << ")" << std::defaultfloat << std::endl;
+		}
+
+		int nbTerminationChange = 0;
+		for (size_t i = 0; i < diagnostics[0].pixels.size(); i++)
+			nbTerminationChange += diagnostics[0].pixels[i].termination != diagnostics[1].pixels[i].termination ? 1 : 0;
+		std::cout << "  " << nbTerminationChange << " pixels end differently" << std::endl;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGTree.hpp"
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+/*
+* Timings of the CPU rendering path, printed on the standard output like the results of CSGTreeTest
+*/
+class CSGBenchmark
+{
+public:
+	void performAllBenchmarks() const;
+
+	// Union of 'nbPrimitive' primitives of every type laid out on a grid, some of them drilled by a cylinder
+	CSGTree buildGridScene(int nbPrimitive) const;
+	CameraParameters buildGridCamera(int nbPrimitive) const;
+
+	/*
+	* Balanced union of 'nbPrimitive' spheres and boxes on a square grid, serialized directly in flat buffers without building a CSGTree,
+	* to produce scenes of millions of nodes
+	*/
+	CSGSceneData buildLargeFlatScene(int nbPrimitive) const;
+
+	// Cost per hit pixel of each normal estimator of SphereMarcher, on the hit points of a rendered frame
+	void benchmarkHitShading() const;
+
+	// Build and destroy a balanced tree of about 'nbNode' nodes, with the usual shared_ptr factories and with a CSGArena
+	void benchmarkTreeAllocation(int nbNode = 1 << 20) const;
+
+	// Time to first frame and peak memory of the streaming loader, against the shared_ptr tree path, on a generated binary scene
+	void benchmarkStreamingLoad(int nbPrimitive = 1 << 19) const;
+
+	// Serialization and point evaluation of a scene stored in a CSGTree against the same scene in a CSGPrimitiveStore
+	void benchmarkPrimitiveStore(int nbPrimitive = 4096) const;
+
+	// Size and point evaluation of grid and random scenes with full primitive records against a CSGCompactScene, with the distance error of the quantization
+	void benchmarkCompactScene() const;
+
+	// Point evaluation of a small fixed part (nut and bolt) with the node interpreter and with the equivalent CSGExpression type
+	void benchmarkExpression() const;
+
+	// Point evaluation with the node interpreter against a CSGCompiledProgram over batches, on buildComplexTree() and a grid of 'nbPrimitive' primitives
+	void benchmarkCompiledEvaluator(int nbPrimitive = 1000) const;
+
+	// Node count, point evaluation and picking rays of union chains of 'nbPrimitive' primitives, binary and collapsed into n-ary nodes
+	void benchmarkNaryNodes(int nbPrimitive = 1000) const;
+
+	// Point evaluation with and without the short-circuit of intersections and differences, and the share of the node evaluations it skips
+	void benchmarkShortCircuit(int nbPrimitive = 1000) const;
+
+	// Distance queries at 'nbPoint' random points of a grid scene: interpreter loop against CSGPointQuery, with and without threads and spatial sorting
+	void benchmarkPointQuery(int nbPoint = 1 << 20) const;
+
+	// Mesh extraction of a grid of 'nbPrimitive' primitives at 'resolution'^3 effective resolution, with and without sharp features
+	void benchmarkMesher(int nbPrimitive = 1000, int resolution = 512) const;
+
+	// Picking rays of a frame on a grid of 'nbPrimitive' primitives: sphere marching against CSGRayQuery, time per ray and distance to the surface at the hits
+	void benchmarkRayQuery(int nbPrimitive = 256) const;
+
+	// Frame of a grid of 'nbPrimitive' primitives and of a grid of thin features, rendered by SphereMarcher and by CSGRayTracer
+	void benchmarkRayTracer(int nbPrimitive = 256) const;
+
+	// Frames of a grid, instanced parts, a difference chain and non-uniformly scaled primitives, marched with each SphereMarcher::StepMethod
+	void benchmarkStepMethods() const;
+
+	// Peak resident memory of the process in bytes, or -1 if unknown on this platform. resetPeakResidentMemory() is a no-op where unsupported.
+	static long long peakResidentMemory();
+	static void resetPeakResidentMemory();
+};
@@ -0,0 +1,214 @@
+#include "renderer/opengl/Primitives/CSGBenchmarkSuite.hpp"
+
+#include "renderer/opengl/Primitives/CSGSceneGenerator.hpp"
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+#include "renderer/opengl/Primitives/Primitive.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+// Results of the measured calls are added to it, so the compiler cannot drop them
+static volatile size_t benchmarkSink = 0;
+
+template<typename Function>
+void CSGBenchmarkSuite::measure(const std::string& name, const long long nbItem, Function function, std::ostream* log)
+{
+	if (!_filter.empty() && name.find(_filter) == std::string::npos)
+		return;
+
+	using Clock = std::chrono::steady_clock;
+	function(); // Warm up
+
+	long long nbIteration = 1;
+	double seconds = 0.;
+	while (true)
+	{
+		const Clock::time_point start = Clock::now();
+		for (long long i = 0; i < nbIteration; i++)
+			function();
+		seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		if (seconds >= _minTime || nbIteration >= (1LL << 40))
+			break;
+		// Aim directly at the minimum time once the duration is measurable, at most 10x more iterations
+		nbIteration = seconds > 1e-3 ? std::max(nbIteration + 1, std::min(nbIteration * 10, static_cast<long long>(1.2 * _minTime / seconds * nbIteration))) : nbIteration * 10;
+	}
+
+	BenchmarkResult result;
+	result.name = name;
+	result.nbIteration = nbIteration;
+	result.nanosecondsPerIteration = seconds * 1e9 / static_cast<double>(nbIteration);
+	result.itemsPerSecond = static_cast<double>(nbItem) * static_cast<double>(nbIteration) / seconds;
+	_results.push_back(result);
+
+	if (log != nullptr)
+		*log << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(0) << std::setw(14) << result.nanosecondsPerIteration << " ns"
+			<< std::setw(12) << nbIteration << " iterations" << std::setprecision(3) << std::setw(12) << result.itemsPerSecond * 1e-6 << " M items/s" << std::endl;
+}
+
+const std::vector<BenchmarkResult>& CSGBenchmarkSuite::run(std::ostream* log)
+{
+	_results.clear();
+
+	struct SceneFamily
+	{
+		std::string name;
+		std::vector<std::pair<std::string, std::function<CSGTree()>>> scenes; // Parameter name and generator
+	};
+	std::vector<SceneFamily> families(4);
+	families[0].name = "balancedUnion";
+	for (const int nbSphere : {64, 1024, 16384})
+		families[0].scenes.emplace_back(std::to_string(nbSphere), [nbSphere]() { return CSGSceneGenerator{}.balancedUnion(nbSphere); });
+	families[1].name = "differenceChain";
+	for (const int depth : {16, 256, 2048})
+		families[1].scenes.emplace_back(std::to_string(depth), [depth]() { return CSGSceneGenerator{}.differenceChain(depth); });
+	families[2].name = "randomTree";
+	for (const auto& [nbPrimitive, maxHeight] : {std::pair<int, int>{64, 8}, {1024, 16}, {16384, 24}})
+		families[2].scenes.emplace_back(std::to_string(nbPrimitive) + "h" + std::to_string(maxHeight), [nbPrimitive = nbPrimitive, maxHeight = maxHeight]()
+		{
+			return CSGSceneGenerator{}.randomTree(nbPrimitive, maxHeight);
+		});
+	families[3].name = "instancedGrid";
+	for (const int size : {4, 16})
+		families[3].scenes.emplace_back(std::to_string(size) + "x" + std::to_string(size) + "x4", [size]() { return CSGSceneGenerator{}.instancedGrid(size, size, 4); });
+
+	constexpr int nbIndexQuery = 64;
+	constexpr int nbPoint = 4096;
+	for (const SceneFamily& family : families)
+	{
+		for (const auto& [parameter, generate] : family.scenes)
+		{
+			const std::string prefix = family.name + "/" + parameter + "/";
+			const CSGTree tree = generate();
+			const int nbNode = tree.nbNode();
+
+			measure(prefix + "build", nbNode, [&generate]() { benchmarkSink = benchmarkSink + static_cast<size_t>(generate().isEmpty()); }, log);
+			measure(prefix + "nbNode", nbNode, [&tree]() { benchmarkSink = benchmarkSink + static_cast<size_t>(tree.nbNode()); }, log);
+
+			std::vector<int> indices;
+			for (int i = 0; i < nbIndexQuery; i++)
+				indices.push_back(static_cast<int>(static_cast<long long>(i) * nbNode / nbIndexQuery));
+			measure(prefix + "atPreorder", nbIndexQuery, [&tree, &indices]()
+			{
+				for (const int index : indices)
+					benchmarkSink = benchmarkSink + static_cast<size_t>(tree.atPreorder(index) != nullptr);
+			}, log);
+			measure(prefix + "atPostorder", nbIndexQuery, [&tree, &indices]()
+			{
+				for (const int index : indices)
+					benchmarkSink = benchmarkSink + static_cast<size_t>(tree.atPostorder(index) != nullptr);
+			}, log);
+
+			measure(prefix + "treeRawData", nbNode, [&tree]() { benchmarkSink = benchmarkSink + tree.treeRawData().size(); }, log);
+			measure(prefix + "rawDataByPrimitiveType", tree.nbOfPrimitive(), [&tree]()
+			{
+				for (const Primitive::PrimitiveType type : {Primitive::PrimitiveType::Sphere, Primitive::PrimitiveType::Torus, Primitive::PrimitiveType::Cylinder, Primitive::PrimitiveType::Box})
+					benchmarkSink = benchmarkSink + tree.rawDataByPrimitiveType(type).size();
+			}, log);
+			measure(prefix + "CSGSceneData", nbNode, [&tree]() { benchmarkSink = benchmarkSink + static_cast<size_t>(CSGSceneData{tree}.view().nbNode); }, log);
+
+			// Random points in the bounds of the scene, a cube around the origin when unbounded
+			const CSGSceneData scene{tree};
+			AABB bounds = CSGBounds::nodeBounds(scene.view()).back();
+			if (bounds.isInfinite() || bounds.isEmpty())
+				bounds = AABB{glm::vec3(-6.f), glm::vec3(6.f)};
+			CSGSceneGenerator generator;
+			std::vector<glm::vec3> points(nbPoint);
+			for (glm::vec3& point : points)
+				point = bounds.min + (generator.randomPoint(1.f) * 0.5f + 0.5f) * (bounds.max - bounds.min);
+
+			const CSGEvaluator evaluator{scene.view()};
+			measure(prefix + "evaluate", nbPoint, [&evaluator, &points]()
+			{
+				float sum = 0.f;
+				for (const glm::vec3& point : points)
+					sum += evaluator.scanSDF(point).dist;
+				benchmarkSink = benchmarkSink + static_cast<size_t>(sum != 0.f);
+			}, log);
+
+			const CSGCompiledEvaluator compiledEvaluator{scene.view(), std::make_shared<const CSGCompiledProgram>(scene.view())};
+			std::vector<float> distances(nbPoint);
+			measure(prefix + "compiledEvaluate", nbPoint, [&compiledEvaluator, &points, &distances]()
+			{
+				compiledEvaluator.distances(points.data(), nbPoint, distances.data());
+				benchmarkSink = benchmarkSink + static_cast<size_t>(distances.front() != 0.f);
+			}, log);
+		}
+	}
+	return _results;
+}
+
+// Escape the characters that cannot appear as is in a JSON string
+static std::string jsonString(const std::string& text)
+{
+	std::string result = "\"";
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		result += c;
+	}
+	return result + "\"";
+}
+
+std::string CSGBenchmarkSuite::toJson() const
+{
+	const std::time_t now = std::time(nullptr);
+	char date[32] = {};
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+	// Same fields as google-benchmark, the times are wall clock times
+	std::ostringstream stream;
+	stream << std::setprecision(10);
+	stream << "{\n  \"context\": {\n"
+		<< "    \"date\": " << jsonString(date) << ",\n"
+		<< "    \"executable\": \"CSGBenchmarkSuite\",\n"
+		<< "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+		<< "    \"min_time\": " << _minTime << ",\n"
+		<< "    \"library_build_type\": " << jsonString(
+#ifdef NDEBUG
+			"release"
+#else
+			"debug"
+#endif
+		) << "\n  },\n  \"benchmarks\": [";
+	for (size_t i = 0; i < _results.size(); i++)
+	{
+		const BenchmarkResult& result = _results[i];
+		stream << (i > 0 ? "," : "") << "\n    {\n"
+			<< "      \"name\": " << jsonString(result.name) << ",\n"
+			<< "      \"run_name\": " << jsonString(result.name) << ",\n"
+			<< "      \"run_type\": \"iteration\",\n"
+			<< "      \"iterations\": " << result.nbIteration << ",\n"
+			<< "      \"real_time\": " << result.nanosecondsPerIteration << ",\n"
+			<< "      \"cpu_time\": " << result.nanosecondsPerIteration << ",\n"
+			<< "      \"time_unit\": \"ns\",\n"
+			<< "      \"items_per_second\": " << result.itemsPerSecond << "\n    }";
+	}
+	stream << "\n  ]\n}\n";
+	return stream.str();
+}
+
+bool CSGBenchmarkSuite::writeJson(const std::string& path, std::string& error) const
+{
+	std::ofstream file{path, std::ios::binary};
+	if (!file)
+	{
+		error = "cannot create '" + path + "'";
+		return false;
+	}
+	file << toJson();
+	if (!file)
+	{
+		error = "cannot write '" + path + "'";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+/*
+* Result of one benchmark case
+*/
+struct BenchmarkResult
+{
+	std::string name; // family/parameter/operation, e.g. "balancedUnion/1024/atPreorder"
+	long long nbIteration = 0;
+	double nanosecondsPerIteration = 0.;
+	double itemsPerSecond = 0.; // Nodes, queries or points processed per second, depending on the operation
+};
+
+/*
+* Benchmark suite over parametric synthetic scenes (see CSGSceneGenerator): balanced unions of spheres, difference chains, random
+* mixed trees of bounded height and instanced grids, at several sizes. For each scene it measures:
+*   - build: generation of the CSGTree,
+*   - nbNode, atPreorder, atPostorder: traversal queries on the tree (64 indices spread over the tree for the indexed ones),
+*   - treeRawData, rawDataByPrimitiveType: serialization of the tree for the shader, and CSGSceneData: the whole flat scene,
+*   - evaluate, compiledEvaluate: distance queries at random points of the scene bounds, with CSGEvaluator and CSGCompiledEvaluator.
+*
+* Every case is repeated with a doubling number of iterations until it runs for at least getMinTime() seconds, as google-benchmark
+* does, and the results can be written in the JSON format of google-benchmark, so its compare.py can track regressions between runs.
+*/
+class CSGBenchmarkSuite
+{
+public:
+	void setMinTime(double seconds) { _minTime = seconds; }
+	[[nodiscard]] double getMinTime() const { return _minTime; }
+
+	// Only run the cases whose name contains 'filter', all of them if empty
+	void setFilter(const std::string& filter) { _filter = filter; }
+
+	// Run the cases, printing a line per case on 'log' if not null
+	const std::vector<BenchmarkResult>& run(std::ostream* log = nullptr);
+	[[nodiscard]] const std::vector<BenchmarkResult>& getResults() const { return _results; }
+
+	[[nodiscard]] std::string toJson() const;
+	bool writeJson(const std::string& path, std::string& error) const;
+
+private:
+	// Time 'function' (one iteration processing 'nbItem' items) and add its result, if 'name' passes the filter
+	template<typename Function>
+	void measure(const std::string& name, long long nbItem, Function function, std::ostream* log);
+
+	double _minTime = 0.2;
+	std::string _filter;
+	std::vector<BenchmarkResult> _results;
+};
@@ -0,0 +1,323 @@
+#include "renderer/opengl/Primitives/CSGBinaryScene.hpp"
+
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+#include "renderer/opengl/Primitives/Sphere.hpp"
+#include "renderer/opengl/Primitives/Torus.hpp"
+#include "renderer/opengl/Primitives/Cylinder.hpp"
+#include "renderer/opengl/Primitives/Box.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CSGBinaryScene::CSGBinaryScene() = default;
+
+CSGBinaryScene::~CSGBinaryScene()
+{
+	close();
+}
+
+bool CSGBinaryScene::save(const std::string& path, const CSGSceneView& scene, std::string& error)
+{
+	const void* sections[5] = {scene.nodes, scene.spheres, scene.toruses, scene.cylinders, scene.boxes};
+	const int counts[5] = {scene.nbNode, scene.nbSphere, scene.nbTorus, scene.nbCylinder, scene.nbBox};
+	const uint32_t recordSizes[5] = {sizeof(CSGNode::ShaderNodeData), sizeof(SphereData), sizeof(TorusData), sizeof(CylinderData), sizeof(BoxData)};
+
+	CSGBinaryHeader header{};
+	memcpy(header.magic, CSGBinaryHeader::MAGIC, sizeof(header.magic));
+	header.version = CSGBinaryHeader::CURRENT_VERSION;
+	header.headerSize = sizeof(CSGBinaryHeader);
+	header.contentHash = CSGSceneData::contentHash(scene);
+
+	uint64_t offset = sizeof(CSGBinaryHeader);
+	for (int i = 0; i < 5; i++)
+	{
+		offset = (offset + CSGBinaryHeader::SECTION_ALIGNMENT - 1) / CSGBinaryHeader::SECTION_ALIGNMENT * CSGBinaryHeader::SECTION_ALIGNMENT;
+		header.sectionOffset[i] = offset;
+		header.sectionCount[i] = static_cast<uint32_t>(counts[i]);
+		header.sectionRecordSize[i] = recordSizes[i];
+		offset += static_cast<uint64_t>(counts[i]) * recordSizes[i];
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		error = "cannot create '" + path + "'";
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	uint64_t written = sizeof(header);
+	static const char padding[CSGBinaryHeader::SECTION_ALIGNMENT] = {};
+	for (int i = 0; i < 5; i++)
+	{
+		file.write(padding, static_cast<std::streamsize>(header.sectionOffset[i] - written));
+		file.write(static_cast<const char*>(sections[i]), static_cast<std::streamsize>(header.sectionCount[i]) * recordSizes[i]);
+		written = header.sectionOffset[i] + static_cast<uint64_t>(header.sectionCount[i]) * recordSizes[i];
+	}
+
+	if (!file)
+	{
+		error = "cannot write '" + path + "'";
+		return false;
+	}
+	return true;
+}
+
+bool CSGBinaryScene::open(const std::string& path, std::string& error)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		error = "cannot open '" + path + "'";
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	CloseHandle(file); // The mapping keeps the file open
+	if (mapping == nullptr)
+	{
+		error = "cannot map '" + path + "'";
+		return false;
+	}
+	_fileHandle = mapping;
+	_mapping = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+	if (_mapping == nullptr)
+	{
+		close();
+		error = "cannot map '" + path + "'";
+		return false;
+	}
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		error = "cannot open '" + path + "'";
+		return false;
+	}
+	struct stat fileStatus;
+	void* mapping = MAP_FAILED;
+	if (fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0)
+		mapping = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file); // The mapping keeps the file open
+	if (mapping == MAP_FAILED)
+	{
+		error = "cannot map '" + path + "'";
+		return false;
+	}
+	_mapping = static_cast<const uint8_t*>(mapping);
+	_mappingSize = static_cast<size_t>(fileStatus.st_size);
+#endif
+
+	auto fail = [&](const std::string& message)
+	{
+		close();
+		error = path + ": " + message;
+		return false;
+	};
+
+	if (_mappingSize < sizeof(CSGBinaryHeader))
+		return fail("file too small for a binary scene header");
+	memcpy(&_header, _mapping, sizeof(CSGBinaryHeader));
+	if (memcmp(_header.magic, CSGBinaryHeader::MAGIC, sizeof(_header.magic)) != 0)
+		return fail("not a binary scene file");
+	if (_header.version != CSGBinaryHeader::CURRENT_VERSION)
+		return fail("unsupported version " + std::to_string(_header.version));
+	if (_header.headerSize < sizeof(CSGBinaryHeader) || _header.headerSize > _mappingSize)
+		return fail("invalid header size " + std::to_string(_header.headerSize));
+
+	const uint32_t recordSizes[5] = {sizeof(CSGNode::ShaderNodeData), sizeof(SphereData), sizeof(TorusData), sizeof(CylinderData), sizeof(BoxData)};
+	for (int i = 0; i < 5; i++)
+	{
+		if (_header.sectionRecordSize[i] != recordSizes[i])
+			return fail("record size mismatch in section " + std::to_string(i));
+		// Compared without sums, a crafted offset must not wrap around
+		if (_header.sectionOffset[i] % alignof(float) != 0 || _header.sectionOffset[i] < _header.headerSize || _header.sectionOffset[i] > _mappingSize
+			|| _header.sectionCount[i] > (_mappingSize - _header.sectionOffset[i]) / recordSizes[i])
+			return fail("section " + std::to_string(i) + " is out of the file");
+	}
+
+	_view.nodes = reinterpret_cast<const CSGNode::ShaderNodeData*>(_mapping + _header.sectionOffset[0]);
+	_view.nbNode = static_cast<int>(_header.sectionCount[0]);
+	_view.spheres = reinterpret_cast<const SphereData*>(_mapping + _header.sectionOffset[1]);
+	_view.nbSphere = static_cast<int>(_header.sectionCount[1]);
+	_view.toruses = reinterpret_cast<const TorusData*>(_mapping + _header.sectionOffset[2]);
+	_view.nbTorus = static_cast<int>(_header.sectionCount[2]);
+	_view.cylinders = reinterpret_cast<const CylinderData*>(_mapping + _header.sectionOffset[3]);
+	_view.nbCylinder = static_cast<int>(_header.sectionCount[3]);
+	_view.boxes = reinterpret_cast<const BoxData*>(_mapping + _header.sectionOffset[4]);
+	_view.nbBox = static_cast<int>(_header.sectionCount[4]);
+
+	std::string nodeError;
+	if (!validateNodes(_view, nodeError))
+		return fail(nodeError);
+	return true;
+}
+
+void CSGBinaryScene::close()
+{
+	if (_mapping != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(_mapping);
+#else
+		munmap(const_cast<uint8_t*>(_mapping), _mappingSize);
+#endif
+	}
+#ifdef _WIN32
+	if (_fileHandle != nullptr)
+		CloseHandle(static_cast<HANDLE>(_fileHandle));
+#endif
+	_mapping = nullptr;
+	_mappingSize = 0;
+	_fileHandle = nullptr;
+	_header = CSGBinaryHeader{};
+	_view = CSGSceneView{};
+	_tree.reset();
+}
+
+CSGTree& CSGBinaryScene::tree()
+{
+	if (_tree == nullptr)
+		_tree = std::make_unique<CSGTree>(buildTree(_view));
+	return *_tree;
+}
+
+bool CSGBinaryScene::validateNodes(const CSGSceneView& scene, std::string& error)
+{
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		bool valid;
+		// Leaves have no children, as written by CSGNode::rawDataStep()
+		const bool noChild = node.leftChildIndex == -1 && node.rightChildIndex == -1;
+		switch (node.type)
+		{
+		case SHADER_TYPE_SPHERE:
+			valid = noChild && node.primitiveIndex >= 0 && node.primitiveIndex < scene.nbSphere;
+			break;
+		case SHADER_TYPE_TORUS:
+			valid = noChild && node.primitiveIndex >= 0 && node.primitiveIndex < scene.nbTorus;
+			break;
+		case SHADER_TYPE_CYLINDER:
+			valid = noChild && node.primitiveIndex >= 0 && node.primitiveIndex < scene.nbCylinder;
+			break;
+		case SHADER_TYPE_BOX:
+			valid = noChild && node.primitiveIndex >= 0 && node.primitiveIndex < scene.nbBox;
+			break;
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_DIFFERENCE:
+			// Postorder: the children are before their parent
+			valid = node.leftChildIndex >= 0 && node.leftChildIndex < i && node.rightChildIndex >= 0 && node.rightChildIndex < i;
+			break;
+		case SHADER_TYPE_COMPLEMENTARY:
+			valid = node.leftChildIndex >= 0 && node.leftChildIndex < i;
+			break;
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+			valid = node.leftChildIndex >= 0 && node.leftChildIndex < i && node.rightChildIndex >= 0 && node.rightChildIndex < i
+				&& blendRadius(node) > 0.f && std::isfinite(blendRadius(node));
+			break;
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+			// At least two consecutive leaves, before their parent
+			valid = node.leftChildIndex >= 0 && node.leftChildIndex < node.rightChildIndex && node.rightChildIndex < i;
+			for (int child = node.leftChildIndex; valid && child <= node.rightChildIndex; child++)
+				valid = isLeafType(scene.nodes[child].type);
+			break;
+		default:
+			valid = false;
+			break;
+		}
+
+		if (!valid)
+		{
+			error = "invalid node " + std::to_string(i);
+			return false;
+		}
+	}
+	return true;
+}
+
+CSGTree CSGBinaryScene::buildTree(const CSGSceneView& scene)
+{
+	if (scene.isEmpty())
+		return CSGTree{};
+
+	std::vector<CSGNode::NodePtr> nodes(scene.nbNode);
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		switch (hardOperation(node.type))
+		{
+		case SHADER_TYPE_SPHERE:
+		{
+			const SphereData& sphere = scene.spheres[node.primitiveIndex];
+			nodes[i] = CSGNode::makePrimitive(std::make_shared<Sphere>(glm::inverse(affineMatrix(sphere.inverseTransform)), sphere.color, sphere.radius));
+			break;
+		}
+		case SHADER_TYPE_TORUS:
+		{
+			const TorusData& torus = scene.toruses[node.primitiveIndex];
+			nodes[i] = CSGNode::makePrimitive(std::make_shared<Torus>(glm::inverse(affineMatrix(torus.inverseTransform)), torus.color, torus.majorRadius, torus.minorRadius));
+			break;
+		}
+		case SHADER_TYPE_CYLINDER:
+		{
+			const CylinderData& cylinder = scene.cylinders[node.primitiveIndex];
+			nodes[i] = CSGNode::makePrimitive(std::make_shared<Cylinder>(glm::inverse(affineMatrix(cylinder.inverseTransform)), cylinder.color, cylinder.height, cylinder.radius));
+			break;
+		}
+		case SHADER_TYPE_BOX:
+		{
+			const BoxData& box = scene.boxes[node.primitiveIndex];
+			nodes[i] = CSGNode::makePrimitive(std::make_shared<Box>(glm::inverse(affineMatrix(box.inverseTransform)), box.color, box.size));
+			break;
+		}
+		case SHADER_TYPE_INTERSECTION:
+			nodes[i] = CSGNode::makeIntersection(nodes[node.leftChildIndex], nodes[node.rightChildIndex]);
+			break;
+		case SHADER_TYPE_UNION:
+			nodes[i] = CSGNode::makeUnion(nodes[node.leftChildIndex], nodes[node.rightChildIndex]);
+			break;
+		case SHADER_TYPE_DIFFERENCE:
+			nodes[i] = CSGNode::makeDifference(nodes[node.leftChildIndex], nodes[node.rightChildIndex]);
+			break;
+		case SHADER_TYPE_COMPLEMENTARY:
+			nodes[i] = CSGNode::makeComplement(nodes[node.leftChildIndex]);
+			break;
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+			nodes[i] = nodes[node.leftChildIndex];
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			{
+				nodes[i] = node.type == SHADER_TYPE_NARY_UNION ? CSGNode::makeUnion(nodes[i], nodes[child])
+					: CSGNode::makeIntersection(nodes[i], nodes[child]);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return CSGTree{ nodes.back() };
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+/*
+* Header of a binary scene file (.csgb). Every section is the raw content of one SSBO: the postorder node buffer, then one buffer of std430
+* records per primitive type, each starting on a 64 bytes boundary. A mapped file can therefore be handed to the evaluator or uploaded
+* with glBufferData without any conversion.
+*/
+struct CSGBinaryHeader
+{
+	static constexpr char MAGIC[8] = {'C', 'S', 'G', 'S', 'C', 'E', 'N', 'E'};
+	static constexpr uint32_t CURRENT_VERSION = 2; // 2: affine inverse transforms and precomputed distance scales in the records
+	static constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize; // sizeof(CSGBinaryHeader) when the file was written, sections start after it
+	uint64_t contentHash; // CSGSceneData::contentHash() of the scene, usable as a cache key without reading the sections
+
+	// Sections, in this order: nodes, spheres, toruses, cylinders, boxes
+	uint64_t sectionOffset[5]; // From the start of the file
+	uint32_t sectionCount[5]; // Number of records
+	uint32_t sectionRecordSize[5]; // sizeof() of a record, checked at loading
+	uint32_t reserved[2]; // Zero, keeps the header size a multiple of 16
+};
+
+static_assert(sizeof(CSGBinaryHeader) == 112, "The binary scene header must not depend on the compiler");
+
+/*
+* Scene loaded from a binary scene file. The file is memory mapped: view() points into the mapping, nothing is copied or converted.
+* The shared_ptr CSGTree used by the editor is only rebuilt from the sections the first time tree() is called.
+*/
+class CSGBinaryScene
+{
+public:
+	CSGBinaryScene();
+	~CSGBinaryScene();
+
+	CSGBinaryScene(const CSGBinaryScene&) = delete;
+	CSGBinaryScene& operator=(const CSGBinaryScene&) = delete;
+
+	static bool save(const std::string& path, const CSGSceneView& scene, std::string& error);
+
+	/*
+	* Map the file and check its header and its node section (types, child and primitive indices), so that a corrupted file cannot make
+	* the evaluator read out of bounds. Primitive records are not read.
+	*/
+	bool open(const std::string& path, std::string& error);
+	void close();
+
+	[[nodiscard]] bool isOpen() const { return _mapping != nullptr; }
+	[[nodiscard]] const CSGSceneView& view() const { return _view; }
+	[[nodiscard]] uint64_t contentHash() const { return _header.contentHash; }
+
+	// Editable tree, rebuilt from the mapped sections on the first call. Edits are not written back to the file.
+	CSGTree& tree();
+	[[nodiscard]] bool isTreeBuilt() const { return _tree != nullptr; }
+
+	/*
+	* Rebuild a tree from any flat scene: primitives get their transform back from the inverse transform of their record.
+	* CSGNode has no smooth operations, they are rebuilt as their hard operation, and n-ary operations as left-deep chains of binary ones.
+	*/
+	static CSGTree buildTree(const CSGSceneView& scene);
+
+	/*
+	* Check that every node of 'scene' only refers to existing nodes and primitives, that leaves have -1 as child indices, that smooth
+	* operations have a positive blend radius and that n-ary operations have at least two leaves
+	*/
+	static bool validateNodes(const CSGSceneView& scene, std::string& error);
+
+private:
+	const uint8_t* _mapping = nullptr;
+	size_t _mappingSize = 0;
+	void* _fileHandle = nullptr; // Windows file mapping handle
+	CSGBinaryHeader _header{};
+	CSGSceneView _view;
+	std::unique_ptr<CSGTree> _tree;
+};
@@ -0,0 +1,265 @@
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+
+#include <cstring>
+#include <cmath>
+
+AABB AABB::infinite()
+{
+	AABB bounds;
+	bounds.min = glm::vec3(-std::numeric_limits<float>::infinity());
+	bounds.max = glm::vec3(std::numeric_limits<float>::infinity());
+	return bounds;
+}
+
+bool AABB::isInfinite() const
+{
+	return std::isinf(min.x) || std::isinf(min.y) || std::isinf(min.z) || std::isinf(max.x) || std::isinf(max.y) || std::isinf(max.z);
+}
+
+AABB AABB::merged(const AABB& other) const
+{
+	AABB bounds;
+	bounds.min = glm::min(min, other.min);
+	bounds.max = glm::max(max, other.max);
+	return bounds;
+}
+
+AABB AABB::intersected(const AABB& other) const
+{
+	AABB bounds;
+	bounds.min = glm::max(min, other.min);
+	bounds.max = glm::min(max, other.max);
+	return bounds;
+}
+
+AABB AABB::expanded(const float margin) const
+{
+	if (isEmpty())
+		return *this;
+	AABB bounds;
+	bounds.min = min - glm::vec3(margin);
+	bounds.max = max + glm::vec3(margin);
+	return bounds;
+}
+
+AABB AABB::transformed(const glm::mat4& transform) const
+{
+	if (isEmpty() || isInfinite())
+		return *this;
+
+	AABB bounds;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const glm::vec3 cornerPos{corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z};
+		const glm::vec3 transformedPos = glm::vec3(transform * glm::vec4(cornerPos, 1.f));
+		bounds.min = glm::min(bounds.min, transformedPos);
+		bounds.max = glm::max(bounds.max, transformedPos);
+	}
+	return bounds;
+}
+
+float AABB::distance(const glm::vec3& pos) const
+{
+	if (isEmpty())
+		return std::numeric_limits<float>::infinity();
+	const glm::vec3 outside = glm::max(glm::max(min - pos, pos - max), glm::vec3(0.f));
+	return glm::length(outside);
+}
+
+/*
+* Local bounds follow the SDFs of PrimitiveSceneSDF.glsl: sizes and heights are half extents
+*/
+static AABB localBounds(const glm::vec3& halfExtents)
+{
+	AABB bounds;
+	bounds.min = -halfExtents;
+	bounds.max = halfExtents;
+	return bounds;
+}
+
+AABB CSGBounds::sphereBounds(const SphereData& sphere)
+{
+	return localBounds(glm::vec3(sphere.radius)).transformed(glm::inverse(affineMatrix(sphere.inverseTransform)));
+}
+
+AABB CSGBounds::torusBounds(const TorusData& torus)
+{
+	const float outerRadius = torus.majorRadius + torus.minorRadius;
+	return localBounds(glm::vec3(outerRadius, torus.minorRadius, outerRadius)).transformed(glm::inverse(affineMatrix(torus.inverseTransform)));
+}
+
+AABB CSGBounds::cylinderBounds(const CylinderData& cylinder)
+{
+	return localBounds(glm::vec3(cylinder.radius, cylinder.height, cylinder.radius)).transformed(glm::inverse(affineMatrix(cylinder.inverseTransform)));
+}
+
+AABB CSGBounds::boxBounds(const BoxData& box)
+{
+	return localBounds(box.size).transformed(glm::inverse(affineMatrix(box.inverseTransform)));
+}
+
+AABB CSGBounds::leafBounds(const CSGSceneView& scene, const CSGNode::ShaderNodeData& node)
+{
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+		return sphereBounds(scene.spheres[node.primitiveIndex]);
+	case SHADER_TYPE_TORUS:
+		return torusBounds(scene.toruses[node.primitiveIndex]);
+	case SHADER_TYPE_CYLINDER:
+		return cylinderBounds(scene.cylinders[node.primitiveIndex]);
+	case SHADER_TYPE_BOX:
+		return boxBounds(scene.boxes[node.primitiveIndex]);
+	default:
+		return AABB{};
+	}
+}
+
+AABB CSGBounds::primitiveBounds(const Primitive& primitive)
+{
+	const std::vector<uint8_t> rawData = primitive.rawData();
+
+	// Decode the serialized primitive into its GPU record, so the bounds are the ones of what is actually rendered
+	auto decode = [&rawData](auto record)
+	{
+		memcpy(&record, rawData.data(), std::min(rawData.size(), sizeof(record)));
+		return record;
+	};
+
+	switch (primitive.getType())
+	{
+	case Primitive::PrimitiveType::Sphere:
+		return sphereBounds(decode(SphereData{}));
+	case Primitive::PrimitiveType::Torus:
+		return torusBounds(decode(TorusData{}));
+	case Primitive::PrimitiveType::Cylinder:
+		return cylinderBounds(decode(CylinderData{}));
+	case Primitive::PrimitiveType::Box:
+		return boxBounds(decode(BoxData{}));
+	default:
+		return AABB::infinite();
+	}
+}
+
+std::vector<AABB> CSGBounds::nodeBounds(const CSGSceneView& scene)
+{
+	std::vector<AABB> bounds(scene.nbNode);
+
+	// Postorder buffer: children are always before their parent
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		switch (node.type)
+		{
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_DIFFERENCE:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+			bounds[i] = operationBounds(node.type, bounds[node.leftChildIndex], bounds[node.rightChildIndex], blendRadius(node));
+			break;
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+			bounds[i] = bounds[node.leftChildIndex];
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+				bounds[i] = operationBounds(binaryOperation(node.type), bounds[i], bounds[child]);
+			break;
+		case SHADER_TYPE_COMPLEMENTARY:
+			bounds[i] = AABB::infinite();
+			break;
+		default:
+			bounds[i] = leafBounds(scene, node);
+			break;
+		}
+	}
+	return bounds;
+}
+
+AABB CSGBounds::operationBounds(const int type, const AABB& left, const AABB& right, const float blendRadius)
+{
+	switch (type)
+	{
+	case SHADER_TYPE_UNION:
+		return left.merged(right);
+	case SHADER_TYPE_SMOOTH_UNION:
+		return left.merged(right).expanded(blendRadius);
+	case SHADER_TYPE_INTERSECTION:
+	case SHADER_TYPE_SMOOTH_INTERSECTION: // The smooth max is above the max: the blend only removes matter
+		return left.intersected(right);
+	case SHADER_TYPE_DIFFERENCE:
+	case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		return left;
+	case SHADER_TYPE_COMPLEMENTARY:
+	default:
+		return AABB::infinite();
+	}
+}
+
+std::vector<float> CSGBounds::blendMargins(const CSGSceneView& scene)
+{
+	std::vector<float> margins(scene.nbNode, 0.f);
+
+	// Parents are after their children: go down from the root
+	for (int i = scene.nbNode - 1; i >= 0; i--)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		if (node.type < SHADER_TYPE_INTERSECTION)
+			continue;
+		const float margin = margins[i] + blendRadius(node);
+		if (isNaryOperation(node.type))
+		{
+			for (int child = std::max(node.leftChildIndex, 0); child <= node.rightChildIndex && child < i; child++)
+				margins[child] = margin;
+			continue;
+		}
+		if (node.leftChildIndex >= 0 && node.leftChildIndex < i)
+			margins[node.leftChildIndex] = margin;
+		if (node.type != SHADER_TYPE_COMPLEMENTARY && node.rightChildIndex >= 0 && node.rightChildIndex < i)
+			margins[node.rightChildIndex] = margin;
+	}
+	return margins;
+}
+
+ScreenRect CSGBounds::project(const AABB& bounds, const CameraParameters& camera, const int width, const int height)
+{
+	const ScreenRect fullScreen{0, 0, width, height};
+	if (bounds.isEmpty())
+		return ScreenRect{};
+	if (bounds.isInfinite())
+		return fullScreen;
+
+	const float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+	const float tanHalfFov = std::tan(camera.fieldOfView / 2.f);
+
+	glm::vec2 minPixel{std::numeric_limits<float>::infinity()};
+	glm::vec2 maxPixel{-std::numeric_limits<float>::infinity()};
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const glm::vec3 cornerPos{corner & 1 ? bounds.max.x : bounds.min.x, corner & 2 ? bounds.max.y : bounds.min.y, corner & 4 ? bounds.max.z : bounds.min.z};
+		const glm::vec3 viewPos = glm::vec3(camera.viewMat * glm::vec4(cornerPos, 1.f));
+
+		// A corner behind the camera can project anywhere on screen, so stay conservative
+		if (viewPos.z > -1e-4f)
+			return fullScreen;
+
+		// Inverse of the ray generation of primitiveSphereMarching.comp.glsl
+		const glm::vec2 ndc = glm::vec2(viewPos.x, viewPos.y) / (-viewPos.z * tanHalfFov) / glm::vec2(aspectRatio, 1.f);
+		const glm::vec2 pixel = (ndc + 1.f) * 0.5f * glm::vec2(static_cast<float>(width), static_cast<float>(height)) - 0.5f;
+		minPixel = glm::min(minPixel, pixel);
+		maxPixel = glm::max(maxPixel, pixel);
+	}
+
+	// Clamp before the conversion to int, a corner close to the camera plane projects very far away
+	const glm::vec2 screenMin{-2.f};
+	const glm::vec2 screenMax{static_cast<float>(width) + 2.f, static_cast<float>(height) + 2.f};
+	minPixel = glm::clamp(minPixel, screenMin, screenMax);
+	maxPixel = glm::clamp(maxPixel, screenMin, screenMax);
+
+	const int minX = static_cast<int>(std::floor(minPixel.x)) - 1;
+	const int minY = static_cast<int>(std::floor(minPixel.y)) - 1;
+	const int maxX = static_cast<int>(std::ceil(maxPixel.x)) + 2;
+	const int maxY = static_cast<int>(std::ceil(maxPixel.y)) + 2;
+	return ScreenRect{minX, minY, maxX - minX, maxY - minY}.clipped(width, height);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <limits>
+
+/*
+* Axis aligned bounding box, empty by default
+*/
+struct AABB
+{
+	glm::vec3 min{std::numeric_limits<float>::infinity()};
+	glm::vec3 max{-std::numeric_limits<float>::infinity()};
+
+	static AABB infinite();
+
+	[[nodiscard]] bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+	[[nodiscard]] bool isInfinite() const;
+
+	[[nodiscard]] AABB merged(const AABB& other) const;
+	[[nodiscard]] AABB intersected(const AABB& other) const;
+	[[nodiscard]] AABB expanded(float margin) const;
+	[[nodiscard]] AABB transformed(const glm::mat4& transform) const; // Bounds of the 8 transformed corners
+
+	// Distance from 'pos' to the box, 0 inside
+	[[nodiscard]] float distance(const glm::vec3& pos) const;
+};
+
+/*
+* World space bounds of the primitives and of the nodes of a serialized CSG tree
+*/
+class CSGBounds
+{
+public:
+	static AABB sphereBounds(const SphereData& sphere);
+	static AABB torusBounds(const TorusData& torus);
+	static AABB cylinderBounds(const CylinderData& cylinder);
+	static AABB boxBounds(const BoxData& box);
+
+	// Bounds of the primitive referenced by a leaf of the node buffer
+	static AABB leafBounds(const CSGSceneView& scene, const CSGNode::ShaderNodeData& node);
+
+	// Bounds of a primitive object, computed from its serialized data
+	static AABB primitiveBounds(const Primitive& primitive);
+
+	/*
+	* Bounds of every node of the postorder buffer (same indexing).
+	* Union merges, Intersection intersects, Difference keeps the left bounds and Complement is unbounded. N-ary operations fold the same
+	* rules over their leaves.
+	* A smooth operation has the bounds of its hard operation, expanded by the blend radius for a smooth union: the blend only adds
+	* matter where a child is closer than k / 4, k covers children whose distance is underestimated up to 4 times.
+	*/
+	static std::vector<AABB> nodeBounds(const CSGSceneView& scene);
+
+	// Bounds of an operation node of type 'type' (SHADER_TYPE_*) from the bounds of its children, 'blendRadius' for the smooth operations
+	static AABB operationBounds(int type, const AABB& left, const AABB& right, float blendRadius = 0.f);
+
+	/*
+	* Sum of the blend radii of the smooth operations above every node of the postorder buffer (same indexing).
+	* A node whose bounds are further than its margin from a region does not take part in any blend in it, so it can be culled like a
+	* node below hard operations only.
+	*/
+	static std::vector<float> blendMargins(const CSGSceneView& scene);
+
+	// Pixels of a 'width' x 'height' image that can be covered by 'bounds' seen from 'camera', with a one pixel margin
+	static ScreenRect project(const AABB& bounds, const CameraParameters& camera, int width, int height);
+};
@@ -0,0 +1,325 @@
+#include "renderer/opengl/Primitives/CSGCompactScene.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+static uint16_t quantizeUnorm16(const float value)
+{
+	return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+static int16_t quantizeSnorm16(const float value)
+{
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+// Translation, rotation and scale of the forward transform of a record, the reflection (if any) is put on the x scale
+static CSGCompactScene::Placement decompose(const glm::mat3x4& inverseTransform)
+{
+	const glm::mat4 transform = glm::inverse(affineMatrix(inverseTransform));
+	CSGCompactScene::Placement placement;
+	placement.translation = glm::vec3(transform[3]);
+	placement.scale = glm::vec3(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+
+	glm::mat3 rotation{glm::vec3(transform[0]) / placement.scale.x, glm::vec3(transform[1]) / placement.scale.y, glm::vec3(transform[2]) / placement.scale.z};
+	if (glm::determinant(rotation) < 0.f)
+	{
+		placement.scale.x = -placement.scale.x;
+		rotation[0] = -rotation[0];
+	}
+	placement.rotation = glm::normalize(glm::quat_cast(rotation));
+	return placement;
+}
+
+// Rotation of 'v' by the inverse of the unit quaternion 'q': v + w t + u x t with t = 2 u x v, u being the vector part of the conjugate.
+// Written out as transformPoint(), the evaluation of the compact records is dominated by this rotation.
+static glm::vec3 inverseRotate(const glm::quat& q, const glm::vec3& v)
+{
+	const float tx = 2.f * (q.z * v.y - q.y * v.z);
+	const float ty = 2.f * (q.x * v.z - q.z * v.x);
+	const float tz = 2.f * (q.y * v.x - q.x * v.y);
+	return glm::vec3(v.x + q.w * tx - (q.y * tz - q.z * ty), v.y + q.w * ty - (q.z * tx - q.x * tz), v.z + q.w * tz - (q.x * ty - q.y * tx));
+}
+
+static glm::vec3 unpackHalf3(const uint16_t* values)
+{
+	return glm::vec3(glm::unpackHalf1x16(values[0]), glm::unpackHalf1x16(values[1]), glm::unpackHalf1x16(values[2]));
+}
+
+static void packHalf3(const glm::vec3& values, uint16_t* result)
+{
+	for (int i = 0; i < 3; i++)
+		result[i] = glm::packHalf1x16(values[i]);
+}
+
+CSGCompactScene::CSGCompactScene(const CSGSceneView& scene) :
+	_nodes(scene.nodes, scene.nodes + scene.nbNode)
+{
+	// Translation bounds of all the primitives, the fixed point positions are relative to them
+	glm::vec3 minTranslation{std::numeric_limits<float>::infinity()};
+	glm::vec3 maxTranslation{-std::numeric_limits<float>::infinity()};
+	auto addTranslations = [&minTranslation, &maxTranslation](const auto* records, const int nbRecord)
+	{
+		for (int i = 0; i < nbRecord; i++)
+		{
+			const glm::vec3 translation = decompose(records[i].inverseTransform).translation;
+			minTranslation = glm::min(minTranslation, translation);
+			maxTranslation = glm::max(maxTranslation, translation);
+		}
+	};
+	addTranslations(scene.spheres, scene.nbSphere);
+	addTranslations(scene.toruses, scene.nbTorus);
+	addTranslations(scene.cylinders, scene.nbCylinder);
+	addTranslations(scene.boxes, scene.nbBox);
+	if (minTranslation.x <= maxTranslation.x)
+	{
+		_origin = minTranslation;
+		_extent = maxTranslation - minTranslation;
+	}
+
+	encode(Primitive::PrimitiveType::Sphere, scene.spheres, scene.nbSphere, [](const SphereData& sphere) { return glm::vec3(sphere.radius, 0.f, 0.f); });
+	encode(Primitive::PrimitiveType::Torus, scene.toruses, scene.nbTorus, [](const TorusData& torus) { return glm::vec3(torus.majorRadius, torus.minorRadius, 0.f); });
+	encode(Primitive::PrimitiveType::Cylinder, scene.cylinders, scene.nbCylinder, [](const CylinderData& cylinder) { return glm::vec3(cylinder.height, cylinder.radius, 0.f); });
+	encode(Primitive::PrimitiveType::Box, scene.boxes, scene.nbBox, [](const BoxData& box) { return box.size; });
+}
+
+template<typename Data, typename Parameters>
+void CSGCompactScene::encode(const Primitive::PrimitiveType type, const Data* records, const int nbRecord, Parameters parameters)
+{
+	std::vector<CompactPrimitiveData>& compactRecords = _records[static_cast<int>(type)];
+	compactRecords.resize(nbRecord);
+	for (int i = 0; i < nbRecord; i++)
+	{
+		const Placement placement = decompose(records[i].inverseTransform);
+		CompactPrimitiveData& compact = compactRecords[i];
+		for (int axis = 0; axis < 3; axis++)
+			compact.translation[axis] = _extent[axis] > 0.f ? quantizeUnorm16((placement.translation[axis] - _origin[axis]) / _extent[axis]) : 0;
+		for (int component = 0; component < 4; component++)
+			compact.rotation[component] = quantizeSnorm16(placement.rotation[component]);
+		packHalf3(placement.scale, compact.scale);
+		packHalf3(parameters(records[i]), compact.parameters);
+		packHalf3(records[i].color, compact.color);
+	}
+}
+
+std::vector<uint8_t> CSGCompactScene::rawDataByPrimitiveType(const Primitive::PrimitiveType type) const
+{
+	const std::vector<CompactPrimitiveData>& records = getRecords(type);
+	std::vector<uint8_t> rawData(records.size() * sizeof(CompactPrimitiveData));
+	if (!records.empty())
+		memcpy(rawData.data(), records.data(), rawData.size());
+	return rawData;
+}
+
+size_t CSGCompactScene::primitiveByteSize() const
+{
+	size_t byteSize = 0;
+	for (const std::vector<CompactPrimitiveData>& records : _records)
+		byteSize += records.size() * sizeof(CompactPrimitiveData);
+	return byteSize;
+}
+
+CSGCompactScene::Placement CSGCompactScene::decodePlacement(const CompactPrimitiveData& record) const
+{
+	Placement placement;
+	for (int axis = 0; axis < 3; axis++)
+		placement.translation[axis] = _origin[axis] + _extent[axis] * (static_cast<float>(record.translation[axis]) / 65535.f);
+
+	glm::quat rotation;
+	for (int component = 0; component < 4; component++)
+		rotation[component] = static_cast<float>(record.rotation[component]) / 32767.f;
+	placement.rotation = glm::normalize(rotation);
+
+	placement.scale = unpackHalf3(record.scale);
+	return placement;
+}
+
+float CSGCompactScene::leafDistance(const CSGNode::ShaderNodeData& leaf, const glm::vec3& pos) const
+{
+	const CompactPrimitiveData& record = _records[leaf.type - SHADER_TYPE_SPHERE][leaf.primitiveIndex];
+	// Decoded inline, without decodePlacement(): the quaternion is not renormalized, its norm is 1 up to 3e-5
+	const float quantization = 1.f / 32767.f;
+	const glm::quat rotation{quantization * record.rotation[3], quantization * record.rotation[0], quantization * record.rotation[1],
+		quantization * record.rotation[2]};
+	glm::vec3 offset;
+	for (int axis = 0; axis < 3; axis++)
+		offset[axis] = pos[axis] - (_origin[axis] + _extent[axis] * (static_cast<float>(record.translation[axis]) / 65535.f));
+	const glm::vec3 primitiveScale = unpackHalf3(record.scale);
+	const glm::vec3 localPos = inverseRotate(rotation, offset) / primitiveScale;
+	// Smallest scale of the transform, as distanceScale() of the full records
+	const glm::vec3 absScale = glm::abs(primitiveScale);
+	const float scale = std::min(absScale.x, std::min(absScale.y, absScale.z));
+	const glm::vec3 parameters = unpackHalf3(record.parameters);
+
+	switch (leaf.type)
+	{
+	case SHADER_TYPE_SPHERE:
+		return (glm::length(localPos) - parameters.x) * scale;
+	case SHADER_TYPE_TORUS:
+	{
+		TorusData torus{};
+		torus.majorRadius = parameters.x;
+		torus.minorRadius = parameters.y;
+		return torusSDF(torus, localPos) * scale;
+	}
+	case SHADER_TYPE_CYLINDER:
+	{
+		CylinderData cylinder{};
+		cylinder.height = parameters.x;
+		cylinder.radius = parameters.y;
+		return cylinderSDF(cylinder, localPos) * scale;
+	}
+	case SHADER_TYPE_BOX:
+	default:
+	{
+		BoxData box{};
+		box.size = parameters;
+		return boxSDF(box, localPos) * scale;
+	}
+	}
+}
+
+glm::vec3 CSGCompactScene::leafColor(const CSGNode::ShaderNodeData& leaf) const
+{
+	return unpackHalf3(_records[leaf.type - SHADER_TYPE_SPHERE][leaf.primitiveIndex].color);
+}
+
+CSGSceneData CSGCompactScene::decode() const
+{
+	// Full record of a compact one: inverse of translation * rotation * scale, the same composition as Primitive::getTransform()
+	auto decodeRecord = [this](const CompactPrimitiveData& compact, auto record)
+	{
+		const Placement placement = decodePlacement(compact);
+		const glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.f), placement.translation) * glm::mat4_cast(placement.rotation), placement.scale);
+		setInverseTransform(record, glm::inverse(transform));
+		record.color = unpackHalf3(compact.color);
+		return record;
+	};
+
+	std::vector<SphereData> spheres;
+	for (const CompactPrimitiveData& compact : getRecords(Primitive::PrimitiveType::Sphere))
+	{
+		SphereData sphere = decodeRecord(compact, SphereData{});
+		sphere.radius = glm::unpackHalf1x16(compact.parameters[0]);
+		spheres.push_back(sphere);
+	}
+
+	std::vector<TorusData> toruses;
+	for (const CompactPrimitiveData& compact : getRecords(Primitive::PrimitiveType::Torus))
+	{
+		TorusData torus = decodeRecord(compact, TorusData{});
+		torus.majorRadius = glm::unpackHalf1x16(compact.parameters[0]);
+		torus.minorRadius = glm::unpackHalf1x16(compact.parameters[1]);
+		toruses.push_back(torus);
+	}
+
+	std::vector<CylinderData> cylinders;
+	for (const CompactPrimitiveData& compact : getRecords(Primitive::PrimitiveType::Cylinder))
+	{
+		CylinderData cylinder = decodeRecord(compact, CylinderData{});
+		cylinder.height = glm::unpackHalf1x16(compact.parameters[0]);
+		cylinder.radius = glm::unpackHalf1x16(compact.parameters[1]);
+		cylinders.push_back(cylinder);
+	}
+
+	std::vector<BoxData> boxes;
+	for (const CompactPrimitiveData& compact : getRecords(Primitive::PrimitiveType::Box))
+	{
+		BoxData box = decodeRecord(compact, BoxData{});
+		box.size = unpackHalf3(compact.parameters);
+		boxes.push_back(box);
+	}
+
+	return CSGSceneData{_nodes, std::move(spheres), std::move(toruses), std::move(cylinders), std::move(boxes)};
+}
+
+CSGCompactEvaluator::CSGCompactEvaluator(const CSGCompactScene& scene) :
+	_scene{&scene},
+	_nodeDistances(scene.getNodes().size()),
+	_nodeLeaves(scene.getNodes().size())
+{
+}
+
+CSGEvaluation CSGCompactEvaluator::scanSDF(const glm::vec3& pos) const
+{
+	_nbEvaluation++;
+	const std::vector<CSGNode::ShaderNodeData>& nodes = _scene->getNodes();
+	if (nodes.empty())
+		return {glm::vec3(0.f), std::numeric_limits<float>::infinity()};
+
+	const int nbNode = static_cast<int>(nodes.size());
+	for (int i = 0; i < nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = nodes[i];
+		switch (node.type)
+		{
+		case SHADER_TYPE_SPHERE:
+		case SHADER_TYPE_TORUS:
+		case SHADER_TYPE_CYLINDER:
+		case SHADER_TYPE_BOX:
+			_nodeDistances[i] = _scene->leafDistance(node, pos);
+			_nodeLeaves[i] = i;
+			break;
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_DIFFERENCE:
+		{
+			const float a = _nodeDistances[node.leftChildIndex];
+			const float b = _nodeDistances[node.rightChildIndex];
+
+			float dist;
+			if (node.type == SHADER_TYPE_INTERSECTION)
+				dist = std::max(a, b);
+			else if (node.type == SHADER_TYPE_UNION)
+				dist = std::min(a, b);
+			else
+				dist = std::max(a, -b);
+
+			_nodeLeaves[i] = dist == a ? _nodeLeaves[node.leftChildIndex] : _nodeLeaves[node.rightChildIndex];
+			_nodeDistances[i] = dist;
+			break;
+		}
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		{
+			// Only one leaf can be carried: the color is the one of the child with the larger weight in the blend
+			float h;
+			_nodeDistances[i] = smoothOperationSDF(node.type, _nodeDistances[node.leftChildIndex], _nodeDistances[node.rightChildIndex], blendRadius(node), h);
+			_nodeLeaves[i] = h >= 0.5f ? _nodeLeaves[node.leftChildIndex] : _nodeLeaves[node.rightChildIndex];
+			break;
+		}
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+		{
+			const bool unionNode = node.type == SHADER_TYPE_NARY_UNION;
+			int selected = node.leftChildIndex;
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			{
+				if (unionNode ? _nodeDistances[child] < _nodeDistances[selected] : _nodeDistances[child] > _nodeDistances[selected])
+					selected = child;
+			}
+			_nodeDistances[i] = _nodeDistances[selected];
+			_nodeLeaves[i] = _nodeLeaves[selected];
+			break;
+		}
+		case SHADER_TYPE_COMPLEMENTARY:
+			_nodeDistances[i] = -_nodeDistances[node.leftChildIndex];
+			_nodeLeaves[i] = -1; // Black, as in the shader
+			break;
+		default:
+			_nodeDistances[i] = std::numeric_limits<float>::infinity();
+			_nodeLeaves[i] = -1;
+			break;
+		}
+	}
+
+	const int rootLeaf = _nodeLeaves[nbNode - 1];
+	const glm::vec3 color = rootLeaf < 0 ? glm::vec3(0.f) : _scene->leafColor(nodes[rootLeaf]);
+	return {color, _nodeDistances[nbNode - 1]};
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+#include <cstdint>
+
+/*
+* Quantized record of a primitive of any type, 32 bytes instead of the 80 bytes of the full records (a uint[8] in std430).
+* The transform is stored decomposed, as Primitive::setTransform() builds it (translation * rotation * scale, no shear):
+*   - translation: unorm16 fixed point in the translation bounds of the scene (CSGCompactScene::getOrigin() and getExtent()),
+*   - rotation: unit quaternion x, y, z, w in snorm16,
+*   - scale, parameters and color: half floats.
+*/
+struct CompactPrimitiveData
+{
+	uint16_t translation[3];
+	int16_t rotation[4];
+	uint16_t scale[3]; // Negative x for a reflection
+	uint16_t parameters[3]; // Sphere: radius. Torus: major and minor radius. Cylinder: height and radius. Box: size.
+	uint16_t color[3];
+};
+
+static_assert(sizeof(CompactPrimitiveData) == 32, "Compact record must fit in 8 uints");
+
+/*
+* Compact copy of a serialized scene: the same postorder node buffer, and one buffer of CompactPrimitiveData per primitive type in
+* place of the full records, 2.5 times smaller. The records are decoded at each evaluation by CSGCompactEvaluator, so only the
+* compact buffers are read.
+* The quantization error on the distances is about 5e-4 relative for the sizes (half floats), extent / 131070 for the positions and
+* 3e-5 radian for the orientations, see CSGBenchmark::benchmarkCompactScene().
+*/
+class CSGCompactScene
+{
+public:
+	explicit CSGCompactScene(const CSGSceneView& scene);
+
+	// Primitive placement decoded from a record
+	struct Placement
+	{
+		glm::vec3 translation;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+
+	[[nodiscard]] const std::vector<CSGNode::ShaderNodeData>& getNodes() const { return _nodes; }
+	// Records of one primitive type, indexed by the primitiveIndex of the leaves as the full buffers
+	[[nodiscard]] const std::vector<CompactPrimitiveData>& getRecords(Primitive::PrimitiveType type) const { return _records[static_cast<int>(type)]; }
+	// Same role as CSGTree::rawDataByPrimitiveType(), with the compact records
+	[[nodiscard]] std::vector<uint8_t> rawDataByPrimitiveType(Primitive::PrimitiveType type) const;
+	// Size of all the primitive buffers, in bytes
+	[[nodiscard]] size_t primitiveByteSize() const;
+
+	// The translations are quantized in the box [origin, origin + extent]
+	[[nodiscard]] const glm::vec3& getOrigin() const { return _origin; }
+	[[nodiscard]] const glm::vec3& getExtent() const { return _extent; }
+
+	[[nodiscard]] Placement decodePlacement(const CompactPrimitiveData& record) const;
+	// Distance from 'pos' to the primitive of a leaf of the node buffer, same SDFs and scale correction as CSGEvaluator
+	[[nodiscard]] float leafDistance(const CSGNode::ShaderNodeData& leaf, const glm::vec3& pos) const;
+	[[nodiscard]] glm::vec3 leafColor(const CSGNode::ShaderNodeData& leaf) const;
+
+	// Full records holding the quantized values, to compare the compact scene with the original one
+	[[nodiscard]] CSGSceneData decode() const;
+
+private:
+	// 'parameters' gives the parameters of a full record as a vec3
+	template<typename Data, typename Parameters>
+	void encode(Primitive::PrimitiveType type, const Data* records, int nbRecord, Parameters parameters);
+
+	std::vector<CSGNode::ShaderNodeData> _nodes;
+	std::vector<CompactPrimitiveData> _records[4]; // Indexed by Primitive::PrimitiveType
+	glm::vec3 _origin{0.f};
+	glm::vec3 _extent{0.f};
+};
+
+/*
+* CPU evaluator reading a CSGCompactScene, same node loop as CSGStoreEvaluator: each leaf decodes its record on the fly, the
+* operation nodes select distances and carry the leaf responsible for them, whose color is decoded once at the end (the child with
+* the larger weight for a smooth operation).
+* Use one evaluator per thread.
+*/
+class CSGCompactEvaluator
+{
+public:
+	explicit CSGCompactEvaluator(const CSGCompactScene& scene);
+
+	CSGEvaluation scanSDF(const glm::vec3& pos) const;
+
+	// Number of points evaluated since the construction of the evaluator
+	[[nodiscard]] long long getNbEvaluation() const { return _nbEvaluation; }
+
+private:
+	const CSGCompactScene* _scene;
+	mutable std::vector<float> _nodeDistances;
+	mutable std::vector<int> _nodeLeaves; // Leaf node responsible for the distance of each node, -1 below a complement (black)
+	mutable long long _nbEvaluation = 0;
+};
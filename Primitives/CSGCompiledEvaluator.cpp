@@ -0,0 +1,455 @@
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+#include "renderer/opengl/Primitives/CSGShaderGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using OpCode = CSGCompiledProgram::OpCode;
+static constexpr int BATCH_SIZE = CSGCompiledProgram::BATCH_SIZE;
+
+CSGCompiledProgram::CSGCompiledProgram(const CSGSceneView& scene) :
+	_topologyHash{CSGShaderGenerator::topologyHash(scene)}
+{
+	if (scene.isEmpty())
+		return;
+
+	// Last node reading the result of each node: its register is released after that node
+	std::vector<int> lastUse(scene.nbNode);
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		lastUse[i] = i;
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		if (node.type >= SHADER_TYPE_INTERSECTION && node.type <= SHADER_TYPE_SMOOTH_DIFFERENCE)
+		{
+			if (node.leftChildIndex >= 0 && node.leftChildIndex < i)
+				lastUse[node.leftChildIndex] = i;
+			if (node.type != SHADER_TYPE_COMPLEMENTARY && node.rightChildIndex >= 0 && node.rightChildIndex < i)
+				lastUse[node.rightChildIndex] = i;
+		}
+	}
+	lastUse[scene.nbNode - 1] = scene.nbNode; // The root is read by the caller
+
+	// N-ary operation reading each node, -1 for the others
+	std::vector<int> naryParents(scene.nbNode, -1);
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		if (isNaryOperation(node.type) && node.leftChildIndex >= 0 && node.leftChildIndex <= node.rightChildIndex && node.rightChildIndex < i)
+			std::fill(naryParents.begin() + node.leftChildIndex, naryParents.begin() + node.rightChildIndex + 1, i);
+	}
+
+	std::vector<int> nodeRegisters(scene.nbNode, -1);
+	std::vector<int> freeRegisters;
+	auto allocate = [&]()
+	{
+		if (freeRegisters.empty())
+			return _nbRegister++;
+		const int reg = freeRegisters.back();
+		freeRegisters.pop_back();
+		return reg;
+	};
+	auto release = [&](const int child, const int i)
+	{
+		if (lastUse[child] == i)
+		{
+			freeRegisters.push_back(nodeRegisters[child]);
+			lastUse[child] = -1; // A node reading the same child twice releases it once
+		}
+	};
+
+	_instructions.reserve(scene.nbNode);
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		const bool validLeft = node.leftChildIndex >= 0 && node.leftChildIndex < i;
+		const bool validRight = node.rightChildIndex >= 0 && node.rightChildIndex < i;
+		Instruction instruction{OpCode::Infinity, -1};
+
+		switch (node.type)
+		{
+		case SHADER_TYPE_SPHERE:
+		case SHADER_TYPE_TORUS:
+		case SHADER_TYPE_CYLINDER:
+		case SHADER_TYPE_BOX:
+			instruction.opCode = node.type == SHADER_TYPE_SPHERE ? OpCode::Sphere : node.type == SHADER_TYPE_TORUS ? OpCode::Torus
+				: node.type == SHADER_TYPE_CYLINDER ? OpCode::Cylinder : OpCode::Box;
+			instruction.leaf = static_cast<int>(_leafNodes.size());
+			_leafNodes.push_back(i);
+			break;
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_DIFFERENCE:
+			if (validLeft && validRight)
+			{
+				instruction.opCode = node.type == SHADER_TYPE_INTERSECTION ? OpCode::Intersection : node.type == SHADER_TYPE_UNION ? OpCode::Union : OpCode::Difference;
+				instruction.left = nodeRegisters[node.leftChildIndex];
+				instruction.right = nodeRegisters[node.rightChildIndex];
+				release(node.leftChildIndex, i);
+				release(node.rightChildIndex, i);
+			}
+			break;
+		case SHADER_TYPE_COMPLEMENTARY:
+			if (validLeft)
+			{
+				instruction.opCode = OpCode::Complement;
+				instruction.left = nodeRegisters[node.leftChildIndex];
+				release(node.leftChildIndex, i);
+			}
+			break;
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+			if (validLeft && validRight)
+			{
+				instruction.opCode = node.type == SHADER_TYPE_SMOOTH_INTERSECTION ? OpCode::SmoothIntersection
+					: node.type == SHADER_TYPE_SMOOTH_UNION ? OpCode::SmoothUnion : OpCode::SmoothDifference;
+				instruction.left = nodeRegisters[node.leftChildIndex];
+				instruction.right = nodeRegisters[node.rightChildIndex];
+				instruction.blendRadius = blendRadius(node);
+				release(node.leftChildIndex, i);
+				release(node.rightChildIndex, i);
+			}
+			break;
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+			// Already computed in the register of its first child, by the folds of the others
+			if (node.leftChildIndex >= 0 && naryParents[node.leftChildIndex] == i)
+				continue;
+			break;
+		default:
+			break;
+		}
+
+		// The output may reuse the register of a child: every instruction reads a point before writing it
+		instruction.output = allocate();
+		nodeRegisters[i] = instruction.output;
+		_instructions.push_back(instruction);
+
+		// The children of an n-ary operation are folded into its register as soon as they are computed, instead of all staying live until it
+		const int naryNode = naryParents[i];
+		if (naryNode >= 0 && i == scene.nodes[naryNode].leftChildIndex)
+		{
+			nodeRegisters[naryNode] = instruction.output;
+			lastUse[i] = -1; // The register now belongs to the n-ary operation
+		}
+		else if (naryNode >= 0)
+		{
+			Instruction fold{scene.nodes[naryNode].type == SHADER_TYPE_NARY_UNION ? OpCode::Union : OpCode::Intersection, nodeRegisters[naryNode]};
+			fold.left = nodeRegisters[naryNode];
+			fold.right = instruction.output;
+			_instructions.push_back(fold);
+		}
+		release(i, i); // Result never read
+	}
+	_resultRegister = nodeRegisters[scene.nbNode - 1];
+}
+
+std::shared_ptr<const CSGCompiledProgram> CSGProgramCache::getProgram(const CSGSceneView& scene)
+{
+	const uint64_t topology = CSGShaderGenerator::topologyHash(scene);
+	{
+		std::lock_guard<std::mutex> lock{_mutex};
+		auto found = _programs.find(topology);
+		if (found != _programs.end())
+		{
+			_nbHit++;
+			return found->second;
+		}
+	}
+
+	// Compiled outside of the lock, a concurrent compilation of the same topology keeps the first program
+	auto program = std::make_shared<const CSGCompiledProgram>(scene);
+	std::lock_guard<std::mutex> lock{_mutex};
+	_nbCompilation++;
+	return _programs.emplace(topology, std::move(program)).first->second;
+}
+
+void CSGProgramCache::clear()
+{
+	std::lock_guard<std::mutex> lock{_mutex};
+	_programs.clear();
+}
+
+size_t CSGProgramCache::size() const
+{
+	std::lock_guard<std::mutex> lock{_mutex};
+	return _programs.size();
+}
+
+long long CSGProgramCache::getNbHit() const
+{
+	std::lock_guard<std::mutex> lock{_mutex};
+	return _nbHit;
+}
+
+long long CSGProgramCache::getNbCompilation() const
+{
+	std::lock_guard<std::mutex> lock{_mutex};
+	return _nbCompilation;
+}
+
+CSGCompiledEvaluator::CSGCompiledEvaluator(const CSGSceneView& scene, std::shared_ptr<const CSGCompiledProgram> program) :
+	_program{std::move(program)},
+	_registers(static_cast<size_t>(_program->getNbRegister()) * BATCH_SIZE),
+	_winners(static_cast<size_t>(_program->getNbRegister()) * BATCH_SIZE)
+{
+	_leaves.reserve(_program->getLeafNodes().size());
+	for (const int nodeIndex : _program->getLeafNodes())
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+		const glm::mat3x4* inverseTransform;
+		BoundLeaf leaf{};
+
+		switch (node.type)
+		{
+		case SHADER_TYPE_SPHERE:
+		{
+			const SphereData& sphere = scene.spheres[node.primitiveIndex];
+			inverseTransform = &sphere.inverseTransform;
+			leaf.scale = sphere.scale;
+			leaf.color = sphere.color;
+			leaf.parameters[0] = sphere.radius;
+			break;
+		}
+		case SHADER_TYPE_TORUS:
+		{
+			const TorusData& torus = scene.toruses[node.primitiveIndex];
+			inverseTransform = &torus.inverseTransform;
+			leaf.scale = torus.scale;
+			leaf.color = torus.color;
+			leaf.parameters[0] = torus.majorRadius;
+			leaf.parameters[1] = torus.minorRadius;
+			break;
+		}
+		case SHADER_TYPE_CYLINDER:
+		{
+			const CylinderData& cylinder = scene.cylinders[node.primitiveIndex];
+			inverseTransform = &cylinder.inverseTransform;
+			leaf.scale = cylinder.scale;
+			leaf.color = cylinder.color;
+			leaf.parameters[0] = cylinder.radius;
+			leaf.parameters[1] = cylinder.height;
+			break;
+		}
+		case SHADER_TYPE_BOX:
+		default:
+		{
+			const BoxData& box = scene.boxes[node.primitiveIndex];
+			inverseTransform = &box.inverseTransform;
+			leaf.scale = box.scale;
+			leaf.color = box.color;
+			leaf.parameters[0] = box.size.x;
+			leaf.parameters[1] = box.size.y;
+			leaf.parameters[2] = box.size.z;
+			break;
+		}
+		}
+
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				leaf.rows[row][column] = (*inverseTransform)[row][column];
+		}
+		_leaves.push_back(leaf);
+	}
+}
+
+/*
+* Batch kernels. Each one is a loop without branches over the points of the batch, written with the same operations as the
+* SDFs of CSGPrimitiveSDF.hpp
+*/
+static void transformBatch(const float rows[3][4], const float* x, const float* y, const float* z, const int nbPoint, float* lx, float* ly, float* lz)
+{
+	for (int k = 0; k < nbPoint; k++)
+	{
+		lx[k] = (rows[0][0] * x[k] + rows[0][1] * y[k]) + (rows[0][2] * z[k] + rows[0][3]);
+		ly[k] = (rows[1][0] * x[k] + rows[1][1] * y[k]) + (rows[1][2] * z[k] + rows[1][3]);
+		lz[k] = (rows[2][0] * x[k] + rows[2][1] * y[k]) + (rows[2][2] * z[k] + rows[2][3]);
+	}
+}
+
+template<OpCode opCode>
+static void primitiveBatch(const float* parameters, const float scale, const float* x, const float* y, const float* z, const int nbPoint, float* out)
+{
+	for (int k = 0; k < nbPoint; k++)
+	{
+		float dist;
+		if constexpr (opCode == OpCode::Sphere)
+		{
+			dist = std::sqrt(x[k] * x[k] + y[k] * y[k] + z[k] * z[k]) - parameters[0];
+		}
+		else if constexpr (opCode == OpCode::Torus)
+		{
+			const float q = std::sqrt(x[k] * x[k] + z[k] * z[k]) - parameters[0];
+			dist = std::sqrt(q * q + y[k] * y[k]) - parameters[1];
+		}
+		else if constexpr (opCode == OpCode::Cylinder)
+		{
+			const float dx = std::sqrt(x[k] * x[k] + z[k] * z[k]) - parameters[0];
+			const float dy = std::abs(y[k]) - parameters[1];
+			const float ox = std::max(dx, 0.f);
+			const float oy = std::max(dy, 0.f);
+			dist = std::min(std::max(dx, dy), 0.f) + std::sqrt(ox * ox + oy * oy);
+		}
+		else
+		{
+			const float qx = std::abs(x[k]) - parameters[0];
+			const float qy = std::abs(y[k]) - parameters[1];
+			const float qz = std::abs(z[k]) - parameters[2];
+			const float ox = std::max(qx, 0.f);
+			const float oy = std::max(qy, 0.f);
+			const float oz = std::max(qz, 0.f);
+			dist = std::sqrt(ox * ox + oy * oy + oz * oz) + std::min(std::max(qx, std::max(qy, qz)), 0.f);
+		}
+		out[k] = dist * scale;
+	}
+}
+
+template<bool computeColor>
+void CSGCompiledEvaluator::runBatch(const glm::vec3* positions, const int nbPoint) const
+{
+	for (int k = 0; k < nbPoint; k++)
+	{
+		_x[k] = positions[k].x;
+		_y[k] = positions[k].y;
+		_z[k] = positions[k].z;
+	}
+
+	float lx[BATCH_SIZE];
+	float ly[BATCH_SIZE];
+	float lz[BATCH_SIZE];
+
+	for (const CSGCompiledProgram::Instruction& instruction : _program->getInstructions())
+	{
+		float* out = _registers.data() + instruction.output * BATCH_SIZE;
+		int* outWinner = _winners.data() + instruction.output * BATCH_SIZE;
+
+		switch (instruction.opCode)
+		{
+		case OpCode::Sphere:
+		case OpCode::Torus:
+		case OpCode::Cylinder:
+		case OpCode::Box:
+		{
+			const BoundLeaf& leaf = _leaves[instruction.leaf];
+			transformBatch(leaf.rows, _x, _y, _z, nbPoint, lx, ly, lz);
+			if (instruction.opCode == OpCode::Sphere)
+				primitiveBatch<OpCode::Sphere>(leaf.parameters, leaf.scale, lx, ly, lz, nbPoint, out);
+			else if (instruction.opCode == OpCode::Torus)
+				primitiveBatch<OpCode::Torus>(leaf.parameters, leaf.scale, lx, ly, lz, nbPoint, out);
+			else if (instruction.opCode == OpCode::Cylinder)
+				primitiveBatch<OpCode::Cylinder>(leaf.parameters, leaf.scale, lx, ly, lz, nbPoint, out);
+			else
+				primitiveBatch<OpCode::Box>(leaf.parameters, leaf.scale, lx, ly, lz, nbPoint, out);
+			if constexpr (computeColor)
+				std::fill(outWinner, outWinner + nbPoint, instruction.leaf);
+			break;
+		}
+		case OpCode::Intersection:
+		case OpCode::Union:
+		case OpCode::Difference:
+		{
+			const float* a = _registers.data() + instruction.left * BATCH_SIZE;
+			const float* b = _registers.data() + instruction.right * BATCH_SIZE;
+			const int* aWinner = _winners.data() + instruction.left * BATCH_SIZE;
+			const int* bWinner = _winners.data() + instruction.right * BATCH_SIZE;
+			for (int k = 0; k < nbPoint; k++)
+			{
+				const float aDist = a[k];
+				const float bDist = b[k];
+				float dist;
+				if (instruction.opCode == OpCode::Intersection)
+					dist = std::max(aDist, bDist);
+				else if (instruction.opCode == OpCode::Union)
+					dist = std::min(aDist, bDist);
+				else
+					dist = std::max(aDist, -bDist);
+				if constexpr (computeColor)
+					outWinner[k] = dist == aDist ? aWinner[k] : bWinner[k];
+				out[k] = dist;
+			}
+			break;
+		}
+		case OpCode::SmoothIntersection:
+		case OpCode::SmoothUnion:
+		case OpCode::SmoothDifference:
+		{
+			const float* a = _registers.data() + instruction.left * BATCH_SIZE;
+			const float* b = _registers.data() + instruction.right * BATCH_SIZE;
+			const int* aWinner = _winners.data() + instruction.left * BATCH_SIZE;
+			const int* bWinner = _winners.data() + instruction.right * BATCH_SIZE;
+			const float radius = instruction.blendRadius;
+			// Same formulas as CSGPrimitiveSDF.hpp: 'side' is 1 for the smooth min and -1 for the smooth max, 'sign' complements b for a difference
+			const float side = instruction.opCode == OpCode::SmoothUnion ? 1.f : -1.f;
+			const float sign = instruction.opCode == OpCode::SmoothDifference ? -1.f : 1.f;
+			for (int k = 0; k < nbPoint; k++)
+			{
+				const float aDist = a[k];
+				const float bDist = sign * b[k];
+				const float h = std::clamp(0.5f + side * 0.5f * (bDist - aDist) / radius, 0.f, 1.f);
+				if constexpr (computeColor)
+					outWinner[k] = h >= 0.5f ? aWinner[k] : bWinner[k];
+				out[k] = bDist + (aDist - bDist) * h - side * radius * h * (1.f - h);
+			}
+			break;
+		}
+		case OpCode::Complement:
+		{
+			const float* a = _registers.data() + instruction.left * BATCH_SIZE;
+			for (int k = 0; k < nbPoint; k++)
+				out[k] = -a[k];
+			if constexpr (computeColor)
+				std::fill(outWinner, outWinner + nbPoint, -1);
+			break;
+		}
+		case OpCode::Infinity:
+		default:
+			std::fill(out, out + nbPoint, std::numeric_limits<float>::infinity());
+			if constexpr (computeColor)
+				std::fill(outWinner, outWinner + nbPoint, -1);
+			break;
+		}
+	}
+}
+
+void CSGCompiledEvaluator::distances(const glm::vec3* positions, const int nbPoint, float* distances) const
+{
+	_nbEvaluation += nbPoint;
+	const int result = _program->getResultRegister();
+	if (result < 0)
+	{
+		std::fill(distances, distances + nbPoint, std::numeric_limits<float>::infinity());
+		return;
+	}
+
+	for (int first = 0; first < nbPoint; first += BATCH_SIZE)
+	{
+		const int batchSize = std::min(BATCH_SIZE, nbPoint - first);
+		runBatch<false>(positions + first, batchSize);
+		std::copy_n(_registers.data() + result * BATCH_SIZE, batchSize, distances + first);
+	}
+}
+
+void CSGCompiledEvaluator::evaluate(const glm::vec3* positions, const int nbPoint, CSGEvaluation* results) const
+{
+	_nbEvaluation += nbPoint;
+	const int result = _program->getResultRegister();
+	if (result < 0)
+	{
+		std::fill(results, results + nbPoint, CSGEvaluation{glm::vec3(0.f), std::numeric_limits<float>::infinity()});
+		return;
+	}
+
+	for (int first = 0; first < nbPoint; first += BATCH_SIZE)
+	{
+		const int batchSize = std::min(BATCH_SIZE, nbPoint - first);
+		runBatch<true>(positions + first, batchSize);
+		for (int k = 0; k < batchSize; k++)
+		{
+			const int winner = _winners[result * BATCH_SIZE + k];
+			results[first + k] = {winner < 0 ? glm::vec3(0.f) : _leaves[winner].color, _registers[result * BATCH_SIZE + k]};
+		}
+	}
+}
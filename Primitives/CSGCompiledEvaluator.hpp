@@ -0,0 +1,142 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+/*
+* Straight-line program computing the distance field of one CSG tree topology, the CPU counterpart of CSGShaderGenerator.
+* The node buffer is lowered once to a list of instructions working on registers of CSGCompiledProgram::BATCH_SIZE floats: the
+* switch on the node type, the child lookups and the record fetches are paid once per batch instead of once per point, and every
+* instruction is a plain loop over the batch that the compiler vectorizes.
+* Registers are reused as soon as the value they hold has been read by its last parent, so a balanced tree of n nodes only needs
+* O(log n) registers and the working set stays in the cache. An n-ary operation is lowered to a binary instruction per child, run
+* right after the child, so its children never need more than two registers.
+* Like the generated shaders, a program only depends on the node buffer: primitive parameters are bound by CSGCompiledEvaluator.
+*/
+class CSGCompiledProgram
+{
+public:
+	// Number of points evaluated together by each instruction
+	static constexpr int BATCH_SIZE = 64;
+
+	enum class OpCode : uint8_t
+	{
+		Sphere,
+		Torus,
+		Cylinder,
+		Box,
+		Intersection,
+		Union,
+		Difference,
+		Complement,
+		SmoothIntersection,
+		SmoothUnion,
+		SmoothDifference,
+		Infinity // Unknown node type, same result as an empty scene
+	};
+
+	struct Instruction
+	{
+		OpCode opCode;
+		int output;			// Register written
+		int left = -1;		// Registers read
+		int right = -1;
+		int leaf = -1;		// Index of the leaf in the order of the program, for primitive instructions
+		float blendRadius = 0.f; // Smooth operations, part of the node buffer and so of the topology
+	};
+
+	explicit CSGCompiledProgram(const CSGSceneView& scene);
+
+	[[nodiscard]] const std::vector<Instruction>& getInstructions() const { return _instructions; }
+	// Node index of each leaf, to bind the primitive records of a scene
+	[[nodiscard]] const std::vector<int>& getLeafNodes() const { return _leafNodes; }
+	[[nodiscard]] int getNbRegister() const { return _nbRegister; }
+	// Register holding the distance of the root, -1 for an empty scene
+	[[nodiscard]] int getResultRegister() const { return _resultRegister; }
+	[[nodiscard]] uint64_t getTopologyHash() const { return _topologyHash; }
+
+private:
+	std::vector<Instruction> _instructions;
+	std::vector<int> _leafNodes;
+	int _nbRegister = 0;
+	int _resultRegister = -1;
+	uint64_t _topologyHash = 0;
+};
+
+/*
+* Compiled programs shared between scenes of the same topology, keyed by the same hash as CSGShaderCache.
+* Safe to use from several render threads.
+*/
+class CSGProgramCache
+{
+public:
+	std::shared_ptr<const CSGCompiledProgram> getProgram(const CSGSceneView& scene);
+
+	void clear();
+
+	[[nodiscard]] size_t size() const;
+	[[nodiscard]] long long getNbHit() const;
+	[[nodiscard]] long long getNbCompilation() const;
+
+private:
+	mutable std::mutex _mutex;
+	std::unordered_map<uint64_t, std::shared_ptr<const CSGCompiledProgram>> _programs;
+	long long _nbHit = 0;
+	long long _nbCompilation = 0;
+};
+
+/*
+* Batch evaluator running a CSGCompiledProgram on the records of a scene.
+* Distances and colors follow the same rules as CSGEvaluator (the color is the one of the child responsible for the distance,
+* black for a complement); distances only differ by the rounding of the transform. Colors are not blended: a smooth operation takes
+* the color of the child with the larger weight.
+* An evaluator keeps its own registers, use one evaluator per thread.
+*/
+class CSGCompiledEvaluator
+{
+public:
+	// 'program' must have been compiled from a scene with the same topology as 'scene'
+	CSGCompiledEvaluator(const CSGSceneView& scene, std::shared_ptr<const CSGCompiledProgram> program);
+
+	// Signed distances of the scene at 'nbPoint' positions
+	void distances(const glm::vec3* positions, int nbPoint, float* distances) const;
+
+	// Distances and colors at 'nbPoint' positions
+	void evaluate(const glm::vec3* positions, int nbPoint, CSGEvaluation* results) const;
+
+	[[nodiscard]] const CSGCompiledProgram& getProgram() const { return *_program; }
+
+	// Number of points evaluated since the construction of the evaluator
+	[[nodiscard]] long long getNbEvaluation() const { return _nbEvaluation; }
+
+private:
+	/*
+	* Primitive record prepared for the batch loops: the three first rows of the inverse transform, the distance scale and the
+	* dimensions of the primitive (radius, major and minor radii, height and radius, or half size)
+	*/
+	struct BoundLeaf
+	{
+		float rows[3][4];
+		float scale;
+		float parameters[3];
+		glm::vec3 color;
+	};
+
+	template<bool computeColor>
+	void runBatch(const glm::vec3* positions, int nbPoint) const;
+
+	std::shared_ptr<const CSGCompiledProgram> _program;
+	std::vector<BoundLeaf> _leaves;
+	mutable std::vector<float> _registers;
+	mutable std::vector<int> _winners; // Leaf responsible for the distance in each register, -1 for black
+	mutable float _x[CSGCompiledProgram::BATCH_SIZE];
+	mutable float _y[CSGCompiledProgram::BATCH_SIZE];
+	mutable float _z[CSGCompiledProgram::BATCH_SIZE];
+	mutable long long _nbEvaluation = 0;
+};
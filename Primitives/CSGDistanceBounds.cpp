@@ -0,0 +1,151 @@
+#include "renderer/opengl/Primitives/CSGDistanceBounds.hpp"
+
+#include <algorithm>
+
+// Relative precision of the scale of the records: primitives whose singular values are this close to 1 after the scale correction are exact
+static constexpr float EXACT_TOLERANCE = 1e-4f;
+
+glm::vec2 CSGDistanceBounds::singularValueRange(const glm::mat3& matrix)
+{
+	// Square roots of the extreme eigenvalues of the symmetric matrix M^T M, in closed form (trigonometric solution of the cubic).
+	// M^T M holds the dot products of the columns, computed in double precision.
+	double m[3][3];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			m[i][j] = static_cast<double>(matrix[i].x) * matrix[j].x + static_cast<double>(matrix[i].y) * matrix[j].y + static_cast<double>(matrix[i].z) * matrix[j].z;
+
+	const double offDiagonal = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+	const double q = (m[0][0] + m[1][1] + m[2][2]) / 3.;
+	const double p2 = (m[0][0] - q) * (m[0][0] - q) + (m[1][1] - q) * (m[1][1] - q) + (m[2][2] - q) * (m[2][2] - q) + 2. * offDiagonal;
+	if (p2 <= 1e-24 * q * q)
+		return glm::vec2(static_cast<float>(std::sqrt(std::max(q, 0.))));
+
+	// Eigenvalues of B = (M^T M - q I) / p are 2 cos(phi + 2k pi / 3) with cos(3 phi) = det(B) / 2
+	const double p = std::sqrt(p2 / 6.);
+	double b[3][3];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			b[i][j] = (m[i][j] - (i == j ? q : 0.)) / p;
+	const double determinant = b[0][0] * (b[1][1] * b[2][2] - b[1][2] * b[2][1]) - b[0][1] * (b[1][0] * b[2][2] - b[1][2] * b[2][0])
+		+ b[0][2] * (b[1][0] * b[2][1] - b[1][1] * b[2][0]);
+	const double r = std::clamp(determinant / 2., -1., 1.);
+	const double phi = std::acos(r) / 3.;
+	const double largestEigenvalue = q + 2. * p * std::cos(phi);
+	const double smallestEigenvalue = q + 2. * p * std::cos(phi + 2.0943951023931957);
+	return glm::vec2(static_cast<float>(std::sqrt(std::max(smallestEigenvalue, 0.))), static_cast<float>(std::sqrt(std::max(largestEigenvalue, 0.))));
+}
+
+DistanceBound CSGDistanceBounds::leafBound(const glm::mat3x4& inverseTransform, const float scale)
+{
+	// The local SDF is exact, and a local displacement is between the smallest and the largest singular value times the world one.
+	// The rows hold the transpose of the linear part, which has the same singular values.
+	const glm::vec2 lipschitzRange = scale * singularValueRange(glm::mat3(inverseTransform));
+	DistanceBound bound;
+	const bool exact = std::abs(lipschitzRange.x - 1.f) <= EXACT_TOLERANCE && std::abs(lipschitzRange.y - 1.f) <= EXACT_TOLERANCE;
+	bound.exactOutside = exact;
+	bound.exactInside = exact;
+	// Margin for the rounding of the record: never claim a Lipschitz constant below the one of the float computation
+	bound.lipschitz = exact ? 1.f : lipschitzRange.y * (1.f + EXACT_TOLERANCE);
+	return bound;
+}
+
+static DistanceBound recordBound(const CSGSceneView& scene, const CSGNode::ShaderNodeData& node)
+{
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+	{
+		const SphereData& sphere = scene.spheres[node.primitiveIndex];
+		return CSGDistanceBounds::leafBound(sphere.inverseTransform, sphere.scale);
+	}
+	case SHADER_TYPE_TORUS:
+	{
+		const TorusData& torus = scene.toruses[node.primitiveIndex];
+		return CSGDistanceBounds::leafBound(torus.inverseTransform, torus.scale);
+	}
+	case SHADER_TYPE_CYLINDER:
+	{
+		const CylinderData& cylinder = scene.cylinders[node.primitiveIndex];
+		return CSGDistanceBounds::leafBound(cylinder.inverseTransform, cylinder.scale);
+	}
+	case SHADER_TYPE_BOX:
+	{
+		const BoxData& box = scene.boxes[node.primitiveIndex];
+		return CSGDistanceBounds::leafBound(box.inverseTransform, box.scale);
+	}
+	default:
+		return DistanceBound{};
+	}
+}
+
+std::vector<DistanceBound> CSGDistanceBounds::nodeBounds(const CSGSceneView& scene)
+{
+	std::vector<DistanceBound> bounds(scene.nbNode);
+
+	// Postorder buffer: children are always before their parent
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		DistanceBound& bound = bounds[i];
+		switch (node.type)
+		{
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_DIFFERENCE:
+		{
+			const DistanceBound& left = bounds[node.leftChildIndex];
+			const DistanceBound& right = bounds[node.rightChildIndex];
+			bound.lipschitz = std::max(left.lipschitz, right.lipschitz);
+			// The min of exact distances is the exact distance to the union outside of both operands, and symmetrically for the max inside
+			bound.exactOutside = node.type == SHADER_TYPE_UNION && left.exactOutside && right.exactOutside;
+			bound.exactInside = node.type == SHADER_TYPE_INTERSECTION ? left.exactInside && right.exactInside
+				: node.type == SHADER_TYPE_DIFFERENCE && left.exactInside && right.exactOutside;
+			break;
+		}
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		{
+			// The gradient of the blend is a convex combination of the gradients of the children: same Lipschitz constant, never exact
+			bound.lipschitz = std::max(bounds[node.leftChildIndex].lipschitz, bounds[node.rightChildIndex].lipschitz);
+			bound.exactOutside = false;
+			bound.exactInside = false;
+			break;
+		}
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+		{
+			// Same as the chain of binary operations
+			bound.lipschitz = 0.f;
+			bound.exactOutside = node.type == SHADER_TYPE_NARY_UNION;
+			bound.exactInside = node.type == SHADER_TYPE_NARY_INTERSECTION;
+			for (int child = node.leftChildIndex; child <= node.rightChildIndex; child++)
+			{
+				bound.lipschitz = std::max(bound.lipschitz, bounds[child].lipschitz);
+				bound.exactOutside = bound.exactOutside && bounds[child].exactOutside;
+				bound.exactInside = bound.exactInside && bounds[child].exactInside;
+			}
+			break;
+		}
+		case SHADER_TYPE_COMPLEMENTARY:
+		{
+			const DistanceBound& child = bounds[node.leftChildIndex];
+			bound.lipschitz = child.lipschitz;
+			bound.exactOutside = child.exactInside;
+			bound.exactInside = child.exactOutside;
+			break;
+		}
+		default:
+			bound = recordBound(scene, node);
+			break;
+		}
+	}
+	return bounds;
+}
+
+DistanceBound CSGDistanceBounds::rootBound(const CSGSceneView& scene)
+{
+	if (scene.isEmpty())
+		return DistanceBound{};
+	return nodeBounds(scene).back();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+
+/*
+* What the distance computed by the evaluators for a node guarantees.
+* The distance d(p) of every node is 'lipschitz'-Lipschitz and zero on the surface of the node, so |d(p)| / lipschitz is always a lower
+* bound of the distance from p to the surface. Where the node is exact, d(p) is the signed euclidean distance itself.
+*/
+struct DistanceBound
+{
+	float lipschitz = 1.f;
+	bool exactOutside = true; // Exact for the points where d(p) > 0
+	bool exactInside = true; // Exact for the points where d(p) <= 0
+
+	[[nodiscard]] bool isExact(const float dist) const { return dist > 0.f ? exactOutside : exactInside; }
+	// Radius of a sphere around the point that does not cross the surface
+	[[nodiscard]] float safeRadius(const float dist) const { return std::abs(dist) / lipschitz; }
+};
+
+/*
+* Static analysis of the distance field of a serialized CSG tree, for the marchers.
+* The distance of a primitive is scale * sdf(inverseTransform * p), whose Lipschitz constant is its scale times the largest singular value
+* of the inverse transform: 1 with the scale of distanceScale(). It is exact when the transform is rigid or uniformly scaled, and
+* otherwise underestimates the distance along some directions.
+* Union is exact outside and a bound inside, Intersection is exact inside and a bound outside, Difference is an intersection with a
+* complement, and Complement swaps inside and outside. The Lipschitz constant of an operation is the max of those of its children, smooth
+* operations included, which are never exact.
+*/
+class CSGDistanceBounds
+{
+public:
+	// Smallest and largest singular values of 'matrix'
+	static glm::vec2 singularValueRange(const glm::mat3& matrix);
+
+	// Bound of the distance of a primitive, from the inverse transform and the scale of its record
+	static DistanceBound leafBound(const glm::mat3x4& inverseTransform, float scale);
+
+	// Bound of every node of the postorder buffer (same indexing)
+	static std::vector<DistanceBound> nodeBounds(const CSGSceneView& scene);
+
+	// Bound of the root, the default (exact) bound for an empty scene
+	static DistanceBound rootBound(const CSGSceneView& scene);
+};
@@ -0,0 +1,458 @@
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+#include "renderer/opengl/Primitives/CSGShortCircuit.hpp"
+
+#include <limits>
+#include <algorithm>
+
+/*
+* Gradients of the primitive SDFs in local space (unit vectors, except on the degenerated points of the SDF)
+*/
+static glm::vec3 safeNormalize(const glm::vec3& v)
+{
+	const float length = glm::length(v);
+	return length > 0.f ? v / length : glm::vec3(0.f, 1.f, 0.f);
+}
+
+static glm::vec3 sphereGradient(const glm::vec3& p)
+{
+	return safeNormalize(p);
+}
+
+static glm::vec3 torusGradient(const TorusData& torus, const glm::vec3& p)
+{
+	const float radialLength = glm::length(glm::vec2(p.x, p.z));
+	const glm::vec2 radialDirection = radialLength > 0.f ? glm::vec2(p.x, p.z) / radialLength : glm::vec2(1.f, 0.f);
+	const glm::vec2 q{radialLength - torus.majorRadius, p.y}; // Position in the plane of the tube section
+	const float qLength = glm::length(q);
+	const glm::vec2 sectionGradient = qLength > 0.f ? q / qLength : glm::vec2(1.f, 0.f);
+	return glm::vec3(sectionGradient.x * radialDirection.x, sectionGradient.y, sectionGradient.x * radialDirection.y);
+}
+
+// Gradient of the SDF of a 2D box whose distance vector to the corner is 'w', in the quadrant of the point
+static glm::vec2 boxGradient2D(const glm::vec2& w)
+{
+	if (std::max(w.x, w.y) > 0.f) // Outside: direction to the closest point of the box
+		return glm::normalize(glm::max(w, glm::vec2(0.f)));
+	return w.x > w.y ? glm::vec2(1.f, 0.f) : glm::vec2(0.f, 1.f); // Inside: normal of the closest face
+}
+
+static glm::vec3 cylinderGradient(const CylinderData& cylinder, const glm::vec3& pos)
+{
+	const float radialLength = glm::length(glm::vec2(pos.x, pos.z));
+	const glm::vec2 radialDirection = radialLength > 0.f ? glm::vec2(pos.x, pos.z) / radialLength : glm::vec2(1.f, 0.f);
+	const glm::vec2 gradient2D = boxGradient2D(glm::vec2(radialLength, std::abs(pos.y)) - glm::vec2(cylinder.radius, cylinder.height));
+	return glm::vec3(gradient2D.x * radialDirection.x, pos.y < 0.f ? -gradient2D.y : gradient2D.y, gradient2D.x * radialDirection.y);
+}
+
+static glm::vec3 boxGradient(const BoxData& box, const glm::vec3& pos)
+{
+	const glm::vec3 w = glm::abs(pos) - box.size;
+	const float g = std::max(w.x, std::max(w.y, w.z));
+
+	glm::vec3 quadrantGradient;
+	if (g > 0.f) // Outside: direction to the closest point of the box
+		quadrantGradient = glm::normalize(glm::max(w, glm::vec3(0.f)));
+	else if (w.x > w.y && w.x > w.z) // Inside: normal of the closest face
+		quadrantGradient = glm::vec3(1.f, 0.f, 0.f);
+	else if (w.y > w.z)
+		quadrantGradient = glm::vec3(0.f, 1.f, 0.f);
+	else
+		quadrantGradient = glm::vec3(0.f, 0.f, 1.f);
+
+	return glm::vec3(pos.x < 0.f ? -quadrantGradient.x : quadrantGradient.x,
+		pos.y < 0.f ? -quadrantGradient.y : quadrantGradient.y,
+		pos.z < 0.f ? -quadrantGradient.z : quadrantGradient.z);
+}
+
+// Move the ray instead of the primitive, and return the scale correction of the distance, precomputed in the record
+template<typename Data>
+static glm::vec3 transformRay(const glm::vec3& worldPos, const Data& primitive, float& scale)
+{
+	scale = primitive.scale;
+	return transformPoint(primitive.inverseTransform, worldPos);
+}
+
+// Bring a local gradient back to world space: d(world) = scale * d(inverseTransform * world). The rows of the record are the columns of
+// the transposed linear part.
+static glm::vec3 transformGradient(const glm::vec3& localGradient, const glm::mat3x4& inverseTransform, const float scale)
+{
+	return scale * (glm::mat3(inverseTransform) * localGradient);
+}
+
+CSGEvaluator::CSGEvaluator(const CSGSceneView& scene) :
+	_scene{scene},
+	_nodeStack(scene.nbNode),
+	_gradientStack(scene.nbNode),
+	_distance4Stack(scene.nbNode)
+{
+}
+
+template<bool computeGradient, bool computeBound>
+void CSGEvaluator::scanCSG(const int nodeIndex, const glm::vec3& pos) const
+{
+	const CSGNode::ShaderNodeData& node = _scene.nodes[nodeIndex];
+	CSGEvaluation& result = _nodeStack[nodeIndex];
+	float scale;
+
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+	{
+		const SphereData& sphere = _scene.spheres[node.primitiveIndex];
+		const glm::vec3 localPos = transformRay(pos, sphere, scale);
+		result.color = sphere.color;
+		result.dist = sphereSDF(sphere, localPos) * scale;
+		if constexpr (computeGradient)
+			_gradientStack[nodeIndex] = transformGradient(sphereGradient(localPos), sphere.inverseTransform, scale);
+		break;
+	}
+	case SHADER_TYPE_TORUS:
+	{
+		const TorusData& torus = _scene.toruses[node.primitiveIndex];
+		const glm::vec3 localPos = transformRay(pos, torus, scale);
+		result.color = torus.color;
+		result.dist = torusSDF(torus, localPos) * scale;
+		if constexpr (computeGradient)
+			_gradientStack[nodeIndex] = transformGradient(torusGradient(torus, localPos), torus.inverseTransform, scale);
+		break;
+	}
+	case SHADER_TYPE_CYLINDER:
+	{
+		const CylinderData& cylinder = _scene.cylinders[node.primitiveIndex];
+		const glm::vec3 localPos = transformRay(pos, cylinder, scale);
+		result.color = cylinder.color;
+		result.dist = cylinderSDF(cylinder, localPos) * scale;
+		if constexpr (computeGradient)
+			_gradientStack[nodeIndex] = transformGradient(cylinderGradient(cylinder, localPos), cylinder.inverseTransform, scale);
+		break;
+	}
+	case SHADER_TYPE_BOX:
+	{
+		const BoxData& box = _scene.boxes[node.primitiveIndex];
+		const glm::vec3 localPos = transformRay(pos, box, scale);
+		result.color = box.color;
+		result.dist = boxSDF(box, localPos) * scale;
+		if constexpr (computeGradient)
+			_gradientStack[nodeIndex] = transformGradient(boxGradient(box, localPos), box.inverseTransform, scale);
+		break;
+	}
+	case SHADER_TYPE_INTERSECTION:
+	case SHADER_TYPE_UNION:
+	case SHADER_TYPE_DIFFERENCE:
+	{
+		const CSGEvaluation& a = _nodeStack[node.leftChildIndex];
+		const CSGEvaluation& b = _nodeStack[node.rightChildIndex];
+
+		float dist;
+		if (node.type == SHADER_TYPE_INTERSECTION)
+			dist = std::max(a.dist, b.dist);
+		else if (node.type == SHADER_TYPE_UNION)
+			dist = std::min(a.dist, b.dist);
+		else
+			dist = std::max(a.dist, -b.dist);
+
+		// The color is the one of the child responsible for the distance, as in the shader
+		result.color = dist == a.dist ? a.color : b.color;
+		result.dist = dist;
+
+		// min and max are piecewise: the gradient is the one of the selected child (negated for the right child of a difference)
+		if constexpr (computeGradient)
+		{
+			if (dist == a.dist)
+				_gradientStack[nodeIndex] = _gradientStack[node.leftChildIndex];
+			else if (node.type == SHADER_TYPE_DIFFERENCE)
+				_gradientStack[nodeIndex] = -_gradientStack[node.rightChildIndex];
+			else
+				_gradientStack[nodeIndex] = _gradientStack[node.rightChildIndex];
+		}
+		break;
+	}
+	case SHADER_TYPE_SMOOTH_INTERSECTION:
+	case SHADER_TYPE_SMOOTH_UNION:
+	case SHADER_TYPE_SMOOTH_DIFFERENCE:
+	{
+		const CSGEvaluation& a = _nodeStack[node.leftChildIndex];
+		const CSGEvaluation& b = _nodeStack[node.rightChildIndex];
+
+		// The blend weights the colors and the gradients of both children
+		float h;
+		result.dist = smoothOperationSDF(node.type, a.dist, b.dist, blendRadius(node), h);
+		result.color = b.color + (a.color - b.color) * h;
+		if constexpr (computeGradient)
+		{
+			const glm::vec3& gradientB = _gradientStack[node.rightChildIndex];
+			_gradientStack[nodeIndex] = h * _gradientStack[node.leftChildIndex] + (1.f - h) * (node.type == SHADER_TYPE_SMOOTH_DIFFERENCE ? -gradientB : gradientB);
+		}
+		break;
+	}
+	case SHADER_TYPE_NARY_INTERSECTION:
+	case SHADER_TYPE_NARY_UNION:
+	{
+		// The first leaf giving the distance wins, as the leftmost operand of a chain of binary operations
+		const bool unionNode = node.type == SHADER_TYPE_NARY_UNION;
+		int selected = node.leftChildIndex;
+		for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+		{
+			const float dist = _nodeStack[child].dist;
+			if (unionNode ? dist < _nodeStack[selected].dist : dist > _nodeStack[selected].dist)
+				selected = child;
+		}
+		result = _nodeStack[selected];
+		if constexpr (computeGradient)
+			_gradientStack[nodeIndex] = _gradientStack[selected];
+		break;
+	}
+	case SHADER_TYPE_COMPLEMENTARY:
+	{
+		result.color = glm::vec3(0.f);
+		result.dist = -_nodeStack[node.leftChildIndex].dist;
+		if constexpr (computeGradient)
+			_gradientStack[nodeIndex] = -_gradientStack[node.leftChildIndex];
+		break;
+	}
+	default:
+		break;
+	}
+
+	if constexpr (computeBound)
+		scanBound(nodeIndex);
+}
+
+void CSGEvaluator::scanCSG4(const int nodeIndex, const std::array<glm::vec3, 4>& positions) const
+{
+	const CSGNode::ShaderNodeData& node = _scene.nodes[nodeIndex];
+	glm::vec4& result = _distance4Stack[nodeIndex];
+	float scale;
+
+	// The record and its scale correction are shared by the four points, only the point transform and the SDF are done four times
+	auto evaluatePrimitive = [&](const auto& primitive, auto sdf)
+	{
+		const glm::vec3 localPos0 = transformRay(positions[0], primitive, scale);
+		const glm::mat3x4& inverseTransform = primitive.inverseTransform;
+		result = glm::vec4(sdf(primitive, localPos0),
+			sdf(primitive, transformPoint(inverseTransform, positions[1])),
+			sdf(primitive, transformPoint(inverseTransform, positions[2])),
+			sdf(primitive, transformPoint(inverseTransform, positions[3]))) * scale;
+	};
+
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+		evaluatePrimitive(_scene.spheres[node.primitiveIndex], sphereSDF);
+		break;
+	case SHADER_TYPE_TORUS:
+		evaluatePrimitive(_scene.toruses[node.primitiveIndex], torusSDF);
+		break;
+	case SHADER_TYPE_CYLINDER:
+		evaluatePrimitive(_scene.cylinders[node.primitiveIndex], cylinderSDF);
+		break;
+	case SHADER_TYPE_BOX:
+		evaluatePrimitive(_scene.boxes[node.primitiveIndex], boxSDF);
+		break;
+	case SHADER_TYPE_INTERSECTION:
+		result = glm::max(_distance4Stack[node.leftChildIndex], _distance4Stack[node.rightChildIndex]);
+		break;
+	case SHADER_TYPE_UNION:
+		result = glm::min(_distance4Stack[node.leftChildIndex], _distance4Stack[node.rightChildIndex]);
+		break;
+	case SHADER_TYPE_DIFFERENCE:
+		result = glm::max(_distance4Stack[node.leftChildIndex], -_distance4Stack[node.rightChildIndex]);
+		break;
+	case SHADER_TYPE_COMPLEMENTARY:
+		result = -_distance4Stack[node.leftChildIndex];
+		break;
+	case SHADER_TYPE_NARY_INTERSECTION:
+		result = _distance4Stack[node.leftChildIndex];
+		for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			result = glm::max(result, _distance4Stack[child]);
+		break;
+	case SHADER_TYPE_NARY_UNION:
+		result = _distance4Stack[node.leftChildIndex];
+		for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			result = glm::min(result, _distance4Stack[child]);
+		break;
+	case SHADER_TYPE_SMOOTH_INTERSECTION:
+	case SHADER_TYPE_SMOOTH_UNION:
+	case SHADER_TYPE_SMOOTH_DIFFERENCE:
+	{
+		const glm::vec4& a = _distance4Stack[node.leftChildIndex];
+		const glm::vec4& b = _distance4Stack[node.rightChildIndex];
+		const float k = blendRadius(node);
+		float h;
+		for (int i = 0; i < 4; i++)
+			result[i] = smoothOperationSDF(node.type, a[i], b[i], k, h);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+CSGEvaluation CSGEvaluator::scanSDF(const glm::vec3& pos) const
+{
+	_nbEvaluation++;
+	if (_scene.isEmpty())
+		return {glm::vec3(0.f), std::numeric_limits<float>::infinity()};
+
+	// The first node of the buffer is a leaf and the last one is the root: a single forward pass evaluates the whole tree
+	for (int i = 0; i < _scene.nbNode; i++)
+		scanCSG<false, false>(i, pos);
+
+	return _nodeStack[_scene.nbNode - 1];
+}
+
+CSGGradientEvaluation CSGEvaluator::scanSDFGradient(const glm::vec3& pos) const
+{
+	_nbEvaluation++;
+	if (_scene.isEmpty())
+		return {glm::vec3(0.f), std::numeric_limits<float>::infinity(), glm::vec3(0.f)};
+
+	for (int i = 0; i < _scene.nbNode; i++)
+		scanCSG<true, false>(i, pos);
+
+	const CSGEvaluation& root = _nodeStack[_scene.nbNode - 1];
+	return {root.color, root.dist, _gradientStack[_scene.nbNode - 1]};
+}
+
+glm::vec4 CSGEvaluator::scanSDF4(const std::array<glm::vec3, 4>& positions) const
+{
+	_nbEvaluation += 4;
+	if (_scene.isEmpty())
+		return glm::vec4(std::numeric_limits<float>::infinity());
+
+	for (int i = 0; i < _scene.nbNode; i++)
+		scanCSG4(i, positions);
+
+	return _distance4Stack[_scene.nbNode - 1];
+}
+
+/*
+* Safe radius and exactness of the union or intersection of two operands at distances 'a' and 'b', 'dist' being the distance of the
+* operation. The right operand of a difference is passed complemented: same radius and exactness, opposite side.
+*/
+static void operationBound(const bool unionNode, const float dist, const float a, const float radiusA, const uint8_t exactA, const float b,
+	const float radiusB, const uint8_t exactB, float& radius, uint8_t& exact)
+{
+	// A union is the complement of the intersection of the complements: only the side changes
+	if (unionNode ? dist > 0.f : dist <= 0.f)
+	{
+		// On the side where both operands agree: the closest of the two surfaces
+		radius = std::min(radiusA, radiusB);
+		exact = exactA & exactB;
+	}
+	else
+	{
+		// At least one operand alone puts the point on this side, the farthest of their surfaces bounds the node
+		const bool sideA = unionNode ? a <= 0.f : a > 0.f;
+		const bool sideB = unionNode ? b <= 0.f : b > 0.f;
+		radius = std::max(sideA ? radiusA : 0.f, sideB ? radiusB : 0.f);
+		exact = 0;
+	}
+}
+
+void CSGEvaluator::scanBound(const int nodeIndex) const
+{
+	const CSGNode::ShaderNodeData& node = _scene.nodes[nodeIndex];
+	const float dist = _nodeStack[nodeIndex].dist;
+	float& radius = _radiusStack[nodeIndex];
+	uint8_t& exact = _exactStack[nodeIndex];
+
+	if (isLeafType(node.type))
+	{
+		const DistanceBound& bound = _distanceBounds[nodeIndex];
+		radius = bound.safeRadius(dist);
+		exact = bound.isExact(dist);
+	}
+	else if (node.type == SHADER_TYPE_COMPLEMENTARY)
+	{
+		radius = _radiusStack[node.leftChildIndex];
+		exact = _exactStack[node.leftChildIndex];
+	}
+	else if (isSmoothOperation(node.type))
+	{
+		// The blend is never exact, only its Lipschitz constant (the one of the children) bounds it
+		radius = _distanceBounds[nodeIndex].safeRadius(dist);
+		exact = 0;
+	}
+	else if (isNaryOperation(node.type))
+	{
+		// Same rules as the chain of binary operations, folded over the leaves
+		const bool unionNode = node.type == SHADER_TYPE_NARY_UNION;
+		float accumulated = _nodeStack[node.leftChildIndex].dist;
+		radius = _radiusStack[node.leftChildIndex];
+		exact = _exactStack[node.leftChildIndex];
+		for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+		{
+			const float b = _nodeStack[child].dist;
+			const float combined = unionNode ? std::min(accumulated, b) : std::max(accumulated, b);
+			operationBound(unionNode, combined, accumulated, radius, exact, b, _radiusStack[child], _exactStack[child], radius, exact);
+			accumulated = combined;
+		}
+	}
+	else
+	{
+		const float a = _nodeStack[node.leftChildIndex].dist;
+		const float b = node.type == SHADER_TYPE_DIFFERENCE ? -_nodeStack[node.rightChildIndex].dist : _nodeStack[node.rightChildIndex].dist;
+		operationBound(node.type == SHADER_TYPE_UNION, dist, a, _radiusStack[node.leftChildIndex], _exactStack[node.leftChildIndex], b,
+			_radiusStack[node.rightChildIndex], _exactStack[node.rightChildIndex], radius, exact);
+	}
+}
+
+CSGBoundEvaluation CSGEvaluator::scanSDFBound(const glm::vec3& pos) const
+{
+	_nbEvaluation++;
+	if (_scene.isEmpty())
+		return {glm::vec3(0.f), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), false};
+
+	if (_distanceBounds.empty())
+	{
+		_distanceBounds = CSGDistanceBounds::nodeBounds(_scene);
+		_radiusStack.resize(_scene.nbNode);
+		_exactStack.resize(_scene.nbNode);
+	}
+
+	for (int i = 0; i < _scene.nbNode; i++)
+		scanCSG<false, true>(i, pos);
+
+	const int root = _scene.nbNode - 1;
+	return {_nodeStack[root].color, _nodeStack[root].dist, _radiusStack[root], _exactStack[root] != 0};
+}
+
+CSGEvaluation CSGEvaluator::scanSDFShortCircuit(const glm::vec3& pos) const
+{
+	_nbEvaluation++;
+	if (_scene.isEmpty())
+		return {glm::vec3(0.f), std::numeric_limits<float>::infinity()};
+
+	if (!_shortCircuit)
+		_shortCircuit = std::make_shared<const CSGShortCircuit>(_scene);
+	const CSGShortCircuit& plan = *_shortCircuit;
+	// Without guards, the order of the buffer gives the same result without the indirection
+	if (plan.getNbGuard() == 0)
+	{
+		for (int i = 0; i < _scene.nbNode; i++)
+			scanCSG<false, false>(i, pos);
+		return _nodeStack[_scene.nbNode - 1];
+	}
+
+	const std::vector<int>& order = plan.getOrder();
+	const float margin = CSGShortCircuit::guardMargin(pos);
+
+	// The nodes keep their slot of the stack, only the order changes. A skipped child gets a distance its parent does not select.
+	for (int position = 0; position < _scene.nbNode; position++)
+	{
+		const int operation = plan.getGuard(position);
+		if (operation >= 0 && plan.canSkip(operation, pos, _nodeStack[plan.firstChild(operation)].dist, margin))
+		{
+			const int skipped = plan.secondChild(operation);
+			_nodeStack[skipped].dist = plan.skippedDistance(operation);
+			_nbSkippedNode += plan.getPosition(skipped) - position + 1;
+			position = plan.getPosition(skipped);
+			continue;
+		}
+		scanCSG<false, false>(order[position], pos);
+	}
+
+	return _nodeStack[_scene.nbNode - 1];
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGDistanceBounds.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <array>
+#include <memory>
+
+class CSGShortCircuit;
+
+/*
+* Result of the evaluation of a node, same as the 'SmallNode' struct of PrimitiveSceneSDF.glsl
+*/
+struct CSGEvaluation
+{
+	glm::vec3 color;
+	float dist;
+};
+
+/*
+* Result of the evaluation of a node with the gradient of its distance
+*/
+struct CSGGradientEvaluation
+{
+	glm::vec3 color;
+	float dist;
+	glm::vec3 gradient;
+};
+
+/*
+* Result of the evaluation of a node with what its distance guarantees at this point
+*/
+struct CSGBoundEvaluation
+{
+	glm::vec3 color;
+	float dist;
+	float safeRadius; // The surface is at least this far from the point
+	bool exact; // 'dist' is the signed euclidean distance to the surface, and 'safeRadius' its absolute value
+};
+
+/*
+* CPU evaluator of the signed distance field of a serialized CSG tree.
+* It interprets the postorder node buffer exactly like scanCSG() in PrimitiveSceneSDF.glsl, so the CPU and GPU paths give the same distances and colors.
+* An evaluator keeps its own node stack, use one evaluator per thread.
+*/
+class CSGEvaluator
+{
+public:
+	explicit CSGEvaluator(const CSGSceneView& scene);
+
+	// Return the signed distance of the whole scene at 'pos' and the color of the primitive responsible for it
+	CSGEvaluation scanSDF(const glm::vec3& pos) const;
+
+	/*
+	* Same as scanSDF(), but also return the gradient of the distance, computed analytically in the same pass.
+	* Primitive gradients are brought back to world space with the inverse transform, and min/max/negate nodes forward the gradient of the child they select,
+	* smooth operations blend the gradients of their children with the weights of their distances.
+	*/
+	CSGGradientEvaluation scanSDFGradient(const glm::vec3& pos) const;
+
+	/*
+	* Distances at four points in a single pass over the tree: each primitive record is fetched and its scale correction computed once
+	* for the four points, which is what normal estimators need (colors are not computed).
+	*/
+	glm::vec4 scanSDF4(const std::array<glm::vec3, 4>& positions) const;
+
+	/*
+	* Same as scanSDF(), but also track per node a radius around the point that does not cross the surface of the node, and whether the
+	* distance is exact there (see CSGDistanceBounds). A primitive gives its distance divided by its Lipschitz constant. Outside of a
+	* union, the radius is the min of the radii of the children, inside it is the max of the radii of the children containing the point;
+	* intersections are the other way around, differences are intersections with a complement. Smooth operations only use their Lipschitz constant.
+	* Unlike a single Lipschitz constant for the whole scene, a badly scaled primitive only shortens the steps taken near it.
+	*/
+	CSGBoundEvaluation scanSDFBound(const glm::vec3& pos) const;
+
+	/*
+	* Same result as scanSDF(), in the order of a CSGShortCircuit plan built by the first call: the children of intersections and
+	* differences that the bounds prove irrelevant at 'pos' are skipped with their whole subtree.
+	*/
+	CSGEvaluation scanSDFShortCircuit(const glm::vec3& pos) const;
+
+	[[nodiscard]] const CSGSceneView& getScene() const { return _scene; }
+
+	// Number of points evaluated since the construction of the evaluator (a call to scanSDF4() counts for four)
+	[[nodiscard]] long long getNbEvaluation() const { return _nbEvaluation; }
+	// Nodes skipped by scanSDFShortCircuit() since the construction of the evaluator
+	[[nodiscard]] long long getNbSkippedNode() const { return _nbSkippedNode; }
+
+private:
+	template<bool computeGradient, bool computeBound>
+	void scanCSG(int nodeIndex, const glm::vec3& pos) const;
+	void scanCSG4(int nodeIndex, const std::array<glm::vec3, 4>& positions) const;
+	void scanBound(int nodeIndex) const; // From the distance of the node and the bounds of its children
+
+	CSGSceneView _scene;
+	mutable std::vector<CSGEvaluation> _nodeStack;
+	mutable std::vector<glm::vec3> _gradientStack; // Gradient of each node, only filled by scanSDFGradient()
+	mutable std::vector<glm::vec4> _distance4Stack; // Four distances per node, only filled by scanSDF4()
+	mutable std::vector<DistanceBound> _distanceBounds; // Static bound of each node, computed by the first call to scanSDFBound()
+	mutable std::vector<float> _radiusStack; // Safe radius and exactness of each node, only filled by scanSDFBound()
+	mutable std::vector<uint8_t> _exactStack;
+	mutable std::shared_ptr<const CSGShortCircuit> _shortCircuit; // Built by the first call to scanSDFShortCircuit()
+	mutable long long _nbEvaluation = 0;
+	mutable long long _nbSkippedNode = 0;
+};
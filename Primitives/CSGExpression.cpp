@@ -0,0 +1,155 @@
+#include "renderer/opengl/Primitives/CSGExpression.hpp"
+
+#include <sstream>
+#include <functional>
+
+// Exact float literal
+static std::string floatLiteral(const float value)
+{
+	std::ostringstream stream;
+	stream << std::hexfloat << value << "f";
+	return stream.str();
+}
+
+static std::string vec3Literal(const glm::vec3& v)
+{
+	return "glm::vec3(" + floatLiteral(v.x) + ", " + floatLiteral(v.y) + ", " + floatLiteral(v.z) + ")";
+}
+
+static std::string mat3x4Literal(const glm::mat3x4& m)
+{
+	std::string literal = "glm::mat3x4(";
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 4; row++)
+			literal += floatLiteral(m[column][row]) + (column == 2 && row == 3 ? ")" : ", ");
+	}
+	return literal;
+}
+
+// Leaf constructor with its record, e.g. "CSGExpression::Sphere{SphereData{glm::mat3x4(...), glm::vec3(...), 0x1p+0f, 0x1p+0f}}"
+static std::string leafSource(const CSGSceneView& scene, const CSGNode::ShaderNodeData& node)
+{
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+	{
+		const SphereData& sphere = scene.spheres[node.primitiveIndex];
+		return "CSGExpression::Sphere{SphereData{" + mat3x4Literal(sphere.inverseTransform) + ", " + vec3Literal(sphere.color) + ", " + floatLiteral(sphere.scale)
+			+ ", " + floatLiteral(sphere.radius) + "}}";
+	}
+	case SHADER_TYPE_TORUS:
+	{
+		const TorusData& torus = scene.toruses[node.primitiveIndex];
+		return "CSGExpression::Torus{TorusData{" + mat3x4Literal(torus.inverseTransform) + ", " + vec3Literal(torus.color) + ", " + floatLiteral(torus.scale)
+			+ ", " + floatLiteral(torus.majorRadius)
+			+ ", " + floatLiteral(torus.minorRadius) + "}}";
+	}
+	case SHADER_TYPE_CYLINDER:
+	{
+		const CylinderData& cylinder = scene.cylinders[node.primitiveIndex];
+		return "CSGExpression::Cylinder{CylinderData{" + mat3x4Literal(cylinder.inverseTransform) + ", " + vec3Literal(cylinder.color) + ", " + floatLiteral(cylinder.scale)
+			+ ", " + floatLiteral(cylinder.height)
+			+ ", " + floatLiteral(cylinder.radius) + "}}";
+	}
+	case SHADER_TYPE_BOX:
+	default:
+	{
+		const BoxData& box = scene.boxes[node.primitiveIndex];
+		return "CSGExpression::Box{BoxData{" + mat3x4Literal(box.inverseTransform) + ", " + vec3Literal(box.color) + ", " + floatLiteral(box.scale)
+			+ ", " + vec3Literal(box.size) + "}}";
+	}
+	}
+}
+
+static const char* operationName(const int type)
+{
+	switch (type)
+	{
+	case SHADER_TYPE_INTERSECTION:
+		return "Intersection";
+	case SHADER_TYPE_UNION:
+		return "Union";
+	case SHADER_TYPE_DIFFERENCE:
+		return "Difference";
+	case SHADER_TYPE_SMOOTH_INTERSECTION:
+		return "SmoothIntersection";
+	case SHADER_TYPE_SMOOTH_UNION:
+		return "SmoothUnion";
+	case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		return "SmoothDifference";
+	case SHADER_TYPE_NARY_INTERSECTION:
+		return "NaryIntersection";
+	case SHADER_TYPE_NARY_UNION:
+		return "NaryUnion";
+	default:
+		return "Complement";
+	}
+}
+
+static bool isLeaf(const int type)
+{
+	return type >= SHADER_TYPE_SPHERE && type <= SHADER_TYPE_BOX;
+}
+
+std::string CSGExpression::typeName(const CSGSceneView& scene, const std::string& qualifier)
+{
+	static const char* leafNames[] = {"Sphere", "Torus", "Cylinder", "Box"};
+
+	std::function<std::string(int)> nodeName = [&](const int nodeIndex) -> std::string
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+		if (isLeaf(node.type))
+			return qualifier + leafNames[node.type - SHADER_TYPE_SPHERE];
+		if (node.type == SHADER_TYPE_COMPLEMENTARY)
+			return qualifier + "Complement<" + nodeName(node.leftChildIndex) + ">";
+		if (isNaryOperation(node.type))
+		{
+			std::string childNames;
+			for (int child = node.leftChildIndex; child <= node.rightChildIndex; child++)
+				childNames += (child == node.leftChildIndex ? "" : ", ") + nodeName(child);
+			return qualifier + operationName(node.type) + "<" + childNames + ">";
+		}
+		return qualifier + operationName(node.type) + "<" + nodeName(node.leftChildIndex) + ", " + nodeName(node.rightChildIndex) + ">";
+	};
+
+	return scene.isEmpty() ? std::string() : nodeName(scene.nbNode - 1);
+}
+
+std::string CSGExpression::generateSource(const CSGSceneView& scene, const std::string& functionName)
+{
+	if (scene.isEmpty())
+		return {};
+
+	// One node per line, children indented below their parent
+	std::function<std::string(int, int)> nodeSource = [&](const int nodeIndex, const int depth) -> std::string
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+		const std::string indent(depth + 2, '\t');
+		if (isLeaf(node.type))
+			return indent + leafSource(scene, node);
+
+		std::string source = indent + "CSGExpression::make" + operationName(node.type) + "(\n" + nodeSource(node.leftChildIndex, depth + 1);
+		if (isNaryOperation(node.type))
+		{
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+				source += ",\n" + nodeSource(child, depth + 1);
+		}
+		else if (node.type != SHADER_TYPE_COMPLEMENTARY)
+			source += ",\n" + nodeSource(node.rightChildIndex, depth + 1);
+		if (isSmoothOperation(node.type))
+			source += ",\n" + indent + "\t" + floatLiteral(blendRadius(node));
+		return source + ")";
+	};
+
+	std::ostringstream source;
+	source << "// Generated by CSGExpression::generateSource(), do not edit\n"
+		<< "#pragma once\n\n"
+		<< "#include \"renderer/opengl/Primitives/CSGExpression.hpp\"\n\n"
+		<< "using " << functionName << "Type = " << typeName(scene, "CSGExpression::") << ";\n\n"
+		<< "inline " << functionName << "Type " << functionName << "()\n"
+		<< "{\n"
+		<< "\treturn\n" << nodeSource(scene.nbNode - 1, 0) << ";\n"
+		<< "}\n";
+	return source.str();
+}
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+
+/*
+* CSG trees fixed at compile time, for reusable parts (fasteners, standard profiles) whose topology never changes.
+* The tree is a type, e.g. Union<Difference<Cylinder, Torus>, Box>: distance() and evaluate() are inlined by the compiler into a
+* single function without any node buffer, switch or stack. Only the primitive records (transform, color, dimensions) are data.
+*
+* An expression is filled either from a serialized scene of the same topology with bindScene(), or by the C++ source that
+* generateSource() writes for any runtime tree.
+* Results are identical to CSGEvaluator on the same scene.
+* Sphere, Torus, Cylinder and Box are also the names of the runtime primitive classes: qualify them (or alias the namespace)
+* rather than writing 'using namespace CSGExpression'.
+*/
+namespace CSGExpression
+{
+	/*
+	* Per record type information of the leaves
+	*/
+	template<typename Data>
+	struct LeafTraits;
+
+	template<>
+	struct LeafTraits<SphereData>
+	{
+		static constexpr int SHADER_TYPE = SHADER_TYPE_SPHERE;
+		static float sdf(const SphereData& sphere, const glm::vec3& p) { return sphereSDF(sphere, p); }
+		static const SphereData* records(const CSGSceneView& scene) { return scene.spheres; }
+		static int count(const CSGSceneView& scene) { return scene.nbSphere; }
+		static const char* name() { return "Sphere"; }
+	};
+
+	template<>
+	struct LeafTraits<TorusData>
+	{
+		static constexpr int SHADER_TYPE = SHADER_TYPE_TORUS;
+		static float sdf(const TorusData& torus, const glm::vec3& p) { return torusSDF(torus, p); }
+		static const TorusData* records(const CSGSceneView& scene) { return scene.toruses; }
+		static int count(const CSGSceneView& scene) { return scene.nbTorus; }
+		static const char* name() { return "Torus"; }
+	};
+
+	template<>
+	struct LeafTraits<CylinderData>
+	{
+		static constexpr int SHADER_TYPE = SHADER_TYPE_CYLINDER;
+		static float sdf(const CylinderData& cylinder, const glm::vec3& p) { return cylinderSDF(cylinder, p); }
+		static const CylinderData* records(const CSGSceneView& scene) { return scene.cylinders; }
+		static int count(const CSGSceneView& scene) { return scene.nbCylinder; }
+		static const char* name() { return "Cylinder"; }
+	};
+
+	template<>
+	struct LeafTraits<BoxData>
+	{
+		static constexpr int SHADER_TYPE = SHADER_TYPE_BOX;
+		static float sdf(const BoxData& box, const glm::vec3& p) { return boxSDF(box, p); }
+		static const BoxData* records(const CSGSceneView& scene) { return scene.boxes; }
+		static int count(const CSGSceneView& scene) { return scene.nbBox; }
+		static const char* name() { return "Box"; }
+	};
+
+	/*
+	* Primitive leaf, holding the same record as the SSBO, with its precomputed distance scale.
+	*/
+	template<typename Data>
+	struct Leaf
+	{
+		using Traits = LeafTraits<Data>;
+		static constexpr int NB_NODE = 1;
+
+		Data data{};
+
+		Leaf() = default;
+		explicit Leaf(const Data& record) : data{record} {}
+
+		float distance(const glm::vec3& pos) const
+		{
+			return Traits::sdf(data, transformPoint(data.inverseTransform, pos)) * data.scale;
+		}
+
+		CSGEvaluation evaluate(const glm::vec3& pos) const { return {data.color, distance(pos)}; }
+
+		bool bind(const CSGSceneView& scene, const int nodeIndex)
+		{
+			const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+			if (node.type != Traits::SHADER_TYPE || node.primitiveIndex < 0 || node.primitiveIndex >= Traits::count(scene))
+				return false;
+			*this = Leaf{Traits::records(scene)[node.primitiveIndex]};
+			return true;
+		}
+
+		static std::string name() { return Traits::name(); }
+	};
+
+	using Sphere = Leaf<SphereData>;
+	using Torus = Leaf<TorusData>;
+	using Cylinder = Leaf<CylinderData>;
+	using Box = Leaf<BoxData>;
+
+	/*
+	* Intersection, union and difference. As in the shader, the color is the one of the child responsible for the distance.
+	*/
+	template<int shaderType, typename Left, typename Right>
+	struct Operation
+	{
+		static constexpr int NB_NODE = Left::NB_NODE + Right::NB_NODE + 1;
+
+		Left left;
+		Right right;
+
+		static float combine(const float a, const float b)
+		{
+			if constexpr (shaderType == SHADER_TYPE_INTERSECTION)
+				return std::max(a, b);
+			else if constexpr (shaderType == SHADER_TYPE_UNION)
+				return std::min(a, b);
+			else
+				return std::max(a, -b);
+		}
+
+		float distance(const glm::vec3& pos) const { return combine(left.distance(pos), right.distance(pos)); }
+
+		CSGEvaluation evaluate(const glm::vec3& pos) const
+		{
+			const CSGEvaluation a = left.evaluate(pos);
+			const CSGEvaluation b = right.evaluate(pos);
+			const float dist = combine(a.dist, b.dist);
+			return {dist == a.dist ? a.color : b.color, dist};
+		}
+
+		bool bind(const CSGSceneView& scene, const int nodeIndex)
+		{
+			const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+			// Children come before their parent in the postorder buffer
+			return node.type == shaderType
+				&& node.leftChildIndex >= 0 && node.leftChildIndex < nodeIndex && node.rightChildIndex >= 0 && node.rightChildIndex < nodeIndex
+				&& left.bind(scene, node.leftChildIndex) && right.bind(scene, node.rightChildIndex);
+		}
+
+		static std::string name()
+		{
+			const char* operationName = shaderType == SHADER_TYPE_INTERSECTION ? "Intersection" : shaderType == SHADER_TYPE_UNION ? "Union" : "Difference";
+			return std::string(operationName) + "<" + Left::name() + ", " + Right::name() + ">";
+		}
+	};
+
+	template<typename Left, typename Right>
+	using Intersection = Operation<SHADER_TYPE_INTERSECTION, Left, Right>;
+	template<typename Left, typename Right>
+	using Union = Operation<SHADER_TYPE_UNION, Left, Right>;
+	template<typename Left, typename Right>
+	using Difference = Operation<SHADER_TYPE_DIFFERENCE, Left, Right>;
+
+	/*
+	* Smooth intersection, union and difference. The blend radius is data, bound from the node buffer like the primitive records.
+	* As in CSGEvaluator, the colors of the children are blended with the weights of their distances.
+	*/
+	template<int shaderType, typename Left, typename Right>
+	struct SmoothOperation
+	{
+		static constexpr int NB_NODE = Left::NB_NODE + Right::NB_NODE + 1;
+
+		Left left;
+		Right right;
+		float radius = 0.f;
+
+		float distance(const glm::vec3& pos) const
+		{
+			float h;
+			return smoothOperationSDF(shaderType, left.distance(pos), right.distance(pos), radius, h);
+		}
+
+		CSGEvaluation evaluate(const glm::vec3& pos) const
+		{
+			const CSGEvaluation a = left.evaluate(pos);
+			const CSGEvaluation b = right.evaluate(pos);
+			float h;
+			const float dist = smoothOperationSDF(shaderType, a.dist, b.dist, radius, h);
+			return {b.color + (a.color - b.color) * h, dist};
+		}
+
+		bool bind(const CSGSceneView& scene, const int nodeIndex)
+		{
+			const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+			if (node.type != shaderType || node.leftChildIndex < 0 || node.leftChildIndex >= nodeIndex || node.rightChildIndex < 0
+				|| node.rightChildIndex >= nodeIndex)
+				return false;
+			radius = blendRadius(node);
+			return left.bind(scene, node.leftChildIndex) && right.bind(scene, node.rightChildIndex);
+		}
+
+		static std::string name()
+		{
+			const char* operationName = shaderType == SHADER_TYPE_SMOOTH_INTERSECTION ? "SmoothIntersection"
+				: shaderType == SHADER_TYPE_SMOOTH_UNION ? "SmoothUnion" : "SmoothDifference";
+			return std::string(operationName) + "<" + Left::name() + ", " + Right::name() + ">";
+		}
+	};
+
+	template<typename Left, typename Right>
+	using SmoothIntersection = SmoothOperation<SHADER_TYPE_SMOOTH_INTERSECTION, Left, Right>;
+	template<typename Left, typename Right>
+	using SmoothUnion = SmoothOperation<SHADER_TYPE_SMOOTH_UNION, Left, Right>;
+	template<typename Left, typename Right>
+	using SmoothDifference = SmoothOperation<SHADER_TYPE_SMOOTH_DIFFERENCE, Left, Right>;
+
+	template<typename Child>
+	struct Complement
+	{
+		static constexpr int NB_NODE = Child::NB_NODE + 1;
+
+		Child child;
+
+		float distance(const glm::vec3& pos) const { return -child.distance(pos); }
+		CSGEvaluation evaluate(const glm::vec3& pos) const { return {glm::vec3(0.f), -child.distance(pos)}; } // Black, as in the shader
+
+		bool bind(const CSGSceneView& scene, const int nodeIndex)
+		{
+			const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+			return node.type == SHADER_TYPE_COMPLEMENTARY && node.leftChildIndex >= 0 && node.leftChildIndex < nodeIndex
+				&& child.bind(scene, node.leftChildIndex);
+		}
+
+		static std::string name() { return "Complement<" + Child::name() + ">"; }
+	};
+
+	/*
+	* N-ary intersection and union of primitives, bound to the consecutive leaves of an n-ary node. The first child giving the distance
+	* gives its color, as in CSGEvaluator.
+	*/
+	template<int shaderType, typename... Children>
+	struct NaryOperation
+	{
+		static_assert(sizeof...(Children) >= 2, "An n-ary operation has at least two children");
+		static constexpr int NB_NODE = (Children::NB_NODE + ...) + 1;
+
+		std::tuple<Children...> children;
+
+		float distance(const glm::vec3& pos) const
+		{
+			return std::apply([&pos](const Children&... child)
+			{
+				return shaderType == SHADER_TYPE_NARY_UNION ? std::min({child.distance(pos)...}) : std::max({child.distance(pos)...});
+			}, children);
+		}
+
+		CSGEvaluation evaluate(const glm::vec3& pos) const
+		{
+			CSGEvaluation result{};
+			bool first = true;
+			auto select = [&](const CSGEvaluation& evaluation)
+			{
+				if (first || (shaderType == SHADER_TYPE_NARY_UNION ? evaluation.dist < result.dist : evaluation.dist > result.dist))
+					result = evaluation;
+				first = false;
+			};
+			std::apply([&](const Children&... child) { (select(child.evaluate(pos)), ...); }, children);
+			return result;
+		}
+
+		bool bind(const CSGSceneView& scene, const int nodeIndex)
+		{
+			const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+			if (node.type != shaderType || node.leftChildIndex < 0 || node.rightChildIndex >= nodeIndex
+				|| node.rightChildIndex - node.leftChildIndex + 1 != static_cast<int>(sizeof...(Children)))
+				return false;
+			return bindChildren(scene, node.leftChildIndex, std::index_sequence_for<Children...>{});
+		}
+
+		static std::string name()
+		{
+			std::string childNames;
+			((childNames += (childNames.empty() ? "" : ", ") + Children::name()), ...);
+			return std::string(shaderType == SHADER_TYPE_NARY_UNION ? "NaryUnion<" : "NaryIntersection<") + childNames + ">";
+		}
+
+	private:
+		template<size_t... indices>
+		bool bindChildren(const CSGSceneView& scene, const int firstChild, std::index_sequence<indices...>)
+		{
+			return (std::get<indices>(children).bind(scene, firstChild + static_cast<int>(indices)) && ...);
+		}
+	};
+
+	template<typename... Children>
+	using NaryIntersection = NaryOperation<SHADER_TYPE_NARY_INTERSECTION, Children...>;
+	template<typename... Children>
+	using NaryUnion = NaryOperation<SHADER_TYPE_NARY_UNION, Children...>;
+
+	/*
+	* Factories, so the type of an expression does not have to be written
+	*/
+	template<typename Left, typename Right>
+	Intersection<Left, Right> makeIntersection(const Left& left, const Right& right) { return {left, right}; }
+	template<typename Left, typename Right>
+	Union<Left, Right> makeUnion(const Left& left, const Right& right) { return {left, right}; }
+	template<typename Left, typename Right>
+	Difference<Left, Right> makeDifference(const Left& left, const Right& right) { return {left, right}; }
+	template<typename Child>
+	Complement<Child> makeComplement(const Child& child) { return {child}; }
+	template<typename Left, typename Right>
+	SmoothIntersection<Left, Right> makeSmoothIntersection(const Left& left, const Right& right, const float radius) { return {left, right, radius}; }
+	template<typename Left, typename Right>
+	SmoothUnion<Left, Right> makeSmoothUnion(const Left& left, const Right& right, const float radius) { return {left, right, radius}; }
+	template<typename Left, typename Right>
+	SmoothDifference<Left, Right> makeSmoothDifference(const Left& left, const Right& right, const float radius) { return {left, right, radius}; }
+	template<typename... Children>
+	NaryIntersection<Children...> makeNaryIntersection(const Children&... children) { return {std::make_tuple(children...)}; }
+	template<typename... Children>
+	NaryUnion<Children...> makeNaryUnion(const Children&... children) { return {std::make_tuple(children...)}; }
+
+	/*
+	* Fill 'expression' with the records of a serialized scene. Fail if the topology of the scene is not exactly the one of the
+	* expression (same operations, same primitive types, no extra node).
+	*/
+	template<typename Expression>
+	bool bindScene(const CSGSceneView& scene, Expression& expression, std::string& error)
+	{
+		if (scene.nbNode != Expression::NB_NODE)
+		{
+			error = "The scene has " + std::to_string(scene.nbNode) + " nodes, " + Expression::name() + " has " + std::to_string(Expression::NB_NODE);
+			return false;
+		}
+		if (!expression.bind(scene, scene.nbNode - 1))
+		{
+			error = "The topology of the scene does not match " + Expression::name();
+			return false;
+		}
+		return true;
+	}
+
+	// Expression type matching the topology of a serialized scene, e.g. "Difference<Union<Sphere, Box>, Cylinder>", each name prefixed by 'qualifier'
+	std::string typeName(const CSGSceneView& scene, const std::string& qualifier = "");
+
+	/*
+	* C++ header declaring 'functionName'Type, the expression type of the scene, and an inline function 'functionName'() returning
+	* it filled with the records of the scene. Floats are written in hexadecimal, so the generated expression gives bit for bit the
+	* distances of the scene.
+	*/
+	std::string generateSource(const CSGSceneView& scene, const std::string& functionName);
+}
@@ -0,0 +1,495 @@
+#include "renderer/opengl/Primitives/CSGFuzzer.hpp"
+
+#include "renderer/opengl/Primitives/CSGSceneGenerator.hpp"
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveStore.hpp"
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGPointQuery.hpp"
+#include "renderer/opengl/Primitives/CSGBinaryScene.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/CSGRayQuery.hpp"
+#include "renderer/opengl/Primitives/CSGNaryNodes.hpp"
+
+#include <filesystem>
+#include <sstream>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <array>
+
+// Decode the record written by Primitive::rawData(), the padding of the std430 layout is not part of it
+template<typename Record>
+static Record decodeRecord(const Primitive& primitive)
+{
+	Record record{};
+	const std::vector<uint8_t> rawData = primitive.rawData();
+	std::memcpy(&record, rawData.data(), std::min(rawData.size(), sizeof(Record)));
+	return record;
+}
+
+template<typename Record, typename SDF>
+static float referencePrimitiveDistance(const Primitive& primitive, const glm::vec3& pos, SDF sdf)
+{
+	const Record record = decodeRecord<Record>(primitive);
+	const glm::mat4 inverseTransform = glm::inverse(primitive.getTransform());
+	return sdf(record, transformPoint(affineRows(inverseTransform), pos)) * distanceScale(inverseTransform);
+}
+
+CSGEvaluation CSGFuzzer::referenceEvaluation(const CSGNode::NodePtr& node, const glm::vec3& pos)
+{
+	if (node->isLeaf())
+	{
+		const Primitive& primitive = *node->getPrimitive();
+		switch (primitive.getType())
+		{
+		case Primitive::PrimitiveType::Sphere:
+			return {primitive.getColor(), referencePrimitiveDistance<SphereData>(primitive, pos, sphereSDF)};
+		case Primitive::PrimitiveType::Torus:
+			return {primitive.getColor(), referencePrimitiveDistance<TorusData>(primitive, pos, torusSDF)};
+		case Primitive::PrimitiveType::Cylinder:
+			return {primitive.getColor(), referencePrimitiveDistance<CylinderData>(primitive, pos, cylinderSDF)};
+		case Primitive::PrimitiveType::Box:
+			return {primitive.getColor(), referencePrimitiveDistance<BoxData>(primitive, pos, boxSDF)};
+		default:
+			return {glm::vec3(0.f), std::numeric_limits<float>::infinity()};
+		}
+	}
+
+	const CSGEvaluation a = referenceEvaluation(node->getFirstChild(), pos);
+	if (node->getType() == CSGNode::NodeType::Complement)
+		return {glm::vec3(0.f), -a.dist};
+
+	const CSGEvaluation b = referenceEvaluation(node->getSecondChild(), pos);
+	float dist;
+	switch (node->getType())
+	{
+	case CSGNode::NodeType::Intersection:
+		dist = std::max(a.dist, b.dist);
+		break;
+	case CSGNode::NodeType::Union:
+		dist = std::min(a.dist, b.dist);
+		break;
+	default:
+		dist = std::max(a.dist, -b.dist);
+		break;
+	}
+	return {dist == a.dist ? a.color : b.color, dist};
+}
+
+static void collectPreorder(const CSGNode::NodePtr& node, std::vector<CSGNode::NodePtr>& nodes)
+{
+	if (node == nullptr)
+		return;
+	nodes.push_back(node);
+	collectPreorder(node->getFirstChild(), nodes);
+	collectPreorder(node->getSecondChild(), nodes);
+}
+
+static void collectPostorder(const CSGNode::NodePtr& node, std::vector<CSGNode::NodePtr>& nodes)
+{
+	if (node == nullptr)
+		return;
+	collectPostorder(node->getFirstChild(), nodes);
+	collectPostorder(node->getSecondChild(), nodes);
+	nodes.push_back(node);
+}
+
+static int referenceHeight(const CSGNode::NodePtr& node)
+{
+	if (node == nullptr)
+		return 0;
+	return 1 + std::max(referenceHeight(node->getFirstChild()), referenceHeight(node->getSecondChild()));
+}
+
+static int subtreeSize(const CSGNode::NodePtr& node)
+{
+	if (node == nullptr)
+		return 0;
+	return 1 + subtreeSize(node->getFirstChild()) + subtreeSize(node->getSecondChild());
+}
+
+// Relative tolerance, the paths differ by the order of the operations at most
+static bool closeTo(const float a, const float b, const float tolerance = 1e-4f)
+{
+	return a == b || std::abs(a - b) <= tolerance * std::max(1.f, std::abs(a));
+}
+
+static std::string pointString(const glm::vec3& pos)
+{
+	std::ostringstream stream;
+	stream << "(" << pos.x << ", " << pos.y << ", " << pos.z << ")";
+	return stream.str();
+}
+
+bool CSGFuzzer::checkTreeQueries(const CSGTree& tree, std::string& error) const
+{
+	std::vector<CSGNode::NodePtr> preorder;
+	std::vector<CSGNode::NodePtr> postorder;
+	collectPreorder(tree.getRoot(), preorder);
+	collectPostorder(tree.getRoot(), postorder);
+
+	const int nbNode = static_cast<int>(preorder.size());
+	if (tree.nbNode() != nbNode)
+	{
+		error = "nbNode() is " + std::to_string(tree.nbNode()) + ", the tree has " + std::to_string(nbNode) + " nodes";
+		return false;
+	}
+	if (tree.height() != referenceHeight(tree.getRoot()))
+	{
+		error = "height() is " + std::to_string(tree.height()) + " instead of " + std::to_string(referenceHeight(tree.getRoot()));
+		return false;
+	}
+	const int nbLeaf = static_cast<int>(std::count_if(preorder.begin(), preorder.end(), [](const CSGNode::NodePtr& node) { return node->isLeaf(); }));
+	if (tree.nbOfPrimitive() != nbLeaf)
+	{
+		error = "nbOfPrimitive() is " + std::to_string(tree.nbOfPrimitive()) + " instead of " + std::to_string(nbLeaf);
+		return false;
+	}
+	for (int i = 0; i < nbNode; i++)
+	{
+		if (tree.atPreorder(i) != preorder[i])
+		{
+			error = "atPreorder(" + std::to_string(i) + ") does not return the node of preorder index " + std::to_string(i);
+			return false;
+		}
+		if (tree.atPostorder(i) != postorder[i])
+		{
+			error = "atPostorder(" + std::to_string(i) + ") does not return the node of postorder index " + std::to_string(i);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CSGFuzzer::checkTree(const CSGTree& tree, std::mt19937& generator, std::string& error)
+{
+	_statistics.nbTree++;
+	if (!checkTreeQueries(tree, error))
+		return false;
+
+	// Serializers: the store and the flat scene must give the bytes of the tree, the node buffer must follow the postorder
+	const std::vector<uint8_t> treeRawData = tree.treeRawData();
+	const CSGSceneData scene{tree};
+	const CSGSceneView view = scene.view();
+	if (treeRawData.size() != static_cast<size_t>(view.nbNode) * sizeof(CSGNode::ShaderNodeData)
+		|| (!treeRawData.empty() && std::memcmp(treeRawData.data(), view.nodes, treeRawData.size()) != 0))
+	{
+		error = "CSGSceneData nodes differ from treeRawData()";
+		return false;
+	}
+	std::vector<CSGNode::NodePtr> postorder;
+	collectPostorder(tree.getRoot(), postorder);
+	for (int i = 0; i < view.nbNode; i++)
+	{
+		const bool leaf = view.nodes[i].leftChildIndex < 0;
+		if (leaf != postorder[i]->isLeaf() || (!leaf && (view.nodes[i].leftChildIndex >= i || view.nodes[i].rightChildIndex >= i)))
+		{
+			error = "node " + std::to_string(i) + " of treeRawData() does not match the postorder of the tree";
+			return false;
+		}
+	}
+
+	const CSGPrimitiveStore store{tree};
+	if (store.treeRawData() != treeRawData)
+	{
+		error = "CSGPrimitiveStore::treeRawData() differs from CSGTree::treeRawData()";
+		return false;
+	}
+	for (const Primitive::PrimitiveType type : {Primitive::PrimitiveType::Sphere, Primitive::PrimitiveType::Torus, Primitive::PrimitiveType::Cylinder, Primitive::PrimitiveType::Box})
+	{
+		if (store.rawDataByPrimitiveType(type) != tree.rawDataByPrimitiveType(type))
+		{
+			error = "CSGPrimitiveStore::rawDataByPrimitiveType() differs from CSGTree::rawDataByPrimitiveType() for type " + std::to_string(static_cast<int>(type));
+			return false;
+		}
+	}
+
+	// Binary scene: same node bytes once mapped, and the tree rebuilt from the records has the same distance field
+	const std::string path = (std::filesystem::temp_directory_path() / ("csgFuzzer" + std::to_string(_seed) + ".csgb")).string();
+	CSGBinaryScene binaryScene;
+	if (!CSGBinaryScene::save(path, view, error) || !binaryScene.open(path, error))
+	{
+		error = "binary scene: " + error;
+		return false;
+	}
+	if (binaryScene.view().nbNode != view.nbNode || std::memcmp(binaryScene.view().nodes, view.nodes, treeRawData.size()) != 0)
+	{
+		error = "the nodes of the binary scene differ from treeRawData()";
+		return false;
+	}
+	const CSGTree rebuiltTree = CSGBinaryScene::buildTree(binaryScene.view());
+	if (rebuiltTree.treeRawData() != treeRawData)
+	{
+		error = "the tree rebuilt from the binary scene has different nodes";
+		return false;
+	}
+
+	// Evaluators at random points, in and around the cube where the generator places the primitives
+	std::uniform_real_distribution<float> coordinate{-6.f, 6.f};
+	std::vector<glm::vec3> points(_nbPointPerTree);
+	for (glm::vec3& point : points)
+	{
+		const float x = coordinate(generator);
+		const float y = coordinate(generator);
+		const float z = coordinate(generator);
+		point = glm::vec3(x, y, z);
+	}
+
+	const CSGEvaluator evaluator{view};
+	const CSGEvaluator binaryEvaluator{binaryScene.view()};
+	const CSGStoreEvaluator storeEvaluator{store};
+	const CSGCompiledEvaluator compiledEvaluator{view, std::make_shared<const CSGCompiledProgram>(view)};
+	const CSGPointQuery pointQuery{view, 1};
+	std::vector<float> compiledDistances(points.size());
+	compiledEvaluator.distances(points.data(), static_cast<int>(points.size()), compiledDistances.data());
+	const std::vector<CSGEvaluation> queryResults = pointQuery.evaluate(points);
+
+	AABB bounds = CSGBounds::nodeBounds(view).back();
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const glm::vec3& pos = points[i];
+		const CSGEvaluation reference = referenceEvaluation(tree.getRoot(), pos);
+		const std::string at = " at " + pointString(pos) + ", reference distance " + std::to_string(reference.dist);
+
+		const CSGEvaluation evaluation = evaluator.scanSDF(pos);
+		if (!closeTo(reference.dist, evaluation.dist) || evaluation.color != reference.color)
+		{
+			error = "CSGEvaluator::scanSDF() gives " + std::to_string(evaluation.dist) + at;
+			return false;
+		}
+		const CSGEvaluation shortCircuit = evaluator.scanSDFShortCircuit(pos);
+		if (shortCircuit.dist != evaluation.dist || shortCircuit.color != evaluation.color)
+		{
+			error = "CSGEvaluator::scanSDFShortCircuit() gives " + std::to_string(shortCircuit.dist) + " instead of " + std::to_string(evaluation.dist) + at;
+			return false;
+		}
+		if (!closeTo(reference.dist, binaryEvaluator.scanSDF(pos).dist))
+		{
+			error = "the mapped binary scene gives " + std::to_string(binaryEvaluator.scanSDF(pos).dist) + at;
+			return false;
+		}
+		// The records of the rebuilt tree went through a decomposition of the inverse transform
+		if (!closeTo(reference.dist, referenceEvaluation(rebuiltTree.getRoot(), pos).dist, 1e-3f))
+		{
+			error = "the tree rebuilt from the binary scene gives " + std::to_string(referenceEvaluation(rebuiltTree.getRoot(), pos).dist) + at;
+			return false;
+		}
+		const CSGEvaluation storeEvaluation = storeEvaluator.scanSDF(pos);
+		if (!closeTo(reference.dist, storeEvaluation.dist) || storeEvaluation.color != reference.color)
+		{
+			error = "CSGStoreEvaluator::scanSDF() gives " + std::to_string(storeEvaluation.dist) + at;
+			return false;
+		}
+		if (!closeTo(reference.dist, compiledDistances[i]))
+		{
+			error = "CSGCompiledEvaluator::distances() gives " + std::to_string(compiledDistances[i]) + at;
+			return false;
+		}
+		if (!closeTo(reference.dist, queryResults[i].dist) || queryResults[i].color != reference.color)
+		{
+			error = "CSGPointQuery::evaluate() gives " + std::to_string(queryResults[i].dist) + at;
+			return false;
+		}
+
+		// Conservative bounds: the points out of them are outside of the scene
+		if ((bounds.isEmpty() || (!bounds.isInfinite() && bounds.distance(pos) > 1e-3f)) && reference.dist < -1e-4f)
+		{
+			error = "the point is inside the scene but outside of the bounds of the root" + at;
+			return false;
+		}
+	}
+	for (size_t i = 0; i + 4 <= points.size(); i += 4)
+	{
+		const glm::vec4 distances = evaluator.scanSDF4({points[i], points[i + 1], points[i + 2], points[i + 3]});
+		for (int j = 0; j < 4; j++)
+		{
+			if (!closeTo(referenceEvaluation(tree.getRoot(), points[i + j]).dist, distances[j]))
+			{
+				error = "CSGEvaluator::scanSDF4() gives " + std::to_string(distances[j]) + " at " + pointString(points[i + j]);
+				return false;
+			}
+		}
+	}
+	_statistics.nbPoint += static_cast<long long>(points.size());
+	_statistics.nbSkippedNode += evaluator.getNbSkippedNode();
+
+	// N-ary nodes: every chain collapsed, even of two leaves. Fewer nodes, same distances and colors, and back to binary nodes by expansion.
+	const std::vector<CSGNode::ShaderNodeData> collapsedNodes = CSGNaryNodes::collapseChains(view, 2);
+	CSGSceneView collapsedView = view;
+	collapsedView.nodes = collapsedNodes.data();
+	collapsedView.nbNode = static_cast<int>(collapsedNodes.size());
+	const std::vector<CSGNode::ShaderNodeData> expandedNodes = CSGNaryNodes::expandNaryNodes(collapsedView);
+	CSGSceneView expandedView = view;
+	expandedView.nodes = expandedNodes.data();
+	expandedView.nbNode = static_cast<int>(expandedNodes.size());
+	if (!CSGBinaryScene::validateNodes(collapsedView, error) || collapsedView.nbNode > view.nbNode || expandedView.nbNode != view.nbNode
+		|| CSGNaryNodes::collapseChains(collapsedView, 2).size() != collapsedNodes.size())
+	{
+		error = "CSGNaryNodes: the collapsed buffer of " + std::to_string(collapsedView.nbNode) + " nodes is invalid, or does not expand back to "
+			+ std::to_string(view.nbNode) + " nodes " + error;
+		return false;
+	}
+	const CSGEvaluator collapsedEvaluator{collapsedView};
+	const CSGEvaluator expandedEvaluator{expandedView};
+	const CSGCompiledEvaluator collapsedCompiledEvaluator{collapsedView, std::make_shared<const CSGCompiledProgram>(collapsedView)};
+	std::vector<CSGEvaluation> collapsedResults(points.size());
+	collapsedCompiledEvaluator.evaluate(points.data(), static_cast<int>(points.size()), collapsedResults.data());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const CSGEvaluation reference = referenceEvaluation(tree.getRoot(), points[i]);
+		const CSGEvaluation collapsed = collapsedEvaluator.scanSDF(points[i]);
+		const std::string at = " at " + pointString(points[i]) + ", reference distance " + std::to_string(reference.dist);
+		if (!closeTo(reference.dist, collapsed.dist) || collapsed.color != reference.color)
+		{
+			error = "CSGEvaluator::scanSDF() on the collapsed buffer gives " + std::to_string(collapsed.dist) + at;
+			return false;
+		}
+		if (!closeTo(reference.dist, collapsedResults[i].dist) || collapsedResults[i].color != reference.color)
+		{
+			error = "CSGCompiledEvaluator::evaluate() on the collapsed buffer gives " + std::to_string(collapsedResults[i].dist) + at;
+			return false;
+		}
+		if (expandedEvaluator.scanSDF(points[i]).dist != collapsed.dist)
+		{
+			error = "the expanded buffer gives " + std::to_string(expandedEvaluator.scanSDF(points[i]).dist) + at;
+			return false;
+		}
+	}
+
+	// Ray intervals: inside in the middle of an interval, outside in the middle of a gap, with and without the n-ary nodes
+	constexpr float tMax = 30.f;
+	const CSGRayQuery rayQuery{view};
+	const CSGRayQuery collapsedRayQuery{collapsedView};
+	for (int i = 0; i < _nbRayPerTree; i++)
+	{
+		const glm::vec3 target{coordinate(generator), coordinate(generator), coordinate(generator)};
+		glm::vec3 origin{coordinate(generator), coordinate(generator), coordinate(generator)};
+		origin = 12.f * glm::normalize(origin + glm::vec3(1e-3f));
+		const Ray ray{origin, glm::normalize(target - origin)};
+
+		auto checkSign = [&](const float tStart, const float tEnd, const bool inside)
+		{
+			if (tEnd - tStart < 1e-3f)
+				return true;
+			const glm::vec3 pos = ray.origin + 0.5f * (tStart + tEnd) * ray.direction;
+			const float dist = referenceEvaluation(tree.getRoot(), pos).dist;
+			if (inside ? dist <= 1e-3f : dist >= -1e-3f)
+				return true;
+			error = "CSGRayQuery::intervals() puts " + pointString(pos) + (inside ? " inside" : " outside") + " the scene, reference distance " + std::to_string(dist);
+			return false;
+		};
+
+		for (const CSGRayQuery* query : {&rayQuery, &collapsedRayQuery})
+		{
+			float previousExit = 0.f;
+			for (const RayInterval& interval : query->intervals(ray, 0.f, tMax))
+			{
+				const float tEnter = std::max(interval.tEnter, 0.f);
+				const float tExit = std::min(interval.tExit, tMax);
+				if (!checkSign(previousExit, tEnter, false) || !checkSign(tEnter, tExit, true))
+					return false;
+				previousExit = tExit;
+			}
+			if (!checkSign(previousExit, tMax, false))
+				return false;
+		}
+		_statistics.nbRay++;
+	}
+	return true;
+}
+
+bool CSGFuzzer::runIteration(const int iteration)
+{
+	_statistics.nbIteration++;
+	std::seed_seq seed{_seed, static_cast<uint32_t>(iteration)};
+	std::mt19937 generator{seed};
+	CSGSceneGenerator sceneGenerator{static_cast<uint32_t>(generator())};
+
+	std::uniform_int_distribution<int> nbPrimitiveDistribution{1, _maxPrimitive};
+	const int nbPrimitive = nbPrimitiveDistribution(generator);
+	CSGTree tree = sceneGenerator.randomTree(nbPrimitive, std::uniform_int_distribution<int>{1, 12}(generator));
+
+	auto fail = [&](const std::string& step, const std::string& error)
+	{
+		std::ostringstream stream;
+		stream << "seed " << _seed << ", iteration " << iteration << ", " << step << ": " << error;
+		_failure = stream.str();
+		return false;
+	};
+
+	std::string error;
+	if (!tree.isValid())
+		return fail("generated tree", "isValid() is false");
+	if (!checkTree(tree, generator, error))
+		return fail("generated tree", error);
+
+	const int nbMutation = std::uniform_int_distribution<int>{1, 6}(generator);
+	for (int mutation = 0; mutation < nbMutation; mutation++)
+	{
+		const int nbNode = tree.nbNode();
+		// One past the last node too, which must be rejected
+		const int index = std::uniform_int_distribution<int>{0, nbNode}(generator);
+		const bool safe = std::uniform_int_distribution<int>{0, 3}(generator) != 0;
+		const CSGNode::NodePtr removed = tree.atPreorder(index);
+		const std::string step = std::string(safe ? "removeAtPreorderOperation(" : "unsafeRemoveAtPreorder(") + std::to_string(index) + ") on " + std::to_string(nbNode) + " nodes";
+
+		const bool expected = removed != nullptr && (!safe || !removed->isLeaf());
+		const bool result = safe ? tree.removeAtPreorderOperation(index) : tree.unsafeRemoveAtPreorder(index);
+		if (result != expected)
+			return fail(step, std::string("returned ") + (result ? "true" : "false"));
+		if (!result)
+		{
+			_statistics.nbRejectedMutation++;
+			continue;
+		}
+		_statistics.nbMutation++;
+
+		// The unsafe removal of the root empties the tree
+		if (!safe && index == 0)
+		{
+			if (!tree.isEmpty())
+				return fail(step, "the tree is not empty");
+			break;
+		}
+		// An operation is replaced by its first child, a leaf removed by the unsafe version leaves its parent without a child
+		if (removed->isLeaf())
+		{
+			if (tree.isValid())
+				return fail(step, "the tree is still reported valid after a leaf was removed");
+			_statistics.nbInvalidTree++;
+			break;
+		}
+		const int expectedNbNode = nbNode - subtreeSize(removed) + subtreeSize(removed->getFirstChild());
+		if (tree.nbNode() != expectedNbNode)
+			return fail(step, "the tree has " + std::to_string(tree.nbNode()) + " nodes instead of " + std::to_string(expectedNbNode));
+		if (!tree.isValid())
+			return fail(step, "isValid() is false after the removal of an operation");
+		if (!checkTree(tree, generator, error))
+			return fail(step, error);
+	}
+
+	if (tree.isEmpty() && (tree.removeAtPreorderOperation(0) || tree.unsafeRemoveAtPreorder(0)))
+		return fail("empty tree", "a removal succeeded");
+	return true;
+}
+
+bool CSGFuzzer::run(const int nbIteration, std::ostream* log)
+{
+	_failure.clear();
+	bool success = true;
+	for (int iteration = 0; iteration < nbIteration && success; iteration++)
+		success = runIteration(iteration);
+
+	if (log != nullptr)
+	{
+		*log << "Fuzzer (seed " << _seed << "): " << _statistics.nbIteration << " iterations, " << _statistics.nbTree << " trees, "
+			<< _statistics.nbMutation << " mutations (" << _statistics.nbRejectedMutation << " rejected, " << _statistics.nbInvalidTree << " invalid trees), "
+			<< _statistics.nbPoint << " points (" << _statistics.nbSkippedNode << " nodes short-circuited), " << _statistics.nbRay << " rays" << std::endl;
+		if (!success)
+			*log << "Fuzzer failure: " << _failure << std::endl;
+	}
+	std::error_code errorCode;
+	std::filesystem::remove(std::filesystem::temp_directory_path() / ("csgFuzzer" + std::to_string(_seed) + ".csgb"), errorCode);
+	return success;
+}
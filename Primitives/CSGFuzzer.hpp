@@ -0,0 +1,82 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGTree.hpp"
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <ostream>
+#include <random>
+#include <cstdint>
+
+/*
+* Counters of a fuzzing run
+*/
+struct FuzzStatistics
+{
+	int nbIteration = 0;
+	int nbTree = 0;				// Trees cross-checked, mutated ones included
+	int nbMutation = 0;			// Successful calls to removeAtPreorderOperation() and unsafeRemoveAtPreorder()
+	int nbRejectedMutation = 0;	// Calls that returned false (leaf index for the safe removal, out of range index)
+	int nbInvalidTree = 0;		// Trees left invalid by unsafeRemoveAtPreorder(), and correctly reported as such by isValid()
+	long long nbPoint = 0;		// Points at which the optimized paths were compared with the reference
+	long long nbSkippedNode = 0;	// Nodes skipped by CSGEvaluator::scanSDFShortCircuit() at these points
+	long long nbRay = 0;
+};
+
+/*
+* Property-based tests of the CSG code: random valid trees (CSGSceneGenerator::randomTree) are mutated with
+* CSGTree::removeAtPreorderOperation() and CSGTree::unsafeRemoveAtPreorder(), and after each step every optimized path is compared with
+* a naive recursive evaluation of the shared_ptr tree:
+*   - tree queries: nbNode, height, nbOfPrimitive, atPreorder and atPostorder against a recursive traversal, and the node count expected
+*     after each removal,
+*   - serializers: CSGPrimitiveStore and the binary scene file (save, map, buildTree) must give the same bytes as treeRawData() and
+*     rawDataByPrimitiveType(),
+*   - CPU evaluators on random points: CSGEvaluator (distance, color, scanSDF4, the same bits for scanSDFShortCircuit),
+*     CSGCompiledEvaluator, CSGPointQuery, CSGStoreEvaluator and the mapped binary scene,
+*   - CSGBounds: points outside the bounds of the root are outside the scene,
+*   - CSGNaryNodes: the buffer with every chain collapsed is valid, smaller, gives the same distances and colors (CSGEvaluator,
+*     CSGCompiledEvaluator, CSGRayQuery) and expands back to as many nodes as the original,
+*   - CSGRayQuery: the middle of every returned interval is inside the scene, and the middle of every gap is outside.
+*
+* Each iteration only depends on the seed and on its index, so a failure reported as "seed S, iteration I" is reproduced by
+* runIteration(I) on a fuzzer of seed S.
+*/
+class CSGFuzzer
+{
+public:
+	explicit CSGFuzzer(uint32_t seed = 1) : _seed{seed} {}
+
+	void setMaxPrimitive(int maxPrimitive) { _maxPrimitive = maxPrimitive; }
+	void setNbPointPerTree(int nbPoint) { _nbPointPerTree = nbPoint; }
+	void setNbRayPerTree(int nbRay) { _nbRayPerTree = nbRay; }
+
+	// Run iterations 0 to 'nbIteration' - 1, stopping at the first failure (see getFailure()). Print a summary on 'log' if not null.
+	bool run(int nbIteration, std::ostream* log = nullptr);
+
+	// Generate one random tree, then mutate it and check it until it is empty, invalid, or after a few mutations
+	bool runIteration(int iteration);
+
+	/*
+	* Compare every optimized path with the reference on 'tree', which must be valid. 'generator' draws the points and rays.
+	* Return false and fill 'error' on the first mismatch.
+	*/
+	bool checkTree(const CSGTree& tree, std::mt19937& generator, std::string& error);
+
+	// Naive recursive evaluation of the distance and color at 'pos', same conventions as CSGEvaluator. 'node' must be valid.
+	static CSGEvaluation referenceEvaluation(const CSGNode::NodePtr& node, const glm::vec3& pos);
+
+	[[nodiscard]] const FuzzStatistics& getStatistics() const { return _statistics; }
+	[[nodiscard]] const std::string& getFailure() const { return _failure; }
+
+private:
+	bool checkTreeQueries(const CSGTree& tree, std::string& error) const;
+
+	uint32_t _seed;
+	int _maxPrimitive = 24;
+	int _nbPointPerTree = 64;
+	int _nbRayPerTree = 8;
+	FuzzStatistics _statistics;
+	std::string _failure;
+};
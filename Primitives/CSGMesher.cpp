@@ -0,0 +1,574 @@
+#include "renderer/opengl/Primitives/CSGMesher.hpp"
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+void MeshStatistics::merge(const MeshStatistics& other)
+{
+	nbBrick += other.nbBrick;
+	nbCulledBrick += other.nbCulledBrick;
+	nbSurfaceCell += other.nbSurfaceCell;
+	nbEvaluation += other.nbEvaluation;
+	nbVertex += other.nbVertex;
+	nbTriangle += other.nbTriangle;
+}
+
+CSGMesher::CSGMesher(const CSGSceneView& scene, const int nbThread) :
+	_scene{scene},
+	_nodeBounds{CSGBounds::nodeBounds(scene)},
+	_blendMargins{CSGBounds::blendMargins(scene)},
+	_nbThread{nbThread > 0 ? nbThread : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))}
+{
+}
+
+static bool isPowerOfTwo(const int value)
+{
+	return value > 0 && (value & (value - 1)) == 0;
+}
+
+bool CSGMesher::domain(glm::vec3& origin, float& size, std::string& error) const
+{
+	if (!isPowerOfTwo(_resolution) || _resolution < 8 || _resolution > MAX_RESOLUTION)
+	{
+		error = "The resolution must be a power of two between 8 and " + std::to_string(MAX_RESOLUTION);
+		return false;
+	}
+	if (!isPowerOfTwo(_brickResolution) || _brickResolution > _resolution)
+	{
+		error = "The brick resolution must be a power of two, at most the resolution";
+		return false;
+	}
+
+	const AABB bounds = !_bounds.isEmpty() ? _bounds : _scene.isEmpty() ? AABB{} : _nodeBounds.back();
+	if (bounds.isInfinite())
+	{
+		error = "The scene is unbounded, give the region to mesh with setBounds()";
+		return false;
+	}
+
+	size = 0.f;
+	const glm::vec3 extent = bounds.max - bounds.min;
+	const float maxExtent = bounds.isEmpty() ? 0.f : std::max(extent.x, std::max(extent.y, extent.z));
+	if (maxExtent > 0.f)
+	{
+		/*
+		* Two empty cells on each side, so the surface never reaches the border of the domain. The lattice is shifted by half a
+		* cell, so the faces of the bounds (the poles of a sphere, the faces of a box) are not exactly on lattice points, where the
+		* crossings of several edges would give the same vertex to several cells.
+		*/
+		size = maxExtent * static_cast<float>(_resolution) / static_cast<float>(_resolution - 4);
+		origin = 0.5f * (bounds.min + bounds.max) - glm::vec3(0.5f * size + 0.5f * size / static_cast<float>(_resolution));
+	}
+	return true;
+}
+
+float CSGMesher::cellSize() const
+{
+	glm::vec3 origin;
+	float size;
+	std::string error;
+	return domain(origin, size, error) ? size / static_cast<float>(_resolution) : 0.f;
+}
+
+/*
+* Culling of the node buffer to a region. A node is either kept, or known to be outside (positive) or inside (negative) in the
+* whole region: a primitive whose bounds do not reach the region is outside, and the operations propagate these states.
+* Dropping such a node does not change the sign of the distance in the region, and near the surface (where a dropped node is
+* further than the margin of the region) it does not change the distance either.
+* Below smooth operations, a primitive is only dropped when its bounds are further from the region than the blend radii above it
+* ('blendMargins'), so that it does not take part in a blend there. Smooth operations are then culled as their hard operation.
+* The leaves of an n-ary operation are culled one by one: the ones kept are still consecutive in the culled buffer.
+*/
+static constexpr int CULLED_OUTSIDE = -1;
+static constexpr int CULLED_INSIDE = -2;
+
+// Return the state of the root: CULLED_OUTSIDE, CULLED_INSIDE or the index of the root in 'culledNodes'
+static int cullNodes(const CSGSceneView& scene, const std::vector<AABB>& nodeBounds, const std::vector<float>& blendMargins, const AABB& region,
+	std::vector<int>& states, std::vector<CSGNode::ShaderNodeData>& culledNodes)
+{
+	culledNodes.clear();
+	states.resize(scene.nbNode);
+	auto keep = [&culledNodes](const int type, const int left, const int right, const int primitiveIndex)
+	{
+		culledNodes.push_back(CSGNode::ShaderNodeData{type, left, right, primitiveIndex});
+		return static_cast<int>(culledNodes.size()) - 1;
+	};
+
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		const int a = node.leftChildIndex >= 0 && node.leftChildIndex < i ? states[node.leftChildIndex] : CULLED_OUTSIDE;
+		const int b = node.rightChildIndex >= 0 && node.rightChildIndex < i ? states[node.rightChildIndex] : CULLED_OUTSIDE;
+
+		// The primitiveIndex of an operation is -1, or the blend radius of a smooth operation
+		switch (hardOperation(node.type))
+		{
+		case SHADER_TYPE_SPHERE:
+		case SHADER_TYPE_TORUS:
+		case SHADER_TYPE_CYLINDER:
+		case SHADER_TYPE_BOX:
+			states[i] = nodeBounds[i].expanded(blendMargins[i]).intersected(region).isEmpty() ? CULLED_OUTSIDE
+				: keep(node.type, -1, -1, node.primitiveIndex);
+			break;
+		case SHADER_TYPE_UNION:
+			states[i] = a == CULLED_OUTSIDE ? b : b == CULLED_OUTSIDE ? a : a == CULLED_INSIDE || b == CULLED_INSIDE ? CULLED_INSIDE
+				: keep(node.type, a, b, node.primitiveIndex);
+			break;
+		case SHADER_TYPE_INTERSECTION:
+			states[i] = a == CULLED_INSIDE ? b : b == CULLED_INSIDE ? a : a == CULLED_OUTSIDE || b == CULLED_OUTSIDE ? CULLED_OUTSIDE
+				: keep(node.type, a, b, node.primitiveIndex);
+			break;
+		case SHADER_TYPE_DIFFERENCE:
+			if (a == CULLED_OUTSIDE || b == CULLED_INSIDE)
+				states[i] = CULLED_OUTSIDE;
+			else if (b == CULLED_OUTSIDE)
+				states[i] = a;
+			else if (a == CULLED_INSIDE)
+				states[i] = keep(SHADER_TYPE_COMPLEMENTARY, b, -1, -1);
+			else
+				states[i] = keep(node.type, a, b, node.primitiveIndex);
+			break;
+		case SHADER_TYPE_COMPLEMENTARY:
+			states[i] = a == CULLED_OUTSIDE ? CULLED_INSIDE : a == CULLED_INSIDE ? CULLED_OUTSIDE : keep(node.type, a, -1, -1);
+			break;
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+		{
+			// A leaf outside of the region is outside of the intersection, and does not change the union
+			const bool unionNode = node.type == SHADER_TYPE_NARY_UNION;
+			int first = -1;
+			int last = -1;
+			bool culled = false;
+			for (int child = std::max(node.leftChildIndex, 0); child <= node.rightChildIndex && child < i; child++)
+			{
+				if (states[child] < 0)
+					culled = true;
+				else
+				{
+					first = first < 0 ? states[child] : first;
+					last = states[child];
+				}
+			}
+			if (unionNode)
+				states[i] = first < 0 ? CULLED_OUTSIDE : first == last ? first : keep(node.type, first, last, -1);
+			else
+				states[i] = culled || first < 0 ? CULLED_OUTSIDE : first == last ? first : keep(node.type, first, last, -1);
+			break;
+		}
+		default:
+			states[i] = CULLED_OUTSIDE;
+			break;
+		}
+	}
+	return scene.nbNode > 0 ? states[scene.nbNode - 1] : CULLED_OUTSIDE;
+}
+
+// Key of a cell or of a lattice point, one cell of margin below the domain for the cells under the lower faces of the branches
+static uint64_t latticeKey(const glm::ivec3& p)
+{
+	return (static_cast<uint64_t>(p.x + 1) << 42) | (static_cast<uint64_t>(p.y + 1) << 21) | static_cast<uint64_t>(p.z + 1);
+}
+
+static glm::ivec3 cornerOffset(const int corner)
+{
+	return glm::ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+}
+
+static glm::ivec3 axisOffset(const int axis)
+{
+	return glm::ivec3(axis == 0 ? 1 : 0, axis == 1 ? 1 : 0, axis == 2 ? 1 : 0);
+}
+
+static bool isInside(const float dist)
+{
+	return dist <= 0.f;
+}
+
+/*
+* Vertex minimizing the squared distances to the planes (points[i], normals[i]) and, along the directions the planes do not
+* constrain (flat or cylindrical surfaces), staying at the mass point. Pseudo inverse of the normal equations through a Jacobi
+* eigen decomposition, with the eigenvalues under a tenth of the largest one truncated.
+*/
+static glm::vec3 solveQEF(const glm::vec3* points, const glm::vec3* normals, const int nbPoint, const glm::vec3& massPoint)
+{
+	float a[3][3] = {};
+	float atb[3] = {};
+	for (int i = 0; i < nbPoint; i++)
+	{
+		const glm::vec3& n = normals[i];
+		const float b = glm::dot(n, points[i] - massPoint);
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 3; column++)
+				a[row][column] += n[row] * n[column];
+			atb[row] += n[row] * b;
+		}
+	}
+
+	float v[3][3] = {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+	for (int sweep = 0; sweep < 16; sweep++)
+	{
+		if (a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2] < 1e-12f)
+			break;
+		for (int p = 0; p < 2; p++)
+		{
+			for (int q = p + 1; q < 3; q++)
+			{
+				if (std::abs(a[p][q]) < 1e-12f)
+					continue;
+				const float theta = (a[q][q] - a[p][p]) / (2.f * a[p][q]);
+				const float t = (theta >= 0.f ? 1.f : -1.f) / (std::abs(theta) + std::sqrt(theta * theta + 1.f));
+				const float c = 1.f / std::sqrt(t * t + 1.f);
+				const float s = t * c;
+				for (int k = 0; k < 3; k++)
+				{
+					const float akp = a[k][p];
+					const float akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < 3; k++)
+				{
+					const float apk = a[p][k];
+					const float aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < 3; k++)
+				{
+					const float vkp = v[k][p];
+					const float vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	const float maxEigenvalue = std::max(a[0][0], std::max(a[1][1], a[2][2]));
+	glm::vec3 offset{0.f};
+	for (int j = 0; j < 3; j++)
+	{
+		if (maxEigenvalue <= 0.f || a[j][j] < 0.1f * maxEigenvalue)
+			continue;
+		const float projection = (v[0][j] * atb[0] + v[1][j] * atb[1] + v[2][j] * atb[2]) / a[j][j];
+		offset += projection * glm::vec3(v[0][j], v[1][j], v[2][j]);
+	}
+	return massPoint + offset;
+}
+
+/*
+* Settings and shared state of an extraction
+*/
+struct MeshDomain
+{
+	CSGSceneView scene;
+	const std::vector<AABB>* nodeBounds;
+	const std::vector<float>* blendMargins;
+	glm::vec3 origin;
+	float cellSize;
+	int brickResolution;
+	int nbBrickPerSide;
+	bool sharpFeatures;
+	CSGProgramCache* cache;
+
+	glm::vec3 position(const glm::ivec3& p) const
+	{
+		return origin + glm::vec3(static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(p.z)) * cellSize;
+	}
+};
+
+/*
+* Working buffers of a thread, kept from one branch to the next
+*/
+struct BrickBuffers
+{
+	struct Quad
+	{
+		uint64_t cells[4]; // Counter clockwise around the edge
+		bool flip;
+	};
+
+	std::vector<int> states;
+	std::vector<CSGNode::ShaderNodeData> nodes;
+	std::vector<glm::ivec3> cells;
+	std::vector<glm::ivec3> nextCells;
+	std::vector<glm::vec3> positions;
+	std::vector<float> distances;
+	std::vector<uint64_t> pendingCorners;
+	std::unordered_map<uint64_t, float> corners;
+	std::unordered_map<uint64_t, int> surfaceCells; // Index in 'vertices', -1 while a cell below the branch waits for its vertex
+	std::vector<glm::ivec3> surfaceCellPositions;
+	std::vector<glm::vec3> vertices;
+	std::vector<int> outputIndices; // Index in the chunk, -1 until a triangle uses the vertex
+	std::vector<Quad> quads;
+};
+
+// Evaluate the corners of 'cells' missing from buffers.corners
+static void evaluateCorners(const CSGCompiledEvaluator& evaluator, const MeshDomain& domain, const std::vector<glm::ivec3>& cells, BrickBuffers& buffers,
+	MeshStatistics& statistics)
+{
+	buffers.pendingCorners.clear();
+	buffers.positions.clear();
+	for (const glm::ivec3& cell : cells)
+	{
+		for (int corner = 0; corner < 8; corner++)
+		{
+			const glm::ivec3 p = cell + cornerOffset(corner);
+			if (buffers.corners.emplace(latticeKey(p), 0.f).second)
+			{
+				buffers.pendingCorners.push_back(latticeKey(p));
+				buffers.positions.push_back(domain.position(p));
+			}
+		}
+	}
+
+	buffers.distances.resize(buffers.positions.size());
+	evaluator.distances(buffers.positions.data(), static_cast<int>(buffers.positions.size()), buffers.distances.data());
+	statistics.nbEvaluation += static_cast<long long>(buffers.positions.size());
+	for (size_t i = 0; i < buffers.pendingCorners.size(); i++)
+		buffers.corners[buffers.pendingCorners[i]] = buffers.distances[i];
+}
+
+// Add the vertex of a cell crossed by the surface, whose corners are evaluated
+static void addSurfaceCell(const MeshDomain& domain, const glm::ivec3& cell, const CSGEvaluator& gradientEvaluator, BrickBuffers& buffers,
+	MeshStatistics& statistics)
+{
+	float cornerDistances[8];
+	for (int corner = 0; corner < 8; corner++)
+		cornerDistances[corner] = buffers.corners.at(latticeKey(cell + cornerOffset(corner)));
+
+	// Crossings of the 12 edges, linearly interpolated
+	glm::vec3 points[12];
+	int nbPoint = 0;
+	glm::vec3 massPoint{0.f};
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int corner = 0; corner < 8; corner++)
+		{
+			if ((corner >> axis) & 1)
+				continue;
+			const int otherCorner = corner | (1 << axis);
+			const float d0 = cornerDistances[corner];
+			const float d1 = cornerDistances[otherCorner];
+			if (isInside(d0) == isInside(d1))
+				continue;
+			const glm::vec3 p0 = domain.position(cell + cornerOffset(corner));
+			const glm::vec3 p1 = domain.position(cell + cornerOffset(otherCorner));
+			points[nbPoint] = p0 + (d0 / (d0 - d1)) * (p1 - p0);
+			massPoint += points[nbPoint];
+			nbPoint++;
+		}
+	}
+	massPoint /= static_cast<float>(std::max(nbPoint, 1));
+
+	glm::vec3 vertex = massPoint;
+	if (domain.sharpFeatures && nbPoint > 0)
+	{
+		glm::vec3 normals[12];
+		for (int i = 0; i < nbPoint; i++)
+		{
+			const glm::vec3 gradient = gradientEvaluator.scanSDFGradient(points[i]).gradient;
+			const float length = glm::length(gradient);
+			normals[i] = length > 0.f ? gradient / length : glm::vec3(0.f);
+		}
+		statistics.nbEvaluation += nbPoint;
+
+		// A vertex outside of its cell would fold the neighboring quads
+		const glm::vec3 cellMin = domain.position(cell);
+		vertex = glm::clamp(solveQEF(points, normals, nbPoint, massPoint), cellMin, cellMin + glm::vec3(domain.cellSize));
+	}
+
+	buffers.surfaceCells[latticeKey(cell)] = static_cast<int>(buffers.vertices.size());
+	buffers.surfaceCellPositions.push_back(cell);
+	buffers.vertices.push_back(vertex);
+	buffers.outputIndices.push_back(-1);
+}
+
+static void meshBrick(const MeshDomain& domain, const int brick, BrickBuffers& buffers, MeshChunk& chunk, MeshStatistics& statistics)
+{
+	const int n = domain.nbBrickPerSide;
+	const int brickResolution = domain.brickResolution;
+	const glm::ivec3 brickMin = glm::ivec3(brick % n, (brick / n) % n, brick / (n * n)) * brickResolution;
+	statistics.nbBrick++;
+
+	chunk.brick = brick;
+	chunk.vertices.clear();
+	chunk.triangles.clear();
+
+	// Everything evaluated for the branch, including the cells below its lower faces, with a margin of two cells
+	const float margin = 3.f * domain.cellSize;
+	AABB region;
+	region.min = domain.position(brickMin) - glm::vec3(margin);
+	region.max = domain.position(brickMin + glm::ivec3(brickResolution)) + glm::vec3(margin);
+	const int root = cullNodes(domain.scene, *domain.nodeBounds, *domain.blendMargins, region, buffers.states, buffers.nodes);
+	if (root < 0)
+	{
+		statistics.nbCulledBrick++;
+		return;
+	}
+
+	CSGSceneView culledScene = domain.scene;
+	culledScene.nodes = buffers.nodes.data();
+	culledScene.nbNode = static_cast<int>(buffers.nodes.size());
+	const CSGCompiledEvaluator evaluator{culledScene, domain.cache->getProgram(culledScene)};
+	const CSGEvaluator gradientEvaluator{culledScene};
+
+	// Refine the cells whose center is closer to the surface than their half diagonal, down to the finest cells
+	buffers.cells.assign(1, brickMin);
+	for (int size = brickResolution; size >= 1 && !buffers.cells.empty(); size /= 2)
+	{
+		buffers.positions.clear();
+		for (const glm::ivec3& cell : buffers.cells)
+			buffers.positions.push_back(domain.position(cell) + glm::vec3(0.5f * static_cast<float>(size) * domain.cellSize));
+		buffers.distances.resize(buffers.positions.size());
+		evaluator.distances(buffers.positions.data(), static_cast<int>(buffers.positions.size()), buffers.distances.data());
+		statistics.nbEvaluation += static_cast<long long>(buffers.positions.size());
+
+		const float halfDiagonal = 0.87f * static_cast<float>(size) * domain.cellSize; // Slightly more than sqrt(3) / 2
+		buffers.nextCells.clear();
+		for (size_t i = 0; i < buffers.cells.size(); i++)
+		{
+			if (std::abs(buffers.distances[i]) > halfDiagonal)
+				continue;
+			if (size == 1)
+				buffers.nextCells.push_back(buffers.cells[i]);
+			else
+			{
+				for (int child = 0; child < 8; child++)
+					buffers.nextCells.push_back(buffers.cells[i] + cornerOffset(child) * (size / 2));
+			}
+		}
+		buffers.cells.swap(buffers.nextCells);
+	}
+
+	// Vertices of the finest cells crossed by the surface
+	buffers.corners.clear();
+	buffers.surfaceCells.clear();
+	buffers.surfaceCellPositions.clear();
+	buffers.vertices.clear();
+	buffers.outputIndices.clear();
+	evaluateCorners(evaluator, domain, buffers.cells, buffers, statistics);
+	for (const glm::ivec3& cell : buffers.cells)
+	{
+		const bool inside = isInside(buffers.corners.at(latticeKey(cell)));
+		for (int corner = 1; corner < 8; corner++)
+		{
+			if (isInside(buffers.corners.at(latticeKey(cell + cornerOffset(corner)))) != inside)
+			{
+				addSurfaceCell(domain, cell, gradientEvaluator, buffers, statistics);
+				break;
+			}
+		}
+	}
+	const size_t nbBrickCell = buffers.surfaceCellPositions.size();
+	statistics.nbSurfaceCell += static_cast<long long>(nbBrickCell);
+
+	// A branch owns the edges starting at its cells: one quad around each edge crossing the surface
+	buffers.quads.clear();
+	buffers.cells.clear(); // Cells below the lower faces, missing from the branch
+	for (size_t i = 0; i < nbBrickCell; i++)
+	{
+		const glm::ivec3 cell = buffers.surfaceCellPositions[i];
+		const bool inside = isInside(buffers.corners.at(latticeKey(cell)));
+		for (int axis = 0; axis < 3; axis++)
+		{
+			auto end = buffers.corners.find(latticeKey(cell + axisOffset(axis)));
+			if (end == buffers.corners.end() || isInside(end->second) == inside)
+				continue;
+
+			const glm::ivec3 b = axisOffset((axis + 1) % 3);
+			const glm::ivec3 c = axisOffset((axis + 2) % 3);
+			const BrickBuffers::Quad quad{{latticeKey(cell - b - c), latticeKey(cell - c), latticeKey(cell), latticeKey(cell - b)}, !inside};
+			buffers.quads.push_back(quad);
+			for (const glm::ivec3& neighbor : {cell - b - c, cell - c, cell - b})
+			{
+				if (buffers.surfaceCells.emplace(latticeKey(neighbor), -1).second) // Vertex computed below
+					buffers.cells.push_back(neighbor);
+			}
+		}
+	}
+
+	evaluateCorners(evaluator, domain, buffers.cells, buffers, statistics);
+	for (const glm::ivec3& cell : buffers.cells)
+		addSurfaceCell(domain, cell, gradientEvaluator, buffers, statistics);
+
+	auto outputIndex = [&buffers, &chunk](const uint64_t cell)
+	{
+		const int vertex = buffers.surfaceCells.at(cell);
+		if (buffers.outputIndices[vertex] < 0)
+		{
+			buffers.outputIndices[vertex] = static_cast<int>(chunk.vertices.size());
+			chunk.vertices.push_back(buffers.vertices[vertex]);
+		}
+		return static_cast<uint32_t>(buffers.outputIndices[vertex]);
+	};
+
+	for (const BrickBuffers::Quad& quad : buffers.quads)
+	{
+		uint32_t indices[4];
+		for (int i = 0; i < 4; i++)
+			indices[i] = outputIndex(quad.cells[i]);
+		if (quad.flip)
+			chunk.triangles.insert(chunk.triangles.end(), {indices[0], indices[2], indices[1], indices[0], indices[3], indices[2]});
+		else
+			chunk.triangles.insert(chunk.triangles.end(), {indices[0], indices[1], indices[2], indices[0], indices[2], indices[3]});
+	}
+
+	statistics.nbVertex += static_cast<long long>(chunk.vertices.size());
+	statistics.nbTriangle += static_cast<long long>(chunk.triangles.size() / 3);
+}
+
+bool CSGMesher::extract(const ChunkFunction& output, std::string& error, MeshStatistics* statistics) const
+{
+	glm::vec3 origin;
+	float size;
+	if (!domain(origin, size, error))
+		return false;
+	if (size <= 0.f)
+		return true;
+
+	CSGProgramCache cache; // Most branches of an assembly share a few culled topologies
+	const int nbBrickPerSide = _resolution / _brickResolution;
+	const MeshDomain meshDomain{_scene, &_nodeBounds, &_blendMargins, origin, size / static_cast<float>(_resolution), _brickResolution, nbBrickPerSide, _sharpFeatures, &cache};
+	const int nbBrick = nbBrickPerSide * nbBrickPerSide * nbBrickPerSide;
+
+	std::atomic<int> nextBrick{0};
+	std::mutex outputMutex;
+	auto worker = [&]()
+	{
+		BrickBuffers buffers;
+		MeshChunk chunk;
+		MeshStatistics threadStatistics;
+		for (int brick = nextBrick++; brick < nbBrick; brick = nextBrick++)
+		{
+			meshBrick(meshDomain, brick, buffers, chunk, threadStatistics);
+			if (!chunk.triangles.empty())
+			{
+				std::lock_guard<std::mutex> lock(outputMutex);
+				output(chunk);
+			}
+		}
+
+		if (statistics != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(outputMutex);
+			statistics->merge(threadStatistics);
+		}
+	};
+
+	const int nbThread = std::min(_nbThread, nbBrick);
+	std::vector<std::thread> threads;
+	for (int i = 1; i < nbThread; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+	return true;
+}
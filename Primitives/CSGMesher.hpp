@@ -0,0 +1,95 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <functional>
+#include <string>
+#include <cstdint>
+
+/*
+* Triangles of one octree branch, given to the output as soon as the branch is meshed
+*/
+struct MeshChunk
+{
+	int brick = 0; // Index of the branch in the domain
+	std::vector<glm::vec3> vertices;
+	std::vector<uint32_t> triangles; // Three indices in 'vertices' per triangle, counter clockwise seen from outside
+};
+
+/*
+* Counters accumulated over the branches of an extraction
+*/
+struct MeshStatistics
+{
+	long long nbBrick = 0; // Branches of the domain
+	long long nbCulledBrick = 0; // Branches skipped without any evaluation, as no primitive bound reaches them
+	long long nbSurfaceCell = 0; // Finest cells crossed by the surface
+	long long nbEvaluation = 0; // Points where the distance (or its gradient) was evaluated
+	long long nbVertex = 0;
+	long long nbTriangle = 0;
+
+	void merge(const MeshStatistics& other);
+};
+
+/*
+* Dual contouring of the distance field of a serialized scene on an adaptive octree.
+* The cubic domain is split in branches of getBrickResolution()^3 finest cells, meshed in parallel and independently:
+*   - the node buffer is culled to the primitives whose bounds reach the branch, most branches of a large assembly only keep a few
+*     nodes and the empty ones are skipped,
+*   - cells are refined level by level and only kept while the distance at their center is smaller than their half diagonal,
+*     with batches of points evaluated by a CSGCompiledProgram,
+*   - one vertex is placed in each finest cell crossed by the surface, and a quad joins the four cells around each edge crossing it.
+* With sharp features, the vertex minimizes the distance to the tangent planes at the edge crossings (normals from the analytic
+* gradient) instead of being their mean, which keeps the edges and corners of boxes and of CSG operations.
+*
+* A branch also computes the vertices of the cells just below its lower faces, so every branch is a watertight piece: the vertices
+* shared by two chunks are duplicated, with bit for bit the same positions, and can be welded by the caller.
+*/
+class CSGMesher
+{
+public:
+	using ChunkFunction = std::function<void(const MeshChunk& chunk)>;
+
+	static constexpr int MAX_RESOLUTION = 1 << 16;
+
+	explicit CSGMesher(const CSGSceneView& scene, int nbThread = 0); // 0 means one thread per hardware thread
+
+	// Finest cells along each side of the domain, a power of two (512 for a 512^3 effective resolution)
+	void setResolution(int resolution) { _resolution = resolution; }
+	[[nodiscard]] int getResolution() const { return _resolution; }
+
+	// Finest cells along each side of a branch, a power of two
+	void setBrickResolution(int brickResolution) { _brickResolution = brickResolution; }
+	[[nodiscard]] int getBrickResolution() const { return _brickResolution; }
+
+	void setSharpFeatures(bool sharpFeatures) { _sharpFeatures = sharpFeatures; }
+	[[nodiscard]] bool getSharpFeatures() const { return _sharpFeatures; }
+
+	// Region to mesh, the bounds of the scene by default. Required for unbounded scenes (complement at the root).
+	void setBounds(const AABB& bounds) { _bounds = bounds; }
+
+	/*
+	* Mesh the scene, calling 'output' for every branch with triangles. Calls come from the worker threads, one at a time, in no
+	* particular order. Return false with an error message if the settings or the scene cannot be meshed.
+	*/
+	bool extract(const ChunkFunction& output, std::string& error, MeshStatistics* statistics = nullptr) const;
+
+	// Side of a finest cell for the current settings, 0 if there is nothing to mesh
+	[[nodiscard]] float cellSize() const;
+
+private:
+	// Cubic domain with two empty cells around the meshed region
+	bool domain(glm::vec3& origin, float& size, std::string& error) const;
+
+	CSGSceneView _scene;
+	std::vector<AABB> _nodeBounds;
+	std::vector<float> _blendMargins; // CSGBounds::blendMargins(), the leaves are culled with their bounds expanded by it
+	int _nbThread;
+	int _resolution = 256;
+	int _brickResolution = 32;
+	bool _sharpFeatures = false;
+	AABB _bounds;
+};
@@ -0,0 +1,183 @@
+#include "renderer/opengl/Primitives/CSGNaryNodes.hpp"
+
+#include <algorithm>
+
+std::vector<CSGNode::ShaderNodeData> CSGNaryNodes::collapseChains(const CSGSceneView& scene, const int minNbLeaf)
+{
+	const size_t minRun = static_cast<size_t>(std::max(minNbLeaf, 2));
+
+	// Operands of the chain ending at each union or intersection node, in order: the input nodes that are not of its type
+	std::vector<int> chainTypes(scene.nbNode, 0);
+	std::vector<std::vector<int>> chains(scene.nbNode);
+	auto appendOperands = [&](const int child, const int type, std::vector<int>& operands)
+	{
+		if (chainTypes[child] == type && operands.empty())
+			operands = std::move(chains[child]);
+		else if (chainTypes[child] == type)
+			operands.insert(operands.end(), chains[child].begin(), chains[child].end());
+		else
+			operands.push_back(child);
+	};
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		const int type = binaryOperation(node.type);
+		if (type != SHADER_TYPE_UNION && type != SHADER_TYPE_INTERSECTION)
+			continue;
+
+		chainTypes[i] = type;
+		if (isNaryOperation(node.type))
+		{
+			for (int child = node.leftChildIndex; child <= node.rightChildIndex; child++)
+				appendOperands(child, type, chains[i]);
+		}
+		else
+		{
+			appendOperands(node.leftChildIndex, type, chains[i]);
+			appendOperands(node.rightChildIndex, type, chains[i]);
+		}
+	}
+
+	// Emitted from the root down, so that every subtree stays a contiguous range of the buffer. The pending nodes are kept on an explicit
+	// stack: a difference chain of 100k nodes is as deep as it is long.
+	std::vector<CSGNode::ShaderNodeData> nodes;
+	nodes.reserve(scene.nbNode);
+	auto emit = [&nodes](const CSGNode::ShaderNodeData& node)
+	{
+		nodes.push_back(node);
+		return static_cast<int>(nodes.size()) - 1;
+	};
+
+	struct PendingNode
+	{
+		int index; // In the input buffer
+		size_t next = 0; // Next child (0 or 1) or next operand of a chain
+		int result = -1; // Output index of the chain combined so far
+		bool waiting = false; // A child was pushed, its output index is 'emitted'
+		CSGNode::ShaderNodeData copy{};
+	};
+	std::vector<PendingNode> stack;
+	if (scene.nbNode > 0)
+		stack.push_back(PendingNode{scene.nbNode - 1});
+	int emitted = -1; // Output index of the last node popped from the stack
+	while (!stack.empty())
+	{
+		PendingNode& pending = stack.back();
+		const CSGNode::ShaderNodeData& node = scene.nodes[pending.index];
+		if (isLeafType(node.type))
+		{
+			emitted = emit(node);
+			stack.pop_back();
+			continue;
+		}
+
+		if (chainTypes[pending.index] == 0)
+		{
+			if (pending.waiting)
+			{
+				(pending.next == 0 ? pending.copy.leftChildIndex : pending.copy.rightChildIndex) = emitted;
+				pending.waiting = false;
+				pending.next++;
+			}
+			else if (pending.next == 0)
+				pending.copy = node;
+
+			const int nbChild = node.type == SHADER_TYPE_COMPLEMENTARY ? 1 : 2;
+			if (pending.next < static_cast<size_t>(nbChild))
+			{
+				pending.waiting = true;
+				const int child = pending.next == 0 ? node.leftChildIndex : node.rightChildIndex;
+				stack.push_back(PendingNode{child});
+				continue;
+			}
+			emitted = emit(pending.copy);
+			stack.pop_back();
+			continue;
+		}
+
+		// Runs of leaves become n-ary nodes, the operands are then combined from left to right: the leftmost operand still wins the ties
+		const int type = chainTypes[pending.index];
+		const std::vector<int>& operands = chains[pending.index];
+		auto combine = [&](const int operand)
+		{
+			pending.result = pending.result < 0 ? operand : emit(CSGNode::ShaderNodeData{type, pending.result, operand, -1});
+		};
+		if (pending.waiting)
+		{
+			combine(emitted);
+			pending.waiting = false;
+			pending.next++;
+		}
+
+		bool pushed = false;
+		while (pending.next < operands.size() && !pushed)
+		{
+			size_t end = pending.next;
+			while (end < operands.size() && isLeafType(scene.nodes[operands[end]].type))
+				end++;
+
+			if (end - pending.next >= minRun)
+			{
+				const int firstLeaf = static_cast<int>(nodes.size());
+				for (size_t k = pending.next; k < end; k++)
+					emit(scene.nodes[operands[k]]);
+				const int naryType = type == SHADER_TYPE_UNION ? SHADER_TYPE_NARY_UNION : SHADER_TYPE_NARY_INTERSECTION;
+				combine(emit(CSGNode::ShaderNodeData{naryType, firstLeaf, static_cast<int>(nodes.size()) - 1, -1}));
+				pending.next = end;
+			}
+			else if (isLeafType(scene.nodes[operands[pending.next]].type))
+			{
+				combine(emit(scene.nodes[operands[pending.next]]));
+				pending.next++;
+			}
+			else
+			{
+				pending.waiting = true;
+				pushed = true;
+			}
+		}
+		if (pushed)
+		{
+			const int operand = operands[pending.next];
+			stack.push_back(PendingNode{operand}); // Invalidates 'pending'
+			continue;
+		}
+		emitted = pending.result;
+		stack.pop_back();
+	}
+	return nodes;
+}
+
+std::vector<CSGNode::ShaderNodeData> CSGNaryNodes::expandNaryNodes(const CSGSceneView& scene)
+{
+	std::vector<CSGNode::ShaderNodeData> nodes;
+	nodes.reserve(scene.nbNode);
+	std::vector<int> outputIndices(scene.nbNode, -1);
+
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		CSGNode::ShaderNodeData node = scene.nodes[i];
+		if (isNaryOperation(node.type))
+		{
+			// Left-deep chain: ((c0 op c1) op c2) op ...
+			int result = outputIndices[node.leftChildIndex];
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			{
+				nodes.push_back(CSGNode::ShaderNodeData{binaryOperation(node.type), result, outputIndices[child], -1});
+				result = static_cast<int>(nodes.size()) - 1;
+			}
+			outputIndices[i] = result;
+			continue;
+		}
+
+		if (!isLeafType(node.type))
+		{
+			node.leftChildIndex = outputIndices[node.leftChildIndex];
+			if (node.type != SHADER_TYPE_COMPLEMENTARY)
+				node.rightChildIndex = outputIndices[node.rightChildIndex];
+		}
+		nodes.push_back(node);
+		outputIndices[i] = static_cast<int>(nodes.size()) - 1;
+	}
+	return nodes;
+}
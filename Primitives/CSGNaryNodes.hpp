@@ -0,0 +1,26 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+
+#include <vector>
+
+/*
+* Conversions between chains of binary operations and the n-ary operations of the node buffer (SHADER_TYPE_NARY_UNION...).
+* A union of 1000 primitives takes 999 binary nodes, each one a buffer slot, a fetch and a stack entry of the evaluators. Collapsed, it
+* is a single node reading its 1000 consecutive leaves, whose leaves the mesher and the ray queries can still cull one by one.
+*/
+class CSGNaryNodes
+{
+public:
+	/*
+	* Node buffer of 'scene' where every chain of binary unions (or intersections) is flattened into its operands, in order, and each
+	* run of at least 'minNbLeaf' consecutive primitive operands becomes an n-ary node. The other operands are combined with these nodes
+	* by binary operations from left to right, so the distances and the colors are exactly the ones of the original buffer.
+	* Existing n-ary nodes are merged into the chains around them, so collapsing a collapsed buffer does not change its size. The primitive buffers are
+	* unchanged. 'scene' must be valid (CSGBinaryScene::validateNodes()).
+	*/
+	static std::vector<CSGNode::ShaderNodeData> collapseChains(const CSGSceneView& scene, int minNbLeaf = 3);
+
+	// Node buffer of 'scene' where every n-ary node is replaced by a left-deep chain of binary operations
+	static std::vector<CSGNode::ShaderNodeData> expandNaryNodes(const CSGSceneView& scene);
+};
@@ -168,6 +168,10 @@ bool CSGNode::removeAtPreorderOperation(const int preorderIdx)
 {
 	if (preorderIdx <= 0) // Can't remove the root node
 		return false;
+	// Leaves are rejected here: the search below does not stop on them, and would go on with a shifted index
+	const NodePtr node = atPreorderChild(preorderIdx);
+	if (node == nullptr || node->isLeaf())
+		return false;
 	int idx = 0;
 	return removeAtPreorderOperationStep(idx, preorderIdx);
 }
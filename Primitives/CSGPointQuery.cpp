@@ -0,0 +1,174 @@
+#include "renderer/opengl/Primitives/CSGPointQuery.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+CSGPointQuery::CSGPointQuery(const CSGSceneView& scene, const int nbThread, CSGProgramCache* cache) :
+	_scene{scene},
+	_program{cache != nullptr ? cache->getProgram(scene) : std::make_shared<const CSGCompiledProgram>(scene)},
+	_nbThread{nbThread > 0 ? nbThread : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))}
+{
+}
+
+// Spread the 10 low bits of 'v' so that there are two zero bits between each of them
+static uint32_t spreadBits(uint32_t v)
+{
+	v &= 0x3ff;
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+std::vector<uint32_t> CSGPointQuery::spatialOrder(const glm::vec3* points, const size_t nbPoint)
+{
+	if (nbPoint == 0)
+		return {};
+
+	glm::vec3 boxMin = points[0];
+	glm::vec3 boxMax = points[0];
+	for (size_t i = 1; i < nbPoint; i++)
+	{
+		boxMin = glm::min(boxMin, points[i]);
+		boxMax = glm::max(boxMax, points[i]);
+	}
+	const glm::vec3 extent = boxMax - boxMin;
+	const glm::vec3 cellScale{extent.x > 0.f ? 1023.f / extent.x : 0.f, extent.y > 0.f ? 1023.f / extent.y : 0.f, extent.z > 0.f ? 1023.f / extent.z : 0.f};
+
+	// Morton code in the high half of the key, index of the point in the low half
+	std::vector<uint64_t> keys(nbPoint);
+	for (size_t i = 0; i < nbPoint; i++)
+	{
+		const glm::vec3 cell = (points[i] - boxMin) * cellScale;
+		const uint32_t code = (spreadBits(static_cast<uint32_t>(cell.x)) << 2) | (spreadBits(static_cast<uint32_t>(cell.y)) << 1) | spreadBits(static_cast<uint32_t>(cell.z));
+		keys[i] = (static_cast<uint64_t>(code) << 32) | static_cast<uint64_t>(i);
+	}
+
+	// Radix sort on the 30 bits of the code, in four passes of 8 bits. Stable, so points of the same cell keep their order.
+	std::vector<uint64_t> sortedKeys(nbPoint);
+	for (int shift = 32; shift < 64; shift += 8)
+	{
+		size_t offsets[256] = {};
+		for (const uint64_t key : keys)
+			offsets[(key >> shift) & 0xff]++;
+		size_t offset = 0;
+		for (size_t& bucket : offsets)
+		{
+			const size_t count = bucket;
+			bucket = offset;
+			offset += count;
+		}
+		for (const uint64_t key : keys)
+			sortedKeys[offsets[(key >> shift) & 0xff]++] = key;
+		keys.swap(sortedKeys);
+	}
+
+	std::vector<uint32_t> order(nbPoint);
+	for (size_t i = 0; i < nbPoint; i++)
+		order[i] = static_cast<uint32_t>(keys[i]);
+	return order;
+}
+
+template<typename EvaluateChunk>
+void CSGPointQuery::forEachChunk(const glm::vec3* points, const size_t nbPoint, EvaluateChunk evaluateChunk) const
+{
+	const std::vector<uint32_t> order = _spatialSorting ? spatialOrder(points, nbPoint) : std::vector<uint32_t>{};
+	const size_t nbChunk = (nbPoint + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+	std::atomic<size_t> nextChunk{0};
+	auto worker = [&]()
+	{
+		const CSGCompiledEvaluator evaluator{_scene, _program}; // One evaluator per thread, as it owns its registers
+		for (size_t chunk = nextChunk++; chunk < nbChunk; chunk = nextChunk++)
+		{
+			const size_t first = chunk * CHUNK_SIZE;
+			const int chunkSize = static_cast<int>(std::min<size_t>(CHUNK_SIZE, nbPoint - first));
+			evaluateChunk(evaluator, first, chunkSize, order.empty() ? nullptr : order.data() + first);
+		}
+	};
+
+	const int nbThread = static_cast<int>(std::min<size_t>(_nbThread, nbChunk));
+	std::vector<std::thread> threads;
+	for (int i = 1; i < nbThread; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void CSGPointQuery::distances(const glm::vec3* points, const size_t nbPoint, float* distances) const
+{
+	forEachChunk(points, nbPoint, [points, distances](const CSGCompiledEvaluator& evaluator, const size_t first, const int chunkSize, const uint32_t* order)
+	{
+		if (order == nullptr)
+		{
+			evaluator.distances(points + first, chunkSize, distances + first);
+			return;
+		}
+
+		glm::vec3 chunkPoints[CHUNK_SIZE];
+		float chunkDistances[CHUNK_SIZE];
+		for (int i = 0; i < chunkSize; i++)
+			chunkPoints[i] = points[order[i]];
+		evaluator.distances(chunkPoints, chunkSize, chunkDistances);
+		for (int i = 0; i < chunkSize; i++)
+			distances[order[i]] = chunkDistances[i];
+	});
+}
+
+std::vector<float> CSGPointQuery::distances(const std::vector<glm::vec3>& points) const
+{
+	std::vector<float> result(points.size());
+	distances(points.data(), points.size(), result.data());
+	return result;
+}
+
+void CSGPointQuery::inside(const glm::vec3* points, const size_t nbPoint, uint8_t* inside) const
+{
+	forEachChunk(points, nbPoint, [points, inside](const CSGCompiledEvaluator& evaluator, const size_t first, const int chunkSize, const uint32_t* order)
+	{
+		glm::vec3 chunkPoints[CHUNK_SIZE];
+		float chunkDistances[CHUNK_SIZE];
+		for (int i = 0; i < chunkSize; i++)
+			chunkPoints[i] = points[order != nullptr ? order[i] : first + i];
+		evaluator.distances(chunkPoints, chunkSize, chunkDistances);
+		for (int i = 0; i < chunkSize; i++)
+			inside[order != nullptr ? order[i] : first + i] = chunkDistances[i] <= 0.f ? 1 : 0;
+	});
+}
+
+std::vector<uint8_t> CSGPointQuery::inside(const std::vector<glm::vec3>& points) const
+{
+	std::vector<uint8_t> result(points.size());
+	inside(points.data(), points.size(), result.data());
+	return result;
+}
+
+void CSGPointQuery::evaluate(const glm::vec3* points, const size_t nbPoint, CSGEvaluation* results) const
+{
+	forEachChunk(points, nbPoint, [points, results](const CSGCompiledEvaluator& evaluator, const size_t first, const int chunkSize, const uint32_t* order)
+	{
+		if (order == nullptr)
+		{
+			evaluator.evaluate(points + first, chunkSize, results + first);
+			return;
+		}
+
+		glm::vec3 chunkPoints[CHUNK_SIZE];
+		CSGEvaluation chunkResults[CHUNK_SIZE];
+		for (int i = 0; i < chunkSize; i++)
+			chunkPoints[i] = points[order[i]];
+		evaluator.evaluate(chunkPoints, chunkSize, chunkResults);
+		for (int i = 0; i < chunkSize; i++)
+			results[order[i]] = chunkResults[i];
+	});
+}
+
+std::vector<CSGEvaluation> CSGPointQuery::evaluate(const std::vector<glm::vec3>& points) const
+{
+	std::vector<CSGEvaluation> result(points.size());
+	evaluate(points.data(), points.size(), result.data());
+	return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+* Queries of the distance field of a scene at large sets of arbitrary points (collision checks, occupancy maps).
+* Points are split in chunks shared between worker threads, and each thread runs a CSGCompiledEvaluator on its chunks, so the
+* node loops are vectorized over the points of a batch. Results are identical to a single CSGCompiledEvaluator call, whatever the
+* number of threads or the order of the points.
+*
+* With spatial sorting, points are evaluated in the order of their Morton code in the bounding box of the query: a chunk then
+* covers a compact region of space instead of points scattered over the whole scene. Results are still written at the index of
+* their point. It is off by default: the compiled program visits every node for every batch, so the sort and the scattered writes
+* cost more than they save (about 7% slower on benchmarkPointQuery). Enable it for callers that reuse work between nearby points.
+*/
+class CSGPointQuery
+{
+public:
+	// Points evaluated by a thread before taking the next chunk
+	static constexpr int CHUNK_SIZE = 16 * CSGCompiledProgram::BATCH_SIZE;
+
+	// 'cache' may be null, the program is then compiled for this query only. 0 threads means one thread per hardware thread.
+	explicit CSGPointQuery(const CSGSceneView& scene, int nbThread = 0, CSGProgramCache* cache = nullptr);
+
+	void setSpatialSorting(bool spatialSorting) { _spatialSorting = spatialSorting; }
+	[[nodiscard]] bool getSpatialSorting() const { return _spatialSorting; }
+
+	// Signed distance of the scene at each point
+	void distances(const glm::vec3* points, size_t nbPoint, float* distances) const;
+	std::vector<float> distances(const std::vector<glm::vec3>& points) const;
+
+	// 1 for the points inside the scene or on its surface (distance <= 0), 0 for the others
+	void inside(const glm::vec3* points, size_t nbPoint, uint8_t* inside) const;
+	std::vector<uint8_t> inside(const std::vector<glm::vec3>& points) const;
+
+	// Distance and color at each point, the color being resolved as in scanCSG()
+	void evaluate(const glm::vec3* points, size_t nbPoint, CSGEvaluation* results) const;
+	std::vector<CSGEvaluation> evaluate(const std::vector<glm::vec3>& points) const;
+
+	/*
+	* Order in which the points are evaluated with spatial sorting: indices of the points sorted by their 30 bit Morton code
+	* (10 bits per axis) in the bounding box of the points
+	*/
+	static std::vector<uint32_t> spatialOrder(const glm::vec3* points, size_t nbPoint);
+
+private:
+	/*
+	* Run 'evaluateChunk(evaluator, first, nbPoint, order)' on every chunk from the worker threads. 'order' is null without spatial
+	* sorting, otherwise the chunk covers order[first] to order[first + nbPoint - 1].
+	*/
+	template<typename EvaluateChunk>
+	void forEachChunk(const glm::vec3* points, size_t nbPoint, EvaluateChunk evaluateChunk) const;
+
+	CSGSceneView _scene;
+	std::shared_ptr<const CSGCompiledProgram> _program;
+	int _nbThread;
+	bool _spatialSorting = false;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGDistanceBounds.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+
+/*
+* Primitive SDFs in local space, straight ports of the GLSL functions of PrimitiveSceneSDF.glsl.
+* Shared by every CPU evaluator so they all give the same distances as the shader.
+*/
+inline float sphereSDF(const SphereData& sphere, const glm::vec3& p)
+{
+	return glm::length(p) - sphere.radius;
+}
+
+inline float torusSDF(const TorusData& torus, const glm::vec3& p)
+{
+	const float x = glm::length(glm::vec2(p.x, p.z)) - torus.majorRadius;
+	const float y = p.y;
+	return glm::length(glm::vec2(x, y)) - torus.minorRadius;
+}
+
+inline float cylinderSDF(const CylinderData& cylinder, const glm::vec3& pos)
+{
+	const glm::vec2 d = glm::abs(glm::vec2(glm::length(glm::vec2(pos.x, pos.z)), pos.y)) - glm::vec2(cylinder.radius, cylinder.height);
+	return std::min(std::max(d.x, d.y), 0.f) + glm::length(glm::max(d, glm::vec2(0.f)));
+}
+
+inline float boxSDF(const BoxData& box, const glm::vec3& pos)
+{
+	const glm::vec3 q = glm::abs(pos) - box.size;
+	return glm::length(glm::max(q, glm::vec3(0.f))) + std::min(std::max(q.x, std::max(q.y, q.z)), 0.f);
+}
+
+/*
+* Smooth operations with a blend radius k > 0, ports of smoothUnionSDF()... of PrimitiveSceneSDF.glsl (polynomial smooth min).
+* They are min / max where |a - b| >= k, and at most k / 4 below / above them in the blend. 'h' is the weight of 'a' in the blend:
+* the color is mix(colorB, colorA, h) and the gradient h * gradientA + (1 - h) * gradientB, exactly.
+*/
+inline float smoothUnionSDF(const float a, const float b, const float k, float& h)
+{
+	h = std::clamp(0.5f + 0.5f * (b - a) / k, 0.f, 1.f);
+	return b + (a - b) * h - k * h * (1.f - h);
+}
+
+inline float smoothIntersectionSDF(const float a, const float b, const float k, float& h)
+{
+	h = std::clamp(0.5f - 0.5f * (b - a) / k, 0.f, 1.f);
+	return b + (a - b) * h + k * h * (1.f - h);
+}
+
+// Smooth intersection with the complement of 'b': the weight of -b is 1 - h
+inline float smoothDifferenceSDF(const float a, const float b, const float k, float& h)
+{
+	return smoothIntersectionSDF(a, -b, k, h);
+}
+
+// Distance of a SHADER_TYPE_SMOOTH_* node from the distances of its children
+inline float smoothOperationSDF(const int type, const float a, const float b, const float k, float& h)
+{
+	if (type == SHADER_TYPE_SMOOTH_UNION)
+		return smoothUnionSDF(a, b, k, h);
+	if (type == SHADER_TYPE_SMOOTH_INTERSECTION)
+		return smoothIntersectionSDF(a, b, k, h);
+	return smoothDifferenceSDF(a, b, k, h);
+}
+
+// Rows of the affine matrix 'matrix', in the layout of the records (its last row must be 0, 0, 0, 1)
+inline glm::mat3x4 affineRows(const glm::mat4& matrix)
+{
+	return glm::mat3x4(glm::transpose(matrix));
+}
+
+inline glm::mat4 affineMatrix(const glm::mat3x4& rows)
+{
+	return glm::transpose(glm::mat4(rows));
+}
+
+// Local position of 'pos' for the rows of an inverse transform, as vec4(pos, 1.) * rows in the shader. Written out so the translation
+// is an add instead of a product by w = 1, and so the three rows are independent dot products.
+inline glm::vec3 transformPoint(const glm::mat3x4& rows, const glm::vec3& pos)
+{
+	return glm::vec3(rows[0].x * pos.x + rows[0].y * pos.y + rows[0].z * pos.z + rows[0].w,
+		rows[1].x * pos.x + rows[1].y * pos.y + rows[1].z * pos.z + rows[1].w,
+		rows[2].x * pos.x + rows[2].y * pos.y + rows[2].z * pos.z + rows[2].w);
+}
+
+inline glm::vec3 transformDirection(const glm::mat3x4& rows, const glm::vec3& direction)
+{
+	return glm::vec3(rows[0].x * direction.x + rows[0].y * direction.y + rows[0].z * direction.z,
+		rows[1].x * direction.x + rows[1].y * direction.y + rows[1].z * direction.z,
+		rows[2].x * direction.x + rows[2].y * direction.y + rows[2].z * direction.z);
+}
+
+/*
+* Scale correction of the distance computed in the local space of a primitive: the smallest scale of its transform, i.e. one over the
+* largest singular value of its inverse. A local distance times this factor never overestimates the world distance, and is exact for
+* rigid and uniformly scaled transforms.
+*/
+inline float distanceScale(const glm::mat4& inverseTransform)
+{
+	return 1.f / CSGDistanceBounds::singularValueRange(glm::mat3(inverseTransform)).y;
+}
+
+// Write the inverse transform of a primitive and its precomputed distance scale in its record
+template<typename Data>
+void setInverseTransform(Data& record, const glm::mat4& inverseTransform)
+{
+	record.inverseTransform = affineRows(inverseTransform);
+	record.scale = distanceScale(inverseTransform);
+}
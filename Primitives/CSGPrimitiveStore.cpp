@@ -0,0 +1,576 @@
+#include "renderer/opengl/Primitives/CSGPrimitiveStore.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+#include <imgui.h>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+void PrimitiveTransformArrays::reserve(const size_t nbPrimitive)
+{
+	translations.reserve(nbPrimitive);
+	rotations.reserve(nbPrimitive);
+	scales.reserve(nbPrimitive);
+	colors.reserve(nbPrimitive);
+	inverseTransforms.reserve(nbPrimitive);
+	distanceScales.reserve(nbPrimitive);
+}
+
+void PrimitiveTransformArrays::push(const glm::mat4& transform, const glm::vec3& color)
+{
+	translations.emplace_back(0.f);
+	rotations.emplace_back();
+	scales.emplace_back(1.f);
+	colors.push_back(color);
+	inverseTransforms.emplace_back(1.f);
+	distanceScales.push_back(1.f);
+	setTransform(size() - 1, transform);
+}
+
+void PrimitiveTransformArrays::pushInverse(const glm::mat3x4& inverseTransform, const float distanceScale, const glm::vec3& color)
+{
+	push(glm::inverse(affineMatrix(inverseTransform)), color);
+
+	// The decomposition is only used for editing, the record itself is kept unchanged
+	const int index = size() - 1;
+	inverseTransforms[index] = inverseTransform;
+	distanceScales[index] = distanceScale;
+}
+
+glm::mat4 PrimitiveTransformArrays::transform(const int index) const
+{
+	// Same composition as Primitive::getTransform()
+	const glm::mat4 translationMat = glm::translate(glm::mat4(1.), translations[index]);
+	const glm::mat4 scaleMat = glm::scale(glm::mat4(1.), scales[index]);
+	return translationMat * glm::mat4(rotations[index]) * scaleMat;
+}
+
+void PrimitiveTransformArrays::setTransform(const int index, const glm::mat4& transform)
+{
+	glm::vec3 skewIgnored;
+	glm::vec4 perspectiveIgnored;
+	decompose(transform, scales[index], rotations[index], translations[index], skewIgnored, perspectiveIgnored);
+	updateInverseTransform(index);
+}
+
+void PrimitiveTransformArrays::updateInverseTransform(const int index)
+{
+	const glm::mat4 inverseTransform = glm::inverse(transform(index));
+	inverseTransforms[index] = affineRows(inverseTransform);
+	distanceScales[index] = distanceScale(inverseTransform);
+}
+
+CSGPrimitiveStore::CSGPrimitiveStore(const CSGSceneView& scene) :
+	_nodes(scene.nodes, scene.nodes + scene.nbNode)
+{
+	_spheres.reserve(scene.nbSphere);
+	_spheres.radii.reserve(scene.nbSphere);
+	for (int i = 0; i < scene.nbSphere; i++)
+	{
+		_spheres.pushInverse(scene.spheres[i].inverseTransform, scene.spheres[i].scale, scene.spheres[i].color);
+		_spheres.radii.push_back(scene.spheres[i].radius);
+	}
+
+	_toruses.reserve(scene.nbTorus);
+	_toruses.majorRadii.reserve(scene.nbTorus);
+	_toruses.minorRadii.reserve(scene.nbTorus);
+	for (int i = 0; i < scene.nbTorus; i++)
+	{
+		_toruses.pushInverse(scene.toruses[i].inverseTransform, scene.toruses[i].scale, scene.toruses[i].color);
+		_toruses.majorRadii.push_back(scene.toruses[i].majorRadius);
+		_toruses.minorRadii.push_back(scene.toruses[i].minorRadius);
+	}
+
+	_cylinders.reserve(scene.nbCylinder);
+	_cylinders.heights.reserve(scene.nbCylinder);
+	_cylinders.radii.reserve(scene.nbCylinder);
+	for (int i = 0; i < scene.nbCylinder; i++)
+	{
+		_cylinders.pushInverse(scene.cylinders[i].inverseTransform, scene.cylinders[i].scale, scene.cylinders[i].color);
+		_cylinders.heights.push_back(scene.cylinders[i].height);
+		_cylinders.radii.push_back(scene.cylinders[i].radius);
+	}
+
+	_boxes.reserve(scene.nbBox);
+	_boxes.sizes.reserve(scene.nbBox);
+	for (int i = 0; i < scene.nbBox; i++)
+	{
+		_boxes.pushInverse(scene.boxes[i].inverseTransform, scene.boxes[i].scale, scene.boxes[i].color);
+		_boxes.sizes.push_back(scene.boxes[i].size);
+	}
+}
+
+CSGPrimitiveStore::CSGPrimitiveStore(const CSGTree& tree) :
+	CSGPrimitiveStore(CSGSceneData{tree}.view())
+{
+}
+
+PrimitiveHandle CSGPrimitiveStore::addSphere(const glm::mat4& transform, const glm::vec3& color, const float radius)
+{
+	_spheres.push(transform, color);
+	_spheres.radii.push_back(radius);
+	return {Primitive::PrimitiveType::Sphere, _spheres.size() - 1};
+}
+
+PrimitiveHandle CSGPrimitiveStore::addTorus(const glm::mat4& transform, const glm::vec3& color, const float majorRadius, const float minorRadius)
+{
+	_toruses.push(transform, color);
+	_toruses.majorRadii.push_back(majorRadius);
+	_toruses.minorRadii.push_back(minorRadius);
+	return {Primitive::PrimitiveType::Torus, _toruses.size() - 1};
+}
+
+PrimitiveHandle CSGPrimitiveStore::addCylinder(const glm::mat4& transform, const glm::vec3& color, const float height, const float radius)
+{
+	_cylinders.push(transform, color);
+	_cylinders.heights.push_back(height);
+	_cylinders.radii.push_back(radius);
+	return {Primitive::PrimitiveType::Cylinder, _cylinders.size() - 1};
+}
+
+PrimitiveHandle CSGPrimitiveStore::addBox(const glm::mat4& transform, const glm::vec3& color, const glm::vec3& size)
+{
+	_boxes.push(transform, color);
+	_boxes.sizes.push_back(size);
+	return {Primitive::PrimitiveType::Box, _boxes.size() - 1};
+}
+
+int CSGPrimitiveStore::addLeaf(const PrimitiveHandle handle)
+{
+	_nodes.push_back(CSGNode::ShaderNodeData{shaderType(handle.type), -1, -1, handle.index});
+	return static_cast<int>(_nodes.size()) - 1;
+}
+
+int CSGPrimitiveStore::addOperation(const int type, const int leftChildIndex, const int rightChildIndex)
+{
+	_nodes.push_back(CSGNode::ShaderNodeData{type, leftChildIndex, type == SHADER_TYPE_COMPLEMENTARY ? -1 : rightChildIndex, -1});
+	return static_cast<int>(_nodes.size()) - 1;
+}
+
+int CSGPrimitiveStore::addSmoothOperation(const int type, const int leftChildIndex, const int rightChildIndex, const float blendRadius)
+{
+	_nodes.push_back(smoothOperationNode(type, leftChildIndex, rightChildIndex, blendRadius));
+	return static_cast<int>(_nodes.size()) - 1;
+}
+
+PrimitiveHandle CSGPrimitiveStore::leafHandle(const CSGNode::ShaderNodeData& node)
+{
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+		return {Primitive::PrimitiveType::Sphere, node.primitiveIndex};
+	case SHADER_TYPE_TORUS:
+		return {Primitive::PrimitiveType::Torus, node.primitiveIndex};
+	case SHADER_TYPE_CYLINDER:
+		return {Primitive::PrimitiveType::Cylinder, node.primitiveIndex};
+	case SHADER_TYPE_BOX:
+		return {Primitive::PrimitiveType::Box, node.primitiveIndex};
+	default:
+		return {};
+	}
+}
+
+int CSGPrimitiveStore::shaderType(const Primitive::PrimitiveType type)
+{
+	// Same type codes as CSGNode::nodeRawData()
+	switch (type)
+	{
+	case Primitive::PrimitiveType::Sphere:
+		return SHADER_TYPE_SPHERE;
+	case Primitive::PrimitiveType::Torus:
+		return SHADER_TYPE_TORUS;
+	case Primitive::PrimitiveType::Cylinder:
+		return SHADER_TYPE_CYLINDER;
+	case Primitive::PrimitiveType::Box:
+		return SHADER_TYPE_BOX;
+	default:
+		return -1;
+	}
+}
+
+int CSGPrimitiveStore::getNbPrimitive(const Primitive::PrimitiveType type) const
+{
+	return type == Primitive::PrimitiveType::MAX ? 0 : transformArrays(type).size();
+}
+
+const PrimitiveTransformArrays& CSGPrimitiveStore::transformArrays(const Primitive::PrimitiveType type) const
+{
+	switch (type)
+	{
+	case Primitive::PrimitiveType::Torus:
+		return _toruses;
+	case Primitive::PrimitiveType::Cylinder:
+		return _cylinders;
+	case Primitive::PrimitiveType::Box:
+		return _boxes;
+	case Primitive::PrimitiveType::Sphere:
+	default:
+		return _spheres;
+	}
+}
+
+PrimitiveTransformArrays& CSGPrimitiveStore::transformArrays(const Primitive::PrimitiveType type)
+{
+	return const_cast<PrimitiveTransformArrays&>(static_cast<const CSGPrimitiveStore*>(this)->transformArrays(type));
+}
+
+SphereData CSGPrimitiveStore::sphereRecord(const int index) const
+{
+	SphereData sphere{};
+	sphere.inverseTransform = _spheres.inverseTransforms[index];
+	sphere.color = _spheres.colors[index];
+	sphere.scale = _spheres.distanceScales[index];
+	sphere.radius = _spheres.radii[index];
+	return sphere;
+}
+
+TorusData CSGPrimitiveStore::torusRecord(const int index) const
+{
+	TorusData torus{};
+	torus.inverseTransform = _toruses.inverseTransforms[index];
+	torus.color = _toruses.colors[index];
+	torus.scale = _toruses.distanceScales[index];
+	torus.majorRadius = _toruses.majorRadii[index];
+	torus.minorRadius = _toruses.minorRadii[index];
+	return torus;
+}
+
+CylinderData CSGPrimitiveStore::cylinderRecord(const int index) const
+{
+	CylinderData cylinder{};
+	cylinder.inverseTransform = _cylinders.inverseTransforms[index];
+	cylinder.color = _cylinders.colors[index];
+	cylinder.scale = _cylinders.distanceScales[index];
+	cylinder.height = _cylinders.heights[index];
+	cylinder.radius = _cylinders.radii[index];
+	return cylinder;
+}
+
+BoxData CSGPrimitiveStore::boxRecord(const int index) const
+{
+	BoxData box{};
+	box.inverseTransform = _boxes.inverseTransforms[index];
+	box.color = _boxes.colors[index];
+	box.scale = _boxes.distanceScales[index];
+	box.size = _boxes.sizes[index];
+	return box;
+}
+
+CSGSceneData CSGPrimitiveStore::sceneData() const
+{
+	std::vector<SphereData> spheres(_spheres.size());
+	for (int i = 0; i < _spheres.size(); i++)
+		spheres[i] = sphereRecord(i);
+
+	std::vector<TorusData> toruses(_toruses.size());
+	for (int i = 0; i < _toruses.size(); i++)
+		toruses[i] = torusRecord(i);
+
+	std::vector<CylinderData> cylinders(_cylinders.size());
+	for (int i = 0; i < _cylinders.size(); i++)
+		cylinders[i] = cylinderRecord(i);
+
+	std::vector<BoxData> boxes(_boxes.size());
+	for (int i = 0; i < _boxes.size(); i++)
+		boxes[i] = boxRecord(i);
+
+	return CSGSceneData{_nodes, std::move(spheres), std::move(toruses), std::move(cylinders), std::move(boxes)};
+}
+
+std::vector<uint8_t> CSGPrimitiveStore::treeRawData() const
+{
+	std::vector<uint8_t> rawData(_nodes.size() * sizeof(CSGNode::ShaderNodeData));
+	if (!rawData.empty())
+		memcpy(rawData.data(), _nodes.data(), rawData.size());
+	return rawData;
+}
+
+std::vector<uint8_t> CSGPrimitiveStore::rawDataByPrimitiveType(const Primitive::PrimitiveType type) const
+{
+	auto serialize = [](const int nbPrimitive, auto record)
+	{
+		using Record = decltype(record(0));
+		std::vector<uint8_t> rawData(nbPrimitive * sizeof(Record));
+		for (int i = 0; i < nbPrimitive; i++)
+		{
+			const Record data = record(i);
+			memcpy(rawData.data() + i * sizeof(Record), &data, sizeof(Record));
+		}
+		return rawData;
+	};
+
+	switch (type)
+	{
+	case Primitive::PrimitiveType::Sphere:
+		return serialize(_spheres.size(), [this](const int i) { return sphereRecord(i); });
+	case Primitive::PrimitiveType::Torus:
+		return serialize(_toruses.size(), [this](const int i) { return torusRecord(i); });
+	case Primitive::PrimitiveType::Cylinder:
+		return serialize(_cylinders.size(), [this](const int i) { return cylinderRecord(i); });
+	case Primitive::PrimitiveType::Box:
+		return serialize(_boxes.size(), [this](const int i) { return boxRecord(i); });
+	default:
+		return {};
+	}
+}
+
+PrimitiveRef::PrimitiveRef(CSGPrimitiveStore& store, const PrimitiveHandle handle) :
+	_store{&store},
+	_handle{handle}
+{
+}
+
+glm::mat4 PrimitiveRef::getInverseTransform() const
+{
+	return affineMatrix(_store->transformArrays(_handle.type).inverseTransforms[_handle.index]);
+}
+
+glm::vec3 PrimitiveRef::getEulerAngles() const
+{
+	return glm::degrees(glm::eulerAngles(_store->transformArrays(_handle.type).rotations[_handle.index]));
+}
+
+void PrimitiveRef::setEulerAngles(const glm::vec3& eulerAngles)
+{
+	_store->transformArrays(_handle.type).rotations[_handle.index] = glm::quat(glm::radians(eulerAngles));
+	_store->updateInverseTransform(_handle);
+}
+
+const glm::vec3& PrimitiveRef::getColor() const
+{
+	return _store->getColor(_handle);
+}
+
+void PrimitiveRef::setColor(const glm::vec3& color)
+{
+	_store->transformArrays(_handle.type).colors[_handle.index] = color;
+}
+
+std::vector<uint8_t> PrimitiveRef::rawData() const
+{
+	auto toBytes = [](const auto& record)
+	{
+		std::vector<uint8_t> rawData(sizeof(record));
+		memcpy(rawData.data(), &record, sizeof(record));
+		return rawData;
+	};
+
+	switch (_handle.type)
+	{
+	case Primitive::PrimitiveType::Sphere:
+		return toBytes(_store->sphereRecord(_handle.index));
+	case Primitive::PrimitiveType::Torus:
+		return toBytes(_store->torusRecord(_handle.index));
+	case Primitive::PrimitiveType::Cylinder:
+		return toBytes(_store->cylinderRecord(_handle.index));
+	case Primitive::PrimitiveType::Box:
+		return toBytes(_store->boxRecord(_handle.index));
+	default:
+		return {};
+	}
+}
+
+bool PrimitiveRef::modifySelectedPrimitiveUI(const std::string& primitiveName)
+{
+	PrimitiveTransformArrays& arrays = _store->transformArrays(_handle.type);
+	const int i = _handle.index;
+	bool modified = false;
+	bool transformModified = false;
+
+	ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), primitiveName.c_str());
+	if (ImGui::DragFloat3((primitiveName + " translation").c_str(), &arrays.translations[i].x))
+		transformModified = true;
+
+	glm::vec3 euler = getEulerAngles();
+	if (ImGui::DragFloat3((primitiveName + " rotation").c_str(), &euler.x, 0.5f, -180.f, 180.f))
+	{
+		arrays.rotations[i] = glm::quat(glm::radians(euler));
+		transformModified = true;
+	}
+
+	if (ImGui::DragFloat3((primitiveName + " scale").c_str(), &arrays.scales[i].x, 0.01f, 0.1f, 4))
+	{
+		arrays.scales[i] = glm::max(arrays.scales[i], glm::vec3(0.001f));
+		transformModified = true;
+	}
+
+	float color[3] = { arrays.colors[i].x, arrays.colors[i].y, arrays.colors[i].z };
+	if (ImGui::ColorEdit3((primitiveName + " color").c_str(), color))
+	{
+		arrays.colors[i] = glm::clamp(glm::vec3(color[0], color[1], color[2]), glm::vec3(0.f), glm::vec3(255.f));
+		modified = true;
+	}
+
+	if (transformModified)
+		arrays.updateInverseTransform(i);
+
+	// Parameters of each type, same widgets as the overrides of the Primitive subclasses
+	auto dragPositive = [&primitiveName, &modified](const char* label, float& value)
+	{
+		if (ImGui::DragFloat((primitiveName + label).c_str(), &value, 0.01f, 0.1f))
+		{
+			value = std::max(value, 0.001f);
+			modified = true;
+		}
+	};
+
+	switch (_handle.type)
+	{
+	case Primitive::PrimitiveType::Sphere:
+		dragPositive(" radius", _store->getSpheres().radii[i]);
+		break;
+	case Primitive::PrimitiveType::Torus:
+		dragPositive(" major radius", _store->getToruses().majorRadii[i]);
+		dragPositive(" minor radius", _store->getToruses().minorRadii[i]);
+		break;
+	case Primitive::PrimitiveType::Cylinder:
+		dragPositive(" height", _store->getCylinders().heights[i]);
+		dragPositive(" radius", _store->getCylinders().radii[i]);
+		break;
+	case Primitive::PrimitiveType::Box:
+		if (ImGui::DragFloat3((primitiveName + " size").c_str(), &_store->getBoxes().sizes[i].x, 0.01f, 0.1f))
+		{
+			_store->getBoxes().sizes[i] = glm::max(_store->getBoxes().sizes[i], glm::vec3(0.001f));
+			modified = true;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return modified || transformModified;
+}
+
+CSGStoreEvaluator::CSGStoreEvaluator(const CSGPrimitiveStore& store) :
+	_store{&store},
+	_nodeDistances(store.getNbNode()),
+	_nodeLeaves(store.getNbNode())
+{
+	_primitiveDistances[SHADER_TYPE_SPHERE - SHADER_TYPE_SPHERE].resize(store.getSpheres().size());
+	_primitiveDistances[SHADER_TYPE_TORUS - SHADER_TYPE_SPHERE].resize(store.getToruses().size());
+	_primitiveDistances[SHADER_TYPE_CYLINDER - SHADER_TYPE_SPHERE].resize(store.getCylinders().size());
+	_primitiveDistances[SHADER_TYPE_BOX - SHADER_TYPE_SPHERE].resize(store.getBoxes().size());
+}
+
+CSGEvaluation CSGStoreEvaluator::scanSDF(const glm::vec3& pos) const
+{
+	_nbEvaluation++;
+	const std::vector<CSGNode::ShaderNodeData>& nodes = _store->getNodes();
+	if (nodes.empty())
+		return {glm::vec3(0.f), std::numeric_limits<float>::infinity()};
+
+	/*
+	* Distances of every primitive, one loop per type. The SDFs are the ones of PrimitiveSceneSDF.glsl, with the same
+	* scale correction as CSGEvaluator, so the results are identical.
+	*/
+	auto evaluateType = [&pos](const PrimitiveTransformArrays& arrays, std::vector<float>& distances, auto sdf)
+	{
+		const int nbPrimitive = arrays.size();
+		for (int i = 0; i < nbPrimitive; i++)
+		{
+			const glm::vec3 p = transformPoint(arrays.inverseTransforms[i], pos);
+			distances[i] = sdf(i, p) * arrays.distanceScales[i];
+		}
+	};
+
+	const SphereArrays& spheres = _store->getSpheres();
+	evaluateType(spheres, _primitiveDistances[SHADER_TYPE_SPHERE - SHADER_TYPE_SPHERE], [&spheres](const int i, const glm::vec3& p)
+	{
+		return glm::length(p) - spheres.radii[i];
+	});
+
+	const TorusArrays& toruses = _store->getToruses();
+	evaluateType(toruses, _primitiveDistances[SHADER_TYPE_TORUS - SHADER_TYPE_SPHERE], [&toruses](const int i, const glm::vec3& p)
+	{
+		const float x = glm::length(glm::vec2(p.x, p.z)) - toruses.majorRadii[i];
+		return glm::length(glm::vec2(x, p.y)) - toruses.minorRadii[i];
+	});
+
+	const CylinderArrays& cylinders = _store->getCylinders();
+	evaluateType(cylinders, _primitiveDistances[SHADER_TYPE_CYLINDER - SHADER_TYPE_SPHERE], [&cylinders](const int i, const glm::vec3& p)
+	{
+		const glm::vec2 d = glm::abs(glm::vec2(glm::length(glm::vec2(p.x, p.z)), p.y)) - glm::vec2(cylinders.radii[i], cylinders.heights[i]);
+		return std::min(std::max(d.x, d.y), 0.f) + glm::length(glm::max(d, glm::vec2(0.f)));
+	});
+
+	const BoxArrays& boxes = _store->getBoxes();
+	evaluateType(boxes, _primitiveDistances[SHADER_TYPE_BOX - SHADER_TYPE_SPHERE], [&boxes](const int i, const glm::vec3& p)
+	{
+		const glm::vec3 q = glm::abs(p) - boxes.sizes[i];
+		return glm::length(glm::max(q, glm::vec3(0.f))) + std::min(std::max(q.x, std::max(q.y, q.z)), 0.f);
+	});
+
+	// Operation pass: only selects distances, the leaf responsible for the distance of each node is carried along for its color
+	const int nbNode = static_cast<int>(nodes.size());
+	for (int i = 0; i < nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = nodes[i];
+		switch (node.type)
+		{
+		case SHADER_TYPE_SPHERE:
+		case SHADER_TYPE_TORUS:
+		case SHADER_TYPE_CYLINDER:
+		case SHADER_TYPE_BOX:
+			_nodeDistances[i] = _primitiveDistances[node.type - SHADER_TYPE_SPHERE][node.primitiveIndex];
+			_nodeLeaves[i] = i;
+			break;
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_DIFFERENCE:
+		{
+			const float a = _nodeDistances[node.leftChildIndex];
+			const float b = _nodeDistances[node.rightChildIndex];
+
+			float dist;
+			if (node.type == SHADER_TYPE_INTERSECTION)
+				dist = std::max(a, b);
+			else if (node.type == SHADER_TYPE_UNION)
+				dist = std::min(a, b);
+			else
+				dist = std::max(a, -b);
+
+			_nodeLeaves[i] = dist == a ? _nodeLeaves[node.leftChildIndex] : _nodeLeaves[node.rightChildIndex];
+			_nodeDistances[i] = dist;
+			break;
+		}
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		{
+			// Only one leaf can be carried: the color is the one of the child with the larger weight in the blend
+			float h;
+			_nodeDistances[i] = smoothOperationSDF(node.type, _nodeDistances[node.leftChildIndex], _nodeDistances[node.rightChildIndex], blendRadius(node), h);
+			_nodeLeaves[i] = h >= 0.5f ? _nodeLeaves[node.leftChildIndex] : _nodeLeaves[node.rightChildIndex];
+			break;
+		}
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+		{
+			const bool unionNode = node.type == SHADER_TYPE_NARY_UNION;
+			int selected = node.leftChildIndex;
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			{
+				if (unionNode ? _nodeDistances[child] < _nodeDistances[selected] : _nodeDistances[child] > _nodeDistances[selected])
+					selected = child;
+			}
+			_nodeDistances[i] = _nodeDistances[selected];
+			_nodeLeaves[i] = _nodeLeaves[selected];
+			break;
+		}
+		case SHADER_TYPE_COMPLEMENTARY:
+			_nodeDistances[i] = -_nodeDistances[node.leftChildIndex];
+			_nodeLeaves[i] = -1; // Black, as in the shader
+			break;
+		default:
+			_nodeDistances[i] = std::numeric_limits<float>::infinity();
+			_nodeLeaves[i] = -1;
+			break;
+		}
+	}
+
+	const int rootLeaf = _nodeLeaves[nbNode - 1];
+	const glm::vec3 color = rootLeaf < 0 ? glm::vec3(0.f) : _store->getColor(_store->getLeafHandle(rootLeaf));
+	return {color, _nodeDistances[nbNode - 1]};
+}
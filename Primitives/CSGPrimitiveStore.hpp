@@ -0,0 +1,215 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/*
+* Reference to a primitive of a CSGPrimitiveStore: its type and its index in the arrays of this type.
+* A leaf of the node buffer carries the same information (node type and primitiveIndex), see CSGPrimitiveStore::leafHandle().
+*/
+struct PrimitiveHandle
+{
+	Primitive::PrimitiveType type = Primitive::PrimitiveType::MAX;
+	int index = -1;
+
+	[[nodiscard]] bool isValid() const { return type != Primitive::PrimitiveType::MAX && index >= 0; }
+	bool operator==(const PrimitiveHandle& other) const { return type == other.type && index == other.index; }
+	bool operator!=(const PrimitiveHandle& other) const { return !(*this == other); }
+};
+
+/*
+* Attributes shared by every primitive type, one array per attribute.
+* The inverse transform (affine rows, as in the records) and the distance scale (see distanceScale()) are cached, they are the only
+* transform data read by the evaluation loops and the serialization.
+*/
+struct PrimitiveTransformArrays
+{
+	std::vector<glm::vec3> translations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+	std::vector<glm::vec3> colors;
+	std::vector<glm::mat3x4> inverseTransforms;
+	std::vector<float> distanceScales;
+
+	[[nodiscard]] int size() const { return static_cast<int>(colors.size()); }
+	void reserve(size_t nbPrimitive);
+
+	// Append a primitive placed by 'transform', decomposed like Primitive::setTransform()
+	void push(const glm::mat4& transform, const glm::vec3& color);
+	// Append a serialized primitive, its inverse transform and distance scale are kept bit for bit
+	void pushInverse(const glm::mat3x4& inverseTransform, float distanceScale, const glm::vec3& color);
+
+	[[nodiscard]] glm::mat4 transform(int index) const;
+	void setTransform(int index, const glm::mat4& transform);
+	// Recompute the cached inverse transform and distance scale from the translation, rotation and scale of the primitive
+	void updateInverseTransform(int index);
+};
+
+struct SphereArrays : PrimitiveTransformArrays
+{
+	std::vector<float> radii;
+};
+
+struct TorusArrays : PrimitiveTransformArrays
+{
+	std::vector<float> majorRadii;
+	std::vector<float> minorRadii;
+};
+
+struct CylinderArrays : PrimitiveTransformArrays
+{
+	std::vector<float> heights; // Half height, as in CylinderData
+	std::vector<float> radii;
+};
+
+struct BoxArrays : PrimitiveTransformArrays
+{
+	std::vector<glm::vec3> sizes; // Half extents, as in BoxData
+};
+
+/*
+* Scene container storing the primitives grouped by type, in structure of arrays, next to the postorder node buffer whose leaves
+* reference them by handle (node type + primitiveIndex).
+* There is no virtual call and no pointer chasing between primitives: serialization and evaluation are one tight loop per type.
+* PrimitiveRef gives the usual Primitive API (transform, color, rawData, UI) on top of a handle.
+*/
+class CSGPrimitiveStore
+{
+public:
+	CSGPrimitiveStore() = default;
+	// Copy of a serialized scene. The records keep their inverse transform, which is decomposed once for editing.
+	explicit CSGPrimitiveStore(const CSGSceneView& scene);
+	explicit CSGPrimitiveStore(const CSGTree& tree);
+
+	PrimitiveHandle addSphere(const glm::mat4& transform, const glm::vec3& color, float radius);
+	PrimitiveHandle addTorus(const glm::mat4& transform, const glm::vec3& color, float majorRadius, float minorRadius);
+	PrimitiveHandle addCylinder(const glm::mat4& transform, const glm::vec3& color, float height, float radius);
+	PrimitiveHandle addBox(const glm::mat4& transform, const glm::vec3& color, const glm::vec3& size);
+
+	/*
+	* Append a node to the postorder node buffer and return its index. Children must be added before their parent, the last node is the root.
+	* 'rightChildIndex' is ignored by SHADER_TYPE_COMPLEMENTARY.
+	*/
+	int addLeaf(PrimitiveHandle handle);
+	int addOperation(int type, int leftChildIndex, int rightChildIndex = -1);
+	// Smooth operation (SHADER_TYPE_SMOOTH_UNION...) blending its children over 'blendRadius' > 0
+	int addSmoothOperation(int type, int leftChildIndex, int rightChildIndex, float blendRadius);
+
+	// Handle referenced by a leaf node, or an invalid handle for an operation node
+	static PrimitiveHandle leafHandle(const CSGNode::ShaderNodeData& node);
+	[[nodiscard]] PrimitiveHandle getLeafHandle(int nodeIndex) const { return leafHandle(_nodes[nodeIndex]); }
+	// Node type of the leaves of a primitive type (SHADER_TYPE_SPHERE...), -1 for PrimitiveType::MAX
+	static int shaderType(Primitive::PrimitiveType type);
+
+	[[nodiscard]] int getNbPrimitive(Primitive::PrimitiveType type) const;
+	[[nodiscard]] int getNbNode() const { return static_cast<int>(_nodes.size()); }
+	[[nodiscard]] const std::vector<CSGNode::ShaderNodeData>& getNodes() const { return _nodes; }
+
+	/*
+	* Arrays of each type. Radii and sizes can be written directly; after writing a translation, rotation or scale,
+	* call updateInverseTransform() on the handle (setTransform() does it).
+	*/
+	[[nodiscard]] const SphereArrays& getSpheres() const { return _spheres; }
+	[[nodiscard]] const TorusArrays& getToruses() const { return _toruses; }
+	[[nodiscard]] const CylinderArrays& getCylinders() const { return _cylinders; }
+	[[nodiscard]] const BoxArrays& getBoxes() const { return _boxes; }
+	SphereArrays& getSpheres() { return _spheres; }
+	TorusArrays& getToruses() { return _toruses; }
+	CylinderArrays& getCylinders() { return _cylinders; }
+	BoxArrays& getBoxes() { return _boxes; }
+
+	// Transform arrays of a primitive type
+	[[nodiscard]] const PrimitiveTransformArrays& transformArrays(Primitive::PrimitiveType type) const;
+	PrimitiveTransformArrays& transformArrays(Primitive::PrimitiveType type);
+
+	[[nodiscard]] glm::mat4 getTransform(PrimitiveHandle handle) const { return transformArrays(handle.type).transform(handle.index); }
+	void setTransform(PrimitiveHandle handle, const glm::mat4& transform) { transformArrays(handle.type).setTransform(handle.index, transform); }
+	void updateInverseTransform(PrimitiveHandle handle) { transformArrays(handle.type).updateInverseTransform(handle.index); }
+	[[nodiscard]] const glm::vec3& getColor(PrimitiveHandle handle) const { return transformArrays(handle.type).colors[handle.index]; }
+
+	/*
+	* Serialization in the std430 layout of PrimitiveSceneSDF.glsl, one loop per type.
+	* The buffers are the same as CSGTree::treeRawData() and CSGTree::rawDataByPrimitiveType() for the same scene.
+	*/
+	[[nodiscard]] CSGSceneData sceneData() const;
+	[[nodiscard]] std::vector<uint8_t> treeRawData() const;
+	[[nodiscard]] std::vector<uint8_t> rawDataByPrimitiveType(Primitive::PrimitiveType type) const;
+
+	// Record of a single primitive, same bytes as the rawData() method of the matching Primitive subclass
+	[[nodiscard]] SphereData sphereRecord(int index) const;
+	[[nodiscard]] TorusData torusRecord(int index) const;
+	[[nodiscard]] CylinderData cylinderRecord(int index) const;
+	[[nodiscard]] BoxData boxRecord(int index) const;
+
+private:
+	std::vector<CSGNode::ShaderNodeData> _nodes;
+	SphereArrays _spheres;
+	TorusArrays _toruses;
+	CylinderArrays _cylinders;
+	BoxArrays _boxes;
+};
+
+/*
+* Primitive API on top of a handle of a CSGPrimitiveStore, for the code written against Primitive (editor UI, selection, upload).
+* It does not own anything: the store must outlive it, and adding primitives to the store does not invalidate it.
+*/
+class PrimitiveRef
+{
+public:
+	PrimitiveRef(CSGPrimitiveStore& store, PrimitiveHandle handle);
+
+	[[nodiscard]] Primitive::PrimitiveType getType() const { return _handle.type; }
+	[[nodiscard]] PrimitiveHandle getHandle() const { return _handle; }
+
+	[[nodiscard]] glm::mat4 getTransform() const { return _store->getTransform(_handle); }
+	[[nodiscard]] glm::mat4 getInverseTransform() const;
+	void setTransform(const glm::mat4& transform) { _store->setTransform(_handle, transform); }
+
+	[[nodiscard]] glm::vec3 getEulerAngles() const;
+	void setEulerAngles(const glm::vec3& eulerAngles);
+
+	[[nodiscard]] const glm::vec3& getColor() const;
+	void setColor(const glm::vec3& color);
+
+	// Same bytes as Primitive::rawData() of the matching subclass
+	[[nodiscard]] std::vector<uint8_t> rawData() const;
+
+	// Same widgets as Primitive::modifySelectedPrimitiveUI() and the overrides of the subclasses
+	bool modifySelectedPrimitiveUI(const std::string& primitiveName);
+
+private:
+	CSGPrimitiveStore* _store;
+	PrimitiveHandle _handle;
+};
+
+/*
+* CPU evaluator working on a CSGPrimitiveStore, same results as CSGEvaluator on the serialized scene.
+* The distances of all the primitives are computed first, one loop per type over contiguous arrays, then the operation nodes only
+* select among them: each node keeps the distance and the leaf responsible for it, and the color is fetched once at the end.
+* Colors are not blended: a smooth operation keeps the leaf of the child with the larger weight.
+* The evaluator keeps its own buffers sized for the store at construction, use one evaluator per thread and rebuild it if primitives
+* or nodes are added.
+*/
+class CSGStoreEvaluator
+{
+public:
+	explicit CSGStoreEvaluator(const CSGPrimitiveStore& store);
+
+	CSGEvaluation scanSDF(const glm::vec3& pos) const;
+
+	// Number of points evaluated since the construction of the evaluator
+	[[nodiscard]] long long getNbEvaluation() const { return _nbEvaluation; }
+
+private:
+	const CSGPrimitiveStore* _store;
+	mutable std::vector<float> _primitiveDistances[4]; // Distance of every primitive, indexed by leaf node type - SHADER_TYPE_SPHERE
+	mutable std::vector<float> _nodeDistances;
+	mutable std::vector<int> _nodeLeaves; // Leaf node responsible for the distance of each node, -1 below a complement (black)
+	mutable long long _nbEvaluation = 0;
+};
@@ -0,0 +1,530 @@
+#include "renderer/opengl/Primitives/CSGRayQuery.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool CSGRayQuery::hasSmoothOperation(const CSGSceneView& scene)
+{
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		if (isSmoothOperation(scene.nodes[i].type))
+			return true;
+	}
+	return false;
+}
+
+CSGRayQuery::CSGRayQuery(const CSGSceneView& scene) :
+	_scene{scene},
+	_nodeBounds{CSGBounds::nodeBounds(scene)},
+	_subtreeStart(scene.nbNode),
+	_nodeIntervals(scene.nbNode),
+	_skipTo(scene.nbNode, -1),
+	_hasSmoothOperation{hasSmoothOperation(scene)}
+{
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		const int type = hardOperation(node.type);
+		_subtreeStart[i] = i;
+		if (isNaryOperation(type) && node.leftChildIndex >= 0 && node.leftChildIndex < i)
+			_subtreeStart[i] = node.leftChildIndex; // The leaves are consecutive
+		if (type >= SHADER_TYPE_INTERSECTION && type <= SHADER_TYPE_COMPLEMENTARY && node.leftChildIndex >= 0 && node.leftChildIndex < i)
+			_subtreeStart[i] = std::min(_subtreeStart[i], _subtreeStart[node.leftChildIndex]);
+		if (type >= SHADER_TYPE_INTERSECTION && type <= SHADER_TYPE_DIFFERENCE && node.rightChildIndex >= 0 && node.rightChildIndex < i)
+			_subtreeStart[i] = std::min(_subtreeStart[i], _subtreeStart[node.rightChildIndex]);
+	}
+
+	// The evaluator colors the surfaces of complements in black, whatever the leaf below
+	_complemented.assign(scene.nbNode, 0);
+	for (int i = scene.nbNode - 1; i >= 0; i--)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		const int type = hardOperation(node.type);
+		const uint8_t complemented = _complemented[i] != 0 || type == SHADER_TYPE_COMPLEMENTARY ? 1 : 0;
+		if (isNaryOperation(type))
+		{
+			for (int child = std::max(node.leftChildIndex, 0); child <= node.rightChildIndex && child < i; child++)
+				_complemented[child] = complemented;
+		}
+		if (type >= SHADER_TYPE_INTERSECTION && type <= SHADER_TYPE_COMPLEMENTARY && node.leftChildIndex >= 0 && node.leftChildIndex < i)
+			_complemented[node.leftChildIndex] = complemented;
+		if (type >= SHADER_TYPE_INTERSECTION && type <= SHADER_TYPE_DIFFERENCE && node.rightChildIndex >= 0 && node.rightChildIndex < i)
+			_complemented[node.rightChildIndex] = complemented;
+	}
+}
+
+/*
+* Boolean operations on sorted and disjoint interval lists
+*/
+static void unionIntervals(const std::vector<RayInterval>& a, const std::vector<RayInterval>& b, std::vector<RayInterval>& result)
+{
+	result.clear();
+	size_t i = 0;
+	size_t j = 0;
+	while (i < a.size() || j < b.size())
+	{
+		const RayInterval& next = j >= b.size() || (i < a.size() && a[i].tEnter <= b[j].tEnter) ? a[i++] : b[j++];
+		if (!result.empty() && next.tEnter <= result.back().tExit)
+		{
+			if (next.tExit > result.back().tExit)
+			{
+				result.back().tExit = next.tExit;
+				result.back().exitLeaf = next.exitLeaf;
+			}
+		}
+		else
+			result.push_back(next);
+	}
+}
+
+static void intersectIntervals(const std::vector<RayInterval>& a, const std::vector<RayInterval>& b, std::vector<RayInterval>& result)
+{
+	result.clear();
+	size_t i = 0;
+	size_t j = 0;
+	while (i < a.size() && j < b.size())
+	{
+		const RayInterval& first = a[i].tEnter >= b[j].tEnter ? a[i] : b[j];
+		const RayInterval& last = a[i].tExit <= b[j].tExit ? a[i] : b[j];
+		if (first.tEnter < last.tExit)
+			result.push_back(RayInterval{first.tEnter, first.enterLeaf, last.tExit, last.exitLeaf});
+		if (a[i].tExit <= b[j].tExit)
+			i++;
+		else
+			j++;
+	}
+}
+
+// Gaps of 'a' in [tMin, tMax], the ends of the range not being surfaces
+static void complementIntervals(const std::vector<RayInterval>& a, const float tMin, const float tMax, std::vector<RayInterval>& result)
+{
+	result.clear();
+	float t = tMin;
+	int leaf = -1;
+	for (const RayInterval& interval : a)
+	{
+		if (interval.tEnter > t)
+			result.push_back(RayInterval{t, leaf, interval.tEnter, interval.enterLeaf});
+		t = interval.tExit;
+		leaf = interval.exitLeaf;
+	}
+	if (t < tMax)
+		result.push_back(RayInterval{t, leaf, tMax, -1});
+}
+
+// Add the part of [tEnter, tExit] in [tMin, tMax]
+static void addClipped(const double tEnter, const double tExit, const int leaf, const float tMin, const float tMax, std::vector<RayInterval>& result)
+{
+	const float enter = static_cast<float>(tEnter);
+	const float exit = static_cast<float>(tExit);
+	if (enter >= tMax || exit <= tMin || !(enter < exit))
+		return;
+	result.push_back(RayInterval{std::max(enter, tMin), enter < tMin ? -1 : leaf, std::min(exit, tMax), exit > tMax ? -1 : leaf});
+}
+
+/*
+* Analytic intersections in the local space of the primitives, in double precision. The ray is transformed with the affine inverse
+* transform without normalizing its direction, so t is the same in local and world space.
+*/
+struct LocalRay
+{
+	glm::dvec3 origin;
+	glm::dvec3 direction;
+};
+
+static LocalRay localRay(const Ray& ray, const glm::mat3x4& inverseTransform)
+{
+	return LocalRay{glm::dvec3(transformPoint(inverseTransform, ray.origin)), glm::dvec3(transformDirection(inverseTransform, ray.direction))};
+}
+
+// Roots of a t^2 + 2 b t + c, false if there is none
+static bool solveQuadratic(const double a, const double b, const double c, double& t0, double& t1)
+{
+	const double discriminant = b * b - a * c;
+	if (discriminant < 0. || a == 0.)
+		return false;
+	// Stable form, without the cancellation of -b + sqrt(discriminant)
+	const double q = -(b + std::copysign(std::sqrt(discriminant), b));
+	t0 = q / a;
+	t1 = q != 0. ? c / q : t0;
+	if (t0 > t1)
+		std::swap(t0, t1);
+	return true;
+}
+
+// Segment of the ray in the slab |x| <= halfSize along one axis, false if the ray misses it
+static bool slab(const double origin, const double direction, const double halfSize, double& tEnter, double& tExit)
+{
+	if (direction == 0.)
+	{
+		tEnter = -std::numeric_limits<double>::infinity();
+		tExit = std::numeric_limits<double>::infinity();
+		return std::abs(origin) <= halfSize;
+	}
+	tEnter = (-halfSize - origin) / direction;
+	tExit = (halfSize - origin) / direction;
+	if (tEnter > tExit)
+		std::swap(tEnter, tExit);
+	return true;
+}
+
+static double evaluatePolynomial(const double* coefficients, const int degree, const double t)
+{
+	double value = coefficients[degree];
+	for (int i = degree - 1; i >= 0; i--)
+		value = value * t + coefficients[i];
+	return value;
+}
+
+/*
+* Roots in [a, b] of the polynomial sum(coefficients[i] t^i), in increasing order. Between two consecutive roots of its derivative
+* the polynomial is monotone, so each sign change is isolated and refined by regula falsi (Illinois variant), which always
+* converges, unlike the closed form of the quartic which loses the small roots to cancellation.
+*/
+static int polynomialRoots(const double* coefficients, const int degree, const double a, const double b, double* roots)
+{
+	if (degree == 1)
+	{
+		if (coefficients[1] == 0.)
+			return 0;
+		const double root = -coefficients[0] / coefficients[1];
+		roots[0] = root;
+		return root >= a && root <= b ? 1 : 0;
+	}
+
+	double derivative[4];
+	for (int i = 0; i < degree; i++)
+		derivative[i] = static_cast<double>(i + 1) * coefficients[i + 1];
+	double bounds[6];
+	bounds[0] = a;
+	const int nbCritical = polynomialRoots(derivative, degree - 1, a, b, bounds + 1);
+	bounds[nbCritical + 1] = b;
+
+	int nbRoot = 0;
+	for (int i = 0; i <= nbCritical; i++)
+	{
+		double lo = bounds[i];
+		double hi = bounds[i + 1];
+		double fLo = evaluatePolynomial(coefficients, degree, lo);
+		double fHi = evaluatePolynomial(coefficients, degree, hi);
+		if ((fLo < 0.) == (fHi < 0.))
+			continue;
+
+		int side = 0;
+		double t = lo;
+		for (int iteration = 0; iteration < 100 && hi - lo > 1e-12 * (1. + std::abs(t)); iteration++)
+		{
+			t = (lo * fHi - hi * fLo) / (fHi - fLo);
+			const double f = evaluatePolynomial(coefficients, degree, t);
+			if (f == 0.)
+				break;
+			if ((f < 0.) == (fLo < 0.))
+			{
+				lo = t;
+				fLo = f;
+				if (side == -1)
+					fHi *= 0.5;
+				side = -1;
+			}
+			else
+			{
+				hi = t;
+				fHi = f;
+				if (side == 1)
+					fLo *= 0.5;
+				side = 1;
+			}
+		}
+		roots[nbRoot++] = t;
+	}
+	return nbRoot;
+}
+
+void CSGRayQuery::leafIntervals(const int nodeIndex, const Ray& ray, const float tMin, const float tMax, std::vector<RayInterval>& result) const
+{
+	const CSGNode::ShaderNodeData& node = _scene.nodes[nodeIndex];
+	result.clear();
+	_nbLeafIntersection++;
+	double t0;
+	double t1;
+
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+	{
+		const SphereData& sphere = _scene.spheres[node.primitiveIndex];
+		const LocalRay local = localRay(ray, sphere.inverseTransform);
+		const double radius = sphere.radius;
+		if (solveQuadratic(glm::dot(local.direction, local.direction), glm::dot(local.origin, local.direction),
+			glm::dot(local.origin, local.origin) - radius * radius, t0, t1))
+			addClipped(t0, t1, nodeIndex, tMin, tMax, result);
+		break;
+	}
+	case SHADER_TYPE_BOX:
+	{
+		const BoxData& box = _scene.boxes[node.primitiveIndex];
+		const LocalRay local = localRay(ray, box.inverseTransform);
+		t0 = -std::numeric_limits<double>::infinity();
+		t1 = std::numeric_limits<double>::infinity();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			double enter;
+			double exit;
+			if (!slab(local.origin[axis], local.direction[axis], box.size[axis], enter, exit))
+				return;
+			t0 = std::max(t0, enter);
+			t1 = std::min(t1, exit);
+		}
+		addClipped(t0, t1, nodeIndex, tMin, tMax, result);
+		break;
+	}
+	case SHADER_TYPE_CYLINDER:
+	{
+		const CylinderData& cylinder = _scene.cylinders[node.primitiveIndex];
+		const LocalRay local = localRay(ray, cylinder.inverseTransform);
+		const double radius = cylinder.radius;
+		const double a = local.direction.x * local.direction.x + local.direction.z * local.direction.z;
+		const double c = local.origin.x * local.origin.x + local.origin.z * local.origin.z - radius * radius;
+		if (a == 0.)
+		{
+			// Parallel to the axis
+			if (c > 0.)
+				return;
+			t0 = -std::numeric_limits<double>::infinity();
+			t1 = std::numeric_limits<double>::infinity();
+		}
+		else if (!solveQuadratic(a, local.origin.x * local.direction.x + local.origin.z * local.direction.z, c, t0, t1))
+			return;
+
+		double enter;
+		double exit;
+		if (!slab(local.origin.y, local.direction.y, cylinder.height, enter, exit))
+			return;
+		addClipped(std::max(t0, enter), std::min(t1, exit), nodeIndex, tMin, tMax, result);
+		break;
+	}
+	case SHADER_TYPE_TORUS:
+	{
+		const TorusData& torus = _scene.toruses[node.primitiveIndex];
+		const LocalRay local = localRay(ray, torus.inverseTransform);
+		const glm::dvec3& o = local.origin;
+		const glm::dvec3& d = local.direction;
+		const double majorRadius = torus.majorRadius;
+		const double minorRadius = torus.minorRadius;
+
+		// The roots are in the bounding sphere, outside of which the torus polynomial is positive
+		const double outerRadius = majorRadius + minorRadius;
+		if (!solveQuadratic(glm::dot(d, d), glm::dot(o, d), glm::dot(o, o) - outerRadius * outerRadius, t0, t1))
+			return;
+
+		// (|p|^2 + R^2 - r^2)^2 - 4 R^2 (px^2 + pz^2) along p = o + t d
+		const double a = glm::dot(d, d);
+		const double b = 2. * glm::dot(o, d);
+		const double c = glm::dot(o, o) + majorRadius * majorRadius - minorRadius * minorRadius;
+		const double radialA = d.x * d.x + d.z * d.z;
+		const double radialB = 2. * (o.x * d.x + o.z * d.z);
+		const double radialC = o.x * o.x + o.z * o.z;
+		const double r2 = 4. * majorRadius * majorRadius;
+		const double coefficients[5] = {c * c - r2 * radialC, 2. * b * c - r2 * radialB, b * b + 2. * a * c - r2 * radialA, 2. * a * b, a * a};
+
+		double bounds[6];
+		bounds[0] = t0;
+		const int nbRoot = polynomialRoots(coefficients, 4, t0, t1, bounds + 1);
+		bounds[nbRoot + 1] = t1;
+
+		// Inside segments are told by the sign in their middle, which stays right for tangent rays and double roots: consecutive
+		// inside segments are joined
+		int first = -1;
+		for (int i = 0; i <= nbRoot; i++)
+		{
+			const bool inside = evaluatePolynomial(coefficients, 4, 0.5 * (bounds[i] + bounds[i + 1])) < 0.;
+			if (inside && first < 0)
+				first = i;
+			if (first >= 0 && (!inside || i == nbRoot))
+			{
+				addClipped(bounds[first], bounds[inside ? i + 1 : i], nodeIndex, tMin, tMax, result);
+				first = -1;
+			}
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+const std::vector<RayInterval>& CSGRayQuery::intervals(const Ray& ray, const float tMin, const float tMax) const
+{
+	_nbRay++;
+	static const std::vector<RayInterval> noInterval;
+	if (_scene.isEmpty())
+		return noInterval;
+
+	// From the root down, skip the subtrees whose bounds are not crossed by the ray
+	const glm::vec3 inverseDirection = 1.f / ray.direction;
+	auto crossesBounds = [&](const AABB& bounds)
+	{
+		if (bounds.isInfinite())
+			return true;
+		if (bounds.isEmpty())
+			return false;
+		float enter = tMin;
+		float exit = tMax;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (bounds.min[axis] - ray.origin[axis]) * inverseDirection[axis];
+			float t1 = (bounds.max[axis] - ray.origin[axis]) * inverseDirection[axis];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			// NaN (origin on a face of a flat box, parallel ray) keeps the subtree
+			enter = t0 > enter ? t0 : enter;
+			exit = t1 < exit ? t1 : exit;
+		}
+		return enter <= exit;
+	};
+
+	std::fill(_skipTo.begin(), _skipTo.end(), -1);
+	for (int i = _scene.nbNode - 1; i >= 0; i--)
+	{
+		if (!crossesBounds(_nodeBounds[i]))
+		{
+			_skipTo[_subtreeStart[i]] = i;
+			i = _subtreeStart[i];
+		}
+	}
+
+	for (int i = 0; i < _scene.nbNode; i++)
+	{
+		if (_skipTo[i] >= 0)
+		{
+			i = _skipTo[i];
+			_nodeIntervals[i].clear();
+			continue;
+		}
+
+		const CSGNode::ShaderNodeData& node = _scene.nodes[i];
+		std::vector<RayInterval>& result = _nodeIntervals[i];
+		switch (hardOperation(node.type))
+		{
+		case SHADER_TYPE_UNION:
+			unionIntervals(_nodeIntervals[node.leftChildIndex], _nodeIntervals[node.rightChildIndex], result);
+			break;
+		case SHADER_TYPE_INTERSECTION:
+			intersectIntervals(_nodeIntervals[node.leftChildIndex], _nodeIntervals[node.rightChildIndex], result);
+			break;
+		case SHADER_TYPE_DIFFERENCE:
+			complementIntervals(_nodeIntervals[node.rightChildIndex], tMin, tMax, _complement);
+			intersectIntervals(_nodeIntervals[node.leftChildIndex], _complement, result);
+			break;
+		case SHADER_TYPE_COMPLEMENTARY:
+			complementIntervals(_nodeIntervals[node.leftChildIndex], tMin, tMax, result);
+			break;
+		case SHADER_TYPE_NARY_UNION:
+		case SHADER_TYPE_NARY_INTERSECTION:
+			// Folded over the leaves, the skipped ones having no interval
+			result = _nodeIntervals[node.leftChildIndex];
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			{
+				if (node.type == SHADER_TYPE_NARY_UNION)
+					unionIntervals(result, _nodeIntervals[child], _complement);
+				else
+					intersectIntervals(result, _nodeIntervals[child], _complement);
+				result.swap(_complement);
+			}
+			break;
+		default:
+			leafIntervals(i, ray, tMin, tMax, result);
+			break;
+		}
+	}
+	return _nodeIntervals[_scene.nbNode - 1];
+}
+
+RayHit CSGRayQuery::intersect(const Ray& ray, const float tMin, const float tMax) const
+{
+	RayHit hit;
+	const std::vector<RayInterval>& rootIntervals = intervals(ray, tMin, tMax);
+	if (rootIntervals.empty())
+		return hit;
+
+	// The first segment starts at tMin when the ray starts inside the scene: the hit is then where it leaves it
+	const RayInterval& first = rootIntervals.front();
+	hit.entering = first.enterLeaf >= 0;
+	hit.t = hit.entering ? first.tEnter : first.tExit;
+	hit.nodeIndex = hit.entering ? first.enterLeaf : first.exitLeaf;
+	if (hit.nodeIndex < 0)
+		return RayHit{};
+
+	hit.hit = true;
+	hit.position = ray.origin + hit.t * ray.direction;
+	const CSGNode::ShaderNodeData& node = _scene.nodes[hit.nodeIndex];
+	hit.primitiveType = node.type;
+	hit.primitiveIndex = node.primitiveIndex;
+
+	// Gradient of the implicit surface of the leaf in local space, brought back to world space
+	const glm::mat3x4* inverseTransform = nullptr;
+	glm::vec3 localNormal{0.f, 1.f, 0.f};
+	auto localPosition = [&hit](const glm::mat3x4& transform) { return transformPoint(transform, hit.position); };
+	switch (node.type)
+	{
+	case SHADER_TYPE_SPHERE:
+	{
+		const SphereData& sphere = _scene.spheres[node.primitiveIndex];
+		inverseTransform = &sphere.inverseTransform;
+		hit.color = sphere.color;
+		localNormal = localPosition(sphere.inverseTransform);
+		break;
+	}
+	case SHADER_TYPE_BOX:
+	{
+		const BoxData& box = _scene.boxes[node.primitiveIndex];
+		inverseTransform = &box.inverseTransform;
+		hit.color = box.color;
+		const glm::vec3 p = localPosition(box.inverseTransform) / box.size;
+		const glm::vec3 q = glm::abs(p);
+		const int axis = q.x >= q.y && q.x >= q.z ? 0 : q.y >= q.z ? 1 : 2;
+		localNormal = glm::vec3(0.f);
+		localNormal[axis] = p[axis] < 0.f ? -1.f : 1.f;
+		break;
+	}
+	case SHADER_TYPE_CYLINDER:
+	{
+		const CylinderData& cylinder = _scene.cylinders[node.primitiveIndex];
+		inverseTransform = &cylinder.inverseTransform;
+		hit.color = cylinder.color;
+		const glm::vec3 p = localPosition(cylinder.inverseTransform);
+		const float radial = std::sqrt(p.x * p.x + p.z * p.z);
+		if (std::abs(p.y) / cylinder.height > radial / cylinder.radius)
+			localNormal = glm::vec3(0.f, p.y < 0.f ? -1.f : 1.f, 0.f);
+		else
+			localNormal = glm::vec3(p.x, 0.f, p.z);
+		break;
+	}
+	case SHADER_TYPE_TORUS:
+	{
+		const TorusData& torus = _scene.toruses[node.primitiveIndex];
+		inverseTransform = &torus.inverseTransform;
+		hit.color = torus.color;
+		const glm::vec3 p = localPosition(torus.inverseTransform);
+		const float s = glm::dot(p, p) + torus.majorRadius * torus.majorRadius - torus.minorRadius * torus.minorRadius;
+		localNormal = s * p - 2.f * torus.majorRadius * torus.majorRadius * glm::vec3(p.x, 0.f, p.z);
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (_complemented[hit.nodeIndex] != 0)
+		hit.color = glm::vec3(0.f);
+
+	glm::vec3 normal = inverseTransform != nullptr ? glm::mat3(*inverseTransform) * localNormal : localNormal;
+	const float length = glm::length(normal);
+	normal = length > 0.f ? normal / length : -glm::normalize(ray.direction);
+
+	// Out of the scene: against the ray where it enters, along the ray where it leaves (complements and differences flip the leaf normal)
+	if ((glm::dot(normal, ray.direction) < 0.f) != hit.entering)
+		normal = -normal;
+	hit.normal = normal;
+	return hit;
+}
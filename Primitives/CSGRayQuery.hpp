@@ -0,0 +1,86 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+/*
+* Segment [tEnter, tExit] of a ray inside a solid. Each end is on the surface of a leaf (index in the node buffer), or -1 when the
+* segment is cut by the queried range of the ray.
+*/
+struct RayInterval
+{
+	float tEnter;
+	int enterLeaf;
+	float tExit;
+	int exitLeaf;
+};
+
+/*
+* First surface crossed by a ray
+*/
+struct RayHit
+{
+	bool hit = false;
+	float t = 0.f;
+	glm::vec3 position{0.f};
+	glm::vec3 normal{0.f}; // Unit, pointing out of the scene
+	glm::vec3 color{0.f}; // Color of the surface, as given by CSGEvaluator: the color of the leaf, black below a complement
+	int nodeIndex = -1; // Leaf of the node buffer owning the surface, CSGTree::atPostorder(nodeIndex) gives the tree node
+	int primitiveType = 0; // SHADER_TYPE_* of the leaf
+	int primitiveIndex = -1; // Index of the record in the buffer of its type
+	bool entering = true; // False when the ray starts inside the scene and the hit is where it leaves it
+};
+
+/*
+* Exact ray queries on a serialized scene, for picking.
+* Every leaf reached by the ray gives the segments of the ray inside it, from the analytic intersection with the sphere, the box,
+* the capped cylinder or the torus (roots of its quartic isolated between the roots of its derivatives, in double precision).
+* The segments are then combined up the tree with the boolean operations of the nodes, and the first end of the root segments is
+* the hit. Subtrees whose bounds are missed by the ray are skipped without being visited, as well as each leaf of an n-ary operation.
+* Unlike sphere marching, the hit is on the surface up to float rounding, and it does not depend on a step count or an epsilon.
+* Smooth operations are combined as their hard operation: the blends are ignored, the hit can be up to a blend radius from the rendered
+* surface there. Callers needing the rendered surface check hasSmoothOperation().
+* A query keeps its own interval lists, use one query per thread.
+*/
+class CSGRayQuery
+{
+public:
+	explicit CSGRayQuery(const CSGSceneView& scene);
+
+	// First surface crossed by the ray in [tMin, tMax]. The direction does not need to be normalized, t is in its unit.
+	RayHit intersect(const Ray& ray, float tMin = 0.f, float tMax = std::numeric_limits<float>::infinity()) const;
+
+	// Segments of the ray in [tMin, tMax] inside the whole scene, sorted and disjoint
+	const std::vector<RayInterval>& intervals(const Ray& ray, float tMin = 0.f, float tMax = std::numeric_limits<float>::infinity()) const;
+
+	[[nodiscard]] const CSGSceneView& getScene() const { return _scene; }
+
+	// True if some node of the scene is a smooth operation, whose blend the queries ignore
+	[[nodiscard]] bool hasSmoothOperation() const { return _hasSmoothOperation; }
+	static bool hasSmoothOperation(const CSGSceneView& scene);
+
+	// Rays queried, and analytic intersections computed for them (leaves whose bounds were hit)
+	[[nodiscard]] long long getNbRay() const { return _nbRay; }
+	[[nodiscard]] long long getNbLeafIntersection() const { return _nbLeafIntersection; }
+
+private:
+	void leafIntervals(int nodeIndex, const Ray& ray, float tMin, float tMax, std::vector<RayInterval>& result) const;
+
+	CSGSceneView _scene;
+	std::vector<AABB> _nodeBounds;
+	std::vector<int> _subtreeStart; // First node of the subtree of each node in the postorder buffer
+	std::vector<uint8_t> _complemented; // 1 for the nodes below a complement
+
+	mutable std::vector<std::vector<RayInterval>> _nodeIntervals;
+	mutable std::vector<RayInterval> _complement; // Scratch list of the differences
+	mutable std::vector<int> _skipTo; // For the first node of a skipped subtree, its root, else -1
+	bool _hasSmoothOperation;
+	mutable long long _nbRay = 0;
+	mutable long long _nbLeafIntersection = 0;
+};
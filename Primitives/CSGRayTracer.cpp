@@ -0,0 +1,88 @@
+#include "renderer/opengl/Primitives/CSGRayTracer.hpp"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+void TraceStatistics::merge(const TraceStatistics& other)
+{
+	nbPixel += other.nbPixel;
+	nbHit += other.nbHit;
+	nbLeafIntersection += other.nbLeafIntersection;
+}
+
+CSGRayTracer::CSGRayTracer(const CSGSceneView& scene, const int nbThread) :
+	_scene{scene},
+	_nbThread{nbThread > 0 ? nbThread : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))},
+	_hasSmoothOperation{CSGRayQuery::hasSmoothOperation(scene)}
+{
+}
+
+glm::vec4 CSGRayTracer::tracePixel(const CSGRayQuery& query, const Ray& ray)
+{
+	const RayHit hit = query.intersect(ray);
+	if (!hit.hit)
+		return glm::vec4(0.f); // Background
+
+	// SphereMarcher lights the surface with the opposite of the gradient
+	const float light = glm::clamp(glm::dot(-hit.normal, glm::normalize(glm::vec3(1.f))), 0.2f, 1.f);
+	return glm::vec4(hit.color * light, 1.f);
+}
+
+void CSGRayTracer::render(const CameraParameters& camera, RenderedImage& image, TraceStatistics* statistics) const
+{
+	renderRegion(camera, image, ScreenRect{0, 0, image.width, image.height}, statistics);
+}
+
+void CSGRayTracer::renderRegion(const CameraParameters& camera, RenderedImage& image, const ScreenRect& region, TraceStatistics* statistics) const
+{
+	const ScreenRect clippedRegion = region.clipped(image.width, image.height);
+	if (clippedRegion.isEmpty())
+		return;
+
+	const int nbTileX = (clippedRegion.width + TILE_SIZE - 1) / TILE_SIZE;
+	const int nbTileY = (clippedRegion.height + TILE_SIZE - 1) / TILE_SIZE;
+	const int nbTile = nbTileX * nbTileY;
+
+	std::atomic<int> nextTile{0};
+	std::mutex statisticsMutex;
+	auto worker = [&]()
+	{
+		const CSGRayQuery query{_scene}; // One query per thread, as it owns its interval lists
+		TraceStatistics threadStatistics;
+		for (int tile = nextTile++; tile < nbTile; tile = nextTile++)
+		{
+			const int startX = clippedRegion.x + (tile % nbTileX) * TILE_SIZE;
+			const int startY = clippedRegion.y + (tile / nbTileX) * TILE_SIZE;
+			const int endX = std::min(startX + TILE_SIZE, clippedRegion.x + clippedRegion.width);
+			const int endY = std::min(startY + TILE_SIZE, clippedRegion.y + clippedRegion.height);
+
+			for (int y = startY; y < endY; y++)
+			{
+				for (int x = startX; x < endX; x++)
+				{
+					const glm::vec4 color = tracePixel(query, camera.rayThroughPixel(x, y, image.width, image.height));
+					image.at(x, y) = color;
+					threadStatistics.nbHit += color.w > 0.f ? 1 : 0;
+				}
+			}
+			threadStatistics.nbPixel += static_cast<long long>(endX - startX) * (endY - startY);
+		}
+
+		if (statistics != nullptr)
+		{
+			threadStatistics.nbLeafIntersection = query.getNbLeafIntersection();
+			std::lock_guard<std::mutex> lock(statisticsMutex);
+			statistics->merge(threadStatistics);
+		}
+	};
+
+	const int nbThread = std::min(_nbThread, nbTile);
+	std::vector<std::thread> threads;
+	for (int i = 1; i < nbThread; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+}
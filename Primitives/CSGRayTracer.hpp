@@ -0,0 +1,51 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGRayQuery.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+/*
+* Counters accumulated over the pixels of a traced image
+*/
+struct TraceStatistics
+{
+	long long nbPixel = 0;
+	long long nbHit = 0;
+	long long nbLeafIntersection = 0; // Analytic ray/leaf intersections, leaves whose bounds are missed by the ray are not counted
+
+	void merge(const TraceStatistics& other);
+	[[nodiscard]] double meanLeafIntersectionPerPixel() const { return nbPixel > 0 ? static_cast<double>(nbLeafIntersection) / static_cast<double>(nbPixel) : 0.; }
+};
+
+/*
+* Alternative to SphereMarcher producing the same image by ray tracing: the spans of each ray inside the leaves are computed
+* analytically and combined with the boolean operations of the nodes (see CSGRayQuery).
+* There is no step budget nor epsilon, so thin features and grazing rays are exact and never drawn in red, and silhouettes are
+* sharp. The cost of a pixel only depends on the number of leaves whose bounds its ray crosses, not on the distance to the surface.
+* The image is split in 16x16 tiles shared between worker threads, as in SphereMarcher.
+* Smooth operations are traced as their hard operation, only SphereMarcher renders the blends: check hasSmoothOperation() before
+* using the image as the rendered scene.
+*/
+class CSGRayTracer
+{
+public:
+	static constexpr int TILE_SIZE = 16;
+
+	explicit CSGRayTracer(const CSGSceneView& scene, int nbThread = 0); // 0 means one thread per hardware thread
+
+	// If 'statistics' is not null, the counters of the traced pixels are added to it
+	void render(const CameraParameters& camera, RenderedImage& image, TraceStatistics* statistics = nullptr) const;
+
+	// Only trace the pixels of 'region', the other pixels of 'image' are kept as they are
+	void renderRegion(const CameraParameters& camera, RenderedImage& image, const ScreenRect& region, TraceStatistics* statistics = nullptr) const;
+
+	// Color of a single pixel, shaded like SphereMarcher::shade()
+	static glm::vec4 tracePixel(const CSGRayQuery& query, const Ray& ray);
+
+	// True if the scene has smooth operations, traced without their blends (CSGRayQuery::hasSmoothOperation())
+	[[nodiscard]] bool hasSmoothOperation() const { return _hasSmoothOperation; }
+
+private:
+	CSGSceneView _scene;
+	int _nbThread;
+	bool _hasSmoothOperation;
+};
@@ -0,0 +1,287 @@
+#include "renderer/opengl/Primitives/CSGRenderCache.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/SphereMarcher.hpp"
+#include "renderer/opengl/Primitives/DirtyRegionTracker.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+
+CSGRenderCache::CSGRenderCache(const size_t capacity, std::string spillDirectory) :
+	_capacity{std::max<size_t>(capacity, 1)},
+	_spillDirectory{std::move(spillDirectory)}
+{
+}
+
+uint64_t CSGRenderCache::cameraKey(const CameraParameters& camera, const int width, const int height)
+{
+	uint64_t hash = CSGSceneData::hashBytes(&camera.viewMat, sizeof(glm::mat4));
+	hash = CSGSceneData::hashBytes(&camera.fieldOfView, sizeof(float), hash);
+	hash = CSGSceneData::hashBytes(&width, sizeof(int), hash);
+	return CSGSceneData::hashBytes(&height, sizeof(int), hash);
+}
+
+uint64_t CSGRenderCache::renderKey(const CSGSceneData& scene, const CameraParameters& camera, const int width, const int height)
+{
+	const uint64_t sceneHash = scene.contentHash();
+	return CSGSceneData::hashBytes(&sceneHash, sizeof(uint64_t), cameraKey(camera, width, height));
+}
+
+size_t CSGRenderCache::size() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _lru.size();
+}
+
+int CSGRenderCache::getNbHit() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbHit;
+}
+
+int CSGRenderCache::getNbPartialRender() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbPartialRender;
+}
+
+int CSGRenderCache::getNbFullRender() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbFullRender;
+}
+
+CSGRenderCache::ImagePtr CSGRenderCache::find(const uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return findLocked(key);
+}
+
+void CSGRenderCache::insert(const uint64_t key, ImagePtr image)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	insertLocked(key, std::move(image));
+}
+
+CSGRenderCache::ImagePtr CSGRenderCache::findLocked(const uint64_t key)
+{
+	auto entry = _entries.find(key);
+	if (entry != _entries.end())
+	{
+		_lru.splice(_lru.begin(), _lru, entry->second); // Move to the front of the LRU list
+		return entry->second->second;
+	}
+
+	// Not in memory anymore, but it may have been spilled to disk
+	ImagePtr image = loadSpilled(key);
+	if (image != nullptr)
+		insertLocked(key, image);
+	return image;
+}
+
+void CSGRenderCache::insertLocked(const uint64_t key, ImagePtr image)
+{
+	auto entry = _entries.find(key);
+	if (entry != _entries.end())
+	{
+		entry->second->second = std::move(image);
+		_lru.splice(_lru.begin(), _lru, entry->second);
+		return;
+	}
+
+	_lru.emplace_front(key, std::move(image));
+	_entries[key] = _lru.begin();
+
+	while (_lru.size() > _capacity)
+	{
+		auto& leastRecentlyUsed = _lru.back();
+		spill(leastRecentlyUsed.first, *leastRecentlyUsed.second);
+		_entries.erase(leastRecentlyUsed.first);
+		_lru.pop_back();
+	}
+}
+
+const CSGRenderCache::LastFrame* CSGRenderCache::findLastFrameLocked(const uint64_t cameraKey)
+{
+	auto entry = _lastFrames.find(cameraKey);
+	if (entry == _lastFrames.end())
+		return nullptr;
+	_lastFrameLru.splice(_lastFrameLru.begin(), _lastFrameLru, entry->second);
+	return &entry->second->second;
+}
+
+void CSGRenderCache::insertLastFrameLocked(const uint64_t cameraKey, LastFrame lastFrame)
+{
+	auto entry = _lastFrames.find(cameraKey);
+	if (entry != _lastFrames.end())
+	{
+		entry->second->second = std::move(lastFrame);
+		_lastFrameLru.splice(_lastFrameLru.begin(), _lastFrameLru, entry->second);
+		return;
+	}
+
+	_lastFrameLru.emplace_front(cameraKey, std::move(lastFrame));
+	_lastFrames[cameraKey] = _lastFrameLru.begin();
+
+	// Same capacity as the images: the cameras not rendered for the longest time are forgotten first
+	while (_lastFrameLru.size() > _capacity)
+	{
+		_lastFrames.erase(_lastFrameLru.back().first);
+		_lastFrameLru.pop_back();
+	}
+}
+
+std::string CSGRenderCache::spillPath(const uint64_t key) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%016llx.csgimg", static_cast<unsigned long long>(key));
+	return _spillDirectory + "/" + fileName;
+}
+
+void CSGRenderCache::spill(const uint64_t key, const RenderedImage& image) const
+{
+	if (_spillDirectory.empty())
+		return;
+
+	// A reader never sees a partial file: it is complete under its final name or not there at all
+	const std::string path = spillPath(key);
+	const std::string temporaryPath = path + ".tmp";
+	std::ofstream file(temporaryPath, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&image.width), sizeof(int));
+	file.write(reinterpret_cast<const char*>(&image.height), sizeof(int));
+	file.write(reinterpret_cast<const char*>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size() * sizeof(glm::vec4)));
+	file.close();
+
+	std::error_code error;
+	if (file)
+		std::filesystem::rename(temporaryPath, path, error);
+	if (!file || error)
+		std::filesystem::remove(temporaryPath, error);
+}
+
+CSGRenderCache::ImagePtr CSGRenderCache::loadSpilled(const uint64_t key) const
+{
+	if (_spillDirectory.empty())
+		return nullptr;
+
+	std::ifstream file(spillPath(key), std::ios::binary);
+	if (!file)
+		return nullptr;
+
+	int width = 0;
+	int height = 0;
+	file.read(reinterpret_cast<char*>(&width), sizeof(int));
+	file.read(reinterpret_cast<char*>(&height), sizeof(int));
+	if (!file || width <= 0 || height <= 0)
+		return nullptr;
+
+	auto image = std::make_shared<RenderedImage>(width, height);
+	file.read(reinterpret_cast<char*>(image->pixels.data()), static_cast<std::streamsize>(image->pixels.size() * sizeof(glm::vec4)));
+	if (!file)
+		return nullptr;
+	return image;
+}
+
+bool CSGRenderCache::singlePrimitiveChange(const CSGSceneData& previous, const CSGSceneData& current, const CameraParameters& camera, const int width, const int height, ScreenRect& changedRegion)
+{
+	const auto& previousNodes = previous.getNodes();
+	const auto& currentNodes = current.getNodes();
+	if (previousNodes.size() != currentNodes.size()
+		|| memcmp(previousNodes.data(), currentNodes.data(), currentNodes.size() * sizeof(CSGNode::ShaderNodeData)) != 0)
+		return false; // The topology changed
+
+	int nbChangedPrimitive = 0;
+	changedRegion = ScreenRect{};
+
+	// A primitive below smooth operations also moves the blended surfaces around it, up to its blend margin
+	const std::vector<float> nodeMargins = CSGBounds::blendMargins(current.view());
+	std::vector<float> blendMargins[4]; // Indexed by leaf node type - SHADER_TYPE_SPHERE, then by primitive index
+	for (size_t i = 0; i < currentNodes.size(); i++)
+	{
+		const CSGNode::ShaderNodeData& node = currentNodes[i];
+		if (!isLeafType(node.type) || node.primitiveIndex < 0)
+			continue;
+		std::vector<float>& margins = blendMargins[node.type - SHADER_TYPE_SPHERE];
+		if (margins.size() <= static_cast<size_t>(node.primitiveIndex))
+			margins.resize(static_cast<size_t>(node.primitiveIndex) + 1, 0.f);
+		margins[node.primitiveIndex] = std::max(margins[node.primitiveIndex], nodeMargins[i]);
+	}
+
+	auto compareRecords = [&](const auto& previousRecords, const auto& currentRecords, const int type, auto computeBounds) -> bool
+	{
+		if (previousRecords.size() != currentRecords.size())
+			return false;
+		const std::vector<float>& margins = blendMargins[type - SHADER_TYPE_SPHERE];
+		for (size_t i = 0; i < currentRecords.size(); i++)
+		{
+			if (memcmp(&previousRecords[i], &currentRecords[i], sizeof(currentRecords[i])) == 0)
+				continue;
+
+			nbChangedPrimitive++;
+			// Pixels that can change are the ones covered by the primitive before and after the modification
+			const float margin = i < margins.size() ? margins[i] : 0.f;
+			changedRegion = changedRegion.merged(DirtyRegionTracker::screenRegion(computeBounds(previousRecords[i]).expanded(margin), camera, width, height));
+			changedRegion = changedRegion.merged(DirtyRegionTracker::screenRegion(computeBounds(currentRecords[i]).expanded(margin), camera, width, height));
+		}
+		return true;
+	};
+
+	const bool sameCounts = compareRecords(previous.getSpheres(), current.getSpheres(), SHADER_TYPE_SPHERE, CSGBounds::sphereBounds)
+		&& compareRecords(previous.getToruses(), current.getToruses(), SHADER_TYPE_TORUS, CSGBounds::torusBounds)
+		&& compareRecords(previous.getCylinders(), current.getCylinders(), SHADER_TYPE_CYLINDER, CSGBounds::cylinderBounds)
+		&& compareRecords(previous.getBoxes(), current.getBoxes(), SHADER_TYPE_BOX, CSGBounds::boxBounds);
+
+	return sameCounts && nbChangedPrimitive <= 1;
+}
+
+CSGRenderCache::ImagePtr CSGRenderCache::render(const CSGSceneData& scene, const CameraParameters& camera, const int width, const int height)
+{
+	const uint64_t currentCameraKey = cameraKey(camera, width, height);
+	const uint64_t key = renderKey(scene, camera, width, height);
+
+	ImagePtr previousImage = nullptr;
+	std::shared_ptr<const CSGSceneData> previousScene = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (ImagePtr cachedImage = findLocked(key))
+		{
+			_nbHit++;
+			return cachedImage;
+		}
+
+		if (const LastFrame* lastFrame = findLastFrameLocked(currentCameraKey))
+		{
+			previousImage = findLocked(lastFrame->imageKey);
+			previousScene = lastFrame->scene;
+		}
+	}
+
+	const SphereMarcher marcher{scene.view()};
+	std::shared_ptr<RenderedImage> image;
+
+	ScreenRect changedRegion;
+	const bool partialRender = previousImage != nullptr && singlePrimitiveChange(*previousScene, scene, camera, width, height, changedRegion);
+	if (partialRender)
+	{
+		// Partial invalidation: start from the previous frame and only re-march the pixels the edited primitive can cover
+		image = std::make_shared<RenderedImage>(*previousImage);
+		marcher.renderRegion(camera, *image, changedRegion);
+	}
+	else
+	{
+		image = std::make_shared<RenderedImage>(width, height);
+		marcher.render(camera, *image);
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (partialRender)
+		_nbPartialRender++;
+	else
+		_nbFullRender++;
+	insertLocked(key, image);
+
+	insertLastFrameLocked(currentCameraKey, LastFrame{key, std::make_shared<const CSGSceneData>(scene)});
+	return image;
+}
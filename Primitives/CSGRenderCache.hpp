@@ -0,0 +1,75 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*
+* LRU cache of rendered images, keyed by a content hash of the serialized scene, the camera and the resolution.
+* Images evicted from memory are written to 'spillDirectory' (if not empty) and reloaded from there on a later hit.
+* When a request misses but the previous frame of the same camera only differs by one primitive, only the screen region covered
+* by the old and new bounds of that primitive is re-marched.
+*/
+class CSGRenderCache
+{
+public:
+	using ImagePtr = std::shared_ptr<const RenderedImage>;
+
+	explicit CSGRenderCache(size_t capacity, std::string spillDirectory = "");
+
+	static uint64_t cameraKey(const CameraParameters& camera, int width, int height);
+	static uint64_t renderKey(const CSGSceneData& scene, const CameraParameters& camera, int width, int height);
+
+	// Return the cached image, or nullptr
+	ImagePtr find(uint64_t key);
+	void insert(uint64_t key, ImagePtr image);
+
+	// Return the image of 'scene' seen from 'camera', rendering only what is needed with the CPU sphere marcher
+	ImagePtr render(const CSGSceneData& scene, const CameraParameters& camera, int width, int height);
+
+	/*
+	* Screen region that changed between 'previous' and 'current', if they only differ by the parameters of a single primitive.
+	* Return false if the topology or more than one primitive changed.
+	*/
+	static bool singlePrimitiveChange(const CSGSceneData& previous, const CSGSceneData& current, const CameraParameters& camera, int width, int height, ScreenRect& changedRegion);
+
+	[[nodiscard]] size_t size() const;
+	[[nodiscard]] int getNbHit() const;
+	[[nodiscard]] int getNbPartialRender() const;
+	[[nodiscard]] int getNbFullRender() const;
+
+private:
+	struct LastFrame
+	{
+		uint64_t imageKey;
+		std::shared_ptr<const CSGSceneData> scene;
+	};
+
+	ImagePtr findLocked(uint64_t key);
+	void insertLocked(uint64_t key, ImagePtr image);
+	// Most recently used last frame of a camera, or nullptr
+	const LastFrame* findLastFrameLocked(uint64_t cameraKey);
+	void insertLastFrameLocked(uint64_t cameraKey, LastFrame lastFrame);
+	[[nodiscard]] std::string spillPath(uint64_t key) const;
+	// Written to a temporary file renamed into place, so a failed write leaves no file and the image is dropped
+	void spill(uint64_t key, const RenderedImage& image) const;
+	ImagePtr loadSpilled(uint64_t key) const;
+
+	size_t _capacity;
+	std::string _spillDirectory;
+
+	std::list<std::pair<uint64_t, ImagePtr>> _lru; // Most recently used first
+	std::unordered_map<uint64_t, std::list<std::pair<uint64_t, ImagePtr>>::iterator> _entries;
+	std::list<std::pair<uint64_t, LastFrame>> _lastFrameLru; // Last frame rendered for each camera key, most recently used first
+	std::unordered_map<uint64_t, std::list<std::pair<uint64_t, LastFrame>>::iterator> _lastFrames;
+	mutable std::mutex _mutex;
+
+	int _nbHit = 0;
+	int _nbPartialRender = 0;
+	int _nbFullRender = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+struct Ray
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+};
+
+/*
+* Camera as seen by primitiveSphereMarching.comp.glsl (uniforms u_viewMat and u_fieldOfView)
+*/
+struct CameraParameters
+{
+	glm::mat4 viewMat{1.f};
+	float fieldOfView = glm::radians(60.f); // vertical field of view, in radians
+
+	// Ray through the middle of a pixel, built exactly like in primitiveSphereMarching.comp.glsl
+	[[nodiscard]] Ray rayThroughPixel(const int x, const int y, const int width, const int height) const
+	{
+		const glm::mat4 inverseViewMat = glm::inverse(viewMat);
+		const float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+		const glm::vec2 NDCmiddleOfCurrentPixel = 2.f * ((glm::vec2(static_cast<float>(x), static_cast<float>(y)) + 0.5f) / glm::vec2(static_cast<float>(width), static_cast<float>(height))) - 1.f;
+		const glm::vec2 screenDirection = NDCmiddleOfCurrentPixel * std::tan(fieldOfView / 2.f) * glm::vec2(aspectRatio, 1.f);
+		const glm::vec3 cameraToCurrentPixelDirection{screenDirection.x, screenDirection.y, -1.f};
+
+		Ray ray;
+		ray.origin = glm::vec3(inverseViewMat * glm::vec4(0.f, 0.f, 0.f, 1.f));
+		ray.direction = glm::vec3(inverseViewMat * glm::vec4(glm::normalize(cameraToCurrentPixelDirection), 0.f));
+		return ray;
+	}
+};
+
+/*
+* Rectangle of pixels [x, x + width[ x [y, y + height[ of an image
+*/
+struct ScreenRect
+{
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+
+	[[nodiscard]] bool isEmpty() const { return width <= 0 || height <= 0; }
+
+	[[nodiscard]] ScreenRect merged(const ScreenRect& other) const
+	{
+		if (isEmpty())
+			return other;
+		if (other.isEmpty())
+			return *this;
+		const int minX = std::min(x, other.x);
+		const int minY = std::min(y, other.y);
+		const int maxX = std::max(x + width, other.x + other.width);
+		const int maxY = std::max(y + height, other.y + other.height);
+		return ScreenRect{minX, minY, maxX - minX, maxY - minY};
+	}
+
+	[[nodiscard]] ScreenRect clipped(const int imageWidth, const int imageHeight) const
+	{
+		const int minX = std::max(x, 0);
+		const int minY = std::max(y, 0);
+		const int maxX = std::min(x + width, imageWidth);
+		const int maxY = std::min(y + height, imageHeight);
+		return ScreenRect{minX, minY, std::max(maxX - minX, 0), std::max(maxY - minY, 0)};
+	}
+};
+
+/*
+* CPU copy of the rgba32f image written by the sphere marching shader
+*/
+struct RenderedImage
+{
+	int width = 0;
+	int height = 0;
+	std::vector<glm::vec4> pixels; // row major, pixel (0, 0) is the bottom left one as in the shader
+
+	RenderedImage() = default;
+	RenderedImage(const int w, const int h) : width{w}, height{h}, pixels(static_cast<size_t>(w) * h, glm::vec4(0.f)) {}
+
+	glm::vec4& at(const int x, const int y) { return pixels[static_cast<size_t>(y) * width + x]; }
+	[[nodiscard]] const glm::vec4& at(const int x, const int y) const { return pixels[static_cast<size_t>(y) * width + x]; }
+};
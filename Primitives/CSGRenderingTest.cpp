@@ -0,0 +1,1409 @@
+#include "renderer/opengl/Primitives/CSGRenderingTest.hpp"
+
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+#include "renderer/opengl/Primitives/SphereMarcher.hpp"
+#include "renderer/opengl/Primitives/CSGRenderCache.hpp"
+#include "renderer/opengl/Primitives/DirtyRegionTracker.hpp"
+#include "renderer/opengl/Primitives/CSGSceneFile.hpp"
+#include "renderer/opengl/Primitives/CameraPath.hpp"
+#include "renderer/opengl/Primitives/CSGBinaryScene.hpp"
+#include "renderer/opengl/Primitives/CSGStreamingLoader.hpp"
+#include "renderer/opengl/Primitives/CSGArena.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveStore.hpp"
+#include "renderer/opengl/Primitives/CSGExpression.hpp"
+#include "renderer/opengl/Primitives/CSGShaderGenerator.hpp"
+#include "renderer/opengl/Primitives/CSGCompiledEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGPointQuery.hpp"
+#include "renderer/opengl/Primitives/CSGMesher.hpp"
+#include "renderer/opengl/Primitives/CSGRayQuery.hpp"
+#include "renderer/opengl/Primitives/CSGRayTracer.hpp"
+#include "renderer/opengl/Primitives/CSGSceneGenerator.hpp"
+#include "renderer/opengl/Primitives/CSGBenchmarkSuite.hpp"
+#include "renderer/opengl/Primitives/CSGFuzzer.hpp"
+#include "renderer/opengl/Primitives/CSGDistanceBounds.hpp"
+#include "renderer/opengl/Primitives/CSGCompactScene.hpp"
+#include "renderer/opengl/Primitives/CSGNaryNodes.hpp"
+#include "renderer/opengl/Primitives/CSGShortCircuit.hpp"
+#include "renderer/opengl/Primitives/Sphere.hpp"
+#include "renderer/opengl/Primitives/Box.hpp"
+#include "renderer/opengl/Primitives/Cylinder.hpp"
+#include "renderer/opengl/Primitives/Torus.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <random>
+
+/*
+* Build this tree:
+*
+*         D
+*        / \
+*       U   \
+*      / \   \
+*     S   B   C
+*
+* The cylinder drills a vertical hole in the box.
+*/
+CSGTree CSGRenderingTest::buildSampleScene(const glm::vec3& sphereTranslation) const
+{
+	auto sphere = CSGNode::makePrimitive(std::make_shared<Sphere>(sphereTranslation, glm::vec3(1.f, 0.f, 0.f), 1.f));
+	auto box = CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(1.5f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f)));
+	auto cylinder = CSGNode::makePrimitive(std::make_shared<Cylinder>(glm::vec3(1.5f, 0.f, 0.f), 2.f, 0.3f));
+
+	auto union0 = CSGNode::makeUnion(sphere, box);
+	auto difference1 = CSGNode::makeDifference(union0, cylinder);
+
+	return CSGTree{ difference1 };
+}
+
+CameraParameters CSGRenderingTest::buildSampleCamera() const
+{
+	CameraParameters camera;
+	camera.viewMat = glm::lookAt(glm::vec3(0.f, 2.f, 8.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+	camera.fieldOfView = glm::radians(60.f);
+	return camera;
+}
+
+bool CSGRenderingTest::performAllTests() const
+{
+	std::cout << "\nStarted executing CSG rendering tests\n___________________________________________________________________________\n" << std::endl;
+	bool success = true;
+	auto report = [&success](const char* name, const bool result)
+	{
+		std::cout << "Test " << name << ": " << (result ? "success" : "failure") << std::endl;
+		success = success && result;
+	};
+
+	report("evaluator", testEvaluator());
+	report("analyticGradient", testAnalyticGradient());
+	report("normalEstimators", testNormalEstimators());
+	report("sphereMarcher", testSphereMarcher());
+	report("renderCache", testRenderCache());
+	report("partialInvalidation", testPartialInvalidation());
+	report("dirtyRegionTracker", testDirtyRegionTracker());
+	report("sceneFile", testSceneFile());
+	report("binaryScene", testBinaryScene());
+	report("streamingLoader", testStreamingLoader());
+	report("arena", testArena());
+	report("primitiveStore", testPrimitiveStore());
+	report("expression", testExpression());
+	report("shaderGenerator", testShaderGenerator());
+	report("compiledEvaluator", testCompiledEvaluator());
+	report("pointQuery", testPointQuery());
+	report("mesher", testMesher());
+	report("rayQuery", testRayQuery());
+	report("rayTracer", testRayTracer());
+	report("marchDiagnostics", testMarchDiagnostics());
+	report("sceneGenerator", testSceneGenerator());
+	report("fuzzer", testFuzzer());
+	report("distanceBounds", testDistanceBounds());
+	report("compactScene", testCompactScene());
+	report("smoothOperations", testSmoothOperations());
+	report("naryNodes", testNaryNodes());
+	report("shortCircuit", testShortCircuit());
+	std::cout << "\nFinished testing CSG rendering\n___________________________________________________________________________\n" << std::endl;
+	return success;
+}
+
+bool CSGRenderingTest::testEvaluator() const
+{
+	const CSGSceneData scene{buildSampleScene()};
+	const CSGEvaluator evaluator{scene.view()};
+
+	auto closeTo = [](const float a, const float b) { return std::abs(a - b) < 1e-4f; };
+
+	// Above the sphere: the sphere is the closest primitive
+	const CSGEvaluation aboveSphere = evaluator.scanSDF(glm::vec3(-1.5f, 3.f, 0.f));
+	bool distanceCheck = closeTo(aboveSphere.dist, 2.f);
+	bool colorCheck = aboveSphere.color == glm::vec3(1.f, 0.f, 0.f);
+
+	// In the middle of the hole drilled in the box
+	const CSGEvaluation insideHole = evaluator.scanSDF(glm::vec3(1.5f, 0.f, 0.f));
+	distanceCheck = distanceCheck && closeTo(insideHole.dist, 0.3f);
+
+	// Inside the box material, closer to the box faces than to the hole
+	const CSGEvaluation insideBox = evaluator.scanSDF(glm::vec3(2.3f, 0.f, 0.7f));
+	distanceCheck = distanceCheck && closeTo(insideBox.dist, -0.2f);
+	colorCheck = colorCheck && insideBox.color == glm::vec3(0.f, 1.f, 0.f);
+
+	const CSGSceneData emptyScene{CSGTree{}};
+	const CSGEvaluator emptyEvaluator{emptyScene.view()};
+	const bool emptyCheck = std::isinf(emptyEvaluator.scanSDF(glm::vec3(0.f)).dist);
+
+	return distanceCheck && colorCheck && emptyCheck && evaluator.getNbEvaluation() == 3;
+}
+
+bool CSGRenderingTest::testAnalyticGradient() const
+{
+	// Rotated and uniformly scaled primitives, the scale correction of the distance must also apply to the gradient
+	const glm::mat4 transform = glm::scale(glm::rotate(glm::translate(glm::mat4(1.f), glm::vec3(0.2f, -0.1f, 0.3f)),
+		0.7f, glm::normalize(glm::vec3(1.f, 2.f, 0.5f))), glm::vec3(1.5f));
+
+	auto sphere = CSGNode::makePrimitive(std::make_shared<Sphere>(transform, 1.f));
+	auto torus = CSGNode::makePrimitive(std::make_shared<Torus>(transform, 1.f, 0.3f));
+	auto cylinder = CSGNode::makePrimitive(std::make_shared<Cylinder>(transform, 0.8f, 0.5f));
+	auto box = CSGNode::makePrimitive(std::make_shared<Box>(transform, glm::vec3(0.6f, 0.9f, 0.4f)));
+
+	std::vector<CSGTree> trees;
+	trees.emplace_back(sphere);
+	trees.emplace_back(torus);
+	trees.emplace_back(cylinder);
+	trees.emplace_back(box);
+	trees.emplace_back(CSGNode::makeDifference(CSGNode::makeUnion(torus, box), sphere));
+	trees.emplace_back(CSGNode::makeIntersection(CSGNode::makeComplement(cylinder), box));
+
+	bool gradientCheck = true;
+	int nbCheckedPoint = 0;
+	const float h = 1e-3f;
+	for (const CSGTree& tree : trees)
+	{
+		const CSGSceneData scene{tree};
+		const CSGEvaluator evaluator{scene.view()};
+
+		for (float x = -2.f; x <= 2.f; x += 0.45f)
+		{
+			for (float y = -2.f; y <= 2.f; y += 0.45f)
+			{
+				for (float z = -2.f; z <= 2.f; z += 0.45f)
+				{
+					const glm::vec3 p{x, y, z};
+					const float center = evaluator.scanSDF(p).dist;
+					const glm::vec3 forward = glm::vec3(evaluator.scanSDF(p + glm::vec3(h, 0.f, 0.f)).dist,
+						evaluator.scanSDF(p + glm::vec3(0.f, h, 0.f)).dist, evaluator.scanSDF(p + glm::vec3(0.f, 0.f, h)).dist) - center;
+					const glm::vec3 backward = center - glm::vec3(evaluator.scanSDF(p - glm::vec3(h, 0.f, 0.f)).dist,
+						evaluator.scanSDF(p - glm::vec3(0.f, h, 0.f)).dist, evaluator.scanSDF(p - glm::vec3(0.f, 0.f, h)).dist);
+
+					// Skip the points next to a crease of the SDF, where the one sided differences disagree
+					if (glm::length(forward - backward) / h > 1e-2f)
+						continue;
+
+					const glm::vec3 finiteDifference = (forward + backward) / (2.f * h);
+
+					const CSGGradientEvaluation evaluation = evaluator.scanSDFGradient(p);
+					gradientCheck = gradientCheck && glm::length(evaluation.gradient - finiteDifference) < 2e-2f
+						&& evaluation.dist == center;
+					nbCheckedPoint++;
+				}
+			}
+		}
+	}
+
+	return gradientCheck && nbCheckedPoint > 1000;
+}
+
+bool CSGRenderingTest::testNormalEstimators() const
+{
+	const CSGSceneData scene{buildSampleScene()};
+	const CSGEvaluator evaluator{scene.view()};
+	const SphereMarcher marcher{scene.view()};
+	const CameraParameters camera = buildSampleCamera();
+
+	// The batched evaluation gives the same distances as four separate evaluations
+	const std::array<glm::vec3, 4> positions{glm::vec3(-1.5f, 3.f, 0.f), glm::vec3(1.5f, 0.f, 0.f), glm::vec3(2.3f, 0.f, 0.7f), glm::vec3(0.f, -0.4f, 2.f)};
+	const glm::vec4 distances = evaluator.scanSDF4(positions);
+	bool batchCheck = true;
+	for (int i = 0; i < 4; i++)
+		batchCheck = batchCheck && distances[i] == evaluator.scanSDF(positions[i]).dist;
+
+	// On the hit points of a frame, every estimator stays close to the analytic normal
+	const SphereMarcher::NormalMethod methods[] = {SphereMarcher::NormalMethod::ForwardDifference, SphereMarcher::NormalMethod::Tetrahedral, SphereMarcher::NormalMethod::BatchedTetrahedral};
+	bool batchedNormalCheck = true;
+	int nbHit = 0;
+	int nbAgreement = 0;
+	for (int y = 0; y < 48; y += 3)
+	{
+		for (int x = 0; x < 64; x += 3)
+		{
+			const MarchResult march = marcher.marchRay(evaluator, camera.rayThroughPixel(x, y, 64, 48), 64, 48);
+			if (!march.hit)
+				continue;
+			nbHit++;
+
+			const glm::vec3 reference = glm::normalize(evaluator.scanSDFGradient(march.position).gradient);
+			for (const SphereMarcher::NormalMethod method : methods)
+			{
+				const glm::vec3 normal = glm::normalize(SphereMarcher::estimateGradient(evaluator, method, march.position, march.evaluation.dist, march.epsilon));
+				nbAgreement += glm::dot(normal, reference) > 0.9f ? 1 : 0;
+			}
+			// The batched path must give exactly the normal of the four separate evaluations
+			const glm::vec3 tetrahedral = SphereMarcher::estimateGradient(evaluator, SphereMarcher::NormalMethod::Tetrahedral, march.position, march.evaluation.dist, march.epsilon);
+			const glm::vec3 batched = SphereMarcher::estimateGradient(evaluator, SphereMarcher::NormalMethod::BatchedTetrahedral, march.position, march.evaluation.dist, march.epsilon);
+			batchedNormalCheck = batchedNormalCheck && glm::length(tetrahedral - batched) < 1e-5f;
+		}
+	}
+
+	// Finite differences may straddle an edge of the box or of the hole, allow a few disagreements there
+	const bool normalCheck = nbHit > 0 && nbAgreement >= 0.9f * static_cast<float>(3 * nbHit);
+
+	return batchCheck && batchedNormalCheck && normalCheck;
+}
+
+bool CSGRenderingTest::testSphereMarcher() const
+{
+	const CSGSceneData scene{buildSampleScene()};
+	const SphereMarcher marcher{scene.view()};
+	const CameraParameters camera = buildSampleCamera();
+
+	RenderedImage image{64, 48};
+	marcher.render(camera, image);
+
+	// The sphere is on the left of the image, the box on the right and the background in the corners
+	const glm::vec4 spherePixel = image.at(20, 24);
+	const glm::vec4 boxPixel = image.at(44, 24);
+	const glm::vec4 backgroundPixel = image.at(0, 0);
+
+	return spherePixel.w == 1.f && spherePixel.x > 0.f && spherePixel.y == 0.f
+		&& boxPixel.w == 1.f && boxPixel.y > 0.f && boxPixel.x == 0.f
+		&& backgroundPixel == glm::vec4(0.f);
+}
+
+bool CSGRenderingTest::testRenderCache() const
+{
+	const std::filesystem::path spillDirectory = std::filesystem::temp_directory_path() / "csgRenderCacheTest";
+	std::filesystem::create_directories(spillDirectory);
+
+	CSGRenderCache cache{1, spillDirectory.string()};
+	const CameraParameters camera = buildSampleCamera();
+	const CSGSceneData scene0{buildSampleScene()};
+	const CSGSceneData scene1{buildSampleScene(glm::vec3(-1.5f, 1.f, 0.f))};
+
+	auto image0 = cache.render(scene0, camera, 32, 32);
+	bool hitCheck = cache.render(scene0, camera, 32, 32) == image0 && cache.getNbHit() == 1;
+
+	// The cache holds a single image: rendering scene1 spills the image of scene0 to the disk
+	cache.render(scene1, camera, 32, 32);
+	auto reloadedImage0 = cache.find(CSGRenderCache::renderKey(scene0, camera, 32, 32));
+	bool spillCheck = cache.size() == 1 && reloadedImage0 != nullptr && reloadedImage0 != image0 && reloadedImage0->pixels == image0->pixels;
+
+	bool keyCheck = CSGRenderCache::renderKey(scene0, camera, 32, 32) != CSGRenderCache::renderKey(scene1, camera, 32, 32)
+		&& CSGRenderCache::renderKey(scene0, camera, 32, 32) != CSGRenderCache::renderKey(scene0, camera, 32, 16);
+
+	// Spilled images are renamed into place, and an image that cannot be written is dropped
+	for (const auto& entry : std::filesystem::directory_iterator(spillDirectory))
+		spillCheck = spillCheck && entry.path().extension() == ".csgimg";
+	CSGRenderCache unwritableCache{1, (spillDirectory / "missing").string()};
+	unwritableCache.render(scene0, camera, 32, 32);
+	unwritableCache.render(scene1, camera, 32, 32);
+	spillCheck = spillCheck && unwritableCache.find(CSGRenderCache::renderKey(scene0, camera, 32, 32)) == nullptr && unwritableCache.size() == 1;
+
+	// The last frames are forgotten in least recently used order: the camera edited last keeps its partial invalidation
+	CSGRenderCache frameCache{2, spillDirectory.string()};
+	CameraParameters otherCamera = camera;
+	otherCamera.fieldOfView = glm::radians(50.f);
+	CameraParameters thirdCamera = camera;
+	thirdCamera.fieldOfView = glm::radians(40.f);
+	frameCache.render(scene0, camera, 32, 24);
+	frameCache.render(scene0, otherCamera, 32, 24);
+	frameCache.render(scene1, camera, 32, 24);
+	frameCache.render(scene0, thirdCamera, 32, 24);
+	frameCache.render(CSGSceneData{buildSampleScene(glm::vec3(-1.f, 0.5f, 0.f))}, camera, 32, 24);
+	const bool lastFrameCheck = frameCache.getNbPartialRender() == 2 && frameCache.getNbFullRender() == 3;
+
+	std::filesystem::remove_all(spillDirectory);
+	return hitCheck && spillCheck && keyCheck && lastFrameCheck;
+}
+
+bool CSGRenderingTest::testPartialInvalidation() const
+{
+	CSGRenderCache cache{4};
+	const CameraParameters camera = buildSampleCamera();
+	const CSGSceneData scene0{buildSampleScene()};
+	const CSGSceneData scene1{buildSampleScene(glm::vec3(-1.2f, 0.3f, 0.f))}; // Only the sphere moved
+
+	cache.render(scene0, camera, 64, 48);
+	auto partialImage = cache.render(scene1, camera, 64, 48);
+
+	ScreenRect changedRegion;
+	const bool singleChangeCheck = CSGRenderCache::singlePrimitiveChange(scene0, scene1, camera, 64, 48, changedRegion)
+		&& !changedRegion.isEmpty() && changedRegion.width < 64;
+
+	// The partially re-rendered image must match a full render of the new scene
+	RenderedImage fullImage{64, 48};
+	SphereMarcher{scene1.view()}.render(camera, fullImage);
+
+	bool imageCheck = true;
+	for (size_t i = 0; i < fullImage.pixels.size(); i++)
+		imageCheck = imageCheck && glm::length(fullImage.pixels[i] - partialImage->pixels[i]) < 1e-2f;
+
+	// Moving the sphere of a smooth union also moves the blended surface of the box, outside of the bounds of the sphere
+	auto buildSmoothScene = [](const glm::vec3& sphereTranslation)
+	{
+		CSGPrimitiveStore store;
+		const int sphere = store.addLeaf(store.addSphere(glm::translate(glm::mat4(1.f), sphereTranslation), glm::vec3(1.f, 0.f, 0.f), 1.f));
+		const int box = store.addLeaf(store.addBox(glm::translate(glm::mat4(1.f), glm::vec3(1.5f, 0.f, 0.f)), glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f)));
+		store.addSmoothOperation(SHADER_TYPE_SMOOTH_UNION, sphere, box, 1.5f);
+		return store.sceneData();
+	};
+	const CSGSceneData smoothScene0 = buildSmoothScene(glm::vec3(0.f));
+	const CSGSceneData smoothScene1 = buildSmoothScene(glm::vec3(0.f, 0.6f, 0.f));
+	CSGRenderCache smoothCache{4};
+	smoothCache.render(smoothScene0, camera, 64, 48);
+	auto smoothPartialImage = smoothCache.render(smoothScene1, camera, 64, 48);
+	RenderedImage smoothFullImage{64, 48};
+	SphereMarcher{smoothScene1.view()}.render(camera, smoothFullImage);
+	bool smoothCheck = smoothCache.getNbPartialRender() == 1;
+	for (size_t i = 0; i < smoothFullImage.pixels.size(); i++)
+		smoothCheck = smoothCheck && glm::length(smoothFullImage.pixels[i] - smoothPartialImage->pixels[i]) < 1e-2f;
+
+	return singleChangeCheck && imageCheck && cache.getNbPartialRender() == 1 && cache.getNbFullRender() == 1 && smoothCheck;
+}
+
+bool CSGRenderingTest::testDirtyRegionTracker() const
+{
+	auto sphere = std::make_shared<Sphere>(glm::vec3(-1.5f, 0.f, 0.f), glm::vec3(1.f, 0.f, 0.f), 1.f);
+	auto box = std::make_shared<Box>(glm::vec3(1.5f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f));
+	CSGTree tree{ CSGNode::makeUnion(CSGNode::makePrimitive(sphere), CSGNode::makePrimitive(box)) };
+
+	const CameraParameters camera = buildSampleCamera();
+	DirtyRegionTracker tracker;
+
+	// First frame: everything is rendered
+	RenderedImage retainedFrame{64, 48};
+	const ScreenRect firstRegion = tracker.consumeDirtyRegion(camera, 64, 48);
+	SphereMarcher{CSGSceneData{tree}.view()}.renderRegion(camera, retainedFrame, firstRegion);
+	const bool firstFrameCheck = firstRegion.width == 64 && firstRegion.height == 48 && !tracker.hasPendingEdit();
+
+	// Drag the sphere a bit, only the tiles around its old and new positions are re-marched
+	tracker.beginEdit(*sphere);
+	sphere->setTransform(glm::translate(glm::mat4(1.f), glm::vec3(-1.3f, 0.2f, 0.f)));
+	tracker.endEdit(*sphere, true);
+
+	const ScreenRect dirtyRegion = tracker.consumeDirtyRegion(camera, 64, 48);
+	const CSGSceneData editedScene{tree};
+	SphereMarcher{editedScene.view()}.renderRegion(camera, retainedFrame, dirtyRegion);
+
+	const bool regionCheck = !dirtyRegion.isEmpty() && dirtyRegion.width < 64
+		&& dirtyRegion.x % DirtyRegionTracker::TILE_SIZE == 0 && dirtyRegion.y % DirtyRegionTracker::TILE_SIZE == 0
+		&& DirtyRegionTracker::workGroupCount(dirtyRegion).x * DirtyRegionTracker::TILE_SIZE >= dirtyRegion.width;
+
+	RenderedImage fullFrame{64, 48};
+	SphereMarcher{editedScene.view()}.render(camera, fullFrame);
+
+	bool imageCheck = true;
+	for (size_t i = 0; i < fullFrame.pixels.size(); i++)
+		imageCheck = imageCheck && glm::length(fullFrame.pixels[i] - retainedFrame.pixels[i]) < 1e-2f;
+
+	// Nothing was edited since the last frame
+	const bool emptyCheck = tracker.consumeDirtyRegion(camera, 64, 48).isEmpty();
+
+	return firstFrameCheck && regionCheck && imageCheck && emptyCheck;
+}
+
+bool CSGRenderingTest::testSceneFile() const
+{
+	// Same tree as buildSampleScene(), with the default color of the cylinder
+	std::istringstream description{
+		"# Sample scene\n"
+		"sphere radius 1 translate -1.5 0 0 color 1 0 0\n"
+		"box size 1 1 1 translate 1.5 0 0 color 0 1 0\n"
+		"union\n"
+		"\n"
+		"cylinder height 2 radius 0.3 translate 1.5 0 0 # drills the box\n"
+		"difference\n"};
+
+	CSGTree tree;
+	std::string error;
+	const bool parseCheck = CSGSceneFile::parse(description, tree, error)
+		&& CSGSceneData{tree}.contentHash() == CSGSceneData{buildSampleScene()}.contentHash();
+
+	// Invalid descriptions are rejected with the line of the error
+	std::istringstream missingOperator{"sphere radius 1\nbox size 1 1 1\n"};
+	std::istringstream missingOperand{"sphere radius 1\ndifference\n"};
+	std::istringstream badKeyword{"sphere radius 1\nbox side 1\n"};
+	const bool errorCheck = !CSGSceneFile::parse(missingOperator, tree, error)
+		&& !CSGSceneFile::parse(missingOperand, tree, error) && error.rfind("line 2", 0) == 0
+		&& !CSGSceneFile::parse(badKeyword, tree, error) && error.rfind("line 2", 0) == 0;
+
+	std::istringstream path{"lookAt 0 2 8 0 0 0 60\nview 1 0 0 0 0 1 0 0 0 0 1 0 0 0 -5 1 45\n"};
+	std::vector<CameraParameters> cameras;
+	const bool cameraCheck = CameraPath::parse(path, cameras, error) && cameras.size() == 2
+		&& glm::length(cameras[0].viewMat[3] - buildSampleCamera().viewMat[3]) < 1e-5f
+		&& cameras[1].viewMat[3].z == -5.f && std::abs(cameras[1].fieldOfView - glm::radians(45.f)) < 1e-6f
+		&& CameraPath::turntable(8, glm::vec3(0.f), 8.f, 2.f).size() == 8;
+
+	return parseCheck && errorCheck && cameraCheck;
+}
+
+bool CSGRenderingTest::testBinaryScene() const
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "csgBinarySceneTest";
+	std::filesystem::create_directories(directory);
+	const std::string path = (directory / "sample.csgb").string();
+	const std::string corruptedPath = (directory / "corrupted.csgb").string();
+
+	const CSGSceneData scene{buildSampleScene()};
+	std::string error;
+	bool saveCheck = CSGBinaryScene::save(path, scene.view(), error);
+
+	// The mapped sections are the serialized buffers, byte for byte
+	CSGBinaryScene mappedScene;
+	const bool openCheck = mappedScene.open(path, error) && mappedScene.view().nbNode == scene.view().nbNode
+		&& CSGSceneData::contentHash(mappedScene.view()) == scene.contentHash() && mappedScene.contentHash() == scene.contentHash()
+		&& reinterpret_cast<uintptr_t>(mappedScene.view().spheres) % CSGBinaryHeader::SECTION_ALIGNMENT == 0;
+
+	// The tree is only rebuilt when asked for, and evaluates like the original one
+	bool treeCheck = !mappedScene.isTreeBuilt();
+	const CSGSceneData rebuiltScene{mappedScene.tree()};
+	const CSGEvaluator evaluator{scene.view()};
+	const CSGEvaluator rebuiltEvaluator{rebuiltScene.view()};
+	for (const glm::vec3& p : {glm::vec3(-1.5f, 3.f, 0.f), glm::vec3(1.5f, 0.f, 0.f), glm::vec3(2.3f, 0.f, 0.7f)})
+		treeCheck = treeCheck && std::abs(evaluator.scanSDF(p).dist - rebuiltEvaluator.scanSDF(p).dist) < 1e-4f;
+	treeCheck = treeCheck && mappedScene.isTreeBuilt();
+
+	// A node pointing after itself is rejected at loading
+	std::vector<CSGNode::ShaderNodeData> corruptedNodes = scene.getNodes();
+	corruptedNodes.back().leftChildIndex = static_cast<int>(corruptedNodes.size());
+	CSGSceneView corruptedView = scene.view();
+	corruptedView.nodes = corruptedNodes.data();
+	saveCheck = saveCheck && CSGBinaryScene::save(corruptedPath, corruptedView, error);
+	CSGBinaryScene corruptedScene;
+	bool corruptedCheck = !corruptedScene.open(corruptedPath, error) && !corruptedScene.isOpen();
+
+	// So is a leaf with a child index
+	corruptedNodes = scene.getNodes();
+	corruptedNodes.front().leftChildIndex = 100000;
+	corruptedView.nodes = corruptedNodes.data();
+	saveCheck = saveCheck && CSGBinaryScene::save(corruptedPath, corruptedView, error);
+	corruptedCheck = corruptedCheck && !corruptedScene.open(corruptedPath, error);
+
+	// Headers whose sizes or offsets point out of the file, including an offset wrapping around with its section
+	auto openPatchedHeader = [&](const std::function<void(CSGBinaryHeader&)>& patch)
+	{
+		std::filesystem::copy_file(path, corruptedPath, std::filesystem::copy_options::overwrite_existing);
+		std::fstream file{corruptedPath, std::ios::in | std::ios::out | std::ios::binary};
+		CSGBinaryHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		patch(header);
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.close();
+		CSGBinaryScene patchedScene;
+		return patchedScene.open(corruptedPath, error);
+	};
+	corruptedCheck = corruptedCheck && openPatchedHeader([](CSGBinaryHeader&) {})
+		&& !openPatchedHeader([](CSGBinaryHeader& header) { header.headerSize = 16; })
+		&& !openPatchedHeader([](CSGBinaryHeader& header) { header.headerSize = 1u << 30; })
+		&& !openPatchedHeader([](CSGBinaryHeader& header) { header.sectionOffset[1] = ~uint64_t{0} - 63; });
+
+	mappedScene.close();
+	std::filesystem::remove_all(directory);
+	return saveCheck && openCheck && treeCheck && corruptedCheck;
+}
+
+bool CSGRenderingTest::testStreamingLoader() const
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "csgStreamingLoaderTest";
+	std::filesystem::create_directories(directory);
+	const std::string path = (directory / "sample.csgb").string();
+
+	const CSGSceneData scene{buildSampleScene()};
+	std::string error;
+	bool loadCheck = CSGBinaryScene::save(path, scene.view(), error);
+
+	// Two nodes per chunk: after the first chunk, the sphere and the box are two separate subtrees
+	CSGStreamingLoader loader{2};
+	loadCheck = loadCheck && loader.open(path, error) && loader.loadChunk() && !loader.isComplete();
+	const CSGSceneData preview = loader.buildPreview();
+	const bool previewCheck = preview.view().nbBox == 2 && preview.view().nbNode == 3
+		&& CSGEvaluator{preview.view()}.scanSDF(glm::vec3(-1.5f, 0.f, 0.f)).dist < 0.f;
+
+	while (loader.loadChunk())
+	{
+	}
+	const CSGSceneData loadedScene = loader.takeScene();
+	loadCheck = loadCheck && loader.isComplete() && !loader.hasFailed() && loadedScene.contentHash() == scene.contentHash();
+
+	// A truncated file is reported as an error
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 16);
+	CSGStreamingLoader truncatedLoader{2};
+	bool truncatedCheck = truncatedLoader.open(path, error);
+	while (truncatedLoader.loadChunk())
+	{
+	}
+	truncatedCheck = truncatedCheck && truncatedLoader.hasFailed() && !truncatedLoader.isComplete();
+
+	// So is a leaf with a child index
+	std::vector<CSGNode::ShaderNodeData> corruptedNodes = scene.getNodes();
+	corruptedNodes.front().leftChildIndex = 100000;
+	CSGSceneView corruptedView = scene.view();
+	corruptedView.nodes = corruptedNodes.data();
+	CSGStreamingLoader corruptedLoader{2};
+	bool corruptedCheck = CSGBinaryScene::save(path, corruptedView, error) && corruptedLoader.open(path, error);
+	while (corruptedLoader.loadChunk())
+	{
+	}
+	corruptedCheck = corruptedCheck && corruptedLoader.hasFailed() && !corruptedLoader.isComplete();
+
+	std::filesystem::remove_all(directory);
+	return loadCheck && previewCheck && truncatedCheck && corruptedCheck;
+}
+
+bool CSGRenderingTest::testArena() const
+{
+	// Small chunks, so the tree spans several of them
+	CSGArena arena{256};
+	bool arenaCheck;
+	{
+		auto sphere = arena.makePrimitive<Sphere>(glm::vec3(-1.5f, 0.f, 0.f), glm::vec3(1.f, 0.f, 0.f), 1.f);
+		auto box = arena.makePrimitive<Box>(glm::vec3(1.5f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f));
+		auto cylinder = arena.makePrimitive<Cylinder>(glm::vec3(1.5f, 0.f, 0.f), 2.f, 0.3f);
+		const CSGTree tree{ arena.makeDifference(arena.makeUnion(sphere, box), cylinder) };
+
+		// Same serialization as the tree built with the shared_ptr factories
+		arenaCheck = CSGSceneData{tree}.contentHash() == CSGSceneData{buildSampleScene()}.contentHash()
+			&& arena.getNbChunk() > 1 && tree.nbNode() == 5;
+	}
+
+	// Requests are aligned, and bigger requests than a chunk get their own chunk
+	const bool alignmentCheck = reinterpret_cast<uintptr_t>(arena.allocate(3, 1)) != 0
+		&& reinterpret_cast<uintptr_t>(arena.allocate(64, 64)) % 64 == 0
+		&& arena.allocate(4096, 16) != nullptr;
+
+	return arenaCheck && alignmentCheck;
+}
+
+bool CSGRenderingTest::testPrimitiveStore() const
+{
+	// Every primitive type and a complement, rotated and scaled
+	const glm::mat4 transform = glm::scale(glm::rotate(glm::translate(glm::mat4(1.f), glm::vec3(0.5f, 0.f, -0.5f)),
+		0.4f, glm::normalize(glm::vec3(0.f, 1.f, 1.f))), glm::vec3(1.2f));
+	auto torus = CSGNode::makePrimitive(std::make_shared<Torus>(transform, 1.f, 0.3f));
+	auto cylinder = CSGNode::makePrimitive(std::make_shared<Cylinder>(transform, 0.8f, 0.5f));
+	const CSGTree tree{ CSGNode::makeUnion(buildSampleScene().getRoot(), CSGNode::makeIntersection(torus, CSGNode::makeComplement(cylinder))) };
+
+	// The store serializes the same buffers as the tree
+	const CSGSceneData treeScene{tree};
+	CSGPrimitiveStore store{tree};
+	bool serializationCheck = store.sceneData().contentHash() == treeScene.contentHash() && store.treeRawData() == tree.treeRawData();
+	for (const Primitive::PrimitiveType type : {Primitive::PrimitiveType::Sphere, Primitive::PrimitiveType::Torus,
+		Primitive::PrimitiveType::Cylinder, Primitive::PrimitiveType::Box})
+	{
+		serializationCheck = serializationCheck && store.rawDataByPrimitiveType(type) == tree.rawDataByPrimitiveType(type);
+	}
+
+	// Same distances and colors as the evaluator of the serialized scene
+	const CSGEvaluator evaluator{treeScene.view()};
+	const CSGStoreEvaluator storeEvaluator{store};
+	bool evaluationCheck = true;
+	for (float x = -3.f; x <= 3.f; x += 0.37f)
+	{
+		for (float y = -2.f; y <= 2.f; y += 0.41f)
+		{
+			const glm::vec3 pos{x, y, 0.3f * x - 0.2f};
+			const CSGEvaluation expected = evaluator.scanSDF(pos);
+			const CSGEvaluation result = storeEvaluator.scanSDF(pos);
+			evaluationCheck = evaluationCheck && result.dist == expected.dist && result.color == expected.color;
+		}
+	}
+
+	// The sample scene built directly in a store
+	CSGPrimitiveStore builtStore;
+	const int sphere = builtStore.addLeaf(builtStore.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(-1.5f, 0.f, 0.f)), glm::vec3(1.f, 0.f, 0.f), 1.f));
+	const int box = builtStore.addLeaf(builtStore.addBox(glm::translate(glm::mat4(1.f), glm::vec3(1.5f, 0.f, 0.f)), glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f)));
+	const int sampleUnion = builtStore.addOperation(SHADER_TYPE_UNION, sphere, box);
+	const int drill = builtStore.addLeaf(builtStore.addCylinder(glm::translate(glm::mat4(1.f), glm::vec3(1.5f, 0.f, 0.f)), glm::vec3(1.f), 2.f, 0.3f));
+	builtStore.addOperation(SHADER_TYPE_DIFFERENCE, sampleUnion, drill);
+	const bool buildCheck = builtStore.sceneData().contentHash() == CSGSceneData{buildSampleScene()}.contentHash()
+		&& builtStore.getLeafHandle(drill) == PrimitiveHandle{Primitive::PrimitiveType::Cylinder, 0};
+
+	// Editing through the Primitive facade updates the cached inverse transform
+	PrimitiveRef sphereRef{builtStore, builtStore.getLeafHandle(sphere)};
+	sphereRef.setTransform(glm::translate(glm::mat4(1.f), glm::vec3(-2.f, 0.f, 0.f)));
+	const Sphere movedSphere{glm::vec3(-2.f, 0.f, 0.f), glm::vec3(1.f, 0.f, 0.f), 1.f};
+	const CSGStoreEvaluator builtEvaluator{builtStore};
+	const bool facadeCheck = sphereRef.rawData() == movedSphere.rawData() && sphereRef.getColor() == glm::vec3(1.f, 0.f, 0.f)
+		&& std::abs(builtEvaluator.scanSDF(glm::vec3(-2.f, 3.f, 0.f)).dist - 2.f) < 1e-4f;
+
+	return serializationCheck && evaluationCheck && buildCheck && facadeCheck;
+}
+
+bool CSGRenderingTest::testExpression() const
+{
+	// Qualified names, Sphere, Box and Cylinder are also the runtime primitive classes
+	namespace expr = CSGExpression;
+	using SampleExpression = expr::Difference<expr::Union<expr::Sphere, expr::Box>, expr::Cylinder>;
+
+	const CSGSceneData scene{buildSampleScene()};
+	const CSGEvaluator evaluator{scene.view()};
+
+	// Bound to the sample scene, the expression gives exactly the distances and colors of the interpreter
+	SampleExpression expression;
+	std::string error;
+	bool evaluationCheck = expr::bindScene(scene.view(), expression, error);
+	for (float x = -3.f; x <= 3.f; x += 0.29f)
+	{
+		for (float y = -2.f; y <= 2.f; y += 0.33f)
+		{
+			const glm::vec3 pos{x, y, 0.4f * y};
+			const CSGEvaluation expected = evaluator.scanSDF(pos);
+			const CSGEvaluation result = expression.evaluate(pos);
+			evaluationCheck = evaluationCheck && result.dist == expected.dist && result.color == expected.color
+				&& expression.distance(pos) == expected.dist;
+		}
+	}
+
+	// Another topology is rejected
+	expr::Union<expr::Difference<expr::Sphere, expr::Box>, expr::Cylinder> otherExpression;
+	expr::Complement<SampleExpression> biggerExpression;
+	const bool mismatchCheck = !expr::bindScene(scene.view(), otherExpression, error) && !expr::bindScene(scene.view(), biggerExpression, error)
+		&& !error.empty();
+
+	// The generated source declares the same type
+	const std::string source = expr::generateSource(scene.view(), "sampleScene");
+	const bool sourceCheck = expr::typeName(scene.view()) == SampleExpression::name()
+		&& source.find("using sampleSceneType = CSGExpression::Difference<CSGExpression::Union<CSGExpression::Sphere, CSGExpression::Box>, CSGExpression::Cylinder>;") != std::string::npos
+		&& source.find("inline sampleSceneType sampleScene()") != std::string::npos;
+
+	return evaluationCheck && mismatchCheck && sourceCheck;
+}
+
+bool CSGRenderingTest::testShaderGenerator() const
+{
+	const CSGSceneData scene{buildSampleScene()};
+	const CSGSceneData movedScene{buildSampleScene(glm::vec3(-2.f, 1.f, 0.f))};
+	const CSGSceneData otherScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Sphere>(1.f)) }};
+
+	// Straight-line code: no node buffer and no switch, one statement per node with constant indices
+	const std::string source = CSGShaderGenerator::generateSceneSDF(scene.view());
+	const bool sourceCheck = source.find("nodesData") == std::string::npos && source.find("switch") == std::string::npos
+		&& source.find("float d1 = boxSDF(boxesData[0], localPos) * scale;") != std::string::npos
+		&& source.find("float d4 = differenceSDF(d2, d3);") != std::string::npos
+		&& source.find("vec3 g4 = d4 == d2 ? g2 : -g3;") != std::string::npos;
+
+	// Only the topology matters: moving a primitive keeps the same source
+	const bool topologyCheck = CSGShaderGenerator::topologyHash(scene.view()) == CSGShaderGenerator::topologyHash(movedScene.view())
+		&& source == CSGShaderGenerator::generateSceneSDF(movedScene.view())
+		&& CSGShaderGenerator::topologyHash(scene.view()) != CSGShaderGenerator::topologyHash(otherScene.view());
+
+	// The define goes after #version, the generated functions between the include and main()
+	const std::string computeSource = "#version 460\n#include \"../Common/PrimitiveSceneSDF.glsl\"\nvoid main()\n{\n}\n";
+	std::string specializedSource;
+	std::string error;
+	const bool specializeCheck = CSGShaderGenerator::specializeShader(computeSource, scene.view(), specializedSource, error)
+		&& specializedSource.find("#version 460\n#define CSG_SPECIALIZED_SCENE\n#include") == 0
+		&& specializedSource.find("float scanSDF(") > specializedSource.find("PrimitiveSceneSDF.glsl")
+		&& specializedSource.find("void main()") > specializedSource.find("float scanSDFGradient(")
+		&& !CSGShaderGenerator::specializeShader("void main() {}", scene.view(), specializedSource, error);
+
+	// Programs are compiled once per topology, and evicted in least recently used order
+	unsigned int nextProgram = 1;
+	std::vector<unsigned int> releasedPrograms;
+	bool cacheCheck;
+	{
+		CSGShaderCache cache{computeSource, [&nextProgram](const std::string&, std::string&) { return nextProgram++; },
+			[&releasedPrograms](const unsigned int program) { releasedPrograms.push_back(program); }, 1};
+		const unsigned int program = cache.getProgram(scene.view(), error);
+		cacheCheck = program == 1 && cache.getProgram(movedScene.view(), error) == program && cache.getNbHit() == 1
+			&& cache.getProgram(otherScene.view(), error) == 2 && releasedPrograms == std::vector<unsigned int>{1}
+			&& cache.getNbCompilation() == 2 && cache.size() == 1;
+	}
+	cacheCheck = cacheCheck && releasedPrograms == std::vector<unsigned int>{1, 2};
+
+	return sourceCheck && topologyCheck && specializeCheck && cacheCheck;
+}
+
+bool CSGRenderingTest::testCompiledEvaluator() const
+{
+	// Every primitive type, a complement and a tree deeper on the left than on the right
+	const glm::vec3 red{1.f, 0.f, 0.f};
+	auto lattice = CSGNode::makeUnion(
+		CSGNode::makeDifference(CSGNode::makePrimitive(std::make_shared<Torus>(glm::vec3(0.5f, 0.f, 0.f), red, 1.2f, 0.3f)),
+			CSGNode::makePrimitive(std::make_shared<Sphere>(glm::vec3(1.5f, 0.f, 0.f), 0.5f))),
+		CSGNode::makeIntersection(CSGNode::makePrimitive(std::make_shared<Cylinder>(glm::vec3(-1.f, 0.5f, 0.f), glm::vec3(0.f, 1.f, 0.f), 1.f, 0.4f)),
+			CSGNode::makeComplement(CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(-1.f, 1.f, 0.f), glm::vec3(0.2f))))));
+	const CSGSceneData scene{CSGTree{ lattice }};
+	const CSGSceneData sampleScene{buildSampleScene()};
+	const CSGSceneData movedSampleScene{buildSampleScene(glm::vec3(-2.f, 1.f, 0.f))};
+
+	// Same topology, same program
+	CSGProgramCache cache;
+	const auto program = cache.getProgram(scene.view());
+	const auto sampleProgram = cache.getProgram(sampleScene.view());
+	const bool cacheCheck = cache.getProgram(movedSampleScene.view()) == sampleProgram && program != sampleProgram
+		&& cache.getNbCompilation() == 2 && cache.getNbHit() == 1 && cache.size() == 2;
+
+	// Registers are reused once read: 8 nodes only need 3 of them
+	const bool registerCheck = program->getNbRegister() == 3 && program->getInstructions().size() == 8 && program->getLeafNodes().size() == 4;
+
+	// A number of points that is not a multiple of the batch size
+	std::vector<glm::vec3> positions;
+	for (float x = -3.f; x <= 3.f; x += 0.13f)
+	{
+		for (float y = -2.f; y <= 2.f; y += 0.17f)
+			positions.emplace_back(x, y, 0.3f * x - 0.2f * y);
+	}
+
+	auto matches = [&positions](const CSGSceneView& view, const std::shared_ptr<const CSGCompiledProgram>& compiledProgram)
+	{
+		const CSGEvaluator evaluator{view};
+		const CSGCompiledEvaluator compiledEvaluator{view, compiledProgram};
+		std::vector<float> distances(positions.size());
+		std::vector<CSGEvaluation> results(positions.size());
+		compiledEvaluator.distances(positions.data(), static_cast<int>(positions.size()), distances.data());
+		compiledEvaluator.evaluate(positions.data(), static_cast<int>(positions.size()), results.data());
+
+		bool match = compiledEvaluator.getNbEvaluation() == 2 * static_cast<long long>(positions.size());
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			const CSGEvaluation expected = evaluator.scanSDF(positions[i]);
+			match = match && std::abs(distances[i] - expected.dist) <= 1e-5f * (1.f + std::abs(expected.dist))
+				&& results[i].dist == distances[i] && results[i].color == expected.color;
+		}
+		return match;
+	};
+
+	const bool evaluationCheck = matches(scene.view(), program) && matches(sampleScene.view(), sampleProgram)
+		&& matches(movedSampleScene.view(), sampleProgram);
+
+	return cacheCheck && registerCheck && evaluationCheck;
+}
+
+bool CSGRenderingTest::testPointQuery() const
+{
+	const CSGSceneData scene{buildSampleScene()};
+	const CSGEvaluator evaluator{scene.view()};
+
+	// Several chunks, the last one incomplete, in an order without spatial coherence
+	std::vector<glm::vec3> points;
+	for (int i = 0; i < 5 * CSGPointQuery::CHUNK_SIZE + 37; i++)
+		points.emplace_back(static_cast<float>((i * 37) % 101) / 16.f - 3.f, static_cast<float>((i * 53) % 67) / 16.f - 2.f, static_cast<float>(i % 11) / 8.f - 0.6f);
+
+	CSGPointQuery query{scene.view(), 3};
+	const std::vector<float> distances = query.distances(points);
+	const std::vector<uint8_t> inside = query.inside(points);
+	const std::vector<CSGEvaluation> results = query.evaluate(points);
+
+	bool evaluationCheck = true;
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const CSGEvaluation expected = evaluator.scanSDF(points[i]);
+		evaluationCheck = evaluationCheck && std::abs(distances[i] - expected.dist) <= 1e-5f * (1.f + std::abs(expected.dist))
+			&& results[i].dist == distances[i] && results[i].color == expected.color && inside[i] == (distances[i] <= 0.f ? 1 : 0);
+	}
+
+	// Sorting and threads only change the order of the evaluations, not the results
+	CSGPointQuery sortedQuery{scene.view(), 1};
+	sortedQuery.setSpatialSorting(true);
+	const bool sortingCheck = sortedQuery.distances(points) == distances && sortedQuery.inside(points) == inside;
+
+	// Points along the x axis are already in Morton order, and the order is a permutation
+	const std::vector<glm::vec3> line{glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), glm::vec3(2.f, 0.f, 0.f), glm::vec3(3.f, 0.f, 0.f)};
+	const std::vector<glm::vec3> reversedLine(line.rbegin(), line.rend());
+	std::vector<uint32_t> order = CSGPointQuery::spatialOrder(points.data(), points.size());
+	std::sort(order.begin(), order.end());
+	bool orderCheck = CSGPointQuery::spatialOrder(line.data(), line.size()) == std::vector<uint32_t>{0, 1, 2, 3}
+		&& CSGPointQuery::spatialOrder(reversedLine.data(), reversedLine.size()) == std::vector<uint32_t>{3, 2, 1, 0};
+	for (size_t i = 0; i < order.size(); i++)
+		orderCheck = orderCheck && order[i] == i;
+
+	return evaluationCheck && sortingCheck && orderCheck;
+}
+
+bool CSGRenderingTest::testMesher() const
+{
+	// Weld the chunks by position and return the largest distance of a vertex to the surface. 'closed' tells if every edge is
+	// shared by exactly two triangles in opposite directions, and 'volume' is the signed volume of the mesh.
+	auto meshScene = [](const CSGSceneView& scene, const bool sharpFeatures, bool& closed, float& volume)
+	{
+		CSGMesher mesher{scene, 2};
+		mesher.setResolution(32);
+		mesher.setBrickResolution(8);
+		mesher.setSharpFeatures(sharpFeatures);
+
+		std::map<std::tuple<float, float, float>, int> weldedVertices;
+		std::vector<glm::vec3> vertices;
+		std::vector<int> triangles;
+		std::string error;
+		const bool extracted = mesher.extract([&](const MeshChunk& chunk)
+		{
+			std::vector<int> welded;
+			for (const glm::vec3& vertex : chunk.vertices)
+			{
+				welded.push_back(weldedVertices.emplace(std::make_tuple(vertex.x, vertex.y, vertex.z), static_cast<int>(vertices.size())).first->second);
+				if (welded.back() == static_cast<int>(vertices.size()))
+					vertices.push_back(vertex);
+			}
+			for (const uint32_t index : chunk.triangles)
+				triangles.push_back(welded[index]);
+		}, error);
+
+		std::map<std::pair<int, int>, int> edges;
+		volume = 0.f;
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			for (int j = 0; j < 3; j++)
+				edges[{triangles[i + j], triangles[i + (j + 1) % 3]}]++;
+			volume += glm::dot(vertices[triangles[i]], glm::cross(vertices[triangles[i + 1]], vertices[triangles[i + 2]])) / 6.f;
+		}
+		closed = extracted && !triangles.empty();
+		for (const auto& [edge, count] : edges)
+		{
+			auto opposite = edges.find({edge.second, edge.first});
+			closed = closed && count == 1 && opposite != edges.end() && opposite->second == 1;
+		}
+
+		const CSGEvaluator evaluator{scene};
+		float maxError = 0.f;
+		for (const glm::vec3& vertex : vertices)
+			maxError = std::max(maxError, std::abs(evaluator.scanSDF(vertex).dist));
+		return maxError / mesher.cellSize();
+	};
+
+	// A sphere split in 64 branches gives a single closed surface, close to the sphere
+	const CSGSceneData sphereScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Sphere>(glm::vec3(0.3f, -0.2f, 0.1f), 0.93f)) }};
+	bool closed;
+	float volume;
+	const float sphereError = meshScene(sphereScene.view(), false, closed, volume);
+	const float sphereVolume = 4.f / 3.f * 3.14159265f * 0.93f * 0.93f * 0.93f;
+	const bool sphereCheck = closed && sphereError < 0.5f && std::abs(volume - sphereVolume) < 0.02f * sphereVolume;
+
+	// Sharp features put the vertices of the cells on the edges of a box on the edges, instead of rounding them
+	const CSGSceneData boxScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(0.f), glm::vec3(1.f), glm::vec3(0.6f, 0.7f, 0.8f))) }};
+	bool smoothClosed;
+	bool sharpClosed;
+	float smoothVolume;
+	float sharpVolume;
+	const float smoothError = meshScene(boxScene.view(), false, smoothClosed, smoothVolume);
+	const float sharpError = meshScene(boxScene.view(), true, sharpClosed, sharpVolume);
+	const float boxVolume = 1.2f * 1.4f * 1.6f;
+	const bool sharpCheck = smoothClosed && sharpClosed && sharpError < 0.1f && sharpError < 0.5f * smoothError
+		&& std::abs(sharpVolume - boxVolume) < std::abs(smoothVolume - boxVolume);
+
+	// An unbounded scene needs explicit bounds
+	const CSGSceneData complementScene{CSGTree{ CSGNode::makeComplement(CSGNode::makePrimitive(std::make_shared<Sphere>(1.f))) }};
+	CSGMesher complementMesher{complementScene.view()};
+	std::string error;
+	const bool unboundedCheck = !complementMesher.extract([](const MeshChunk&) {}, error) && !error.empty();
+
+	return sphereCheck && sharpCheck && unboundedCheck;
+}
+
+bool CSGRenderingTest::testRayQuery() const
+{
+	auto closeTo = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b) < 1e-4f; };
+
+	// Hits exactly on the surface. The marcher stops before the exact hit (up to its epsilon), and also on the rays passing
+	// within its epsilon of a silhouette, so it hits wherever the query does.
+	const CSGSceneData scene{buildSampleScene()};
+	const CSGEvaluator evaluator{scene.view()};
+	const SphereMarcher marcher{scene.view()};
+	const CSGRayQuery query{scene.view()};
+	const CameraParameters camera = buildSampleCamera();
+	bool marcherCheck = true;
+	bool surfaceCheck = true;
+	int nbHit = 0;
+	for (int y = 0; y < 48; y++)
+	{
+		for (int x = 0; x < 64; x++)
+		{
+			const Ray ray = camera.rayThroughPixel(x, y, 64, 48);
+			const RayHit hit = query.intersect(ray);
+			if (!hit.hit)
+				continue;
+			const MarchResult march = marcher.marchRay(evaluator, ray, 64, 48);
+			const CSGEvaluation evaluation = evaluator.scanSDF(hit.position);
+			marcherCheck = marcherCheck && march.hit && glm::dot(hit.position - march.position, ray.direction) >= -march.epsilon;
+			surfaceCheck = surfaceCheck && std::abs(evaluation.dist) < 1e-4f && evaluation.color == hit.color;
+			nbHit++;
+		}
+	}
+	const bool imageCheck = marcherCheck && nbHit > 64 * 48 / 16 && query.getNbRay() == 64 * 48;
+
+	// Leaves owning the hits, and normals out of the solid: the box face, then the wall of the hole seen from inside the hole
+	const RayHit boxHit = query.intersect(Ray{glm::vec3(1.5f, 0.5f, 5.f), glm::vec3(0.f, 0.f, -1.f)});
+	const RayHit holeHit = query.intersect(Ray{glm::vec3(1.5f, 0.f, 0.f), glm::vec3(1.f, 0.f, 0.f)});
+	const bool leafCheck = boxHit.hit && boxHit.nodeIndex == 1 && boxHit.primitiveType == SHADER_TYPE_BOX && boxHit.t == 4.f
+		&& closeTo(boxHit.normal, glm::vec3(0.f, 0.f, 1.f)) && holeHit.hit && holeHit.nodeIndex == 3 && holeHit.primitiveType == SHADER_TYPE_CYLINDER
+		&& holeHit.entering && std::abs(holeHit.t - 0.3f) < 1e-6f && closeTo(holeHit.normal, glm::vec3(-1.f, 0.f, 0.f))
+		&& !query.intersect(Ray{glm::vec3(1.5f, 5.f, 0.f), glm::vec3(0.f, -1.f, 0.f)}).hit;
+
+	// Torus: both tubes along its diameter, and a ray starting inside the tube
+	const CSGSceneData torusScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Torus>(glm::vec3(0.f), glm::vec3(1.f), 1.f, 0.25f)) }};
+	const CSGRayQuery torusQuery{torusScene.view()};
+	const std::vector<RayInterval> tubes = torusQuery.intervals(Ray{glm::vec3(-5.f, 0.f, 0.f), glm::vec3(1.f, 0.f, 0.f)});
+	const RayHit insideHit = torusQuery.intersect(Ray{glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f)});
+	const bool torusCheck = tubes.size() == 2 && std::abs(tubes[0].tEnter - 3.75f) < 1e-5f && std::abs(tubes[0].tExit - 4.25f) < 1e-5f
+		&& std::abs(tubes[1].tEnter - 5.75f) < 1e-5f && std::abs(tubes[1].tExit - 6.25f) < 1e-5f
+		&& insideHit.hit && !insideHit.entering && std::abs(insideHit.t - 0.25f) < 1e-6f && closeTo(insideHit.normal, glm::vec3(0.f, 1.f, 0.f))
+		&& !torusQuery.intersect(Ray{glm::vec3(0.f, 5.f, 0.f), glm::vec3(0.f, -1.f, 0.f)}).hit;
+
+	// The normal of a complement points into the sphere
+	const CSGSceneData complementScene{CSGTree{ CSGNode::makeComplement(CSGNode::makePrimitive(std::make_shared<Sphere>(1.f))) }};
+	const RayHit complementHit = CSGRayQuery{complementScene.view()}.intersect(Ray{glm::vec3(0.f), glm::vec3(0.f, 0.f, 2.f)});
+	const bool complementCheck = complementHit.hit && complementHit.entering && std::abs(complementHit.t - 0.5f) < 1e-6f
+		&& closeTo(complementHit.normal, glm::vec3(0.f, 0.f, -1.f));
+
+	return imageCheck && surfaceCheck && leafCheck && torusCheck && complementCheck;
+}
+
+bool CSGRenderingTest::testRayTracer() const
+{
+	// Same image as the marcher, but for a few pixels along the silhouettes where the marcher stops within its epsilon
+	const CSGSceneData scene{buildSampleScene()};
+	const CameraParameters camera = buildSampleCamera();
+	RenderedImage marchedImage{64, 48};
+	RenderedImage tracedImage{64, 48};
+	SphereMarcher{scene.view(), 2}.render(camera, marchedImage);
+	TraceStatistics statistics;
+	CSGRayTracer{scene.view(), 2}.render(camera, tracedImage, &statistics);
+	int nbDifferentPixel = 0;
+	for (size_t i = 0; i < tracedImage.pixels.size(); i++)
+		nbDifferentPixel += glm::length(tracedImage.pixels[i] - marchedImage.pixels[i]) > 2e-2f ? 1 : 0;
+	const bool imageCheck = nbDifferentPixel < 64 * 48 / 100 && statistics.nbPixel == 64 * 48 && statistics.nbHit > 0 && statistics.nbLeafIntersection > 0;
+
+	// Floor seen from just above: the rays close to the horizon run out of marching steps, the traced floor fills the lower half
+	const CSGSceneData floorScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(0.f, -1.f, 0.f), glm::vec3(1.f), glm::vec3(50.f, 1.f, 50.f))) }};
+	CameraParameters floorCamera;
+	floorCamera.viewMat = glm::lookAt(glm::vec3(0.f, 0.2f, 8.f), glm::vec3(0.f, 0.2f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+	MarchStatistics marchStatistics;
+	TraceStatistics floorStatistics;
+	SphereMarcher{floorScene.view(), 2}.render(floorCamera, marchedImage, &marchStatistics);
+	CSGRayTracer{floorScene.view(), 2}.render(floorCamera, tracedImage, &floorStatistics);
+	bool floorCheck = marchStatistics.nbOutOfSteps > 0 && floorStatistics.nbHit == 64 * 24;
+	for (int x = 0; x < 64; x++)
+		floorCheck = floorCheck && tracedImage.at(x, 23).w == 1.f && tracedImage.at(x, 24).w == 0.f;
+
+	return imageCheck && floorCheck;
+}
+
+bool CSGRenderingTest::testMarchDiagnostics() const
+{
+	// The diagnostics of every pixel add up to the statistics of the frame
+	const CSGSceneData scene{buildSampleScene()};
+	const SphereMarcher marcher{scene.view(), 2};
+	RenderedImage image{64, 48};
+	MarchStatistics statistics;
+	MarchDiagnostics diagnostics;
+	marcher.render(buildSampleCamera(), image, &statistics, &diagnostics);
+
+	long long nbStep = 0;
+	bool pixelCheck = diagnostics.width == 64 && diagnostics.height == 48;
+	for (int y = 0; y < diagnostics.height && pixelCheck; y++)
+	{
+		for (int x = 0; x < diagnostics.width; x++)
+		{
+			const PixelDiagnostics& pixel = diagnostics.at(x, y);
+			nbStep += pixel.nbStep;
+			// A hit also evaluates its normal, and a rollback adds an evaluation to its step
+			const bool hit = pixel.termination == MarchTermination::Hit;
+			pixelCheck = pixelCheck && hit == (image.at(x, y).w == 1.f) && pixel.nbEvaluation >= pixel.nbStep + (hit ? 1 : 0)
+				&& pixel.nbEvaluation <= 2 * pixel.nbStep + (hit ? 1 : 0);
+		}
+	}
+	const MarchHistograms histograms = diagnostics.histograms();
+	const bool histogramCheck = nbStep == statistics.nbStep && histograms.nbPixel() == 64 * 48
+		&& histograms.terminations[static_cast<int>(MarchTermination::Hit)] == statistics.nbHit
+		&& histograms.stepPercentile(0.5) <= histograms.stepPercentile(0.9) && histograms.stepPercentile(1.) == statistics.maxStep;
+
+	// Floor seen from just above: the rays close to the horizon run out of steps, and are drawn in red on the heat map
+	const CSGSceneData floorScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(0.f, -1.f, 0.f), glm::vec3(1.f), glm::vec3(50.f, 1.f, 50.f))) }};
+	CameraParameters floorCamera;
+	floorCamera.viewMat = glm::lookAt(glm::vec3(0.f, 0.2f, 8.f), glm::vec3(0.f, 0.2f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+	MarchStatistics floorStatistics;
+	SphereMarcher{floorScene.view(), 2}.render(floorCamera, image, &floorStatistics, &diagnostics);
+	const MarchHistograms floorHistograms = diagnostics.histograms();
+	const RenderedImage heatMap = diagnostics.heatMap();
+	const long long nbRedPixel = std::count(heatMap.pixels.begin(), heatMap.pixels.end(), glm::vec4(1.f, 0.f, 0.f, 1.f));
+	const bool outOfStepsCheck = floorStatistics.nbOutOfSteps > 0 && nbRedPixel == floorStatistics.nbOutOfSteps
+		&& floorHistograms.terminations[static_cast<int>(MarchTermination::OutOfSteps)] == floorStatistics.nbOutOfSteps
+		&& floorHistograms.steps[SphereMarcher::MAX_MARCHING_STEPS] >= floorStatistics.nbOutOfSteps;
+
+	return pixelCheck && histogramCheck && outOfStepsCheck;
+}
+
+bool CSGRenderingTest::testSceneGenerator() const
+{
+	const CSGSceneGenerator generator;
+	const CSGTree balanced = generator.balancedUnion(1000);
+	const CSGTree chain = generator.differenceChain(20);
+	const CSGTree grid = generator.instancedGrid(2, 3, 4);
+	const bool shapeCheck = balanced.nbNode() == 1999 && balanced.height() == 11 && chain.nbNode() == 41 && chain.height() == 21
+		&& grid.nbOfPrimitive() == 3 * 24 && grid.isValid();
+
+	// Random trees respect their height, and only depend on the seed
+	bool randomCheck = true;
+	CSGSceneGenerator randomGenerator{7};
+	for (const auto& [nbPrimitive, maxHeight] : {std::pair<int, int>{1, 1}, {5, 3}, {100, 8}, {100, 30}, {300, 2}})
+	{
+		const CSGTree tree = randomGenerator.randomTree(nbPrimitive, maxHeight);
+		randomCheck = randomCheck && tree.isValid() && tree.nbOfPrimitive() == nbPrimitive
+			&& tree.height() <= std::max(maxHeight, 1 + static_cast<int>(std::ceil(std::log2(nbPrimitive))));
+	}
+	randomCheck = randomCheck && CSGSceneGenerator{3}.randomTree(50, 10).treeRawData() == CSGSceneGenerator{3}.randomTree(50, 10).treeRawData()
+		&& CSGSceneGenerator{3}.randomTree(50, 10).treeRawData() != CSGSceneGenerator{4}.randomTree(50, 10).treeRawData();
+
+	// A filtered run of the suite gives a google-benchmark JSON result
+	CSGBenchmarkSuite suite;
+	suite.setMinTime(1e-3);
+	suite.setFilter("differenceChain/16/nbNode");
+	const std::vector<BenchmarkResult>& results = suite.run();
+	const std::string json = suite.toJson();
+	const bool suiteCheck = results.size() == 1 && results[0].nbIteration > 0 && results[0].itemsPerSecond > 0.
+		&& json.find("\"name\": \"differenceChain/16/nbNode\"") != std::string::npos && json.find("\"time_unit\": \"ns\"") != std::string::npos;
+
+	return shapeCheck && randomCheck && suiteCheck;
+}
+
+bool CSGRenderingTest::testFuzzer() const
+{
+	// The reference evaluation follows the conventions of CSGEvaluator
+	const CSGTree sampleTree = buildSampleScene();
+	const CSGEvaluation aboveSphere = CSGFuzzer::referenceEvaluation(sampleTree.getRoot(), glm::vec3(-1.5f, 3.f, 0.f));
+	const bool referenceCheck = std::abs(aboveSphere.dist - 2.f) < 1e-4f && aboveSphere.color == glm::vec3(1.f, 0.f, 0.f);
+
+	// A short run mutates and cross-checks trees without any mismatch
+	CSGFuzzer fuzzer{2024};
+	const bool runCheck = fuzzer.run(40);
+	const FuzzStatistics& statistics = fuzzer.getStatistics();
+	if (!runCheck)
+		std::cout << "Fuzzer failure: " << fuzzer.getFailure() << std::endl;
+	const bool coverageCheck = statistics.nbIteration == 40 && statistics.nbMutation > 0 && statistics.nbRejectedMutation > 0
+		&& statistics.nbTree > statistics.nbIteration && statistics.nbRay > 0;
+
+	return referenceCheck && runCheck && coverageCheck;
+}
+
+bool CSGRenderingTest::testDistanceBounds() const
+{
+	// Union of unscaled primitives: exact outside, where the safe radius is the distance, and a lower bound inside
+	const CSGSceneData scene{CSGTree{ CSGNode::makeUnion(
+		CSGNode::makePrimitive(std::make_shared<Sphere>(glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), 1.f)),
+		CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(1.5f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f)))) }};
+	const CSGEvaluator evaluator{scene.view()};
+	const DistanceBound unionBound = CSGDistanceBounds::rootBound(scene.view());
+	bool unionCheck = unionBound.lipschitz == 1.f && unionBound.exactOutside && !unionBound.exactInside;
+	std::mt19937 generator{7};
+	std::uniform_real_distribution<float> coordinate{-4.f, 4.f};
+	for (int i = 0; i < 256 && unionCheck; i++)
+	{
+		const glm::vec3 pos{coordinate(generator), coordinate(generator), coordinate(generator)};
+		const float dist = evaluator.scanSDF(pos).dist;
+		const CSGBoundEvaluation bound = evaluator.scanSDFBound(pos);
+		unionCheck = bound.dist == dist && bound.safeRadius <= std::abs(dist) + 1e-5f && bound.exact == (dist > 0.f)
+			&& (!bound.exact || std::abs(bound.safeRadius - dist) < 1e-5f);
+	}
+
+	// Sphere scaled 2 times: the scale precomputed in its record makes its distance exact
+	const glm::mat4 uniformScale = glm::scale(glm::translate(glm::mat4(1.f), glm::vec3(1.f, 0.f, 0.f)), glm::vec3(2.f));
+	const CSGSceneData scaledScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Sphere>(uniformScale, glm::vec3(1.f), 1.f)) }};
+	const CSGBoundEvaluation scaled = CSGEvaluator{scaledScene.view()}.scanSDFBound(glm::vec3(1.f, 5.f, 0.f));
+	const bool scaledCheck = std::abs(scaledScene.view().spheres[0].scale - 2.f) < 1e-5f && scaled.exact && std::abs(scaled.dist - 3.f) < 1e-4f;
+
+	// Unit sphere stretched 3 times along y: the distance is only a bound, and the safe radius never crosses the surface
+	const glm::mat4 stretch = glm::scale(glm::mat4(1.f), glm::vec3(1.f, 3.f, 1.f));
+	const CSGSceneData stretchedScene{CSGTree{ CSGNode::makePrimitive(std::make_shared<Sphere>(stretch, glm::vec3(1.f), 1.f)) }};
+	const DistanceBound stretchedBound = CSGDistanceBounds::rootBound(stretchedScene.view());
+	const CSGEvaluator stretchedEvaluator{stretchedScene.view()};
+	const CSGBoundEvaluation beside = stretchedEvaluator.scanSDFBound(glm::vec3(2.f, 0.f, 0.f));
+	const CSGBoundEvaluation above = stretchedEvaluator.scanSDFBound(glm::vec3(0.f, 4.f, 0.f));
+	const bool stretchedCheck = !stretchedBound.exactOutside && std::abs(stretchedBound.lipschitz - 1.f) < 1e-3f && !beside.exact
+		&& std::abs(beside.safeRadius - 1.f) < 1e-3f && above.safeRadius <= 1.f;
+
+	// Both step methods find the same surfaces
+	const CSGSceneData sampleScene{buildSampleScene()};
+	SphereMarcher marcher{sampleScene.view(), 2};
+	RenderedImage relaxedImage{64, 48};
+	RenderedImage overstepImage{64, 48};
+	MarchStatistics relaxedStatistics;
+	MarchStatistics overstepStatistics;
+	marcher.setStepMethod(SphereMarcher::StepMethod::Relaxed);
+	marcher.render(buildSampleCamera(), relaxedImage, &relaxedStatistics);
+	marcher.setStepMethod(SphereMarcher::StepMethod::Overstep);
+	marcher.render(buildSampleCamera(), overstepImage, &overstepStatistics);
+	int nbDifferentPixel = 0;
+	for (size_t i = 0; i < relaxedImage.pixels.size(); i++)
+		nbDifferentPixel += relaxedImage.pixels[i].w != overstepImage.pixels[i].w ? 1 : 0;
+	const bool marcherCheck = relaxedStatistics.nbHit > 0 && nbDifferentPixel <= relaxedStatistics.nbHit / 100 + 1;
+
+	// Leaves are told apart by their type, whatever their child indices
+	std::vector<CSGNode::ShaderNodeData> strayNodes = sampleScene.getNodes();
+	strayNodes.front().leftChildIndex = 100000;
+	CSGSceneView strayView = sampleScene.view();
+	strayView.nodes = strayNodes.data();
+	const glm::vec3 strayPos{2.5f, 0.5f, 0.f};
+	const CSGBoundEvaluation strayBound = CSGEvaluator{strayView}.scanSDFBound(strayPos);
+	const CSGBoundEvaluation sampleBound = CSGEvaluator{sampleScene.view()}.scanSDFBound(strayPos);
+	const bool leafCheck = strayBound.safeRadius == sampleBound.safeRadius && strayBound.exact == sampleBound.exact;
+
+	return unionCheck && scaledCheck && stretchedCheck && marcherCheck && leafCheck;
+}
+
+bool CSGRenderingTest::testCompactScene() const
+{
+	// Random tree of rotated and scaled primitives, with a mirrored and stretched box
+	CSGSceneGenerator generator{11};
+	const glm::mat4 mirror = glm::scale(glm::rotate(glm::translate(glm::mat4(1.f), glm::vec3(1.f, -2.f, 0.5f)), 0.7f, glm::vec3(0.f, 1.f, 0.f)), glm::vec3(-1.f, 2.f, 1.f));
+	const CSGSceneData scene{CSGTree{ CSGNode::makeUnion(generator.randomTree(32, 8).getRoot(),
+		CSGNode::makePrimitive(std::make_shared<Box>(mirror, glm::vec3(0.5f), glm::vec3(0.5f, 0.3f, 0.8f)))) }};
+	const CSGCompactScene compactScene{scene.view()};
+
+	const size_t nbPrimitive = scene.getSpheres().size() + scene.getToruses().size() + scene.getCylinders().size() + scene.getBoxes().size();
+	const bool sizeCheck = compactScene.primitiveByteSize() == 32 * nbPrimitive
+		&& compactScene.rawDataByPrimitiveType(Primitive::PrimitiveType::Box).size() == 32 * scene.getBoxes().size();
+
+	// The compact evaluator matches the full evaluator on the decoded records, and the original scene up to the quantization
+	const CSGSceneData decodedScene = compactScene.decode();
+	const CSGEvaluator evaluator{scene.view()};
+	const CSGEvaluator decodedEvaluator{decodedScene.view()};
+	const CSGCompactEvaluator compactEvaluator{compactScene};
+	bool distanceCheck = decodedScene.getNodes().size() == scene.getNodes().size();
+	for (int i = 0; i < 512 && distanceCheck; i++)
+	{
+		const glm::vec3 pos = generator.randomPoint(5.f);
+		const float dist = compactEvaluator.scanSDF(pos).dist;
+		distanceCheck = std::abs(dist - decodedEvaluator.scanSDF(pos).dist) < 1e-3f && std::abs(dist - evaluator.scanSDF(pos).dist) < 1e-2f;
+	}
+
+	return sizeCheck && distanceCheck && compactEvaluator.getNbEvaluation() == 512;
+}
+
+bool CSGRenderingTest::testSmoothOperations() const
+{
+	// Two overlapping spheres blended together, with a box carved out smoothly
+	CSGPrimitiveStore store;
+	const int left = store.addLeaf(store.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(-0.9f, 0.f, 0.f)), glm::vec3(1.f, 0.f, 0.f), 1.f));
+	const int right = store.addLeaf(store.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(0.9f, 0.f, 0.f)), glm::vec3(0.f, 0.f, 1.f), 1.f));
+	const int blend = store.addSmoothOperation(SHADER_TYPE_SMOOTH_UNION, left, right, 0.5f);
+	const CSGSceneData blendScene = store.sceneData();
+	const int box = store.addLeaf(store.addBox(glm::translate(glm::mat4(1.f), glm::vec3(0.f, 1.f, 0.f)), glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.5f)));
+	store.addSmoothOperation(SHADER_TYPE_SMOOTH_DIFFERENCE, blend, box, 0.2f);
+	const CSGSceneData scene = store.sceneData();
+
+	// The smooth union is below the union by at most k / 4, and equal to it where the distances differ by more than k
+	const CSGEvaluator blendEvaluator{blendScene.view()};
+	bool blendCheck = true;
+	for (float x = -3.f; x <= 3.f; x += 0.11f)
+	{
+		const glm::vec3 pos{x, 0.6f, 0.1f * x};
+		const float a = glm::length(pos - glm::vec3(-0.9f, 0.f, 0.f)) - 1.f;
+		const float b = glm::length(pos - glm::vec3(0.9f, 0.f, 0.f)) - 1.f;
+		const float dist = blendEvaluator.scanSDF(pos).dist;
+		blendCheck = blendCheck && dist <= std::min(a, b) + 1e-5f && dist >= std::min(a, b) - 0.125f - 1e-5f
+			&& (std::abs(a - b) < 0.5f || std::abs(dist - std::min(a, b)) < 1e-5f);
+	}
+
+	// Analytic gradient against finite differences, and the other CPU paths against CSGEvaluator
+	const CSGEvaluator evaluator{scene.view()};
+	const CSGStoreEvaluator storeEvaluator{store};
+	const CSGCompiledEvaluator compiledEvaluator{scene.view(), std::make_shared<const CSGCompiledProgram>(scene.view())};
+	CSGExpression::SmoothDifference<CSGExpression::SmoothUnion<CSGExpression::Sphere, CSGExpression::Sphere>, CSGExpression::Box> expression;
+	std::string error;
+	bool evaluationCheck = CSGExpression::bindScene(scene.view(), expression, error)
+		&& CSGExpression::typeName(scene.view()) == decltype(expression)::name();
+	const float epsilon = 1e-3f;
+	for (float x = -2.5f; x <= 2.5f; x += 0.23f)
+	{
+		for (float y = -1.45f; y <= 2.f; y += 0.27f)
+		{
+			const glm::vec3 pos{x, y, 0.2f * x + 0.1f};
+			const CSGEvaluation expected = evaluator.scanSDF(pos);
+			const CSGGradientEvaluation gradient = evaluator.scanSDFGradient(pos);
+			const glm::vec3 finiteDifference = glm::vec3(
+				evaluator.scanSDF(pos + glm::vec3(epsilon, 0.f, 0.f)).dist - evaluator.scanSDF(pos - glm::vec3(epsilon, 0.f, 0.f)).dist,
+				evaluator.scanSDF(pos + glm::vec3(0.f, epsilon, 0.f)).dist - evaluator.scanSDF(pos - glm::vec3(0.f, epsilon, 0.f)).dist,
+				evaluator.scanSDF(pos + glm::vec3(0.f, 0.f, epsilon)).dist - evaluator.scanSDF(pos - glm::vec3(0.f, 0.f, epsilon)).dist) / (2.f * epsilon);
+			float compiledDistance;
+			compiledEvaluator.distances(&pos, 1, &compiledDistance);
+			evaluationCheck = evaluationCheck && std::abs(gradient.dist - expected.dist) < 1e-6f && glm::length(gradient.gradient - finiteDifference) < 2e-2f
+				&& std::abs(storeEvaluator.scanSDF(pos).dist - expected.dist) < 1e-5f && std::abs(compiledDistance - expected.dist) < 1e-5f
+				&& std::abs(expression.distance(pos) - expected.dist) < 1e-5f && glm::length(expression.evaluate(pos).color - expected.color) < 1e-5f;
+		}
+	}
+
+	// The bounds of the smooth union grow by the blend radius, those of the smooth difference stay the ones of its left child
+	const std::vector<AABB> bounds = CSGBounds::nodeBounds(scene.view());
+	const std::vector<float> margins = CSGBounds::blendMargins(scene.view());
+	const bool boundsCheck = bounds[blend].min.x <= -2.4f && bounds[blend].max.y >= 1.5f && bounds.back().min.x == bounds[blend].min.x
+		&& std::abs(margins[left] - 0.7f) < 1e-6f && margins[box] == 0.2f && margins.back() == 0.f;
+
+	// The node validation accepts positive blend radii only
+	std::vector<CSGNode::ShaderNodeData> nodes = scene.getNodes();
+	CSGSceneView view = scene.view();
+	view.nodes = nodes.data();
+	bool validationCheck = CSGBinaryScene::validateNodes(view, error);
+	nodes.back() = smoothOperationNode(SHADER_TYPE_SMOOTH_DIFFERENCE, blend, box, 0.f);
+	validationCheck = validationCheck && !CSGBinaryScene::validateNodes(view, error);
+
+	// The ray paths report the blends they ignore, so callers can fall back to SphereMarcher
+	const bool rayCheck = CSGRayQuery{scene.view()}.hasSmoothOperation() && CSGRayTracer{blendScene.view(), 1}.hasSmoothOperation()
+		&& !CSGRayQuery::hasSmoothOperation(CSGSceneData{buildSampleScene()}.view());
+
+	return blendCheck && evaluationCheck && boundsCheck && validationCheck && rayCheck;
+}
+
+bool CSGRenderingTest::testNaryNodes() const
+{
+	// A row of 64 spheres joined by a left-deep chain of unions, cut by a box
+	CSGPrimitiveStore store;
+	int row = -1;
+	for (int i = 0; i < 64; i++)
+	{
+		const glm::vec3 color{static_cast<float>(i % 2), 0.f, 1.f};
+		const int sphere = store.addLeaf(store.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(static_cast<float>(i), 0.f, 0.f)), color, 0.6f));
+		row = row < 0 ? sphere : store.addOperation(SHADER_TYPE_UNION, row, sphere);
+	}
+	const int box = store.addLeaf(store.addBox(glm::translate(glm::mat4(1.f), glm::vec3(31.5f, 0.f, 0.f)), glm::vec3(0.f, 1.f, 0.f), glm::vec3(40.f, 0.4f, 1.f)));
+	store.addOperation(SHADER_TYPE_INTERSECTION, row, box);
+	const CSGSceneData scene = store.sceneData();
+
+	// The 63 unions collapse into one n-ary node over the 64 leaves, the intersection of two operands stays binary
+	const std::vector<CSGNode::ShaderNodeData> nodes = CSGNaryNodes::collapseChains(scene.view());
+	CSGSceneView view = scene.view();
+	view.nodes = nodes.data();
+	view.nbNode = static_cast<int>(nodes.size());
+	std::string error;
+	const bool collapseCheck = scene.getNodes().size() == 129 && nodes.size() == 67 && CSGBinaryScene::validateNodes(view, error)
+		&& nodes[64].type == SHADER_TYPE_NARY_UNION && nodes[64].leftChildIndex == 0 && nodes[64].rightChildIndex == 63
+		&& nodes.back().type == SHADER_TYPE_INTERSECTION && CSGNaryNodes::collapseChains(view).size() == nodes.size()
+		&& CSGNaryNodes::expandNaryNodes(view).size() == scene.getNodes().size();
+
+	// Same distances and colors on every evaluator, ties included (between two spheres, the left one wins as in the binary chain)
+	const CSGEvaluator binaryEvaluator{scene.view()};
+	const CSGEvaluator evaluator{view};
+	const CSGCompiledEvaluator compiledEvaluator{view, std::make_shared<const CSGCompiledProgram>(view)};
+	const CSGCompactScene compactScene{view};
+	const CSGCompactEvaluator compactEvaluator{compactScene};
+	const CSGCompactScene binaryCompactScene{scene.view()};
+	const CSGCompactEvaluator binaryCompactEvaluator{binaryCompactScene};
+	bool evaluationCheck = true;
+	for (float x = -2.f; x <= 66.f; x += 0.25f)
+	{
+		const glm::vec3 pos{x, 0.3f * std::sin(x), 0.5f};
+		const CSGEvaluation expected = binaryEvaluator.scanSDF(pos);
+		const CSGEvaluation result = evaluator.scanSDF(pos);
+		CSGEvaluation compiled;
+		compiledEvaluator.evaluate(&pos, 1, &compiled);
+		evaluationCheck = evaluationCheck && result.dist == expected.dist && result.color == expected.color
+			&& std::abs(compiled.dist - expected.dist) < 1e-5f && compiled.color == expected.color
+			&& compactEvaluator.scanSDF(pos).dist == binaryCompactEvaluator.scanSDF(pos).dist
+			&& glm::length(evaluator.scanSDFGradient(pos).gradient - binaryEvaluator.scanSDFGradient(pos).gradient) < 1e-6f;
+	}
+
+	// The bounds of the n-ary node cover its leaves, and a ray across the row only intersects the sphere and the box it crosses
+	const std::vector<AABB> bounds = CSGBounds::nodeBounds(view);
+	const std::vector<AABB> binaryBounds = CSGBounds::nodeBounds(scene.view());
+	const CSGRayQuery rayQuery{view};
+	const std::vector<RayInterval>& intervals = rayQuery.intervals(Ray{glm::vec3(20.f, -5.f, 0.f), glm::vec3(0.f, 1.f, 0.f)});
+	const bool queryCheck = bounds[64].min == binaryBounds[row].min && bounds[64].max == binaryBounds[row].max
+		&& intervals.size() == 1 && std::abs(intervals[0].tEnter - 4.6f) < 1e-4f && rayQuery.getNbLeafIntersection() == 2;
+
+	// Expression of a collapsed chain of three spheres
+	CSGPrimitiveStore smallStore;
+	const int first = smallStore.addLeaf(smallStore.addSphere(glm::mat4(1.f), glm::vec3(1.f, 0.f, 0.f), 1.f));
+	const int second = smallStore.addLeaf(smallStore.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(1.f, 0.f, 0.f)), glm::vec3(0.f, 1.f, 0.f), 1.f));
+	const int third = smallStore.addLeaf(smallStore.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(2.f, 0.f, 0.f)), glm::vec3(0.f, 0.f, 1.f), 1.f));
+	smallStore.addOperation(SHADER_TYPE_UNION, first, smallStore.addOperation(SHADER_TYPE_UNION, second, third));
+	const CSGSceneData smallScene = smallStore.sceneData();
+	const std::vector<CSGNode::ShaderNodeData> smallNodes = CSGNaryNodes::collapseChains(smallScene.view());
+	CSGSceneView smallView = smallScene.view();
+	smallView.nodes = smallNodes.data();
+	smallView.nbNode = static_cast<int>(smallNodes.size());
+	CSGExpression::NaryUnion<CSGExpression::Sphere, CSGExpression::Sphere, CSGExpression::Sphere> expression;
+	const glm::vec3 middle{0.5f, 0.8f, 0.f};
+	const bool expressionCheck = smallNodes.size() == 4 && CSGExpression::bindScene(smallView, expression, error)
+		&& CSGExpression::typeName(smallView) == decltype(expression)::name()
+		&& expression.evaluate(middle).color == glm::vec3(1.f, 0.f, 0.f) && expression.distance(middle) == CSGEvaluator{smallView}.scanSDF(middle).dist;
+
+	// The validation rejects an n-ary range holding an operation
+	std::vector<CSGNode::ShaderNodeData> invalidNodes = nodes;
+	invalidNodes.back() = CSGNode::ShaderNodeData{SHADER_TYPE_NARY_INTERSECTION, 64, 65, -1};
+	CSGSceneView invalidView = view;
+	invalidView.nodes = invalidNodes.data();
+	const bool validationCheck = !CSGBinaryScene::validateNodes(invalidView, error);
+
+	// A difference chain of 200001 nodes, as deep as it is long, is copied unchanged (built flat: CSGTree is recursive)
+	CSGPrimitiveStore deepStore;
+	int deepRoot = deepStore.addLeaf(deepStore.addBox(glm::mat4(1.f), glm::vec3(0.7f), glm::vec3(4.f, 1.f, 4.f)));
+	for (int i = 0; i < 100000; i++)
+	{
+		const glm::mat4 transform = glm::translate(glm::mat4(1.f), glm::vec3(static_cast<float>(i % 7) - 3.f, 1.f, static_cast<float>(i % 5) - 2.f));
+		deepRoot = deepStore.addOperation(SHADER_TYPE_DIFFERENCE, deepRoot, deepStore.addLeaf(deepStore.addSphere(transform, glm::vec3(1.f), 0.3f)));
+	}
+	const CSGSceneData deepScene = deepStore.sceneData();
+	const std::vector<CSGNode::ShaderNodeData> deepNodes = CSGNaryNodes::collapseChains(deepScene.view());
+	const bool deepCheck = deepNodes.size() == 200001
+		&& std::memcmp(deepNodes.data(), deepScene.view().nodes, deepNodes.size() * sizeof(CSGNode::ShaderNodeData)) == 0;
+
+	return collapseCheck && evaluationCheck && queryCheck && expressionCheck && validationCheck && deepCheck;
+}
+
+bool CSGRenderingTest::testShortCircuit() const
+{
+	// Same distances and colors as the full evaluation, returns the number of skipped nodes
+	auto compare = [](const CSGSceneView& scene, bool& check)
+	{
+		const CSGEvaluator evaluator{scene};
+		for (float x = -8.f; x <= 8.f; x += 0.125f)
+		{
+			const glm::vec3 pos{x, 0.7f * std::cos(x), 0.4f * x - 1.f};
+			const CSGEvaluation expected = evaluator.scanSDF(pos);
+			const CSGEvaluation result = evaluator.scanSDFShortCircuit(pos);
+			check = check && result.dist == expected.dist && result.color == expected.color;
+		}
+		return evaluator.getNbSkippedNode();
+	};
+
+	// The counterbored holes are skipped away from them, the single leaves of the other scenes are not worth their guard
+	CSGSceneGenerator generator;
+	const CSGSceneData plate{generator.counterboredPlate(4, 3)};
+	const CSGSceneData chain{generator.differenceChain(20)};
+	const CSGSceneData grid{generator.instancedGrid(2, 3, 4)};
+	bool evaluationCheck = true;
+	evaluationCheck = compare(plate.view(), evaluationCheck) > 0 && CSGShortCircuit{plate.view()}.getNbGuard() == 12 && evaluationCheck;
+	evaluationCheck = compare(chain.view(), evaluationCheck) == 0 && CSGShortCircuit{chain.view()}.getNbGuard() == 0 && evaluationCheck;
+	evaluationCheck = compare(grid.view(), evaluationCheck) == 0 && evaluationCheck;
+
+	// Intersection of a row of tori with a cheaper sphere: the sphere goes first, and far from it the tori are not evaluated
+	auto addTori = [](CSGPrimitiveStore& store)
+	{
+		int tori = -1;
+		for (int i = 0; i < 4; i++)
+		{
+			const glm::mat4 transform = glm::translate(glm::mat4(1.f), glm::vec3(2.f * static_cast<float>(i), 0.f, 0.f));
+			const int torus = store.addLeaf(store.addTorus(transform, glm::vec3(0.f, 0.f, 1.f), 1.f, 0.3f));
+			tori = tori < 0 ? torus : store.addOperation(SHADER_TYPE_UNION, tori, torus);
+		}
+		return tori;
+	};
+	CSGPrimitiveStore store;
+	const int tori = addTori(store);
+	const int sphere = store.addLeaf(store.addSphere(glm::translate(glm::mat4(1.f), glm::vec3(20.f, 0.f, 0.f)), glm::vec3(1.f, 0.f, 0.f), 1.f));
+	const int intersection = store.addOperation(SHADER_TYPE_INTERSECTION, tori, sphere);
+	const CSGSceneData scene = store.sceneData();
+	const CSGShortCircuit plan{scene.view()};
+	const CSGEvaluator evaluator{scene.view()};
+	const glm::vec3 pos{3.f, 0.f, 0.f};
+	const bool orderCheck = plan.getNbGuard() == 1 && plan.getPosition(sphere) == 0 && plan.firstChild(intersection) == sphere
+		&& plan.getGuard(1) == intersection && plan.getOrder().back() == intersection
+		&& evaluator.scanSDFShortCircuit(pos).dist == evaluator.scanSDF(pos).dist && evaluator.getNbSkippedNode() == 7;
+
+	// The cost of a subtree is the sum of the costs of its nodes
+	float totalCost = 0.f;
+	for (int i = 0; i < scene.view().nbNode; i++)
+		totalCost += CSGShortCircuit::nodeCost(scene.view().nodes[i].type);
+	const bool costCheck = CSGShortCircuit::nodeCost(SHADER_TYPE_BOX) > CSGShortCircuit::nodeCost(SHADER_TYPE_SPHERE)
+		&& CSGShortCircuit::nodeCost(SHADER_TYPE_SMOOTH_UNION) > CSGShortCircuit::nodeCost(SHADER_TYPE_UNION)
+		&& std::abs(plan.getCost(intersection) - totalCost) < 1e-3f && plan.getCost(tori) > plan.getCost(sphere);
+
+	// Four vec4 per node, and guards in the generated source only where the plan has some
+	CSGPrimitiveStore unionStore;
+	addTori(unionStore);
+	const CSGSceneData unionScene = unionStore.sceneData();
+	const std::string source = CSGShaderGenerator::generateSceneSDF(scene.view());
+	const bool shaderCheck = plan.nodeBoundsBuffer().size() == 4 * static_cast<size_t>(scene.view().nbNode)
+		&& source.find("if (upperBound(nodeBoundsData[") != std::string::npos
+		&& CSGShaderGenerator::generateSceneSDF(unionScene.view()).find("nodeBoundsData") == std::string::npos;
+
+	return evaluationCheck && orderCheck && costCheck && shaderCheck;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGTree.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+/*
+* Tests of the CPU rendering path: evaluation of the serialized tree, sphere marching and render cache
+*/
+class CSGRenderingTest
+{
+public:
+	// Print the result of every test, return true if they all succeed
+	bool performAllTests() const;
+
+	// Union of a sphere and a box side by side, intersected with a cylinder
+	CSGTree buildSampleScene(const glm::vec3& sphereTranslation = glm::vec3(-1.5f, 0.f, 0.f)) const;
+	CameraParameters buildSampleCamera() const;
+
+	bool testEvaluator() const;
+	bool testAnalyticGradient() const;
+	bool testNormalEstimators() const;
+	bool testSphereMarcher() const;
+	bool testRenderCache() const;
+	bool testPartialInvalidation() const;
+	bool testDirtyRegionTracker() const;
+	bool testSceneFile() const;
+	bool testBinaryScene() const;
+	bool testStreamingLoader() const;
+	bool testArena() const;
+	bool testPrimitiveStore() const;
+	bool testExpression() const;
+	bool testShaderGenerator() const;
+	bool testCompiledEvaluator() const;
+	bool testPointQuery() const;
+	bool testMesher() const;
+	bool testRayQuery() const;
+	bool testRayTracer() const;
+	bool testMarchDiagnostics() const;
+	bool testSceneGenerator() const;
+	bool testFuzzer() const;
+	bool testDistanceBounds() const;
+	bool testCompactScene() const;
+	bool testSmoothOperations() const;
+	bool testNaryNodes() const;
+	bool testShortCircuit() const;
+};
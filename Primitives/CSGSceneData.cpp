@@ -0,0 +1,84 @@
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+
+#include <cstring>
+
+template<typename T>
+std::vector<T> CSGSceneData::fromRawData(const std::vector<uint8_t>& rawData)
+{
+	std::vector<T> records(rawData.size() / sizeof(T));
+	if (!records.empty())
+		memcpy(records.data(), rawData.data(), records.size() * sizeof(T));
+	return records;
+}
+
+CSGSceneData::CSGSceneData(const CSGTree& tree) :
+	_nodes{fromRawData<CSGNode::ShaderNodeData>(tree.treeRawData())},
+	_spheres{fromRawData<SphereData>(tree.rawDataByPrimitiveType(Primitive::PrimitiveType::Sphere))},
+	_toruses{fromRawData<TorusData>(tree.rawDataByPrimitiveType(Primitive::PrimitiveType::Torus))},
+	_cylinders{fromRawData<CylinderData>(tree.rawDataByPrimitiveType(Primitive::PrimitiveType::Cylinder))},
+	_boxes{fromRawData<BoxData>(tree.rawDataByPrimitiveType(Primitive::PrimitiveType::Box))}
+{
+}
+
+CSGSceneData::CSGSceneData(std::vector<CSGNode::ShaderNodeData> nodes, std::vector<SphereData> spheres, std::vector<TorusData> toruses,
+	std::vector<CylinderData> cylinders, std::vector<BoxData> boxes) :
+	_nodes{std::move(nodes)},
+	_spheres{std::move(spheres)},
+	_toruses{std::move(toruses)},
+	_cylinders{std::move(cylinders)},
+	_boxes{std::move(boxes)}
+{
+}
+
+CSGSceneView CSGSceneData::view() const
+{
+	CSGSceneView sceneView;
+	sceneView.nodes = _nodes.data();
+	sceneView.nbNode = static_cast<int>(_nodes.size());
+	sceneView.spheres = _spheres.data();
+	sceneView.nbSphere = static_cast<int>(_spheres.size());
+	sceneView.toruses = _toruses.data();
+	sceneView.nbTorus = static_cast<int>(_toruses.size());
+	sceneView.cylinders = _cylinders.data();
+	sceneView.nbCylinder = static_cast<int>(_cylinders.size());
+	sceneView.boxes = _boxes.data();
+	sceneView.nbBox = static_cast<int>(_boxes.size());
+	return sceneView;
+}
+
+uint64_t CSGSceneData::hashBytes(const void* data, const size_t size, uint64_t seed)
+{
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		seed ^= bytes[i];
+		seed *= 1099511628211ull; // FNV prime
+	}
+	return seed;
+}
+
+uint64_t CSGSceneData::contentHash() const
+{
+	return contentHash(view());
+}
+
+uint64_t CSGSceneData::contentHash(const CSGSceneView& scene)
+{
+	/*
+	* The size of each buffer is hashed before its content, so that moving a record from a buffer to the next one changes the hash
+	*/
+	uint64_t hash = hashBytes(nullptr, 0);
+	auto hashBuffer = [&hash](const auto* buffer, const int count)
+	{
+		const uint64_t size = count;
+		hash = hashBytes(&size, sizeof(uint64_t), hash);
+		hash = hashBytes(buffer, size * sizeof(buffer[0]), hash);
+	};
+
+	hashBuffer(scene.nodes, scene.nbNode);
+	hashBuffer(scene.spheres, scene.nbSphere);
+	hashBuffer(scene.toruses, scene.nbTorus);
+	hashBuffer(scene.cylinders, scene.nbCylinder);
+	hashBuffer(scene.boxes, scene.nbBox);
+	return hash;
+}
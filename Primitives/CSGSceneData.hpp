@@ -0,0 +1,179 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGTree.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+/*
+* CPU side mirror of the SSBOs read by PrimitiveSceneSDF.glsl.
+* Every record has the exact std430 layout written by the rawData() method of the matching primitive, so the buffers produced by
+* CSGTree::treeRawData() and CSGTree::rawDataByPrimitiveType() can be copied in without any parsing.
+* The inverse transform of a primitive is affine: only its three first rows are stored, one per column of a mat3x4, and the local position
+* of p is glm::vec4(p, 1) * inverseTransform (see transformPoint() in CSGPrimitiveSDF.hpp). 'scale' is the distanceScale() of the inverse
+* transform, computed once when the record is written instead of at every evaluation.
+*/
+struct SphereData
+{
+	glm::mat3x4 inverseTransform;
+	glm::vec3 color;
+	float scale;
+	float radius;
+	float padding[3]; // std430 alignment
+};
+
+struct TorusData
+{
+	glm::mat3x4 inverseTransform;
+	glm::vec3 color;
+	float scale;
+	float majorRadius;
+	float minorRadius;
+	float padding[2]; // std430 alignment
+};
+
+struct CylinderData
+{
+	glm::mat3x4 inverseTransform;
+	glm::vec3 color;
+	float scale;
+	float height;
+	float radius;
+	float padding[2]; // std430 alignment
+};
+
+struct BoxData
+{
+	glm::mat3x4 inverseTransform;
+	glm::vec3 color;
+	float scale;
+	glm::vec3 size;
+	float padding; // std430 alignment
+};
+
+static_assert(sizeof(CSGNode::ShaderNodeData) == 4 * sizeof(int), "Node record must match the 'Node' struct of PrimitiveSceneSDF.glsl");
+static_assert(sizeof(SphereData) == 80, "Sphere record must match the 'Sphere' struct of PrimitiveSceneSDF.glsl");
+static_assert(sizeof(TorusData) == 80, "Torus record must match the 'Torus' struct of PrimitiveSceneSDF.glsl");
+static_assert(sizeof(CylinderData) == 80, "Cylinder record must match the 'Cylinder' struct of PrimitiveSceneSDF.glsl");
+static_assert(sizeof(BoxData) == 80, "Box record must match the 'Box' struct of PrimitiveSceneSDF.glsl");
+
+/*
+* Smooth operations of the node buffer, after the types of CSGNode::ShaderNodeData. They have two children like the hard operations, and
+* their blend radius (> 0) takes the place of the primitiveIndex, unused by the operations, as the bits of a float: intBitsToFloat() in
+* PrimitiveSceneSDF.glsl. The distances are the polynomial smooth min / max of CSGPrimitiveSDF.hpp.
+*/
+#define SHADER_TYPE_SMOOTH_INTERSECTION 9
+#define SHADER_TYPE_SMOOTH_UNION 10
+#define SHADER_TYPE_SMOOTH_DIFFERENCE 11
+
+inline bool isSmoothOperation(const int type)
+{
+	return type >= SHADER_TYPE_SMOOTH_INTERSECTION && type <= SHADER_TYPE_SMOOTH_DIFFERENCE;
+}
+
+// Hard operation blended by a smooth one (SHADER_TYPE_SMOOTH_UNION gives SHADER_TYPE_UNION...), other types are returned as is
+inline int hardOperation(const int type)
+{
+	return isSmoothOperation(type) ? type - SHADER_TYPE_SMOOTH_INTERSECTION + SHADER_TYPE_INTERSECTION : type;
+}
+
+inline CSGNode::ShaderNodeData smoothOperationNode(const int type, const int leftChildIndex, const int rightChildIndex, const float blendRadius)
+{
+	CSGNode::ShaderNodeData node{type, leftChildIndex, rightChildIndex, 0};
+	memcpy(&node.primitiveIndex, &blendRadius, sizeof(float));
+	return node;
+}
+
+// Blend radius of a smooth operation node, 0 for any other node
+inline float blendRadius(const CSGNode::ShaderNodeData& node)
+{
+	if (!isSmoothOperation(node.type))
+		return 0.f;
+	float radius;
+	memcpy(&radius, &node.primitiveIndex, sizeof(float));
+	return radius;
+}
+
+/*
+* N-ary operations of the node buffer: the min (union) or the max (intersection) of the leaves leftChildIndex to rightChildIndex, which
+* are consecutive in the buffer and before their parent. The primitiveIndex is unused (-1). Colors and gradients are the ones of the
+* first leaf giving the distance, as the leftmost operand wins in a chain of binary operations. See CSGNaryNodes::collapseChains().
+*/
+#define SHADER_TYPE_NARY_INTERSECTION 12
+#define SHADER_TYPE_NARY_UNION 13
+
+inline bool isNaryOperation(const int type)
+{
+	return type == SHADER_TYPE_NARY_INTERSECTION || type == SHADER_TYPE_NARY_UNION;
+}
+
+// Binary operation repeated by an n-ary one (SHADER_TYPE_NARY_UNION gives SHADER_TYPE_UNION...), other types are returned as is
+inline int binaryOperation(const int type)
+{
+	return type == SHADER_TYPE_NARY_INTERSECTION ? SHADER_TYPE_INTERSECTION : type == SHADER_TYPE_NARY_UNION ? SHADER_TYPE_UNION : type;
+}
+
+inline bool isLeafType(const int type)
+{
+	return type >= SHADER_TYPE_SPHERE && type <= SHADER_TYPE_BOX;
+}
+
+/*
+* Non owning view on a serialized scene: the postorder node buffer and one buffer per primitive type.
+* It can point to a CSGSceneData or to any other memory holding the same layout.
+*/
+struct CSGSceneView
+{
+	const CSGNode::ShaderNodeData* nodes = nullptr;
+	int nbNode = 0;
+
+	const SphereData* spheres = nullptr;
+	int nbSphere = 0;
+	const TorusData* toruses = nullptr;
+	int nbTorus = 0;
+	const CylinderData* cylinders = nullptr;
+	int nbCylinder = 0;
+	const BoxData* boxes = nullptr;
+	int nbBox = 0;
+
+	[[nodiscard]] bool isEmpty() const { return nbNode == 0; }
+};
+
+/*
+* Owning flat copy of a CSGTree, in the layout sent to the GPU.
+*/
+class CSGSceneData
+{
+public:
+	CSGSceneData() = default;
+	explicit CSGSceneData(const CSGTree& tree);
+	// Take buffers built without any CSGTree (streaming loader, generated scenes)
+	CSGSceneData(std::vector<CSGNode::ShaderNodeData> nodes, std::vector<SphereData> spheres, std::vector<TorusData> toruses,
+		std::vector<CylinderData> cylinders, std::vector<BoxData> boxes);
+
+	[[nodiscard]] CSGSceneView view() const;
+
+	[[nodiscard]] const std::vector<CSGNode::ShaderNodeData>& getNodes() const { return _nodes; }
+	[[nodiscard]] const std::vector<SphereData>& getSpheres() const { return _spheres; }
+	[[nodiscard]] const std::vector<TorusData>& getToruses() const { return _toruses; }
+	[[nodiscard]] const std::vector<CylinderData>& getCylinders() const { return _cylinders; }
+	[[nodiscard]] const std::vector<BoxData>& getBoxes() const { return _boxes; }
+
+	// Content hash over all the serialized buffers (FNV-1a, 64 bits)
+	[[nodiscard]] uint64_t contentHash() const;
+	static uint64_t contentHash(const CSGSceneView& scene);
+
+	static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+private:
+	template<typename T>
+	static std::vector<T> fromRawData(const std::vector<uint8_t>& rawData);
+
+	std::vector<CSGNode::ShaderNodeData> _nodes;
+	std::vector<SphereData> _spheres;
+	std::vector<TorusData> _toruses;
+	std::vector<CylinderData> _cylinders;
+	std::vector<BoxData> _boxes;
+};
@@ -0,0 +1,151 @@
+#include "renderer/opengl/Primitives/CSGSceneFile.hpp"
+
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+#include "renderer/opengl/Primitives/Sphere.hpp"
+#include "renderer/opengl/Primitives/Torus.hpp"
+#include "renderer/opengl/Primitives/Cylinder.hpp"
+#include "renderer/opengl/Primitives/Box.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+
+bool CSGSceneFile::load(const std::string& path, CSGTree& tree, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "cannot open '" + path + "'";
+		return false;
+	}
+	return parse(file, tree, error);
+}
+
+bool CSGSceneFile::parse(std::istream& stream, CSGTree& tree, std::string& error)
+{
+	// Number of values following each keyword of a primitive line
+	static const std::map<std::string, int> keywordArity{
+		{"radius", 1}, {"majorRadius", 1}, {"minorRadius", 1}, {"height", 1}, {"size", 3},
+		{"translate", 3}, {"rotate", 4}, {"scale", 3}, {"color", 3}
+	};
+
+	std::vector<CSGNode::NodePtr> stack;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+		const std::string location = "line " + std::to_string(lineNumber) + ": ";
+
+		const size_t commentStart = line.find('#');
+		if (commentStart != std::string::npos)
+			line.erase(commentStart);
+
+		std::istringstream tokens(line);
+		std::string type;
+		if (!(tokens >> type))
+			continue; // Empty line
+
+		// Operators
+		if (type == "union" || type == "intersection" || type == "difference" || type == "complement")
+		{
+			const size_t nbOperand = type == "complement" ? 1 : 2;
+			if (stack.size() < nbOperand)
+			{
+				error = location + "'" + type + "' needs " + std::to_string(nbOperand) + " operand(s)";
+				return false;
+			}
+
+			const CSGNode::NodePtr right = nbOperand == 2 ? stack.back() : nullptr;
+			if (nbOperand == 2)
+				stack.pop_back();
+			const CSGNode::NodePtr left = stack.back();
+			stack.pop_back();
+
+			if (type == "union")
+				stack.push_back(CSGNode::makeUnion(left, right));
+			else if (type == "intersection")
+				stack.push_back(CSGNode::makeIntersection(left, right));
+			else if (type == "difference")
+				stack.push_back(CSGNode::makeDifference(left, right));
+			else
+				stack.push_back(CSGNode::makeComplement(left));
+			continue;
+		}
+
+		if (type != "sphere" && type != "torus" && type != "cylinder" && type != "box")
+		{
+			error = location + "unknown node type '" + type + "'";
+			return false;
+		}
+
+		// Primitives: read all the 'keyword values...' pairs
+		std::map<std::string, std::vector<float>> values;
+		std::string keyword;
+		while (tokens >> keyword)
+		{
+			const auto arity = keywordArity.find(keyword);
+			if (arity == keywordArity.end())
+			{
+				error = location + "unknown keyword '" + keyword + "'";
+				return false;
+			}
+
+			std::vector<float>& keywordValues = values[keyword];
+			keywordValues.resize(arity->second);
+			for (float& value : keywordValues)
+			{
+				if (!(tokens >> value))
+				{
+					error = location + "'" + keyword + "' expects " + std::to_string(arity->second) + " number(s)";
+					return false;
+				}
+			}
+		}
+
+		auto value = [&](const std::string& name, const int component, const float defaultValue)
+		{
+			const auto found = values.find(name);
+			return found == values.end() ? defaultValue : found->second[component];
+		};
+
+		// Same composition as Primitive::getTransform(): translation * rotation * scale
+		glm::mat4 transform = glm::translate(glm::mat4(1.f), glm::vec3(value("translate", 0, 0.f), value("translate", 1, 0.f), value("translate", 2, 0.f)));
+		if (values.count("rotate") != 0)
+		{
+			const glm::vec3 axis{value("rotate", 1, 0.f), value("rotate", 2, 1.f), value("rotate", 3, 0.f)};
+			if (glm::length(axis) == 0.f)
+			{
+				error = location + "rotation axis is null";
+				return false;
+			}
+			transform = glm::rotate(transform, glm::radians(value("rotate", 0, 0.f)), glm::normalize(axis));
+		}
+		transform = glm::scale(transform, glm::vec3(value("scale", 0, 1.f), value("scale", 1, 1.f), value("scale", 2, 1.f)));
+
+		const glm::vec3 color{value("color", 0, 1.f), value("color", 1, 1.f), value("color", 2, 1.f)};
+
+		std::shared_ptr<Primitive> primitive;
+		if (type == "sphere")
+			primitive = std::make_shared<Sphere>(transform, color, value("radius", 0, 1.f));
+		else if (type == "torus")
+			primitive = std::make_shared<Torus>(transform, color, value("majorRadius", 0, 1.f), value("minorRadius", 0, 0.25f));
+		else if (type == "cylinder")
+			primitive = std::make_shared<Cylinder>(transform, color, value("height", 0, 1.f), value("radius", 0, 0.5f));
+		else
+			primitive = std::make_shared<Box>(transform, color, glm::vec3(value("size", 0, 1.f), value("size", 1, 1.f), value("size", 2, 1.f)));
+
+		stack.push_back(CSGNode::makePrimitive(primitive));
+	}
+
+	if (stack.size() > 1)
+	{
+		error = std::to_string(stack.size()) + " nodes are left without parent, the description needs more operators";
+		return false;
+	}
+
+	tree = stack.empty() ? CSGTree{} : CSGTree{ stack.back() };
+	return true;
+}
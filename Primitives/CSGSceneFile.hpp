@@ -0,0 +1,29 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGTree.hpp"
+
+#include <istream>
+#include <string>
+
+/*
+* Text description of a CSG tree, written in postorder: a primitive line pushes a leaf, an operator line pops its operands and pushes the
+* operation, and the only node left at the end is the root. This is the order of the node buffer sent to the shader.
+*
+*     # Sphere and box side by side, drilled by a cylinder
+*     sphere radius 1 translate -1.5 0 0 color 1 0 0
+*     box size 1 1 1 translate 1.5 0 0 color 0 1 0
+*     union
+*     cylinder height 2 radius 0.3 translate 1.5 0 0
+*     difference
+*
+* Primitives: sphere (radius), torus (majorRadius, minorRadius), cylinder (height, radius), box (size x y z), with the same meaning as
+* the constructors of the primitive classes. Every primitive also accepts 'translate x y z', 'rotate angleInDegrees axisX axisY axisZ',
+* 'scale x y z' and 'color r g b'. Operators: union, intersection, difference, complement.
+*/
+class CSGSceneFile
+{
+public:
+	// Return false and describe the first error in 'error' if the description is invalid, 'tree' is only modified on success
+	static bool load(const std::string& path, CSGTree& tree, std::string& error);
+	static bool parse(std::istream& stream, CSGTree& tree, std::string& error);
+};
@@ -0,0 +1,179 @@
+#include "renderer/opengl/Primitives/CSGSceneGenerator.hpp"
+
+#include "renderer/opengl/Primitives/Sphere.hpp"
+#include "renderer/opengl/Primitives/Box.hpp"
+#include "renderer/opengl/Primitives/Cylinder.hpp"
+#include "renderer/opengl/Primitives/Torus.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <algorithm>
+
+CSGNode::NodePtr CSGSceneGenerator::balancedUnion(std::vector<CSGNode::NodePtr>& nodes)
+{
+	if (nodes.empty())
+		return nullptr;
+
+	// Join neighbours level by level
+	while (nodes.size() > 1)
+	{
+		size_t nbJoined = 0;
+		for (size_t i = 0; i < nodes.size(); i += 2)
+			nodes[nbJoined++] = i + 1 < nodes.size() ? CSGNode::makeUnion(nodes[i], nodes[i + 1]) : nodes[i];
+		nodes.resize(nbJoined);
+	}
+	return nodes.front();
+}
+
+CSGTree CSGSceneGenerator::balancedUnion(const int nbSphere) const
+{
+	const int gridSize = std::max(1, static_cast<int>(std::ceil(std::cbrt(static_cast<float>(nbSphere)))));
+	std::vector<CSGNode::NodePtr> spheres;
+	for (int i = 0; i < nbSphere; i++)
+	{
+		const glm::vec3 position{2.5f * static_cast<float>(i % gridSize), 2.5f * static_cast<float>((i / gridSize) % gridSize), -2.5f * static_cast<float>(i / (gridSize * gridSize))};
+		spheres.push_back(CSGNode::makePrimitive(std::make_shared<Sphere>(position, glm::vec3((i % 3) / 2.f, (i % 5) / 4.f, (i % 7) / 6.f), 1.f)));
+	}
+	return CSGTree{ balancedUnion(spheres) };
+}
+
+CSGTree CSGSceneGenerator::differenceChain(const int depth) const
+{
+	CSGNode::NodePtr root = CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(0.f), glm::vec3(0.7f), glm::vec3(4.f, 1.f, 4.f)));
+	for (int i = 0; i < depth; i++)
+	{
+		// Holes spiraling over the top face of the box
+		const float angle = 2.4f * static_cast<float>(i);
+		const float radius = 3.5f * std::sqrt(static_cast<float>(i + 1) / static_cast<float>(depth + 1));
+		const glm::vec3 position{radius * std::cos(angle), 1.f, radius * std::sin(angle)};
+		CSGNode::NodePtr hole = i % 2 == 0 ? CSGNode::makePrimitive(std::make_shared<Sphere>(position, 0.3f))
+			: CSGNode::makePrimitive(std::make_shared<Cylinder>(position, 0.6f, 0.2f));
+		root = CSGNode::makeDifference(root, hole);
+	}
+	return CSGTree{ root };
+}
+
+CSGTree CSGSceneGenerator::counterboredPlate(const int nbX, const int nbZ) const
+{
+	CSGNode::NodePtr root = CSGNode::makePrimitive(std::make_shared<Box>(glm::vec3(0.f), glm::vec3(0.6f, 0.6f, 0.7f),
+		glm::vec3(static_cast<float>(nbX), 0.5f, static_cast<float>(nbZ))));
+	for (int z = 0; z < nbZ; z++)
+	{
+		for (int x = 0; x < nbX; x++)
+		{
+			// Through hole, and a wider and shallower one at the top
+			const glm::vec3 position{2.f * static_cast<float>(x) - static_cast<float>(nbX - 1), 0.f, 2.f * static_cast<float>(z) - static_cast<float>(nbZ - 1)};
+			CSGNode::NodePtr hole = CSGNode::makeUnion(CSGNode::makePrimitive(std::make_shared<Cylinder>(position, 1.2f, 0.3f)),
+				CSGNode::makePrimitive(std::make_shared<Cylinder>(position + glm::vec3(0.f, 0.5f, 0.f), 0.4f, 0.6f)));
+			root = CSGNode::makeDifference(root, hole);
+		}
+	}
+	return CSGTree{ root };
+}
+
+glm::vec3 CSGSceneGenerator::randomPoint(const float extent)
+{
+	std::uniform_real_distribution<float> coordinate{-extent, extent};
+	const float x = coordinate(_generator);
+	const float y = coordinate(_generator);
+	const float z = coordinate(_generator);
+	return glm::vec3(x, y, z);
+}
+
+CSGNode::NodePtr CSGSceneGenerator::randomPrimitive(const float extent)
+{
+	std::uniform_real_distribution<float> unit{0.f, 1.f};
+	auto uniform = [&](const float min, const float max) { return min + (max - min) * unit(_generator); };
+
+	// Uniform scale only, so the distances of the primitives stay exact
+	const glm::vec3 translation = randomPoint(extent);
+	const glm::vec3 axis = randomPoint(1.f) + glm::vec3(0.f, 0.f, 1e-3f);
+	const float angle = uniform(0.f, 6.2831853f);
+	const float scale = uniform(0.5f, 1.5f);
+	const glm::mat4 transform = glm::scale(glm::rotate(glm::translate(glm::mat4(1.f), translation), angle, glm::normalize(axis)), glm::vec3(scale));
+	const glm::vec3 color{unit(_generator), unit(_generator), unit(_generator)};
+
+	switch (std::uniform_int_distribution<int>{0, 3}(_generator))
+	{
+	case 0:
+		return CSGNode::makePrimitive(std::make_shared<Sphere>(transform, color, uniform(0.3f, 1.5f)));
+	case 1:
+	{
+		const float majorRadius = uniform(0.5f, 1.2f);
+		return CSGNode::makePrimitive(std::make_shared<Torus>(transform, color, majorRadius, uniform(0.1f, 0.4f)));
+	}
+	case 2:
+	{
+		const float height = uniform(0.3f, 1.5f);
+		return CSGNode::makePrimitive(std::make_shared<Cylinder>(transform, color, height, uniform(0.2f, 1.f)));
+	}
+	default:
+	{
+		const float x = uniform(0.2f, 1.2f);
+		const float y = uniform(0.2f, 1.2f);
+		const float z = uniform(0.2f, 1.2f);
+		return CSGNode::makePrimitive(std::make_shared<Box>(transform, color, glm::vec3(x, y, z)));
+	}
+	}
+}
+
+CSGNode::NodePtr CSGSceneGenerator::randomSubtree(const int nbPrimitive, const int maxHeight)
+{
+	std::uniform_real_distribution<float> unit{0.f, 1.f};
+
+	// A tree of height h (a leaf has height 1) holds at most 2^(h-1) primitives. A complement takes one level, and can only be added
+	// if its child still fits below it.
+	const int childCapacity = maxHeight >= 2 ? 1 << std::min(maxHeight - 2, 30) : 0;
+	if (nbPrimitive <= childCapacity && unit(_generator) < 0.15f)
+		return CSGNode::makeComplement(randomSubtree(nbPrimitive, maxHeight - 1));
+	if (nbPrimitive == 1)
+		return randomPrimitive();
+
+	const int nbLeft = std::uniform_int_distribution<int>{std::max(1, nbPrimitive - childCapacity), std::min(nbPrimitive - 1, childCapacity)}(_generator);
+	CSGNode::NodePtr left = randomSubtree(nbLeft, maxHeight - 1);
+	CSGNode::NodePtr right = randomSubtree(nbPrimitive - nbLeft, maxHeight - 1);
+	switch (std::uniform_int_distribution<int>{0, 2}(_generator))
+	{
+	case 0:
+		return CSGNode::makeUnion(left, right);
+	case 1:
+		return CSGNode::makeIntersection(left, right);
+	default:
+		return CSGNode::makeDifference(left, right);
+	}
+}
+
+CSGTree CSGSceneGenerator::randomTree(const int nbPrimitive, const int maxHeight)
+{
+	if (nbPrimitive <= 0)
+		return CSGTree{};
+
+	int minHeight = 1;
+	while ((1LL << (minHeight - 1)) < nbPrimitive)
+		minHeight++;
+	return CSGTree{ randomSubtree(nbPrimitive, std::max(maxHeight, minHeight)) };
+}
+
+CSGTree CSGSceneGenerator::instancedGrid(const int nbX, const int nbY, const int nbZ) const
+{
+	std::vector<CSGNode::NodePtr> instances;
+	for (int z = 0; z < nbZ; z++)
+	{
+		for (int y = 0; y < nbY; y++)
+		{
+			for (int x = 0; x < nbX; x++)
+			{
+				const int index = x + nbX * (y + nbY * z);
+				const glm::mat4 placement = glm::rotate(glm::translate(glm::mat4(1.f), glm::vec3(3.f * x, 3.f * y, -3.f * z)),
+					0.4f * static_cast<float>(index), glm::vec3(0.f, 1.f, 0.f));
+				const glm::vec3 color{(index % 3) / 2.f, (index % 5) / 4.f, (index % 7) / 6.f};
+
+				auto block = CSGNode::makePrimitive(std::make_shared<Box>(placement, color, glm::vec3(1.f, 0.5f, 1.f)));
+				auto hole = CSGNode::makePrimitive(std::make_shared<Cylinder>(placement, 1.f, 0.4f));
+				auto ring = CSGNode::makePrimitive(std::make_shared<Torus>(glm::translate(placement, glm::vec3(0.f, 0.5f, 0.f)), color, 0.6f, 0.15f));
+				instances.push_back(CSGNode::makeUnion(CSGNode::makeDifference(block, hole), ring));
+			}
+		}
+	}
+	return CSGTree{ balancedUnion(instances) };
+}
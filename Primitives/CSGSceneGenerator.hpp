@@ -0,0 +1,54 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGTree.hpp"
+#include "renderer/opengl/Primitives/CSGNode.hpp"
+
+#include <glm/glm.hpp>
+#include <random>
+#include <cstdint>
+
+/*
+* Parametric synthetic scenes, for benchmarks and randomized tests.
+* The random scenes only depend on the seed, so a benchmark or a failing test case can be reproduced.
+*/
+class CSGSceneGenerator
+{
+public:
+	explicit CSGSceneGenerator(uint32_t seed = 42) : _generator{seed} {}
+
+	// Balanced union of 'nbSphere' unit spheres on a cubic grid, of height 1 + ceil(log2(nbSphere)) as given by CSGTree::height()
+	CSGTree balancedUnion(int nbSphere) const;
+
+	// Box drilled by 'depth' spheres and cylinders one after the other: ((B - S0) - C1) - ..., a left comb of height 'depth' + 1
+	CSGTree differenceChain(int depth) const;
+
+	// Plate drilled by nbX x nbZ counterbored holes, each one the union of two cylinders: a left comb of differences with compound right children
+	CSGTree counterboredPlate(int nbX, int nbZ) const;
+
+	/*
+	* Random tree of 'nbPrimitive' primitives of every type, with random transforms, colors and sizes, joined by random operations
+	* (complements included), of height at most 'maxHeight' (CSGTree::height(), 1 for a leaf). 'maxHeight' is raised if the primitives
+	* cannot fit under it.
+	*/
+	CSGTree randomTree(int nbPrimitive, int maxHeight);
+
+	// Random primitive of any type, in the cube [-extent, extent]^3
+	CSGNode::NodePtr randomPrimitive(float extent = 4.f);
+
+	// Random point in the cube [-extent, extent]^3
+	glm::vec3 randomPoint(float extent = 4.f);
+
+	/*
+	* Union of nbX x nbY x nbZ copies of a small part (a box drilled by a cylinder, with a torus around the hole), each copy rotated
+	* and placed on a grid. The copies have the same structure and only differ by their transforms, as instances of an assembly.
+	*/
+	CSGTree instancedGrid(int nbX, int nbY, int nbZ) const;
+
+	// Balanced union of 'nodes', the nodes are consumed
+	static CSGNode::NodePtr balancedUnion(std::vector<CSGNode::NodePtr>& nodes);
+
+private:
+	CSGNode::NodePtr randomSubtree(int nbPrimitive, int maxHeight);
+
+	std::mt19937 _generator;
+};
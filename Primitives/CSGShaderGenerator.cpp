@@ -0,0 +1,297 @@
+#include "renderer/opengl/Primitives/CSGShaderGenerator.hpp"
+#include "renderer/opengl/Primitives/CSGShortCircuit.hpp"
+
+#include <sstream>
+#include <algorithm>
+
+uint64_t CSGShaderGenerator::topologyHash(const CSGSceneView& scene)
+{
+	const uint64_t nbNode = scene.nbNode;
+	const uint64_t hash = CSGSceneData::hashBytes(&nbNode, sizeof(uint64_t));
+	return CSGSceneData::hashBytes(scene.nodes, scene.nbNode * sizeof(CSGNode::ShaderNodeData), hash);
+}
+
+/*
+* Statements computing the distance (d<i>), color (c<i>) and optionally gradient (g<i>) of every node, in postorder.
+* With a short-circuit plan, the nodes follow its order and the skippable child of each guarded operation is declared with its sentinel
+* distance before a block evaluating its subtree, entered when the guard of CSGShortCircuit::canSkip() fails.
+*/
+static void writeNodes(std::ostringstream& source, const CSGSceneView& scene, const bool computeGradient, const CSGShortCircuit* plan = nullptr)
+{
+	static const char* buffers[] = {"spheresData", "torusesData", "cylindersData", "boxesData"};
+	static const char* sdfs[] = {"sphereSDF", "torusSDF", "cylinderSDF", "boxSDF"};
+	static const char* gradients[] = {"sphereGradient", "torusGradient", "cylinderGradient", "boxGradient"};
+
+	source << "    vec3 localPos;\n"
+		<< "    float scale;\n";
+
+	std::vector<uint8_t> guardedChildren(scene.nbNode, 0);
+	if (plan && plan->getNbGuard() > 0)
+	{
+		source << "    float margin = guardMargin(pos);\n";
+		for (int position = 0; position < scene.nbNode; position++)
+		{
+			if (plan->getGuard(position) >= 0)
+				guardedChildren[plan->secondChild(plan->getGuard(position))] = 1;
+		}
+	}
+
+	std::string indent = "    ";
+	for (int position = 0; position < scene.nbNode; position++)
+	{
+		const int i = plan ? plan->getOrder()[position] : position;
+		const int guarded = plan ? plan->getGuard(position) : -1;
+		if (guarded >= 0)
+		{
+			const std::string skipped = std::to_string(plan->secondChild(guarded));
+			const std::string first = std::to_string(plan->firstChild(guarded));
+			const std::string bounds = "nodeBoundsData[" + skipped + "], pos, margin";
+			const bool difference = scene.nodes[guarded].type == SHADER_TYPE_DIFFERENCE;
+			source << indent << "float d" << skipped << " = " << (difference ? "FLOAT_INFINITY" : "-FLOAT_INFINITY") << ";\n"
+				<< indent << "vec3 c" << skipped << " = vec3(0.);\n";
+			if (difference)
+				source << indent << "if (d" << first << " < -lowerBound(" << bounds << "))\n";
+			else
+				source << indent << "if (upperBound(" << bounds << ") " << (plan->firstChild(guarded) == scene.nodes[guarded].leftChildIndex ? ">" : ">=")
+					<< " d" << first << ")\n";
+			source << indent << "{\n";
+			indent += "    ";
+		}
+
+		// The skippable children are already declared
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		const std::string n = std::to_string(i);
+		const std::string a = std::to_string(node.leftChildIndex);
+		const std::string b = std::to_string(node.rightChildIndex);
+		const std::string d = indent + (guardedChildren[i] != 0 ? "d" : "float d") + n;
+		const std::string c = indent + (guardedChildren[i] != 0 ? "c" : "vec3 c") + n;
+
+		switch (node.type)
+		{
+		case SHADER_TYPE_SPHERE:
+		case SHADER_TYPE_TORUS:
+		case SHADER_TYPE_CYLINDER:
+		case SHADER_TYPE_BOX:
+		{
+			const int leaf = node.type - SHADER_TYPE_SPHERE;
+			const std::string record = std::string(buffers[leaf]) + "[" + std::to_string(node.primitiveIndex) + "]";
+			source << indent << "localPos = transformRay(pos, " << record << ".inverseTransform);\n"
+				<< indent << "scale = " << record << ".scale;\n"
+				<< d << " = " << sdfs[leaf] << "(" << record << ", localPos) * scale;\n"
+				<< c << " = " << record << ".color;\n";
+			if (computeGradient)
+			{
+				// sphereGradient() only takes the position
+				const std::string gradientArguments = node.type == SHADER_TYPE_SPHERE ? "localPos" : record + ", localPos";
+				source << indent << "vec3 g" << n << " = transformGradient(" << gradients[leaf] << "(" << gradientArguments << "), " << record
+					<< ".inverseTransform, scale);\n";
+			}
+			break;
+		}
+		case SHADER_TYPE_INTERSECTION:
+		case SHADER_TYPE_UNION:
+		case SHADER_TYPE_DIFFERENCE:
+		{
+			const char* operation = node.type == SHADER_TYPE_INTERSECTION ? "intersectionSDF" : node.type == SHADER_TYPE_UNION ? "unionSDF" : "differenceSDF";
+			source << d << " = " << operation << "(d" << a << ", d" << b << ");\n"
+				<< c << " = d" << n << " == d" << a << " ? c" << a << " : c" << b << ";\n";
+			if (computeGradient)
+			{
+				source << indent << "vec3 g" << n << " = d" << n << " == d" << a << " ? g" << a << " : "
+					<< (node.type == SHADER_TYPE_DIFFERENCE ? "-g" : "g") << b << ";\n";
+			}
+			break;
+		}
+		case SHADER_TYPE_SMOOTH_INTERSECTION:
+		case SHADER_TYPE_SMOOTH_UNION:
+		case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		{
+			// The blend radius is read from the node buffer, as the primitive parameters from their records
+			const char* operation = node.type == SHADER_TYPE_SMOOTH_INTERSECTION ? "smoothIntersectionSDF"
+				: node.type == SHADER_TYPE_SMOOTH_UNION ? "smoothUnionSDF" : "smoothDifferenceSDF";
+			source << indent << "float h" << n << ";\n"
+				<< d << " = " << operation << "(d" << a << ", d" << b << ", blendRadius(nodesData[" << n << "]), h" << n << ");\n"
+				<< c << " = mix(c" << b << ", c" << a << ", h" << n << ");\n";
+			if (computeGradient)
+			{
+				source << indent << "vec3 g" << n << " = mix(" << (node.type == SHADER_TYPE_SMOOTH_DIFFERENCE ? "-g" : "g") << b << ", g" << a
+					<< ", h" << n << ");\n";
+			}
+			break;
+		}
+		case SHADER_TYPE_NARY_INTERSECTION:
+		case SHADER_TYPE_NARY_UNION:
+		{
+			// Unrolled over the leaves, the first one giving the distance keeps it
+			const char* comparison = node.type == SHADER_TYPE_NARY_UNION ? " < " : " > ";
+			source << d << " = d" << a << ";\n"
+				<< c << " = c" << a << ";\n";
+			if (computeGradient)
+				source << indent << "vec3 g" << n << " = g" << a << ";\n";
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+			{
+				const std::string k = std::to_string(child);
+				source << indent << "if (d" << k << comparison << "d" << n << ") { d" << n << " = d" << k << "; c" << n << " = c" << k << ";";
+				if (computeGradient)
+					source << " g" << n << " = g" << k << ";";
+				source << " }\n";
+			}
+			break;
+		}
+		case SHADER_TYPE_COMPLEMENTARY:
+			source << d << " = complementarySDF(d" << a << ");\n"
+				<< c << " = vec3(0.);\n";
+			if (computeGradient)
+				source << indent << "vec3 g" << n << " = -g" << a << ";\n";
+			break;
+		default:
+			source << d << " = FLOAT_INFINITY;\n"
+				<< c << " = vec3(0.);\n";
+			if (computeGradient)
+				source << indent << "vec3 g" << n << " = vec3(0.);\n";
+			break;
+		}
+
+		if (guardedChildren[i] != 0)
+		{
+			indent.resize(indent.size() - 4);
+			source << indent << "}\n";
+		}
+	}
+}
+
+std::string CSGShaderGenerator::generateSceneSDF(const CSGSceneView& scene)
+{
+	const std::string root = std::to_string(scene.nbNode - 1);
+
+	std::ostringstream source;
+	source << "// Generated by CSGShaderGenerator for the topology " << std::hex << topologyHash(scene) << std::dec << ", "
+		<< scene.nbNode << " nodes\n\n";
+
+	source << "// Return smallest distance from a primitive\n"
+		<< "float scanSDF(vec3 pos, out vec3 hitColor)\n"
+		<< "{\n";
+	if (scene.isEmpty())
+	{
+		source << "    hitColor = vec3(0.);\n"
+			<< "    return FLOAT_INFINITY;\n";
+	}
+	else
+	{
+		const CSGShortCircuit plan{scene};
+		writeNodes(source, scene, false, &plan);
+		source << "    hitColor = c" << root << ";\n"
+			<< "    return d" << root << ";\n";
+	}
+	source << "}\n\n";
+
+	source << "// Same as scanSDF, but also return the analytic gradient of the distance\n"
+		<< "float scanSDFGradient(vec3 pos, out vec3 hitColor, out vec3 gradient)\n"
+		<< "{\n";
+	if (scene.isEmpty())
+	{
+		source << "    hitColor = vec3(0.);\n"
+			<< "    gradient = vec3(0.);\n"
+			<< "    return FLOAT_INFINITY;\n";
+	}
+	else
+	{
+		writeNodes(source, scene, true);
+		source << "    hitColor = c" << root << ";\n"
+			<< "    gradient = g" << root << ";\n"
+			<< "    return d" << root << ";\n";
+	}
+	source << "}\n";
+
+	return source.str();
+}
+
+bool CSGShaderGenerator::specializeShader(const std::string& computeSource, const CSGSceneView& scene, std::string& specializedSource, std::string& error)
+{
+	const size_t versionPosition = computeSource.find("#version");
+	const size_t includePosition = computeSource.find("PrimitiveSceneSDF.glsl");
+	if (versionPosition == std::string::npos || includePosition == std::string::npos || includePosition < versionPosition)
+	{
+		error = "The compute shader must have a #version line followed by the include of PrimitiveSceneSDF.glsl";
+		return false;
+	}
+
+	const size_t versionEnd = computeSource.find('\n', versionPosition);
+	const size_t includeEnd = computeSource.find('\n', includePosition);
+	if (versionEnd == std::string::npos || includeEnd == std::string::npos)
+	{
+		error = "The compute shader must have a main function after the include of PrimitiveSceneSDF.glsl";
+		return false;
+	}
+
+	specializedSource = computeSource.substr(0, versionEnd + 1)
+		+ "#define " + SPECIALIZED_SCENE_DEFINE + "\n"
+		+ computeSource.substr(versionEnd + 1, includeEnd - versionEnd)
+		+ "\n" + generateSceneSDF(scene)
+		+ computeSource.substr(includeEnd + 1);
+	return true;
+}
+
+CSGShaderCache::CSGShaderCache(std::string computeSource, CompileFunction compile, DeleteFunction release, const size_t capacity) :
+	_computeSource{std::move(computeSource)},
+	_compile{std::move(compile)},
+	_release{std::move(release)},
+	_capacity{std::max<size_t>(capacity, 1)}
+{
+}
+
+CSGShaderCache::~CSGShaderCache()
+{
+	clear();
+}
+
+unsigned int CSGShaderCache::getProgram(const CSGSceneView& scene, std::string& error)
+{
+	const uint64_t topology = CSGShaderGenerator::topologyHash(scene);
+
+	auto found = _entries.find(topology);
+	if (found != _entries.end())
+	{
+		_nbHit++;
+		_lru.splice(_lru.begin(), _lru, found->second.lruPosition);
+		error = found->second.error;
+		return found->second.program;
+	}
+
+	Entry entry;
+	std::string specializedSource;
+	if (CSGShaderGenerator::specializeShader(_computeSource, scene, specializedSource, entry.error))
+	{
+		_nbCompilation++;
+		entry.program = _compile(specializedSource, entry.error);
+	}
+
+	// Evict the least recently used program
+	if (_entries.size() >= _capacity)
+	{
+		const uint64_t evicted = _lru.back();
+		const unsigned int evictedProgram = _entries[evicted].program;
+		if (evictedProgram != 0)
+			_release(evictedProgram);
+		_entries.erase(evicted);
+		_lru.pop_back();
+	}
+
+	_lru.push_front(topology);
+	entry.lruPosition = _lru.begin();
+	error = entry.error;
+	const unsigned int program = entry.program;
+	_entries.emplace(topology, std::move(entry));
+	return program;
+}
+
+void CSGShaderCache::clear()
+{
+	for (const auto& [topology, entry] : _entries)
+	{
+		if (entry.program != 0)
+			_release(entry.program);
+	}
+	_entries.clear();
+	_lru.clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <list>
+#include <cstdint>
+
+/*
+* Generator of GLSL distance functions specialized for the topology of a CSG tree.
+* The generic scanSDF() of PrimitiveSceneSDF.glsl interprets the node SSBO, which means a switch, node fetches and stack accesses for
+* every node at every step of every ray. The generated scanSDF() and scanSDFGradient() are straight-line code: one statement per node,
+* with the node types, children and primitive indices written as constants and the intermediate results kept in local variables.
+* The primitive records are still read from their SSBOs, so editing a transform, a color or a dimension does not change the generated
+* source: only a topology change needs another program.
+* scanSDF() follows the order of a CSGShortCircuit plan and skips the guarded children of intersections and differences where their
+* bounds make them irrelevant. The guards read the node bounds SSBO (BINDING_NODE_BOUNDS_BUFFER, CSGShortCircuit::nodeBoundsBuffer()),
+* which is uploaded again with the records.
+*/
+class CSGShaderGenerator
+{
+public:
+	// Defined in the specialized shader, disables the generic scanSDF() and scanSDFGradient() of PrimitiveSceneSDF.glsl
+	static constexpr const char* SPECIALIZED_SCENE_DEFINE = "CSG_SPECIALIZED_SCENE";
+
+	// Hash of everything the generated source depends on: the node buffer only
+	static uint64_t topologyHash(const CSGSceneView& scene);
+
+	// GLSL scanSDF() and scanSDFGradient() for the topology of 'scene', to be placed after PrimitiveSceneSDF.glsl
+	static std::string generateSceneSDF(const CSGSceneView& scene);
+
+	/*
+	* Specialize the source of primitiveSphereMarching.comp.glsl: SPECIALIZED_SCENE_DEFINE is defined after the #version line and the
+	* generated functions are inserted after the include of PrimitiveSceneSDF.glsl.
+	*/
+	static bool specializeShader(const std::string& computeSource, const CSGSceneView& scene, std::string& specializedSource, std::string& error);
+};
+
+/*
+* Shader programs specialized by CSGShaderGenerator, keyed by the topology hash of the scene.
+* Compilation and deletion are given by the renderer, so the cache does not depend on the GL loader. Programs are evicted in least
+* recently used order once 'capacity' topologies have been compiled.
+*/
+class CSGShaderCache
+{
+public:
+	// Return the linked program, or 0 and an error message
+	using CompileFunction = std::function<unsigned int(const std::string& source, std::string& error)>;
+	using DeleteFunction = std::function<void(unsigned int program)>;
+
+	CSGShaderCache(std::string computeSource, CompileFunction compile, DeleteFunction release, size_t capacity = 16);
+	~CSGShaderCache();
+
+	CSGShaderCache(const CSGShaderCache&) = delete;
+	CSGShaderCache& operator=(const CSGShaderCache&) = delete;
+
+	/*
+	* Program specialized for the topology of 'scene', compiled on first use.
+	* Return 0 if the specialized shader does not compile, the caller then keeps the generic shader. A failed topology is not compiled again.
+	*/
+	unsigned int getProgram(const CSGSceneView& scene, std::string& error);
+
+	// Delete every program
+	void clear();
+
+	[[nodiscard]] size_t size() const { return _entries.size(); }
+	[[nodiscard]] long long getNbHit() const { return _nbHit; }
+	[[nodiscard]] long long getNbCompilation() const { return _nbCompilation; }
+
+private:
+	struct Entry
+	{
+		unsigned int program = 0;
+		std::string error;
+		std::list<uint64_t>::iterator lruPosition;
+	};
+
+	std::string _computeSource;
+	CompileFunction _compile;
+	DeleteFunction _release;
+	size_t _capacity;
+
+	std::unordered_map<uint64_t, Entry> _entries;
+	std::list<uint64_t> _lru; // Most recently used topology first
+	long long _nbHit = 0;
+	long long _nbCompilation = 0;
+};
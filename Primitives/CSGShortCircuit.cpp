@@ -0,0 +1,188 @@
+#include "renderer/opengl/Primitives/CSGShortCircuit.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/CSGDistanceBounds.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+float CSGShortCircuit::nodeCost(const int type)
+{
+	switch (type)
+	{
+	case SHADER_TYPE_SPHERE:
+		return TRANSFORM_COST + 6.f;
+	case SHADER_TYPE_TORUS:
+		return TRANSFORM_COST + 14.f;
+	case SHADER_TYPE_CYLINDER:
+		return TRANSFORM_COST + 16.f;
+	case SHADER_TYPE_BOX:
+		return TRANSFORM_COST + 16.f;
+	case SHADER_TYPE_SMOOTH_INTERSECTION:
+	case SHADER_TYPE_SMOOTH_UNION:
+	case SHADER_TYPE_SMOOTH_DIFFERENCE:
+		return 8.f * OPERATION_COST;
+	default:
+		return OPERATION_COST;
+	}
+}
+
+std::vector<float> CSGShortCircuit::subtreeCosts(const CSGSceneView& scene)
+{
+	std::vector<float> costs(scene.nbNode);
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		costs[i] = nodeCost(node.type);
+		if (isNaryOperation(node.type))
+		{
+			// One selection per leaf
+			for (int child = node.leftChildIndex; child <= node.rightChildIndex; child++)
+				costs[i] += costs[child] + OPERATION_COST;
+		}
+		else if (!isLeafType(node.type))
+		{
+			costs[i] += costs[node.leftChildIndex];
+			if (node.type != SHADER_TYPE_COMPLEMENTARY)
+				costs[i] += costs[node.rightChildIndex];
+		}
+	}
+	return costs;
+}
+
+CSGShortCircuit::CSGShortCircuit(const CSGSceneView& scene) :
+	_scene{scene},
+	_costs{subtreeCosts(scene)},
+	_swapped(scene.nbNode, 0),
+	_positions(scene.nbNode, -1),
+	_guards(scene.nbNode, -1)
+{
+	const std::vector<AABB> bounds = CSGBounds::nodeBounds(scene);
+	const std::vector<DistanceBound> distanceBounds = CSGDistanceBounds::nodeBounds(scene);
+	std::vector<AABB> leafBounds(scene.nbNode); // Bounds of the leaves of each subtree
+	std::vector<float> smoothMargins(scene.nbNode, 0.f); // Largest sum of k / 4 over the smooth operations of a branch of each subtree
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = scene.nodes[i];
+		if (isLeafType(node.type))
+		{
+			leafBounds[i] = CSGBounds::leafBounds(scene, node);
+			continue;
+		}
+
+		// |min|, |max| and |-d| are at most the largest |d| of the children, the blend moves a smooth operation by k / 4 at most
+		auto mergeChild = [&](const int child)
+		{
+			leafBounds[i] = leafBounds[i].merged(leafBounds[child]);
+			smoothMargins[i] = std::max(smoothMargins[i], smoothMargins[child]);
+		};
+		if (isNaryOperation(node.type))
+		{
+			for (int child = node.leftChildIndex; child <= node.rightChildIndex; child++)
+				mergeChild(child);
+		}
+		else
+		{
+			mergeChild(node.leftChildIndex);
+			if (node.type != SHADER_TYPE_COMPLEMENTARY)
+				mergeChild(node.rightChildIndex);
+		}
+		if (isSmoothOperation(node.type))
+			smoothMargins[i] += 0.25f * blendRadius(node);
+
+		// The cheaper child of an intersection first, it is as likely as the other one to make it irrelevant
+		if (node.type == SHADER_TYPE_INTERSECTION && _costs[node.rightChildIndex] < _costs[node.leftChildIndex])
+			_swapped[i] = 1;
+	}
+
+	// An empty box is outside of every point and never exact, an infinite one contains every point
+	constexpr float largest = std::numeric_limits<float>::max();
+	_nodeBounds.reserve(4 * static_cast<size_t>(scene.nbNode));
+	for (int i = 0; i < scene.nbNode; i++)
+	{
+		const bool empty = bounds[i].isEmpty();
+		const glm::vec3 boundsMin = empty ? glm::vec3(largest) : glm::clamp(bounds[i].min, glm::vec3(-largest), glm::vec3(largest));
+		const glm::vec3 boundsMax = empty ? glm::vec3(-largest) : glm::clamp(bounds[i].max, glm::vec3(-largest), glm::vec3(largest));
+		_nodeBounds.emplace_back(boundsMin, distanceBounds[i].exactOutside && !empty ? 1.f : 0.f);
+		_nodeBounds.emplace_back(boundsMax, 0.f);
+		_nodeBounds.emplace_back(leafBounds[i].min, distanceBounds[i].lipschitz);
+		_nodeBounds.emplace_back(leafBounds[i].max, smoothMargins[i]);
+	}
+
+	if (scene.isEmpty())
+		return;
+
+	// Postorder from the root with an explicit stack, the guard of an operation being placed on the first node of its second child
+	_order.reserve(scene.nbNode);
+	std::vector<std::pair<int, int>> stack{{scene.nbNode - 1, 0}}; // Node and number of children already pushed
+	while (!stack.empty())
+	{
+		const int nodeIndex = stack.back().first;
+		const int nbPushed = stack.back().second;
+		const CSGNode::ShaderNodeData& node = scene.nodes[nodeIndex];
+		int nbChild = 0;
+		if (isNaryOperation(node.type))
+			nbChild = node.rightChildIndex - node.leftChildIndex + 1;
+		else if (!isLeafType(node.type))
+			nbChild = node.type == SHADER_TYPE_COMPLEMENTARY ? 1 : 2;
+
+		if (nbPushed == nbChild)
+		{
+			_positions[nodeIndex] = static_cast<int>(_order.size());
+			_order.push_back(nodeIndex);
+			stack.pop_back();
+			continue;
+		}
+
+		stack.back().second++;
+		int child = node.leftChildIndex + nbPushed;
+		if (!isNaryOperation(node.type))
+			child = (nbPushed == 0) != (_swapped[nodeIndex] != 0) ? node.leftChildIndex : node.rightChildIndex;
+
+		// Guarded when skipping the second child may save more than the guard costs
+		if (nbPushed == 1 && (node.type == SHADER_TYPE_INTERSECTION || node.type == SHADER_TYPE_DIFFERENCE) && _costs[child] > GUARD_COST)
+		{
+			_guards[_order.size()] = nodeIndex;
+			_nbGuard++;
+		}
+		stack.emplace_back(child, 0);
+	}
+}
+
+// True if 'distance' is at least the upper bound of |d| of a node, or strictly above it: the distance of the node is zero on the surface
+// of its leaves, which are inside the bounds of its leaves, so |d| <= lipschitz * (distance to their farthest point) + smooth margin
+static bool aboveUpperBound(const glm::vec4* bounds, const glm::vec3& pos, const float distance, const bool strict)
+{
+	const float reach = distance - bounds[3].w;
+	if (reach < 0.f || (strict && reach == 0.f))
+		return false;
+	const glm::vec3 farthest = bounds[2].w * glm::max(glm::abs(pos - glm::vec3(bounds[2])), glm::abs(pos - glm::vec3(bounds[3])));
+	const float farthest2 = glm::dot(farthest, farthest);
+	return strict ? reach * reach > farthest2 : reach * reach >= farthest2;
+}
+
+bool CSGShortCircuit::canSkip(const int operation, const glm::vec3& pos, const float firstDistance, const float margin) const
+{
+	const glm::vec4* bounds = &_nodeBounds[4 * static_cast<size_t>(secondChild(operation))];
+	if (_scene.nodes[operation].type != SHADER_TYPE_DIFFERENCE)
+	{
+		// max(a, b) = a where b <= a, and b alone where a < b strictly: the left child wins the ties
+		return aboveUpperBound(bounds, pos, firstDistance - margin, _swapped[operation] != 0);
+	}
+
+	// max(a, -b) = a where -b <= a. Outside of its bounds, b is positive, and at least as far as its bounds where it is exact.
+	const glm::vec3 outside = glm::max(glm::max(glm::vec3(bounds[0]) - pos, pos - glm::vec3(bounds[1])), glm::vec3(0.f));
+	const float outside2 = glm::dot(outside, outside);
+	if (outside2 > margin * margin)
+	{
+		const float reach = margin - firstDistance; // Distance to the bounds needed with an exact distance
+		if (firstDistance >= 0.f || (bounds[0].w != 0.f && (reach <= 0.f || outside2 >= reach * reach)))
+			return true;
+	}
+	return aboveUpperBound(bounds, pos, firstDistance - margin, false);
+}
+
+float CSGShortCircuit::skippedDistance(const int operation) const
+{
+	return _scene.nodes[operation].type == SHADER_TYPE_DIFFERENCE ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/*
+* Evaluation plan skipping the children of intersections and differences that cannot change the result at a point.
+* max(a, b) is a wherever b <= a, and max(a, -b) is a wherever -b <= a: once one child is known, bounds of the other one can prove it
+* irrelevant without evaluating its subtree. Two bounds of the distance d of a node are used, both from static data:
+*   - |d(p)| <= lipschitz * (distance from p to the farthest point of the bounds of its leaves) + k / 4 per smooth operation below it,
+*     since d is zero on the surface of a leaf, which is inside the bounds of the leaf,
+*   - outside of the bounds of the node (CSGBounds), d(p) > 0, and d(p) is at least the distance to these bounds where it is exact.
+* Every subtree gets a cost estimate from the operation counts of its nodes. The cheaper child of an intersection is evaluated first,
+* the left child of a difference always is (the subtracted child is the bounded one), and the second child is only guarded when it
+* costs more than the guard itself.
+* A skipped child keeps a sentinel distance (-infinity for an intersection, +infinity for a difference) which makes its parent select
+* the first child, so the distances and colors are exactly the ones of the full evaluation.
+* The plan only depends on the topology, the bounds also depend on the primitive records.
+*/
+class CSGShortCircuit
+{
+public:
+	// Rough operation counts: the affine transform of the point (18) and the SDF of the primitive, or the selection of an operation
+	static constexpr float TRANSFORM_COST = 18.f;
+	static constexpr float OPERATION_COST = 1.f;
+	static constexpr float GUARD_COST = TRANSFORM_COST + 16.f; // Two boxes of the skippable child compared with the point, about a leaf
+
+	explicit CSGShortCircuit(const CSGSceneView& scene);
+
+	// Estimated cost of a node alone, and of every subtree of the postorder buffer (same indexing)
+	static float nodeCost(int type);
+	static std::vector<float> subtreeCosts(const CSGSceneView& scene);
+
+	// Nodes in evaluation order: a postorder where each subtree is still contiguous, with the cheaper child of the intersections first
+	[[nodiscard]] const std::vector<int>& getOrder() const { return _order; }
+	// Position of a node in getOrder()
+	[[nodiscard]] int getPosition(int nodeIndex) const { return _positions[nodeIndex]; }
+	// Guarded operation whose skippable child starts at 'position' of getOrder(), -1 if none
+	[[nodiscard]] int getGuard(int position) const { return _guards[position]; }
+	[[nodiscard]] int getNbGuard() const { return _nbGuard; }
+	[[nodiscard]] float getCost(int nodeIndex) const { return _costs[nodeIndex]; }
+
+	// Children of a guarded operation in evaluation order, the second one being the skippable one
+	[[nodiscard]] int firstChild(int operation) const { return _swapped[operation] != 0 ? _scene.nodes[operation].rightChildIndex : _scene.nodes[operation].leftChildIndex; }
+	[[nodiscard]] int secondChild(int operation) const { return _swapped[operation] != 0 ? _scene.nodes[operation].leftChildIndex : _scene.nodes[operation].rightChildIndex; }
+
+	// Margin of the guards at 'pos', covering the rounding of the evaluated distances, which is relative to the coordinates
+	static float guardMargin(const glm::vec3& pos) { return 1e-4f * (1.f + glm::length(pos)); }
+	/*
+	* True if the guarded 'operation' has the result of its first child at 'pos' whatever its second child, 'firstDistance' being the
+	* distance of the first child and 'margin' guardMargin(pos). The distances are compared squared, so a guard takes no square root.
+	*/
+	[[nodiscard]] bool canSkip(int operation, const glm::vec3& pos, float firstDistance, float margin) const;
+	// Distance given to the skipped child of 'operation' so that the operation selects the first child
+	[[nodiscard]] float skippedDistance(int operation) const;
+
+	/*
+	* Bounds of every node read by the guards of the generated shaders: four vec4 per node, the NodeBounds struct written by
+	* CSGShaderGenerator (box min and exactOutside, box max, leaf bounds min and lipschitz, leaf bounds max and smooth margin).
+	* Unbounded boxes are clamped to the largest float, and empty ones are inverted. The CPU guards read the same records.
+	* It depends on the primitive records, so it is uploaded again when they change.
+	*/
+	[[nodiscard]] const std::vector<glm::vec4>& nodeBoundsBuffer() const { return _nodeBounds; }
+
+private:
+	CSGSceneView _scene;
+	std::vector<float> _costs;
+	std::vector<glm::vec4> _nodeBounds;
+	std::vector<uint8_t> _swapped; // Intersections whose right child is evaluated first
+
+	std::vector<int> _order;
+	std::vector<int> _positions;
+	std::vector<int> _guards;
+	int _nbGuard = 0;
+};
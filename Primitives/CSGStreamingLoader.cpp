@@ -0,0 +1,314 @@
+#include "renderer/opengl/Primitives/CSGStreamingLoader.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <queue>
+#include <cstring>
+#include <cmath>
+
+CSGStreamingLoader::CSGStreamingLoader(const int chunkSize) :
+	_chunkSize{std::max(chunkSize, 1)}
+{
+}
+
+CSGStreamingLoader::~CSGStreamingLoader()
+{
+	waitForCompletion();
+}
+
+bool CSGStreamingLoader::fail(const std::string& message)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_error = message;
+	_failed = true;
+	return false;
+}
+
+bool CSGStreamingLoader::validNaryRange(const CSGNode::ShaderNodeData& node) const
+{
+	if (node.leftChildIndex < 0 || node.leftChildIndex >= node.rightChildIndex)
+		return false;
+	const size_t nbChild = static_cast<size_t>(node.rightChildIndex - node.leftChildIndex + 1);
+	if (_subtreeRoots.size() < nbChild)
+		return false;
+	for (size_t j = 0; j < nbChild; j++)
+	{
+		const int child = _subtreeRoots[_subtreeRoots.size() - nbChild + j];
+		if (child != node.leftChildIndex + static_cast<int>(j) || !isLeafType(_nodes[child].type))
+			return false;
+	}
+	return true;
+}
+
+std::string CSGStreamingLoader::getError() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _error;
+}
+
+bool CSGStreamingLoader::open(const std::string& path, std::string& error)
+{
+	_nodeStream.open(path, std::ios::binary);
+	if (!_nodeStream || !_nodeStream.read(reinterpret_cast<char*>(&_header), sizeof(CSGBinaryHeader)))
+	{
+		error = "cannot read '" + path + "'";
+		return false;
+	}
+	if (memcmp(_header.magic, CSGBinaryHeader::MAGIC, sizeof(_header.magic)) != 0 || _header.version != CSGBinaryHeader::CURRENT_VERSION)
+	{
+		error = path + ": not a binary scene file of version " + std::to_string(CSGBinaryHeader::CURRENT_VERSION);
+		return false;
+	}
+
+	const uint32_t recordSizes[5] = {sizeof(CSGNode::ShaderNodeData), sizeof(SphereData), sizeof(TorusData), sizeof(CylinderData), sizeof(BoxData)};
+	for (int i = 0; i < 5; i++)
+	{
+		if (_header.sectionRecordSize[i] != recordSizes[i])
+		{
+			error = path + ": record size mismatch in section " + std::to_string(i);
+			return false;
+		}
+	}
+
+	_nodeStream.seekg(static_cast<std::streamoff>(_header.sectionOffset[0]));
+	for (int i = 0; i < 4; i++)
+	{
+		_primitiveStreams[i].open(path, std::ios::binary);
+		_primitiveStreams[i].seekg(static_cast<std::streamoff>(_header.sectionOffset[i + 1]));
+	}
+
+	// Buffers are sized once, so they never reallocate (and never hold two copies) while loading
+	_nodes.reserve(_header.sectionCount[0]);
+	_bounds.reserve(_header.sectionCount[0]);
+	_spheres.reserve(_header.sectionCount[1]);
+	_toruses.reserve(_header.sectionCount[2]);
+	_cylinders.reserve(_header.sectionCount[3]);
+	_boxes.reserve(_header.sectionCount[4]);
+
+	_complete = _header.sectionCount[0] == 0;
+	return true;
+}
+
+bool CSGStreamingLoader::loadChunk()
+{
+	if (_complete || _failed)
+		return false;
+
+	const size_t firstNode = _nodes.size();
+	const size_t nbChunkNode = std::min<size_t>(_chunkSize, _header.sectionCount[0] - firstNode);
+
+	// Read the chunk and the primitive records of its leaves outside of the lock, the preview can still be built meanwhile
+	std::vector<CSGNode::ShaderNodeData> chunk(nbChunkNode);
+	if (!_nodeStream.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(nbChunkNode * sizeof(CSGNode::ShaderNodeData))))
+		return fail("truncated node section");
+
+	// Leaves are stored in the same order as the records of each primitive section, so every section is read sequentially
+	int nbChunkPrimitive[4] = {0, 0, 0, 0};
+	for (const CSGNode::ShaderNodeData& node : chunk)
+	{
+		if (node.type >= SHADER_TYPE_SPHERE && node.type <= SHADER_TYPE_BOX)
+			nbChunkPrimitive[node.type - SHADER_TYPE_SPHERE]++;
+	}
+
+	std::vector<SphereData> spheres(nbChunkPrimitive[0]);
+	std::vector<TorusData> toruses(nbChunkPrimitive[1]);
+	std::vector<CylinderData> cylinders(nbChunkPrimitive[2]);
+	std::vector<BoxData> boxes(nbChunkPrimitive[3]);
+	auto readRecords = [this](const int section, auto& records)
+	{
+		return records.empty() || _primitiveStreams[section].read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(records[0])));
+	};
+	if (!readRecords(0, spheres) || !readRecords(1, toruses) || !readRecords(2, cylinders) || !readRecords(3, boxes))
+		return fail("truncated primitive section");
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	const size_t primitiveCounts[4] = {_spheres.size() + spheres.size(), _toruses.size() + toruses.size(), _cylinders.size() + cylinders.size(), _boxes.size() + boxes.size()};
+	if (primitiveCounts[0] > _header.sectionCount[1] || primitiveCounts[1] > _header.sectionCount[2]
+		|| primitiveCounts[2] > _header.sectionCount[3] || primitiveCounts[3] > _header.sectionCount[4])
+	{
+		_error = "more leaves than primitive records";
+		_failed = true;
+		return false;
+	}
+	_spheres.insert(_spheres.end(), spheres.begin(), spheres.end());
+	_toruses.insert(_toruses.end(), toruses.begin(), toruses.end());
+	_cylinders.insert(_cylinders.end(), cylinders.begin(), cylinders.end());
+	_boxes.insert(_boxes.end(), boxes.begin(), boxes.end());
+
+	CSGSceneView loadedView;
+	loadedView.nodes = chunk.data();
+	loadedView.spheres = _spheres.data();
+	loadedView.nbSphere = static_cast<int>(_spheres.size());
+	loadedView.toruses = _toruses.data();
+	loadedView.nbTorus = static_cast<int>(_toruses.size());
+	loadedView.cylinders = _cylinders.data();
+	loadedView.nbCylinder = static_cast<int>(_cylinders.size());
+	loadedView.boxes = _boxes.data();
+	loadedView.nbBox = static_cast<int>(_boxes.size());
+
+	for (size_t i = 0; i < nbChunkNode; i++)
+	{
+		const CSGNode::ShaderNodeData& node = chunk[i];
+		const int nodeIndex = static_cast<int>(firstNode + i);
+
+		// Same checks as CSGBinaryScene::validateNodes(), the children of a node are the last subtrees completed before it
+		AABB bounds;
+		const int operation = hardOperation(node.type);
+		const bool validBlend = !isSmoothOperation(node.type) || (blendRadius(node) > 0.f && std::isfinite(blendRadius(node)));
+		if (node.type >= SHADER_TYPE_SPHERE && node.type <= SHADER_TYPE_BOX)
+		{
+			const int nbRecord = node.type == SHADER_TYPE_SPHERE ? loadedView.nbSphere : node.type == SHADER_TYPE_TORUS ? loadedView.nbTorus
+				: node.type == SHADER_TYPE_CYLINDER ? loadedView.nbCylinder : loadedView.nbBox;
+			if (node.primitiveIndex < 0 || node.primitiveIndex >= nbRecord || node.leftChildIndex != -1 || node.rightChildIndex != -1)
+			{
+				_error = "invalid node " + std::to_string(nodeIndex);
+				_failed = true;
+				return false;
+			}
+			bounds = CSGBounds::leafBounds(loadedView, node);
+		}
+		else if (node.type == SHADER_TYPE_COMPLEMENTARY && !_subtreeRoots.empty() && node.leftChildIndex == _subtreeRoots.back())
+		{
+			_subtreeRoots.pop_back();
+			bounds = AABB::infinite();
+		}
+		else if (operation >= SHADER_TYPE_INTERSECTION && operation <= SHADER_TYPE_DIFFERENCE && validBlend && _subtreeRoots.size() >= 2
+			&& node.rightChildIndex == _subtreeRoots.back() && node.leftChildIndex == _subtreeRoots[_subtreeRoots.size() - 2])
+		{
+			_subtreeRoots.resize(_subtreeRoots.size() - 2);
+			bounds = CSGBounds::operationBounds(node.type, _bounds[node.leftChildIndex], _bounds[node.rightChildIndex], blendRadius(node));
+		}
+		else if (isNaryOperation(node.type) && validNaryRange(node))
+		{
+			const size_t nbChild = static_cast<size_t>(node.rightChildIndex - node.leftChildIndex + 1);
+			_subtreeRoots.resize(_subtreeRoots.size() - nbChild);
+			bounds = _bounds[node.leftChildIndex];
+			for (int child = node.leftChildIndex + 1; child <= node.rightChildIndex; child++)
+				bounds = CSGBounds::operationBounds(binaryOperation(node.type), bounds, _bounds[child]);
+		}
+		else
+		{
+			_error = "invalid node " + std::to_string(nodeIndex);
+			_failed = true;
+			return false;
+		}
+
+		_nodes.push_back(node);
+		_bounds.push_back(bounds);
+		_subtreeRoots.push_back(nodeIndex);
+	}
+
+	if (_nodes.size() == _header.sectionCount[0])
+	{
+		if (_subtreeRoots.size() != 1)
+		{
+			_error = "the node section does not describe a single tree";
+			_failed = true;
+			return false;
+		}
+		_complete = true;
+	}
+	return true;
+}
+
+void CSGStreamingLoader::startBackgroundLoad()
+{
+	if (_loadingThread.joinable() || _complete || _failed)
+		return;
+	_loadingThread = std::thread([this]()
+	{
+		while (loadChunk())
+		{
+		}
+	});
+}
+
+void CSGStreamingLoader::waitForCompletion()
+{
+	if (_loadingThread.joinable())
+		_loadingThread.join();
+}
+
+float CSGStreamingLoader::progress() const
+{
+	if (_header.sectionCount[0] == 0)
+		return _complete ? 1.f : 0.f;
+	std::lock_guard<std::mutex> lock(_mutex);
+	return static_cast<float>(_nodes.size()) / static_cast<float>(_header.sectionCount[0]);
+}
+
+CSGSceneData CSGStreamingLoader::buildPreview(const int maxBox) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Refine the biggest boxes first, starting from the roots of the completed subtrees
+	auto volume = [this](const int nodeIndex)
+	{
+		const glm::vec3 size = _bounds[nodeIndex].max - _bounds[nodeIndex].min;
+		return size.x * size.y * size.z;
+	};
+	auto smallerVolume = [&](const int a, const int b) { return volume(a) < volume(b); };
+	std::priority_queue<int, std::vector<int>, decltype(smallerVolume)> boxes(smallerVolume);
+	for (const int root : _subtreeRoots)
+	{
+		if (!_bounds[root].isEmpty() && !_bounds[root].isInfinite())
+			boxes.push(root);
+	}
+
+	std::vector<int> leaves;
+	while (!boxes.empty() && static_cast<int>(boxes.size() + leaves.size()) < maxBox)
+	{
+		const int nodeIndex = boxes.top();
+		const CSGNode::ShaderNodeData& node = _nodes[nodeIndex];
+		// Only a union is exactly covered by the boxes of its children
+		if (node.type != SHADER_TYPE_UNION)
+		{
+			boxes.pop();
+			leaves.push_back(nodeIndex);
+			continue;
+		}
+		boxes.pop();
+		for (const int child : {node.leftChildIndex, node.rightChildIndex})
+		{
+			if (!_bounds[child].isEmpty() && !_bounds[child].isInfinite())
+				boxes.push(child);
+		}
+	}
+	while (!boxes.empty())
+	{
+		leaves.push_back(boxes.top());
+		boxes.pop();
+	}
+
+	// Union chain of the boxes, in postorder
+	std::vector<CSGNode::ShaderNodeData> nodes;
+	std::vector<BoxData> boxRecords;
+	for (const int nodeIndex : leaves)
+	{
+		const AABB& bounds = _bounds[nodeIndex];
+		BoxData box{};
+		setInverseTransform(box, glm::translate(glm::mat4(1.f), -0.5f * (bounds.min + bounds.max)));
+		box.color = glm::vec3(0.5f);
+		box.size = 0.5f * (bounds.max - bounds.min);
+		boxRecords.push_back(box);
+
+		// Union of the previous union (or first box) and the new box
+		nodes.push_back(CSGNode::ShaderNodeData{SHADER_TYPE_BOX, -1, -1, static_cast<int>(boxRecords.size()) - 1});
+		if (nodes.size() > 1)
+			nodes.push_back(CSGNode::ShaderNodeData{SHADER_TYPE_UNION, static_cast<int>(nodes.size()) - 2, static_cast<int>(nodes.size()) - 1, -1});
+	}
+
+	return CSGSceneData{std::move(nodes), {}, {}, {}, std::move(boxRecords)};
+}
+
+CSGSceneData CSGStreamingLoader::takeScene()
+{
+	waitForCompletion();
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_complete)
+		return CSGSceneData{};
+
+	_bounds.clear();
+	_bounds.shrink_to_fit();
+	return CSGSceneData{std::move(_nodes), std::move(_spheres), std::move(_toruses), std::move(_cylinders), std::move(_boxes)};
+}
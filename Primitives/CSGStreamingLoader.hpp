@@ -0,0 +1,79 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGBinaryScene.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string>
+
+/*
+* Incremental reader of a binary scene file, for scenes too big to go through a shared_ptr CSGTree.
+* The node section is read chunk by chunk in postorder, together with the primitive records its leaves use, and appended to flat buffers
+* sized once from the header: memory never exceeds the final scene plus one chunk and one bounding box per node.
+* While the file is loading, buildPreview() returns a scene made of the bounding boxes of the subtrees already loaded, which can be rendered
+* right away with the usual evaluator or shader.
+*/
+class CSGStreamingLoader
+{
+public:
+	static constexpr int DEFAULT_CHUNK_SIZE = 1 << 16; // Nodes read at once
+
+	explicit CSGStreamingLoader(int chunkSize = DEFAULT_CHUNK_SIZE);
+	~CSGStreamingLoader();
+
+	CSGStreamingLoader(const CSGStreamingLoader&) = delete;
+	CSGStreamingLoader& operator=(const CSGStreamingLoader&) = delete;
+
+	// Read and check the header, and reserve the buffers
+	bool open(const std::string& path, std::string& error);
+
+	// Read the next chunk of nodes. Return false when the scene is complete or on error (see getError())
+	bool loadChunk();
+
+	// Load the remaining chunks on a background thread
+	void startBackgroundLoad();
+	void waitForCompletion();
+
+	[[nodiscard]] bool isComplete() const { return _complete; }
+	[[nodiscard]] bool hasFailed() const { return _failed; }
+	[[nodiscard]] std::string getError() const;
+	[[nodiscard]] float progress() const; // Fraction of the nodes loaded, in [0, 1]
+
+	/*
+	* Union of at most 'maxBox' boxes covering the subtrees loaded so far: the roots of the completed subtrees, the biggest of them being
+	* replaced by the boxes of their children while the budget allows. Unbounded subtrees (complement) are left out.
+	*/
+	[[nodiscard]] CSGSceneData buildPreview(int maxBox = 256) const;
+
+	// Move the complete scene out of the loader. Only valid once isComplete() is true.
+	CSGSceneData takeScene();
+
+private:
+	bool fail(const std::string& message);
+	// The leaves of an n-ary operation are the last subtrees completed before it, at least two of them. Call under the lock.
+	[[nodiscard]] bool validNaryRange(const CSGNode::ShaderNodeData& node) const;
+
+	int _chunkSize;
+	std::ifstream _nodeStream;
+	std::ifstream _primitiveStreams[4]; // One sequential reader per primitive section
+	CSGBinaryHeader _header{};
+
+	// Flat buffers being filled, guarded by _mutex (read by buildPreview while the loading thread appends)
+	std::vector<CSGNode::ShaderNodeData> _nodes;
+	std::vector<SphereData> _spheres;
+	std::vector<TorusData> _toruses;
+	std::vector<CylinderData> _cylinders;
+	std::vector<BoxData> _boxes;
+	std::vector<AABB> _bounds; // Bounds of every loaded node
+	std::vector<int> _subtreeRoots; // Postorder stack: loaded nodes whose parent is not loaded yet
+	mutable std::mutex _mutex;
+
+	std::atomic<bool> _complete{false};
+	std::atomic<bool> _failed{false};
+	std::string _error;
+	std::thread _loadingThread;
+};
@@ -125,7 +125,9 @@ std::shared_ptr<CSGNode> CSGTree::getLeafAtIndex(const int idx) const
 
 bool CSGTree::removeAtPreorderOperation(const int preorderIdx)
 {
-	if (preorderIdx == 0 && _root != nullptr && !_root->isLeaf())
+	if (_root == nullptr)
+		return false;
+	else if (preorderIdx == 0 && !_root->isLeaf())
 	{
 		_root = _root->getFirstChild();
 		return true;
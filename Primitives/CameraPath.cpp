@@ -0,0 +1,92 @@
+#include "renderer/opengl/Primitives/CameraPath.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <fstream>
+#include <sstream>
+
+bool CameraPath::load(const std::string& path, std::vector<CameraParameters>& cameras, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "cannot open '" + path + "'";
+		return false;
+	}
+	return parse(file, cameras, error);
+}
+
+bool CameraPath::parse(std::istream& stream, std::vector<CameraParameters>& cameras, std::string& error)
+{
+	std::vector<CameraParameters> parsedCameras;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+		const std::string location = "line " + std::to_string(lineNumber) + ": ";
+
+		const size_t commentStart = line.find('#');
+		if (commentStart != std::string::npos)
+			line.erase(commentStart);
+
+		std::istringstream tokens(line);
+		std::string type;
+		if (!(tokens >> type))
+			continue; // Empty line
+
+		CameraParameters camera;
+		float fieldOfView = 0.f;
+		if (type == "lookAt")
+		{
+			glm::vec3 eye;
+			glm::vec3 target;
+			if (!(tokens >> eye.x >> eye.y >> eye.z >> target.x >> target.y >> target.z >> fieldOfView))
+			{
+				error = location + "'lookAt' expects 7 numbers";
+				return false;
+			}
+			camera.viewMat = glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f));
+		}
+		else if (type == "view")
+		{
+			for (int column = 0; column < 4; column++)
+				for (int row = 0; row < 4; row++)
+					tokens >> camera.viewMat[column][row];
+			if (!(tokens >> fieldOfView))
+			{
+				error = location + "'view' expects 17 numbers";
+				return false;
+			}
+		}
+		else
+		{
+			error = location + "unknown camera type '" + type + "'";
+			return false;
+		}
+
+		if (fieldOfView <= 0.f || fieldOfView >= 180.f)
+		{
+			error = location + "the field of view must be in ]0, 180[ degrees";
+			return false;
+		}
+		camera.fieldOfView = glm::radians(fieldOfView);
+		parsedCameras.push_back(camera);
+	}
+
+	cameras = std::move(parsedCameras);
+	return true;
+}
+
+std::vector<CameraParameters> CameraPath::turntable(const int nbFrame, const glm::vec3& target, const float radius, const float height, const float fieldOfView)
+{
+	std::vector<CameraParameters> cameras(std::max(nbFrame, 0));
+	for (int i = 0; i < nbFrame; i++)
+	{
+		const float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(nbFrame);
+		const glm::vec3 eye = target + glm::vec3(radius * std::sin(angle), height, radius * std::cos(angle));
+		cameras[i].viewMat = glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f));
+		cameras[i].fieldOfView = fieldOfView;
+	}
+	return cameras;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+/*
+* Sequence of cameras for offline renders. A camera path file has one camera per line, in one of these forms:
+*
+*     lookAt eyeX eyeY eyeZ targetX targetY targetZ fieldOfViewInDegrees
+*     view m00 m01 m02 m03 m10 ... m33 fieldOfViewInDegrees
+*
+* 'view' gives the 16 coefficients of the view matrix column by column (the memory layout of glm::mat4). Lines starting with '#' are ignored.
+*/
+class CameraPath
+{
+public:
+	static bool load(const std::string& path, std::vector<CameraParameters>& cameras, std::string& error);
+	static bool parse(std::istream& stream, std::vector<CameraParameters>& cameras, std::string& error);
+
+	// 'nbFrame' cameras on a horizontal circle around 'target', all looking at it
+	static std::vector<CameraParameters> turntable(int nbFrame, const glm::vec3& target, float radius, float height, float fieldOfView = glm::radians(60.f));
+};
@@ -60,7 +60,7 @@ std::vector<uint8_t> Cylinder::rawData() const
 {
 	std::vector<uint8_t> rawData = Primitive::rawData();
 
-	std::vector<uint8_t> cylinderData(5 * sizeof(float)); // some strange sizeof() values for memory alignment on GPU side
+	std::vector<uint8_t> cylinderData(4 * sizeof(float)); // some strange sizeof() values for memory alignment on GPU side
 	memcpy(cylinderData.data(), &_height, sizeof(float));
 	memcpy(cylinderData.data() + sizeof(float), &_radius, sizeof(float));
 	rawData.insert(rawData.end(), cylinderData.begin(), cylinderData.end());
@@ -0,0 +1,79 @@
+#include "renderer/opengl/Primitives/DirtyRegionTracker.hpp"
+#include "renderer/opengl/Primitives/SphereMarcher.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+void DirtyRegionTracker::beginEdit(const Primitive& primitive, const float blendMargin)
+{
+	_editedBlendMargin = blendMargin;
+	_editedPrimitiveBounds = CSGBounds::primitiveBounds(primitive).expanded(blendMargin);
+}
+
+void DirtyRegionTracker::endEdit(const Primitive& primitive, const bool modified)
+{
+	if (modified)
+	{
+		// Pixels covered by the primitive before the edit must be cleared, pixels covered after the edit must be drawn
+		_dirtyBounds = _dirtyBounds.merged(_editedPrimitiveBounds).merged(CSGBounds::primitiveBounds(primitive).expanded(_editedBlendMargin));
+	}
+	_editedPrimitiveBounds = AABB{};
+	_editedBlendMargin = 0.f;
+}
+
+bool DirtyRegionTracker::modifyPrimitiveUI(Primitive& primitive, const std::string& primitiveName)
+{
+	beginEdit(primitive);
+	const bool modified = primitive.modifySelectedPrimitiveUI(primitiveName);
+	endEdit(primitive, modified);
+	return modified;
+}
+
+ScreenRect DirtyRegionTracker::consumeDirtyRegion(const CameraParameters& camera, const int width, const int height)
+{
+	const bool cameraChanged = memcmp(&camera.viewMat, &_lastCamera.viewMat, sizeof(glm::mat4)) != 0 || camera.fieldOfView != _lastCamera.fieldOfView;
+	const bool resolutionChanged = width != _lastWidth || height != _lastHeight;
+
+	ScreenRect region;
+	if (_fullFrame || cameraChanged || resolutionChanged)
+		region = ScreenRect{0, 0, width, height};
+	else
+		region = alignToTiles(screenRegion(_dirtyBounds, camera, width, height), width, height);
+
+	_fullFrame = false;
+	_dirtyBounds = AABB{};
+	_lastCamera = camera;
+	_lastWidth = width;
+	_lastHeight = height;
+	return region;
+}
+
+glm::ivec2 DirtyRegionTracker::workGroupCount(const ScreenRect& region)
+{
+	if (region.isEmpty())
+		return glm::ivec2(0);
+	return glm::ivec2((region.width + TILE_SIZE - 1) / TILE_SIZE, (region.height + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+ScreenRect DirtyRegionTracker::screenRegion(const AABB& bounds, const CameraParameters& camera, const int width, const int height)
+{
+	if (bounds.isEmpty())
+		return ScreenRect{};
+
+	// A ray stops as soon as it is closer than the adaptive epsilon of the marcher, so a primitive also covers the pixels around its bounds
+	const float farthestCorner = glm::length(glm::max(glm::abs(bounds.min), glm::abs(bounds.max)));
+	const float epsilon = std::max(SphereMarcher::MIN_EPSILON, farthestCorner / static_cast<float>(std::max(width, height)));
+	return CSGBounds::project(bounds.expanded(epsilon), camera, width, height);
+}
+
+ScreenRect DirtyRegionTracker::alignToTiles(const ScreenRect& region, const int width, const int height)
+{
+	if (region.isEmpty())
+		return region;
+
+	const int minX = (region.x / TILE_SIZE) * TILE_SIZE;
+	const int minY = (region.y / TILE_SIZE) * TILE_SIZE;
+	const int maxX = ((region.x + region.width + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE;
+	const int maxY = ((region.y + region.height + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE;
+	return ScreenRect{minX, minY, maxX - minX, maxY - minY}.clipped(width, height);
+}
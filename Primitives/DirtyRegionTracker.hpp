@@ -0,0 +1,58 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/Primitive.hpp"
+#include "renderer/opengl/Primitives/CSGBounds.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <string>
+
+/*
+* Keep track of the part of the retained frame invalidated by primitive edits.
+* The world bounds of an edited primitive are recorded before and after the edit; at render time they are projected with the current camera
+* and snapped to the 16x16 tiles of primitiveSphereMarching.comp.glsl, so only these tiles are re-marched (dispatch with u_regionOffset).
+* A camera change, a topology change or an explicit invalidateAll() re-renders the whole frame.
+*/
+class DirtyRegionTracker
+{
+public:
+	static constexpr int TILE_SIZE = 16; // local_size_x and local_size_y of the sphere marching compute shader
+
+	/*
+	* Record the bounds of the primitive before it is modified. 'blendMargin' is CSGBounds::blendMargins() of its leaf: below smooth
+	* operations, the blended surfaces around the primitive move with it, so both bounds are expanded by it.
+	*/
+	void beginEdit(const Primitive& primitive, float blendMargin = 0.f);
+	// Record the bounds of the primitive after the modification, if 'modified' is true
+	void endEdit(const Primitive& primitive, bool modified);
+
+	// Draw the UI of the primitive, and invalidate the pixels it covered before and after the modification
+	bool modifyPrimitiveUI(Primitive& primitive, const std::string& primitiveName);
+
+	void invalidateAll() { _fullFrame = true; }
+
+	/*
+	* Tile aligned region to re-march for the next frame, then forget the recorded edits.
+	* The whole image is returned for the first frame, or if the camera or the resolution changed since the last call.
+	*/
+	ScreenRect consumeDirtyRegion(const CameraParameters& camera, int width, int height);
+
+	[[nodiscard]] bool hasPendingEdit() const { return _fullFrame || !_dirtyBounds.isEmpty(); }
+
+	// Number of workgroups to dispatch to cover 'region'
+	static glm::ivec2 workGroupCount(const ScreenRect& region);
+
+	// Pixels whose ray can be stopped by a surface inside 'bounds', taking the adaptive epsilon of the marcher into account
+	static ScreenRect screenRegion(const AABB& bounds, const CameraParameters& camera, int width, int height);
+
+	static ScreenRect alignToTiles(const ScreenRect& region, int width, int height);
+
+private:
+	AABB _editedPrimitiveBounds; // Bounds recorded by beginEdit()
+	float _editedBlendMargin = 0.f;
+	AABB _dirtyBounds; // Union of the bounds of all the edits since the last frame
+	bool _fullFrame = true;
+
+	CameraParameters _lastCamera;
+	int _lastWidth = 0;
+	int _lastHeight = 0;
+};
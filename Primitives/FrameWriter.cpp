@@ -0,0 +1,331 @@
+#include "renderer/opengl/Primitives/FrameWriter.hpp"
+
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <array>
+
+FrameWriter::FrameWriter(std::string directory, const ImageFormat format, const int maxPendingFrame) :
+	_directory{std::move(directory)},
+	_format{format},
+	_maxPendingFrame{static_cast<size_t>(std::max(maxPendingFrame, 1))},
+	_thread{&FrameWriter::writingLoop, this}
+{
+}
+
+FrameWriter::~FrameWriter()
+{
+	finish();
+}
+
+void FrameWriter::submit(const int frameIndex, RenderedImage image)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_slotAvailable.wait(lock, [this]() { return _pendingFrames.size() < _maxPendingFrame; });
+	_pendingFrames.emplace_back(frameIndex, std::move(image));
+	_frameAvailable.notify_one();
+}
+
+void FrameWriter::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_finishing = true;
+	}
+	_frameAvailable.notify_one();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void FrameWriter::writingLoop()
+{
+	while (true)
+	{
+		std::pair<int, RenderedImage> frame;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_frameAvailable.wait(lock, [this]() { return !_pendingFrames.empty() || _finishing; });
+			if (_pendingFrames.empty())
+				return; // Finishing and nothing left to write
+			frame = std::move(_pendingFrames.front());
+			_pendingFrames.pop_front();
+		}
+		_slotAvailable.notify_one();
+
+		const auto start = std::chrono::steady_clock::now();
+		const bool written = writeImage(framePath(frame.first), frame.second, _format);
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_encodingSeconds += elapsed.count();
+		(written ? _nbWritten : _nbFailed)++;
+	}
+}
+
+std::string FrameWriter::framePath(const int frameIndex) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "frame_%05d.%s", frameIndex, extension(_format));
+	return _directory.empty() ? std::string(fileName) : _directory + "/" + fileName;
+}
+
+int FrameWriter::getNbWritten() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbWritten;
+}
+
+int FrameWriter::getNbFailed() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbFailed;
+}
+
+double FrameWriter::getEncodingSeconds() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _encodingSeconds;
+}
+
+bool FrameWriter::parseFormat(const std::string& name, ImageFormat& format)
+{
+	if (name == "png")
+		format = ImageFormat::PNG;
+	else if (name == "exr")
+		format = ImageFormat::EXR;
+	else if (name == "raw")
+		format = ImageFormat::Raw;
+	else
+		return false;
+	return true;
+}
+
+const char* FrameWriter::extension(const ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::PNG:
+		return "png";
+	case ImageFormat::EXR:
+		return "exr";
+	case ImageFormat::Raw:
+	default:
+		return "rgba32f";
+	}
+}
+
+bool FrameWriter::writeImage(const std::string& path, const RenderedImage& image, const ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::PNG:
+		return writePNG(path, image);
+	case ImageFormat::EXR:
+		return writeEXR(path, image);
+	case ImageFormat::Raw:
+	default:
+		return writeRaw(path, image);
+	}
+}
+
+/*
+* PNG: no compression library is available to the renderer, so the zlib stream is made of 'stored' deflate blocks.
+* Files are bigger than with a real encoder, but the encoding is a plain copy, which keeps the writing thread ahead of the renderer.
+*/
+static uint32_t crc32(const uint8_t* data, const size_t size, uint32_t crc = 0)
+{
+	static const std::array<uint32_t, 256> table = []()
+	{
+		std::array<uint32_t, 256> values{};
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			values[i] = c;
+		}
+		return values;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void appendBigEndian(std::vector<uint8_t>& buffer, const uint32_t value)
+{
+	buffer.push_back(static_cast<uint8_t>(value >> 24));
+	buffer.push_back(static_cast<uint8_t>(value >> 16));
+	buffer.push_back(static_cast<uint8_t>(value >> 8));
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static void writePNGChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	chunk.reserve(data.size() + 12);
+	appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	appendBigEndian(chunk, crc32(chunk.data() + 4, data.size() + 4));
+	file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+bool FrameWriter::writePNG(const std::string& path, const RenderedImage& image)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	std::vector<uint8_t> header;
+	appendBigEndian(header, static_cast<uint32_t>(image.width));
+	appendBigEndian(header, static_cast<uint32_t>(image.height));
+	header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bits per channel, RGBA, deflate, no filter method, no interlacing
+	writePNGChunk(file, "IHDR", header);
+
+	// Scanlines, each one starting with the 'None' filter type
+	const size_t rowSize = static_cast<size_t>(image.width) * 4 + 1;
+	std::vector<uint8_t> scanlines(rowSize * image.height);
+	for (int y = 0; y < image.height; y++)
+	{
+		uint8_t* row = scanlines.data() + static_cast<size_t>(image.height - 1 - y) * rowSize;
+		row[0] = 0;
+		for (int x = 0; x < image.width; x++)
+		{
+			const glm::vec4 pixel = glm::clamp(image.at(x, y), 0.f, 1.f);
+			for (int c = 0; c < 4; c++)
+				row[1 + 4 * x + c] = static_cast<uint8_t>(pixel[c] * 255.f + 0.5f);
+		}
+	}
+
+	// zlib stream of stored blocks of at most 65535 bytes
+	std::vector<uint8_t> zlib{0x78, 0x01};
+	zlib.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+	size_t offset = 0;
+	do
+	{
+		const size_t blockSize = std::min<size_t>(scanlines.size() - offset, 65535);
+		const bool lastBlock = offset + blockSize == scanlines.size();
+		zlib.push_back(lastBlock ? 1 : 0);
+		zlib.push_back(static_cast<uint8_t>(blockSize));
+		zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+		zlib.push_back(static_cast<uint8_t>(~blockSize));
+		zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+		zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < scanlines.size());
+
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for (const uint8_t byte : scanlines)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	appendBigEndian(zlib, (b << 16) | a);
+
+	writePNGChunk(file, "IDAT", zlib);
+	writePNGChunk(file, "IEND", {});
+	return static_cast<bool>(file);
+}
+
+/*
+* OpenEXR single part scanline file, one uncompressed scanline per block
+*/
+template<typename T>
+static void appendLittleEndian(std::vector<uint8_t>& buffer, const T value)
+{
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T)); // Same byte order as EXR on the supported little endian platforms
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+static void appendEXRAttribute(std::vector<uint8_t>& header, const char* name, const char* type, const std::vector<uint8_t>& value)
+{
+	header.insert(header.end(), name, name + strlen(name) + 1);
+	header.insert(header.end(), type, type + strlen(type) + 1);
+	appendLittleEndian(header, static_cast<int32_t>(value.size()));
+	header.insert(header.end(), value.begin(), value.end());
+}
+
+bool FrameWriter::writeEXR(const std::string& path, const RenderedImage& image)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<uint8_t> header{0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0}; // Magic number, version 2, scanline file
+
+	// Channels are sorted by name in the file
+	static const char channelNames[4] = {'A', 'B', 'G', 'R'};
+	static const int channelComponents[4] = {3, 2, 1, 0};
+	std::vector<uint8_t> channels;
+	for (const char channelName : channelNames)
+	{
+		channels.push_back(static_cast<uint8_t>(channelName));
+		channels.push_back(0);
+		appendLittleEndian(channels, int32_t{2}); // FLOAT
+		channels.insert(channels.end(), {0, 0, 0, 0}); // pLinear and reserved
+		appendLittleEndian(channels, int32_t{1}); // x sampling
+		appendLittleEndian(channels, int32_t{1}); // y sampling
+	}
+	channels.push_back(0);
+	appendEXRAttribute(header, "channels", "chlist", channels);
+
+	appendEXRAttribute(header, "compression", "compression", {0}); // NO_COMPRESSION
+
+	std::vector<uint8_t> window;
+	for (const int32_t coordinate : {0, 0, image.width - 1, image.height - 1})
+		appendLittleEndian(window, coordinate);
+	appendEXRAttribute(header, "dataWindow", "box2i", window);
+	appendEXRAttribute(header, "displayWindow", "box2i", window);
+
+	appendEXRAttribute(header, "lineOrder", "lineOrder", {0}); // INCREASING_Y
+
+	std::vector<uint8_t> floatOne;
+	appendLittleEndian(floatOne, 1.f);
+	appendEXRAttribute(header, "pixelAspectRatio", "float", floatOne);
+	appendEXRAttribute(header, "screenWindowCenter", "v2f", std::vector<uint8_t>(8, 0));
+	appendEXRAttribute(header, "screenWindowWidth", "float", floatOne);
+	header.push_back(0); // End of the header
+
+	// Offset table, then one block per scanline: y, size of the data, and the channels one after the other
+	const uint32_t blockDataSize = static_cast<uint32_t>(image.width) * 4 * sizeof(float);
+	const uint64_t blockSize = 8 + blockDataSize;
+	const uint64_t firstBlockOffset = header.size() + static_cast<uint64_t>(image.height) * sizeof(uint64_t);
+	for (int y = 0; y < image.height; y++)
+		appendLittleEndian(header, firstBlockOffset + static_cast<uint64_t>(y) * blockSize);
+	file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+	std::vector<uint8_t> block;
+	block.reserve(blockSize);
+	for (int y = 0; y < image.height; y++)
+	{
+		block.clear();
+		appendLittleEndian(block, static_cast<int32_t>(y));
+		appendLittleEndian(block, blockDataSize);
+		const int imageRow = image.height - 1 - y;
+		for (const int component : channelComponents)
+			for (int x = 0; x < image.width; x++)
+				appendLittleEndian(block, image.at(x, imageRow)[component]);
+		file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+	}
+	return static_cast<bool>(file);
+}
+
+bool FrameWriter::writeRaw(const std::string& path, const RenderedImage& image)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	for (int y = image.height - 1; y >= 0; y--)
+		file.write(reinterpret_cast<const char*>(&image.at(0, y)), static_cast<std::streamsize>(image.width * sizeof(glm::vec4)));
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+enum class ImageFormat
+{
+	PNG, // 8 bits RGBA, clamped to [0, 1]
+	EXR, // 32 bits float RGBA, uncompressed scanlines
+	Raw, // 32 bits float RGBA, top row first, no header
+};
+
+/*
+* Write rendered frames to disk on a background thread, so the encoding of a frame overlaps the rendering of the next one.
+* At most 'maxPendingFrame' frames wait for their encoding: submit() blocks when the queue is full, which bounds the memory of long sequences.
+*/
+class FrameWriter
+{
+public:
+	FrameWriter(std::string directory, ImageFormat format, int maxPendingFrame = 2);
+	~FrameWriter();
+
+	FrameWriter(const FrameWriter&) = delete;
+	FrameWriter& operator=(const FrameWriter&) = delete;
+
+	// Queue the frame for writing in <directory>/frame_<frameIndex>.<extension>
+	void submit(int frameIndex, RenderedImage image);
+
+	// Wait until all the submitted frames are written, and stop the writing thread
+	void finish();
+
+	[[nodiscard]] std::string framePath(int frameIndex) const;
+	[[nodiscard]] int getNbWritten() const;
+	[[nodiscard]] int getNbFailed() const;
+	[[nodiscard]] double getEncodingSeconds() const; // Time spent encoding and writing, on the writing thread
+
+	static bool parseFormat(const std::string& name, ImageFormat& format);
+	static const char* extension(ImageFormat format);
+
+	// Images are stored bottom row first (as in the shader), files are written top row first
+	static bool writeImage(const std::string& path, const RenderedImage& image, ImageFormat format);
+	static bool writePNG(const std::string& path, const RenderedImage& image);
+	static bool writeEXR(const std::string& path, const RenderedImage& image);
+	static bool writeRaw(const std::string& path, const RenderedImage& image);
+
+private:
+	void writingLoop();
+
+	std::string _directory;
+	ImageFormat _format;
+	size_t _maxPendingFrame;
+
+	std::deque<std::pair<int, RenderedImage>> _pendingFrames;
+	mutable std::mutex _mutex;
+	std::condition_variable _frameAvailable;
+	std::condition_variable _slotAvailable;
+	bool _finishing = false;
+
+	int _nbWritten = 0;
+	int _nbFailed = 0;
+	double _encodingSeconds = 0.;
+
+	std::thread _thread; // Started last, once every other member is initialized
+};
@@ -1,4 +1,5 @@
 #include "renderer/opengl/Primitives/Primitive.hpp"
+#include "renderer/opengl/Primitives/CSGPrimitiveSDF.hpp"
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/euler_angles.hpp>
 
@@ -61,14 +62,18 @@ void Primitive::setTransform(const glm::mat4& transform)
 }
 
 // return the data of the object as a vector of uint8_t
-// Caution: the transform is given as an inversed mat4 (to avoid heavy computation in shader later)
+// Caution: the transform is given as the 3 first rows of the inversed mat4 (to avoid heavy computation in shader later), followed by the
+// color and the distance scale of the inverse transform (see distanceScale())
 std::vector<uint8_t> Primitive::rawData() const
 {
 	const glm::mat4 inverseTransformMat = getInverseTransform();
+	const glm::mat3x4 inverseTransformRows = affineRows(inverseTransformMat);
+	const float scale = distanceScale(inverseTransformMat);
 
-	std::vector<uint8_t> rawData(sizeof(glm::mat4) + sizeof(glm::vec3));
-	memcpy(rawData.data(), &inverseTransformMat, sizeof(glm::mat4));
-	memcpy(rawData.data() + sizeof(glm::mat4), &_color, sizeof(glm::vec3));
+	std::vector<uint8_t> rawData(sizeof(glm::mat3x4) + sizeof(glm::vec3) + sizeof(float));
+	memcpy(rawData.data(), &inverseTransformRows, sizeof(glm::mat3x4));
+	memcpy(rawData.data() + sizeof(glm::mat3x4), &_color, sizeof(glm::vec3));
+	memcpy(rawData.data() + sizeof(glm::mat3x4) + sizeof(glm::vec3), &scale, sizeof(float));
 
 	return rawData;
 }
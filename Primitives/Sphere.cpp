@@ -50,7 +50,7 @@ std::vector<uint8_t> Sphere::rawData() const
 {
 	std::vector<uint8_t> rawData = Primitive::rawData();
 
-	std::vector<uint8_t> sphereData(sizeof(float));
+	std::vector<uint8_t> sphereData(4 * sizeof(float)); // radius + 3 * sizeof(float) for memory alignment in shader
 	memcpy(sphereData.data(), &_radius, sizeof(float));
 
 	rawData.insert(rawData.end(), sphereData.begin(), sphereData.end());
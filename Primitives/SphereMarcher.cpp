@@ -0,0 +1,321 @@
+#include "renderer/opengl/Primitives/SphereMarcher.hpp"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <iomanip>
+
+void MarchStatistics::add(const MarchResult& march)
+{
+	nbPixel++;
+	nbStep += march.nbStep;
+	nbHit += march.hit ? 1 : 0;
+	nbOutOfSteps += march.outOfSteps ? 1 : 0;
+	maxStep = std::max(maxStep, march.nbStep);
+}
+
+void MarchStatistics::merge(const MarchStatistics& other)
+{
+	nbPixel += other.nbPixel;
+	nbStep += other.nbStep;
+	nbHit += other.nbHit;
+	nbOutOfSteps += other.nbOutOfSteps;
+	maxStep = std::max(maxStep, other.maxStep);
+}
+
+SphereMarcher::SphereMarcher(const CSGSceneView& scene, const int nbThread) :
+	_scene{scene},
+	_nbThread{nbThread > 0 ? nbThread : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))}
+{
+}
+
+MarchResult SphereMarcher::marchRay(const CSGEvaluator& evaluator, const Ray& ray, const int imageWidth, const int imageHeight) const
+{
+	if (_stepMethod == StepMethod::Overstep)
+		return marchRayOverstep(evaluator, ray, imageWidth, imageHeight);
+
+	MarchResult result;
+	float depth = 0.f; // Depth of the last point
+	float radius = 0.f; // Step allowed from the last point: its safe radius, minus epsilon / 2 where the distance is only a bound
+	float relaxation = 1.f;
+	for (int step = 0; step < MAX_MARCHING_STEPS; step++)
+	{
+		result.nbStep = step + 1;
+		float stepLength = relaxation * radius;
+		glm::vec3 currentPos = ray.origin + (depth + stepLength) * ray.direction;
+		CSGBoundEvaluation evaluation = evaluator.scanSDFBound(currentPos);
+
+		// Relaxed step too long: the safe spheres of its two ends leave a gap where the surface may be, replay it as a plain step
+		if (stepLength > radius && radius + evaluation.safeRadius < stepLength)
+		{
+			stepLength = radius;
+			currentPos = ray.origin + (depth + stepLength) * ray.direction;
+			evaluation = evaluator.scanSDFBound(currentPos);
+		}
+		depth += stepLength;
+
+		// Adaptive epsilon (always keep an epsilon close to the pixel size)
+		const float epsilon = std::max(MIN_EPSILON, glm::length(currentPos) / static_cast<float>(std::max(imageWidth, imageHeight)));
+
+		result.position = currentPos;
+		result.evaluation = {evaluation.color, evaluation.dist};
+		result.epsilon = epsilon;
+
+		// Detect a hit
+		if (evaluation.safeRadius < epsilon)
+		{
+			result.hit = true;
+			return result;
+		}
+
+		// An exact distance can be stepped as is, a bound keeps the float precision margin of the former scheme
+		radius = evaluation.exact ? evaluation.safeRadius : evaluation.safeRadius - epsilon * 0.5f;
+		relaxation = evaluation.exact ? RELAXATION_EXACT : RELAXATION_BOUND;
+
+		if (depth + radius >= MAX_RAY_LENGTH)
+			return result; // Background
+	}
+	result.outOfSteps = true;
+	return result;
+}
+
+MarchResult SphereMarcher::marchRayOverstep(const CSGEvaluator& evaluator, const Ray& ray, const int imageWidth, const int imageHeight) const
+{
+	MarchResult result;
+	float lastDelta = 0.f; // Last delta is added to the next step to implement sphere overstepping
+	float depth = 0.f;
+	for (int step = 0; step < MAX_MARCHING_STEPS; step++)
+	{
+		result.nbStep = step + 1;
+		glm::vec3 currentPos = ray.origin + (depth + lastDelta) * ray.direction;
+		CSGEvaluation evaluation = evaluator.scanSDF(currentPos);
+
+		// Overstepping failed: go back
+		if (evaluation.dist < lastDelta)
+		{
+			currentPos = ray.origin + depth * ray.direction;
+			evaluation = evaluator.scanSDF(currentPos);
+		}
+
+		// Adaptive epsilon (always keep an epsilon close to the pixel size)
+		const float epsilon = std::max(MIN_EPSILON, glm::length(currentPos) / static_cast<float>(std::max(imageWidth, imageHeight)));
+
+		result.position = currentPos;
+		result.evaluation = evaluation;
+		result.epsilon = epsilon;
+
+		// Detect a hit
+		if (std::abs(evaluation.dist) < epsilon)
+		{
+			result.hit = true;
+			return result;
+		}
+
+		const float delta = std::abs(evaluation.dist) - epsilon * 0.5f; // Float precision fix (to ensure the ray will stop before the surface)
+		depth += delta;
+		lastDelta = delta;
+
+		if (depth >= MAX_RAY_LENGTH)
+			return result; // Background
+	}
+	result.outOfSteps = true;
+	return result;
+}
+
+glm::vec3 SphereMarcher::estimateGradient(const CSGEvaluator& evaluator, const NormalMethod normalMethod, const glm::vec3& pos, const float dist, const float epsilon)
+{
+	// Vertices of a regular tetrahedron, their weighted sum cancels out the constant and the second order terms
+	static const std::array<glm::vec3, 4> tetrahedron{glm::vec3(1.f, -1.f, -1.f), glm::vec3(-1.f, -1.f, 1.f), glm::vec3(-1.f, 1.f, -1.f), glm::vec3(1.f, 1.f, 1.f)};
+
+	switch (normalMethod)
+	{
+	case NormalMethod::ForwardDifference:
+		return glm::vec3(evaluator.scanSDF(pos + glm::vec3(epsilon, 0.f, 0.f)).dist,
+			evaluator.scanSDF(pos + glm::vec3(0.f, epsilon, 0.f)).dist,
+			evaluator.scanSDF(pos + glm::vec3(0.f, 0.f, epsilon)).dist) - dist;
+	case NormalMethod::Tetrahedral:
+	{
+		glm::vec3 gradient{0.f};
+		for (const glm::vec3& vertex : tetrahedron)
+			gradient += vertex * evaluator.scanSDF(pos + epsilon * vertex).dist;
+		return gradient;
+	}
+	case NormalMethod::BatchedTetrahedral:
+	{
+		const glm::vec4 distances = evaluator.scanSDF4({pos + epsilon * tetrahedron[0], pos + epsilon * tetrahedron[1],
+			pos + epsilon * tetrahedron[2], pos + epsilon * tetrahedron[3]});
+		return tetrahedron[0] * distances.x + tetrahedron[1] * distances.y + tetrahedron[2] * distances.z + tetrahedron[3] * distances.w;
+	}
+	case NormalMethod::AnalyticGradient:
+	default:
+		return evaluator.scanSDFGradient(pos).gradient;
+	}
+}
+
+glm::vec4 SphereMarcher::marchPixel(const CSGEvaluator& evaluator, const Ray& ray, const int imageWidth, const int imageHeight) const
+{
+	return shade(evaluator, marchRay(evaluator, ray, imageWidth, imageHeight));
+}
+
+glm::vec4 SphereMarcher::shade(const CSGEvaluator& evaluator, const MarchResult& march) const
+{
+	if (march.outOfSteps)
+		return glm::vec4(1.f, 0.f, 0.f, 1.f); // Out of marching steps, drawn in red as in the shader
+	if (!march.hit)
+		return glm::vec4(0.f); // Background
+
+	const glm::vec3 gradient = estimateGradient(evaluator, _normalMethod, march.position, march.evaluation.dist, march.epsilon);
+	const glm::vec3 hitNormal = -glm::normalize(gradient); // Same orientation as the former forward differences (dist - d(pos + epsilon))
+
+	const float light = glm::clamp(glm::dot(hitNormal, glm::normalize(glm::vec3(1.f))), 0.2f, 1.f); // Cheap light calculation
+	return glm::vec4(march.evaluation.color * light, 1.f);
+}
+
+void SphereMarcher::render(const CameraParameters& camera, RenderedImage& image, MarchStatistics* statistics, MarchDiagnostics* diagnostics) const
+{
+	renderRegion(camera, image, ScreenRect{0, 0, image.width, image.height}, statistics, diagnostics);
+}
+
+void SphereMarcher::renderRegion(const CameraParameters& camera, RenderedImage& image, const ScreenRect& region, MarchStatistics* statistics,
+	MarchDiagnostics* diagnostics) const
+{
+	const ScreenRect clippedRegion = region.clipped(image.width, image.height);
+	if (clippedRegion.isEmpty())
+		return;
+	if (diagnostics != nullptr && (diagnostics->width != image.width || diagnostics->height != image.height))
+		*diagnostics = MarchDiagnostics{image.width, image.height};
+
+	const int nbTileX = (clippedRegion.width + TILE_SIZE - 1) / TILE_SIZE;
+	const int nbTileY = (clippedRegion.height + TILE_SIZE - 1) / TILE_SIZE;
+	const int nbTile = nbTileX * nbTileY;
+
+	std::atomic<int> nextTile{0};
+	std::mutex statisticsMutex;
+	auto worker = [&]()
+	{
+		const CSGEvaluator evaluator{_scene}; // One evaluator per thread, as it owns its node stack
+		MarchStatistics threadStatistics;
+		for (int tile = nextTile++; tile < nbTile; tile = nextTile++)
+		{
+			const int startX = clippedRegion.x + (tile % nbTileX) * TILE_SIZE;
+			const int startY = clippedRegion.y + (tile / nbTileX) * TILE_SIZE;
+			const int endX = std::min(startX + TILE_SIZE, clippedRegion.x + clippedRegion.width);
+			const int endY = std::min(startY + TILE_SIZE, clippedRegion.y + clippedRegion.height);
+
+			for (int y = startY; y < endY; y++)
+			{
+				for (int x = startX; x < endX; x++)
+				{
+					const Ray ray = camera.rayThroughPixel(x, y, image.width, image.height);
+					const long long firstEvaluation = evaluator.getNbEvaluation();
+					const MarchResult march = marchRay(evaluator, ray, image.width, image.height);
+					image.at(x, y) = shade(evaluator, march);
+					threadStatistics.add(march);
+
+					if (diagnostics != nullptr)
+					{
+						PixelDiagnostics& pixel = diagnostics->at(x, y);
+						pixel.nbStep = static_cast<uint16_t>(march.nbStep);
+						pixel.nbEvaluation = static_cast<uint16_t>(evaluator.getNbEvaluation() - firstEvaluation);
+						pixel.termination = march.hit ? MarchTermination::Hit : march.outOfSteps ? MarchTermination::OutOfSteps : MarchTermination::Escaped;
+					}
+				}
+			}
+		}
+
+		if (statistics != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(statisticsMutex);
+			statistics->merge(threadStatistics);
+		}
+	};
+
+	const int nbThread = std::min(_nbThread, nbTile);
+	std::vector<std::thread> threads;
+	for (int i = 1; i < nbThread; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void MarchHistograms::add(const PixelDiagnostics& pixel)
+{
+	steps[std::min<int>(pixel.nbStep, NB_STEP_BIN - 1)]++;
+	evaluations[std::min<int>(pixel.nbEvaluation, NB_EVALUATION_BIN - 1)]++;
+	terminations[static_cast<int>(pixel.termination)]++;
+}
+
+void MarchHistograms::merge(const MarchHistograms& other)
+{
+	for (int i = 0; i < NB_STEP_BIN; i++)
+		steps[i] += other.steps[i];
+	for (int i = 0; i < NB_EVALUATION_BIN; i++)
+		evaluations[i] += other.evaluations[i];
+	for (int i = 0; i < 3; i++)
+		terminations[i] += other.terminations[i];
+}
+
+int MarchHistograms::stepPercentile(const double fraction) const
+{
+	const double threshold = fraction * static_cast<double>(nbPixel());
+	double count = 0.;
+	for (int i = 0; i < NB_STEP_BIN; i++)
+	{
+		count += steps[i];
+		if (count >= threshold && count > 0.)
+			return i;
+	}
+	return NB_STEP_BIN - 1;
+}
+
+std::string MarchHistograms::summary() const
+{
+	const double nbPixelTotal = std::max(1., static_cast<double>(nbPixel()));
+	double sumStep = 0.;
+	double sumEvaluation = 0.;
+	for (int i = 0; i < NB_STEP_BIN; i++)
+		sumStep += static_cast<double>(i) * steps[i];
+	for (int i = 0; i < NB_EVALUATION_BIN; i++)
+		sumEvaluation += static_cast<double>(i) * evaluations[i];
+
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(1)
+		<< nbPixel() << " pixels: " << 100. * terminations[0] / nbPixelTotal << "% hit, " << 100. * terminations[1] / nbPixelTotal << "% escaped, "
+		<< 100. * terminations[2] / nbPixelTotal << "% out of steps\n"
+		<< std::setprecision(2) << "steps/pixel mean " << sumStep / nbPixelTotal << ", median " << stepPercentile(0.5) << ", 90% " << stepPercentile(0.9)
+		<< ", 99% " << stepPercentile(0.99) << "\n"
+		<< "evaluations/pixel mean " << sumEvaluation / nbPixelTotal << "\n";
+
+	// Steps histogram in bins of 10 steps
+	for (int bin = 0; bin < NB_STEP_BIN; bin += 10)
+	{
+		uint32_t count = 0;
+		for (int i = bin; i < std::min(bin + 10, NB_STEP_BIN); i++)
+			count += steps[i];
+		stream << "  steps " << std::setw(3) << bin << "-" << std::setw(3) << std::min(bin + 9, NB_STEP_BIN - 1) << " " << std::setw(10) << count << "\n";
+	}
+	return stream.str();
+}
+
+MarchHistograms MarchDiagnostics::histograms() const
+{
+	MarchHistograms result;
+	for (const PixelDiagnostics& pixel : pixels)
+		result.add(pixel);
+	return result;
+}
+
+RenderedImage MarchDiagnostics::heatMap() const
+{
+	RenderedImage image{width, height};
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		const float level = static_cast<float>(pixels[i].nbStep) / static_cast<float>(SphereMarcher::MAX_MARCHING_STEPS);
+		image.pixels[i] = pixels[i].termination == MarchTermination::OutOfSteps ? glm::vec4(1.f, 0.f, 0.f, 1.f) : glm::vec4(level, level, level, 1.f);
+	}
+	return image;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "renderer/opengl/Primitives/CSGEvaluator.hpp"
+#include "renderer/opengl/Primitives/CSGRenderTypes.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+/*
+* End point of a marched ray
+*/
+struct MarchResult
+{
+	bool hit = false;
+	glm::vec3 position{0.f};
+	CSGEvaluation evaluation{glm::vec3(0.f), 0.f}; // Evaluation of the scene at 'position'
+	float epsilon = 0.f; // Adaptive epsilon at 'position'
+	int nbStep = 0; // Iterations of the marching loop
+	bool outOfSteps = false;
+};
+
+/*
+* Counters accumulated over the pixels of a render
+*/
+struct MarchStatistics
+{
+	long long nbPixel = 0;
+	long long nbStep = 0;
+	long long nbHit = 0;
+	long long nbOutOfSteps = 0; // Pixels drawn in red
+	int maxStep = 0;
+
+	void add(const MarchResult& march);
+	void merge(const MarchStatistics& other);
+	[[nodiscard]] double meanStepPerPixel() const { return nbPixel > 0 ? static_cast<double>(nbStep) / static_cast<double>(nbPixel) : 0.; }
+};
+
+struct MarchDiagnostics;
+
+/*
+* CPU port of primitiveSphereMarching.comp.glsl, used when no GPU is available (headless rendering, tests).
+* The image is split in 16x16 tiles (the workgroup size of the shader) shared between worker threads.
+*/
+class SphereMarcher
+{
+public:
+	static constexpr int MAX_MARCHING_STEPS = 100;
+	static constexpr float MIN_EPSILON = 0.01f; // Threshold under which we consider that the ray has hit the object
+	static constexpr float MAX_RAY_LENGTH = 1000000.f;
+	static constexpr int TILE_SIZE = 16;
+
+	/*
+	* How the normal of a hit point is computed.
+	* AnalyticGradient is the default; the others only need distances and are kept as fallbacks for primitives without a closed-form gradient.
+	*/
+	enum class NormalMethod
+	{
+		AnalyticGradient, // One tree pass computing the gradient along the distance
+		ForwardDifference, // Three extra tree passes, one per axis, as the original shader did
+		Tetrahedral, // Four tree passes at the vertices of a tetrahedron, no reuse of the center distance
+		BatchedTetrahedral, // The four tetrahedron vertices evaluated in a single tree pass with scanSDF4()
+	};
+
+	/*
+	* How far each marching step goes.
+	* Overstep is the default, as in scanCSG() of the shader: probe one more distance ahead and go back if it was too far, steps shrunk
+	* by epsilon / 2.
+	* Relaxed takes the steps from the safe radius of CSGEvaluator::scanSDFBound(), so non-uniformly scaled primitives can neither
+	* overshoot nor slow the march down, and each step goes RELAXATION_EXACT or RELAXATION_BOUND times the safe radius, depending on
+	* whether the distance at the point is exact. A step is replayed as a plain step when the safe spheres of its two ends do not overlap.
+	*/
+	enum class StepMethod
+	{
+		Overstep,
+		Relaxed,
+	};
+	static constexpr float RELAXATION_EXACT = 1.6f;
+	static constexpr float RELAXATION_BOUND = 1.2f;
+
+	explicit SphereMarcher(const CSGSceneView& scene, int nbThread = 0); // 0 means one thread per hardware thread
+
+	void setNormalMethod(NormalMethod normalMethod) { _normalMethod = normalMethod; }
+	[[nodiscard]] NormalMethod getNormalMethod() const { return _normalMethod; }
+
+	void setStepMethod(StepMethod stepMethod) { _stepMethod = stepMethod; }
+	[[nodiscard]] StepMethod getStepMethod() const { return _stepMethod; }
+
+	/*
+	* If 'statistics' is not null, the counters of the marched pixels are added to it.
+	* If 'diagnostics' is not null, the steps, evaluations and termination of every pixel are written in it, at the size of the image.
+	*/
+	void render(const CameraParameters& camera, RenderedImage& image, MarchStatistics* statistics = nullptr, MarchDiagnostics* diagnostics = nullptr) const;
+
+	// Only re-march the pixels of 'region', the other pixels of 'image' (and of 'diagnostics') are kept as they are
+	void renderRegion(const CameraParameters& camera, RenderedImage& image, const ScreenRect& region, MarchStatistics* statistics = nullptr,
+		MarchDiagnostics* diagnostics = nullptr) const;
+
+	// Color of a single pixel, as written by the shader in u_outTexture
+	glm::vec4 marchPixel(const CSGEvaluator& evaluator, const Ray& ray, int imageWidth, int imageHeight) const;
+
+	// March the ray until it hits a surface, leaves the scene or runs out of steps
+	MarchResult marchRay(const CSGEvaluator& evaluator, const Ray& ray, int imageWidth, int imageHeight) const;
+
+	// Color of the pixel whose ray ended at 'march'
+	glm::vec4 shade(const CSGEvaluator& evaluator, const MarchResult& march) const;
+
+	/*
+	* Direction of the gradient of the distance at a hit point (not normalized).
+	* 'dist' is the distance already evaluated at 'pos' and 'epsilon' the step of the finite differences.
+	*/
+	static glm::vec3 estimateGradient(const CSGEvaluator& evaluator, NormalMethod normalMethod, const glm::vec3& pos, float dist, float epsilon);
+
+private:
+	MarchResult marchRayOverstep(const CSGEvaluator& evaluator, const Ray& ray, int imageWidth, int imageHeight) const;
+
+	CSGSceneView _scene;
+	int _nbThread;
+	NormalMethod _normalMethod = NormalMethod::AnalyticGradient;
+	StepMethod _stepMethod = StepMethod::Overstep;
+};
+
+/*
+* How the march of a pixel ended
+*/
+enum class MarchTermination : uint8_t
+{
+	Hit,
+	Escaped, // Past MAX_RAY_LENGTH, background
+	OutOfSteps, // MAX_MARCHING_STEPS used without reaching a surface, drawn in red
+};
+
+struct PixelDiagnostics
+{
+	uint16_t nbStep = 0;
+	uint16_t nbEvaluation = 0; // Points where the tree was evaluated: marching steps, overstep rollbacks and normal taps
+	MarchTermination termination = MarchTermination::Escaped;
+};
+
+/*
+* Histograms over the pixels of a frame. Same layout as the DIAGNOSTICS_BUFFER written by primitiveSphereMarching.comp.glsl when it is
+* compiled with DIAGNOSTICS_DEFINE, so the buffer can be read back directly into this struct.
+*/
+struct MarchHistograms
+{
+	static constexpr int NB_STEP_BIN = SphereMarcher::MAX_MARCHING_STEPS + 1;
+	static constexpr int NB_EVALUATION_BIN = 2 * SphereMarcher::MAX_MARCHING_STEPS + 5; // Every step rolled back, and up to 4 normal taps
+
+	uint32_t steps[NB_STEP_BIN] = {};
+	uint32_t evaluations[NB_EVALUATION_BIN] = {}; // The last bin also counts the pixels with more evaluations
+	uint32_t terminations[3] = {}; // Indexed by MarchTermination
+
+	void add(const PixelDiagnostics& pixel);
+	void merge(const MarchHistograms& other);
+	[[nodiscard]] uint32_t nbPixel() const { return terminations[0] + terminations[1] + terminations[2]; }
+
+	// Smallest number of steps reached or exceeded by 'fraction' of the pixels (0.5 for the median)
+	[[nodiscard]] int stepPercentile(double fraction) const;
+
+	// Multi-line text summary: terminations, mean and percentiles of the steps and evaluations
+	[[nodiscard]] std::string summary() const;
+};
+
+/*
+* Per-pixel instrumentation of a march, to check what an acceleration changes
+*/
+struct MarchDiagnostics
+{
+	// Compile definition of the shader enabling its diagnostics outputs, and their bindings
+	static constexpr const char* DIAGNOSTICS_DEFINE = "CSG_MARCH_DIAGNOSTICS";
+	static constexpr int DIAGNOSTICS_IMAGE_BINDING = 1; // rgba32ui image: steps, evaluations, termination
+	static constexpr int DIAGNOSTICS_BUFFER_BINDING = 11; // MarchHistograms, to be cleared before the dispatch
+
+	int width = 0;
+	int height = 0;
+	std::vector<PixelDiagnostics> pixels; // Row major, as RenderedImage
+
+	MarchDiagnostics() = default;
+	MarchDiagnostics(const int w, const int h) : width{w}, height{h}, pixels(static_cast<size_t>(w) * h) {}
+
+	PixelDiagnostics& at(const int x, const int y) { return pixels[static_cast<size_t>(y) * width + x]; }
+	[[nodiscard]] const PixelDiagnostics& at(const int x, const int y) const { return pixels[static_cast<size_t>(y) * width + x]; }
+
+	[[nodiscard]] MarchHistograms histograms() const;
+
+	// Grayscale image of the steps of every pixel (white for MAX_MARCHING_STEPS), red where the march ran out of steps
+	[[nodiscard]] RenderedImage heatMap() const;
+};
@@ -63,7 +63,7 @@ std::vector<uint8_t> Torus::rawData() const
 {
 	std::vector<uint8_t> rawData = Primitive::rawData();
 
-	std::vector<uint8_t> torusData(5 * sizeof(float)); // major and minor radius + 3 * sizeof(float) for memory alignment in shader
+	std::vector<uint8_t> torusData(4 * sizeof(float)); // major and minor radius + 2 * sizeof(float) for memory alignment in shader
 	memcpy(torusData.data(), &_majorRadius, sizeof(float));
 	memcpy(torusData.data() + sizeof(float), &_minorRadius, sizeof(float));
 
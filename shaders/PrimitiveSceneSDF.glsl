@@ -15,6 +15,9 @@
 #ifndef BINDING_BOXES_BUFFER
     #define BINDING_BOXES_BUFFER 3
 #endif
+#ifndef BINDING_NODE_BOUNDS_BUFFER
+    #define BINDING_NODE_BOUNDS_BUFFER 12
+#endif
 #ifndef TYPE_SPHERE
     #define TYPE_SPHERE 1
 #endif
@@ -39,46 +42,65 @@
 #ifndef TYPE_COMPLEMENTARY
     #define TYPE_COMPLEMENTARY 8
 #endif
+#ifndef TYPE_SMOOTH_INTERSECTION
+    #define TYPE_SMOOTH_INTERSECTION 9
+#endif
+#ifndef TYPE_SMOOTH_UNION
+    #define TYPE_SMOOTH_UNION 10
+#endif
+#ifndef TYPE_SMOOTH_DIFFERENCE
+    #define TYPE_SMOOTH_DIFFERENCE 11
+#endif
+#ifndef TYPE_NARY_INTERSECTION
+    #define TYPE_NARY_INTERSECTION 12
+#endif
+#ifndef TYPE_NARY_UNION
+    #define TYPE_NARY_UNION 13
+#endif
 
 /*************************************************
 * Primitives definition
 *************************************************/
 struct Sphere
 {
-    mat4 inverseTransform;
+    mat3x4 inverseTransform; // Rows of the affine inverse transform: localPos = vec4(worldPos, 1.) * inverseTransform
     vec3 color;
+    float scale; // Distance correction of the local SDF, precomputed on the CPU (distanceScale() of CSGPrimitiveSDF.hpp)
     float radius;
 };
 
 struct Torus
 {
-    mat4 inverseTransform;
+    mat3x4 inverseTransform;
     vec3 color;
+    float scale;
     float majorRadius; // Distance from the center of the torus to the center of the tube
     float minorRadius; // Radius of the tube
 };
 
 struct Cylinder
 {
-    mat4 inverseTransform;
+    mat3x4 inverseTransform;
     vec3 color;
+    float scale;
     float height;
     float radius;
 };
 
 struct Box
 {
-    mat4 inverseTransform;
+    mat3x4 inverseTransform;
     vec3 color;
+    float scale;
     vec3 size; // local length in X, Y and Z
 };
 
 struct Node
 {
     int type;
-    int leftChildIndex;
-    int rightChildIndex;
-    int primitiveIndex;
+    int leftChildIndex; // First leaf of an n-ary operation
+    int rightChildIndex; // Last leaf of an n-ary operation
+    int primitiveIndex; // Bits of the blend radius for the smooth operations, see blendRadius()
 };
 
 /*************************************************
@@ -121,6 +143,12 @@ layout(std430, binding = 9) buffer CSGSTACK
     SmallNode csgNodeStack[];
 };
 
+// Gradient of each node, same indexing as csgNodeStack, only written by scanSDFGradient
+layout(std430, binding = 10) buffer CSGGRADIENTSTACK
+{
+    vec4 csgGradientStack[];
+};
+
 uniform int u_nbOfNode;
 
 // Return the signed distance from a sphere
@@ -155,14 +183,76 @@ float boxSDF(in Box box, in vec3 pos)
     return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);
 }
 
+/*************************************************
+* Analytic gradients of the primitive SDFs, in local space
+*************************************************/
+vec3 safeNormalize(in vec3 v)
+{
+    float l = length(v);
+    return l > 0. ? v / l : vec3(0., 1., 0.);
+}
+
+vec3 sphereGradient(in vec3 p)
+{
+    return safeNormalize(p);
+}
+
+vec3 torusGradient(in Torus torus, in vec3 p)
+{
+    float radialLength = length(p.xz);
+    vec2 radialDirection = radialLength > 0. ? p.xz / radialLength : vec2(1., 0.);
+    vec2 q = vec2(radialLength - torus.majorRadius, p.y); // Position in the plane of the tube section
+    float qLength = length(q);
+    vec2 sectionGradient = qLength > 0. ? q / qLength : vec2(1., 0.);
+    return vec3(sectionGradient.x * radialDirection.x, sectionGradient.y, sectionGradient.x * radialDirection.y);
+}
+
+// Gradient of a 2D box SDF given the distance vector to its corner, in the quadrant of the point
+vec2 boxGradient2D(in vec2 w)
+{
+    if (max(w.x, w.y) > 0.) // Outside: direction to the closest point
+        return normalize(max(w, 0.));
+    return w.x > w.y ? vec2(1., 0.) : vec2(0., 1.); // Inside: normal of the closest face
+}
+
+vec3 cylinderGradient(in Cylinder cylinder, in vec3 pos)
+{
+    float radialLength = length(pos.xz);
+    vec2 radialDirection = radialLength > 0. ? pos.xz / radialLength : vec2(1., 0.);
+    vec2 gradient2D = boxGradient2D(vec2(radialLength, abs(pos.y)) - vec2(cylinder.radius, cylinder.height));
+    return vec3(gradient2D.x * radialDirection.x, pos.y < 0. ? -gradient2D.y : gradient2D.y, gradient2D.x * radialDirection.y);
+}
+
+vec3 boxGradient(in Box box, in vec3 pos)
+{
+    vec3 w = abs(pos) - box.size;
+    float g = max(w.x, max(w.y, w.z));
+
+    vec3 quadrantGradient;
+    if (g > 0.) // Outside: direction to the closest point
+        quadrantGradient = normalize(max(w, 0.));
+    else if (w.x > w.y && w.x > w.z) // Inside: normal of the closest face
+        quadrantGradient = vec3(1., 0., 0.);
+    else if (w.y > w.z)
+        quadrantGradient = vec3(0., 1., 0.);
+    else
+        quadrantGradient = vec3(0., 0., 1.);
+
+    return mix(quadrantGradient, -quadrantGradient, lessThan(pos, vec3(0.)));
+}
+
+// Bring a local gradient back to world space: d(world) = scale * d(inverseTransform * world), the rows are the columns of the transposed linear part
+vec3 transformGradient(in vec3 localGradient, in mat3x4 inverseTransform, in float scale)
+{
+    return scale * (mat3(inverseTransform) * localGradient);
+}
+
 //  Place a primitive in the scene given its transformation matrix, by actually adapting the ray that is actually casted and not the primitive in itself
-void transformRay(in vec3 worldPos, in mat4 inverseTransform, out vec3 localPos, out float scale)
+vec3 transformRay(in vec3 worldPos, in mat3x4 inverseTransform)
 {
     // Instead of moving the object, we are moving the ray so we keep simple SDF functions
-    localPos = (inverseTransform * vec4(worldPos, 1.)).xyz;
-    // Compute the scale of the transform
-    vec3 scaleVec = vec3(length(inverseTransform[0]), length(inverseTransform[1]), length(inverseTransform[2]));
-    scale = min(scaleVec.x, min(scaleVec.y, scaleVec.z));
+    // The scale correction of the distance is stored in the primitive records, it is not computed again at every evaluation
+    return vec4(worldPos, 1.) * inverseTransform;
 }
 
 // Intersection of 2 primitives
@@ -189,8 +279,49 @@ float complementarySDF(in float a)
     return -a;
 }
 
+// Blend radius of a smooth operation, stored in place of the primitive index
+float blendRadius(in Node node)
+{
+    return intBitsToFloat(node.primitiveIndex);
+}
+
+// Smooth union of 2 primitives with a blend radius k (polynomial smooth min): min(a,b) where |a - b| >= k, at most k / 4 below it
+// h is the weight of a in the blend, for the color and the gradient
+float smoothUnionSDF(in float a, in float b, in float k, out float h)
+{
+    h = clamp(0.5 + 0.5 * (b - a) / k, 0., 1.);
+    return mix(b, a, h) - k * h * (1. - h);
+}
+
+// Smooth intersection of 2 primitives, max(a,b) where |a - b| >= k, at most k / 4 above it
+float smoothIntersectionSDF(in float a, in float b, in float k, out float h)
+{
+    h = clamp(0.5 - 0.5 * (b - a) / k, 0., 1.);
+    return mix(b, a, h) + k * h * (1. - h);
+}
+
+// Smooth difference of 2 primitives, the weight of -b is 1 - h
+float smoothDifferenceSDF(in float a, in float b, in float k, out float h)
+{
+    return smoothIntersectionSDF(a, -b, k, h);
+}
+
+// Same operations at four points
+vec4 smoothUnionSDF(in vec4 a, in vec4 b, in float k)
+{
+    vec4 h = clamp(0.5 + 0.5 * (b - a) / k, 0., 1.);
+    return mix(b, a, h) - k * h * (1. - h);
+}
+
+vec4 smoothIntersectionSDF(in vec4 a, in vec4 b, in float k)
+{
+    vec4 h = clamp(0.5 - 0.5 * (b - a) / k, 0., 1.);
+    return mix(b, a, h) + k * h * (1. - h);
+}
+
 // Scan a node of the CSG tree and return its distance, begin at the root of the tree
-void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
+// If computeGradient is true, the gradient of the node is also written in csgGradientStack
+void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex, in bool computeGradient)
 {
     vec3 localPos;
     float scale;
@@ -204,12 +335,16 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
 
         Sphere sphere = spheresData[index];
 
-        transformRay(pos, sphere.inverseTransform, localPos, scale);
+        localPos = transformRay(pos, sphere.inverseTransform);
+        scale = sphere.scale;
 
         csgNodeStack[stackStartIndex + nodeIndex].color = sphere.color;
 
         float dist = sphereSDF(sphere, localPos) * scale;
         csgNodeStack[stackStartIndex + nodeIndex].dist = dist;
+
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = vec4(transformGradient(sphereGradient(localPos), sphere.inverseTransform, scale), 0.);
         break;
     }
     case TYPE_TORUS:
@@ -219,12 +354,16 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
 
         Torus torus = torusesData[index];
 
-        transformRay(pos, torus.inverseTransform, localPos, scale);
+        localPos = transformRay(pos, torus.inverseTransform);
+        scale = torus.scale;
 
         csgNodeStack[stackStartIndex + nodeIndex].color = torus.color;
 
         float dist = torusSDF(torus, localPos) * scale;
         csgNodeStack[stackStartIndex + nodeIndex].dist = dist;
+
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = vec4(transformGradient(torusGradient(torus, localPos), torus.inverseTransform, scale), 0.);
         break;
     }
     case TYPE_CYLINDER:
@@ -233,12 +372,16 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
 
         Cylinder cylinder = cylindersData[index];
 
-        transformRay(pos, cylinder.inverseTransform, localPos, scale);
+        localPos = transformRay(pos, cylinder.inverseTransform);
+        scale = cylinder.scale;
 
         csgNodeStack[stackStartIndex + nodeIndex].color = cylinder.color;
 
         float dist = cylinderSDF(cylinder, localPos) * scale;
         csgNodeStack[stackStartIndex + nodeIndex].dist = dist;
+
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = vec4(transformGradient(cylinderGradient(cylinder, localPos), cylinder.inverseTransform, scale), 0.);
         break;
     }
     case TYPE_BOX:
@@ -247,12 +390,16 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
 
         Box box = boxesData[index];
 
-        transformRay(pos, box.inverseTransform, localPos, scale);
+        localPos = transformRay(pos, box.inverseTransform);
+        scale = box.scale;
 
         csgNodeStack[stackStartIndex + nodeIndex].color = box.color;
 
         float dist = boxSDF(box, localPos) * scale;
         csgNodeStack[stackStartIndex + nodeIndex].dist = dist;
+
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = vec4(transformGradient(boxGradient(box, localPos), box.inverseTransform, scale), 0.);
         break;
     }
     case TYPE_INTERSECTION:
@@ -271,6 +418,10 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
         else
             csgNodeStack[stackStartIndex + nodeIndex].color = csgNodeStack[stackStartIndex + index2].color;
 
+        // max is piecewise: forward the gradient of the selected child
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = csgGradientStack[stackStartIndex + (result == a ? index1 : index2)];
+
         csgNodeStack[stackStartIndex + nodeIndex].dist = result;
         break;
     }
@@ -290,6 +441,10 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
         else
             csgNodeStack[stackStartIndex + nodeIndex].color = csgNodeStack[stackStartIndex + index2].color;
 
+        // min is piecewise: forward the gradient of the selected child
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = csgGradientStack[stackStartIndex + (result == a ? index1 : index2)];
+
         csgNodeStack[stackStartIndex + nodeIndex].dist = result;
         break;
     }
@@ -309,6 +464,10 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
         else
             csgNodeStack[stackStartIndex + nodeIndex].color = csgNodeStack[stackStartIndex + index2].color;
 
+        // max(a, -b): forward the gradient of a, or the opposite of the gradient of b
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = result == a ? csgGradientStack[stackStartIndex + index1] : -csgGradientStack[stackStartIndex + index2];
+
         csgNodeStack[stackStartIndex + nodeIndex].dist = result;
         break;
     }
@@ -323,6 +482,68 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
 
         csgNodeStack[stackStartIndex + nodeIndex].color = vec3(0.f, 0.f, 0.f);
 
+        csgNodeStack[stackStartIndex + nodeIndex].dist = result;
+
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = -csgGradientStack[stackStartIndex + index];
+        break;
+    }
+    case TYPE_SMOOTH_INTERSECTION:
+    case TYPE_SMOOTH_UNION:
+    case TYPE_SMOOTH_DIFFERENCE:
+    {
+        // Blend of the two children: the colors and the gradients are mixed with the weights of the distances
+        int index1 = nodesData[nodeIndex].leftChildIndex;
+        int index2 = nodesData[nodeIndex].rightChildIndex;
+
+        float a = csgNodeStack[stackStartIndex + index1].dist;
+        float b = csgNodeStack[stackStartIndex + index2].dist;
+        float k = blendRadius(nodesData[nodeIndex]);
+
+        float h;
+        float result;
+        if (nodesData[nodeIndex].type == TYPE_SMOOTH_UNION)
+            result = smoothUnionSDF(a, b, k, h);
+        else if (nodesData[nodeIndex].type == TYPE_SMOOTH_INTERSECTION)
+            result = smoothIntersectionSDF(a, b, k, h);
+        else
+            result = smoothDifferenceSDF(a, b, k, h);
+
+        csgNodeStack[stackStartIndex + nodeIndex].color = mix(csgNodeStack[stackStartIndex + index2].color, csgNodeStack[stackStartIndex + index1].color, h);
+
+        if (computeGradient)
+        {
+            vec4 gradientB = csgGradientStack[stackStartIndex + index2];
+            if (nodesData[nodeIndex].type == TYPE_SMOOTH_DIFFERENCE)
+                gradientB = -gradientB;
+            csgGradientStack[stackStartIndex + nodeIndex] = mix(gradientB, csgGradientStack[stackStartIndex + index1], h);
+        }
+
+        csgNodeStack[stackStartIndex + nodeIndex].dist = result;
+        break;
+    }
+    case TYPE_NARY_INTERSECTION:
+    case TYPE_NARY_UNION:
+    {
+        // The children are the consecutive leaves leftChildIndex to rightChildIndex, the first one giving the distance wins
+        bool unionNode = nodesData[nodeIndex].type == TYPE_NARY_UNION;
+        int selected = nodesData[nodeIndex].leftChildIndex;
+        float result = csgNodeStack[stackStartIndex + selected].dist;
+        for (int child = selected + 1; child <= nodesData[nodeIndex].rightChildIndex; child++)
+        {
+            float dist = csgNodeStack[stackStartIndex + child].dist;
+            if (unionNode ? dist < result : dist > result)
+            {
+                result = dist;
+                selected = child;
+            }
+        }
+
+        csgNodeStack[stackStartIndex + nodeIndex].color = csgNodeStack[stackStartIndex + selected].color;
+
+        if (computeGradient)
+            csgGradientStack[stackStartIndex + nodeIndex] = csgGradientStack[stackStartIndex + selected];
+
         csgNodeStack[stackStartIndex + nodeIndex].dist = result;
         break;
     }
@@ -330,6 +551,8 @@ void scanCSG(in int nodeIndex, in vec3 pos, int stackStartIndex)
     return;
 }
 
+// The generated code of CSGShaderGenerator replaces scanSDF and scanSDFGradient with straight-line versions for a given tree topology
+#ifndef CSG_SPECIALIZED_SCENE
 // Return smallest distance from a primitive
 float scanSDF(vec3 pos, out vec3 hitColor)
 {
@@ -348,7 +571,7 @@ float scanSDF(vec3 pos, out vec3 hitColor)
     // because the first element of the ssbo is a leaf of the tree, we start from the start of ssbo and compute it until we reach the root
     for(int i = 0; i < u_nbOfNode; i++)
     {
-        scanCSG(i, pos, stackStartIndex);
+        scanCSG(i, pos, stackStartIndex, false);
     }
 
     if(csgNodeStack[stackStartIndex + u_nbOfNode-1].dist < minDistance) // If the result of the CSG tree is closer than what is previously found
@@ -359,5 +582,181 @@ float scanSDF(vec3 pos, out vec3 hitColor)
 
     return minDistance;
 }
+#endif // CSG_SPECIALIZED_SCENE
+
+#ifdef CSG_SPECIALIZED_SCENE
+/*************************************************
+* Short-circuit guards of the generated scanSDF, see CSGShortCircuit
+*************************************************/
+// Four vec4 per node, written by CSGShortCircuit::nodeBoundsBuffer()
+struct NodeBounds
+{
+    vec4 boundsMin; // w: 1 if the distance of the node is exact outside of it
+    vec4 boundsMax;
+    vec4 leafBoundsMin; // w: Lipschitz constant of the node
+    vec4 leafBoundsMax; // w: smooth margin of the node
+};
+
+layout(std430, binding = BINDING_NODE_BOUNDS_BUFFER) buffer nodeBoundsSSBO
+{
+    NodeBounds nodeBoundsData[];
+};
+
+// Margin of the guards at pos, covering the rounding of the distances
+float guardMargin(in vec3 pos)
+{
+    return 1e-4 * (1. + length(pos));
+}
+
+// Upper bound of |d| for a node: its distance is zero on the surface of its leaves, which are inside the bounds of its leaves
+float upperBound(in NodeBounds bounds, in vec3 pos, in float margin)
+{
+    vec3 farthest = max(abs(pos - bounds.leafBoundsMin.xyz), abs(pos - bounds.leafBoundsMax.xyz));
+    return bounds.leafBoundsMin.w * length(farthest) + bounds.leafBoundsMax.w + margin;
+}
+
+// Lower bound of d for a node: positive outside of its bounds, and at least as far as its bounds where it is exact
+float lowerBound(in NodeBounds bounds, in vec3 pos, in float margin)
+{
+    float lower = -upperBound(bounds, pos, margin);
+    float boundsDistance = length(max(max(bounds.boundsMin.xyz - pos, pos - bounds.boundsMax.xyz), vec3(0.)));
+    if (boundsDistance <= margin)
+        return lower;
+    return max(lower, bounds.boundsMin.w != 0. ? boundsDistance - margin : 0.);
+}
+#endif // CSG_SPECIALIZED_SCENE
+
+// Distances of a node at four points, the primitive record and its scale are fetched once for the four points
+// The four distances of each node are stored in csgGradientStack, which is not used by the normal path at the same time
+void scanCSG4(in int nodeIndex, in vec3 p0, in vec3 p1, in vec3 p2, in vec3 p3, int stackStartIndex)
+{
+    vec3 localPos;
+    float scale;
+    vec4 result = vec4(FLOAT_INFINITY);
+    int leftIndex = stackStartIndex + nodesData[nodeIndex].leftChildIndex;
+    int rightIndex = stackStartIndex + nodesData[nodeIndex].rightChildIndex;
+
+    switch (nodesData[nodeIndex].type)
+    {
+    case TYPE_SPHERE:
+    {
+        Sphere sphere = spheresData[nodesData[nodeIndex].primitiveIndex];
+        localPos = transformRay(p0, sphere.inverseTransform);
+        scale = sphere.scale;
+        result = vec4(sphereSDF(sphere, localPos),
+                      sphereSDF(sphere, transformRay(p1, sphere.inverseTransform)),
+                      sphereSDF(sphere, transformRay(p2, sphere.inverseTransform)),
+                      sphereSDF(sphere, transformRay(p3, sphere.inverseTransform))) * scale;
+        break;
+    }
+    case TYPE_TORUS:
+    {
+        Torus torus = torusesData[nodesData[nodeIndex].primitiveIndex];
+        localPos = transformRay(p0, torus.inverseTransform);
+        scale = torus.scale;
+        result = vec4(torusSDF(torus, localPos),
+                      torusSDF(torus, transformRay(p1, torus.inverseTransform)),
+                      torusSDF(torus, transformRay(p2, torus.inverseTransform)),
+                      torusSDF(torus, transformRay(p3, torus.inverseTransform))) * scale;
+        break;
+    }
+    case TYPE_CYLINDER:
+    {
+        Cylinder cylinder = cylindersData[nodesData[nodeIndex].primitiveIndex];
+        localPos = transformRay(p0, cylinder.inverseTransform);
+        scale = cylinder.scale;
+        result = vec4(cylinderSDF(cylinder, localPos),
+                      cylinderSDF(cylinder, transformRay(p1, cylinder.inverseTransform)),
+                      cylinderSDF(cylinder, transformRay(p2, cylinder.inverseTransform)),
+                      cylinderSDF(cylinder, transformRay(p3, cylinder.inverseTransform))) * scale;
+        break;
+    }
+    case TYPE_BOX:
+    {
+        Box box = boxesData[nodesData[nodeIndex].primitiveIndex];
+        localPos = transformRay(p0, box.inverseTransform);
+        scale = box.scale;
+        result = vec4(boxSDF(box, localPos),
+                      boxSDF(box, transformRay(p1, box.inverseTransform)),
+                      boxSDF(box, transformRay(p2, box.inverseTransform)),
+                      boxSDF(box, transformRay(p3, box.inverseTransform))) * scale;
+        break;
+    }
+    case TYPE_INTERSECTION:
+        result = max(csgGradientStack[leftIndex], csgGradientStack[rightIndex]);
+        break;
+    case TYPE_UNION:
+        result = min(csgGradientStack[leftIndex], csgGradientStack[rightIndex]);
+        break;
+    case TYPE_DIFFERENCE:
+        result = max(csgGradientStack[leftIndex], -csgGradientStack[rightIndex]);
+        break;
+    case TYPE_COMPLEMENTARY:
+        result = -csgGradientStack[leftIndex];
+        break;
+    case TYPE_SMOOTH_INTERSECTION:
+        result = smoothIntersectionSDF(csgGradientStack[leftIndex], csgGradientStack[rightIndex], blendRadius(nodesData[nodeIndex]));
+        break;
+    case TYPE_SMOOTH_UNION:
+        result = smoothUnionSDF(csgGradientStack[leftIndex], csgGradientStack[rightIndex], blendRadius(nodesData[nodeIndex]));
+        break;
+    case TYPE_SMOOTH_DIFFERENCE:
+        result = smoothIntersectionSDF(csgGradientStack[leftIndex], -csgGradientStack[rightIndex], blendRadius(nodesData[nodeIndex]));
+        break;
+    case TYPE_NARY_INTERSECTION:
+        result = csgGradientStack[leftIndex];
+        for (int child = leftIndex + 1; child <= rightIndex; child++)
+            result = max(result, csgGradientStack[child]);
+        break;
+    case TYPE_NARY_UNION:
+        result = csgGradientStack[leftIndex];
+        for (int child = leftIndex + 1; child <= rightIndex; child++)
+            result = min(result, csgGradientStack[child]);
+        break;
+    }
+
+    csgGradientStack[stackStartIndex + nodeIndex] = result;
+}
+
+// Normal from the distances at the vertices of a tetrahedron around pos, evaluated in a single pass over the tree
+// Fallback for primitives without an analytic gradient, points in the same direction as the gradient
+vec3 tetrahedralNormal(vec3 pos, float h)
+{
+    const vec3 k0 = vec3(1., -1., -1.);
+    const vec3 k1 = vec3(-1., -1., 1.);
+    const vec3 k2 = vec3(-1., 1., -1.);
+    const vec3 k3 = vec3(1., 1., 1.);
+
+    ivec2 coords2D = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 dims = imageSize(u_outTexture);
+    int stackStartIndex = (coords2D.x + coords2D.y * dims.x) * u_nbOfNode;
+
+    for(int i = 0; i < u_nbOfNode; i++)
+    {
+        scanCSG4(i, pos + h * k0, pos + h * k1, pos + h * k2, pos + h * k3, stackStartIndex);
+    }
+
+    vec4 d = csgGradientStack[stackStartIndex + u_nbOfNode-1];
+    return normalize(k0 * d.x + k1 * d.y + k2 * d.z + k3 * d.w);
+}
+
+#ifndef CSG_SPECIALIZED_SCENE
+// Same as scanSDF, but also return the analytic gradient of the distance, in the same pass over the tree
+float scanSDFGradient(vec3 pos, out vec3 hitColor, out vec3 gradient)
+{
+    ivec2 coords2D = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 dims = imageSize(u_outTexture);
+    int stackStartIndex = (coords2D.x + coords2D.y * dims.x) * u_nbOfNode;
+
+    for(int i = 0; i < u_nbOfNode; i++)
+    {
+        scanCSG(i, pos, stackStartIndex, true);
+    }
+
+    hitColor = csgNodeStack[stackStartIndex + u_nbOfNode-1].color;
+    gradient = csgGradientStack[stackStartIndex + u_nbOfNode-1].xyz;
+    return csgNodeStack[stackStartIndex + u_nbOfNode-1].dist;
+}
+#endif // CSG_SPECIALIZED_SCENE
 
 #endif // PRIMITIVE_SCENE_SDF_GLSL_
\ No newline at end of file
@@ -10,6 +10,7 @@
 uniform mat4 u_viewMat;
 // uniform mat4 u_projectionMat;
 uniform float u_fieldOfView;
+uniform ivec2 u_regionOffset; // First pixel of the re-rendered region, the rest of u_outTexture is kept from the previous frame (0 for a full frame)
 
 /* In */
 layout(local_size_x = 16, local_size_y = 16) in;
@@ -17,6 +18,32 @@ layout(local_size_x = 16, local_size_y = 16) in;
 /* Out */
 layout(binding = 0, rgba32f) writeonly uniform image2D u_outTexture; // Output image
 
+/* Diagnostics, see MarchDiagnostics */
+#define TERMINATION_HIT 0u
+#define TERMINATION_ESCAPED 1u
+#define TERMINATION_OUT_OF_STEPS 2u
+#ifdef CSG_MARCH_DIAGNOSTICS
+#define NB_STEP_BIN (MAX_MARCHING_STEPS + 1)
+#define NB_EVALUATION_BIN (2 * MAX_MARCHING_STEPS + 5)
+layout(binding = 1, rgba32ui) writeonly uniform uimage2D u_diagnosticsTexture; // Steps, evaluations and termination of every pixel
+layout(std430, binding = 11) buffer DIAGNOSTICS // Histograms over the frame (MarchHistograms), cleared before the dispatch
+{
+    uint stepHistogram[NB_STEP_BIN];
+    uint evaluationHistogram[NB_EVALUATION_BIN];
+    uint terminationCounts[3];
+};
+
+void writeDiagnostics(in ivec2 pixel, in int nbStep, in int nbEvaluation, in uint termination)
+{
+    imageStore(u_diagnosticsTexture, pixel, uvec4(uint(nbStep), uint(nbEvaluation), termination, 0u));
+    atomicAdd(stepHistogram[min(nbStep, NB_STEP_BIN - 1)], 1u);
+    atomicAdd(evaluationHistogram[min(nbEvaluation, NB_EVALUATION_BIN - 1)], 1u);
+    atomicAdd(terminationCounts[termination], 1u);
+}
+#else
+#define writeDiagnostics(pixel, nbStep, nbEvaluation, termination)
+#endif
+
 #include "../Common/PrimitiveSceneSDF.glsl"
 
 mat4 buildTranslation(in float x, in float y, in float z)
@@ -63,10 +90,12 @@ mat4 rotationZ( in float angle ) {
 void main()
 {
 	/* Current pixel coordinates */
-	const ivec2 currentPixel = ivec2(gl_GlobalInvocationID.xy);
+	const ivec2 currentPixel = ivec2(gl_GlobalInvocationID.xy) + u_regionOffset;
 
     /* Output image properties */
     ivec2 dims = imageSize(u_outTexture);
+    if (any(greaterThanEqual(currentPixel, dims))) // The last workgroups of a region can go past the image
+        return;
 	const float aspectRatio = float(dims.x) / float(dims.y);
 
     /* Coordinates of current pixel */
@@ -80,17 +109,20 @@ void main()
     /* Sphere Marching */
     float last_delta = 0.; // Last delta is added to the next step to implement Sphere oversteping
     float depth = 0.;
+    int nbEvaluation = 0; // Tree evaluations, only written out with the diagnostics
     for (int i = 0; i < MAX_MARCHING_STEPS; i++)
     {
         vec3 currentPos = ray.origin + (depth + last_delta) * ray.direction;
         vec3 hitColor;
         float minDistance = scanSDF(currentPos, hitColor);
+        nbEvaluation++;
 
         // oversteping failed : go back
         if (minDistance < last_delta) {
 
             currentPos = ray.origin + depth * ray.direction;
             minDistance = scanSDF(currentPos, hitColor);
+            nbEvaluation++;
         }
 
         // adaptative epsilon (alway keep an epsilon close to pixel size)
@@ -99,16 +131,15 @@ void main()
         // Detect a hit
         if (abs(minDistance) < epsilon)
         {
-            // Compute normals
-            float scan_epsilon = epsilon;
-            float dx = scanSDF(currentPos + vec3(scan_epsilon, 0, 0), hitColor);
-            float dy = scanSDF(currentPos + vec3(0, scan_epsilon, 0), hitColor);
-            float dz = scanSDF(currentPos + vec3(0, 0, scan_epsilon), hitColor);
-            vec3 hitNormal = normalize(vec3(minDistance - dx, minDistance - dy, minDistance - dz));
+            // Compute normals: one evaluation with the analytic gradient instead of three finite difference taps
+            vec3 gradient;
+            scanSDFGradient(currentPos, hitColor, gradient);
+            vec3 hitNormal = -normalize(gradient); // Same orientation as the former forward differences (minDistance - scanSDF(currentPos + epsilon))
 
             float light = clamp(dot(hitNormal, normalize(vec3(1))), 0.2, 1.); // Cheap light calculation
 
             imageStore(u_outTexture, currentPixel, vec4(hitColor * light, 1));
+            writeDiagnostics(currentPixel, i + 1, nbEvaluation + 1, TERMINATION_HIT);
             return;
         }
 
@@ -118,8 +149,10 @@ void main()
 
         if (depth >= MAX_RAY_LENGTH) {
             imageStore(u_outTexture, currentPixel, vec4(0., 0., 0., 0.)); // background
+            writeDiagnostics(currentPixel, i + 1, nbEvaluation, TERMINATION_ESCAPED);
             return;
         }
     }
     imageStore(u_outTexture, currentPixel, vec4(1., 0., 0., 1.)); // Draw red when we hit background
+    writeDiagnostics(currentPixel, MAX_MARCHING_STEPS, nbEvaluation, TERMINATION_OUT_OF_STEPS);
 }
\ No newline at end of file
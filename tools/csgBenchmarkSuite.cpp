@@ -0,0 +1,68 @@
+/*
+* Benchmark suite on synthetic CSG scenes (see CSGBenchmarkSuite), for regression tracking.
+*
+* Usage:
+*     csgBenchmarkSuite [--json <results.json>] [--filter <substring>] [--min-time <seconds>]
+*
+* Options:
+*     --json <results.json>     also write the results in the JSON format of google-benchmark
+*     --filter <substring>      only run the cases whose name contains the substring, e.g. "randomTree/" or "/evaluate"
+*     --min-time <seconds>      minimum run time of each case, default 0.2
+*
+* Two result files can be compared with tools/compare.py of google-benchmark: compare.py benchmarks before.json after.json
+*/
+#include "renderer/opengl/Primitives/CSGBenchmarkSuite.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+static void printUsage()
+{
+	std::cerr << "Usage: csgBenchmarkSuite [--json <results.json>] [--filter <substring>] [--min-time <seconds>]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	std::string jsonPath;
+	CSGBenchmarkSuite suite;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << option << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+		const std::string value = argv[++i];
+
+		if (option == "--json")
+			jsonPath = value;
+		else if (option == "--filter")
+			suite.setFilter(value);
+		else if (option == "--min-time")
+			suite.setMinTime(std::atof(value.c_str()));
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (suite.run(&std::cout).empty())
+	{
+		std::cerr << "No benchmark matches the filter" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string error;
+	if (!jsonPath.empty() && !suite.writeJson(jsonPath, error))
+	{
+		std::cerr << error << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
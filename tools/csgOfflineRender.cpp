@@ -0,0 +1,311 @@
+/*
+* Headless offline renderer: render a CSG scene file along a camera path with the CPU sphere marcher (or ray tracer), without any window
+* or ImGui context.
+*
+* Usage:
+*     csgOfflineRender --scene <scene.csg|scene.csgb> (--cameras <path.cam> | --turntable <nbFrame>) [options]
+*     csgOfflineRender --scene <scene.csg> --export <scene.csgb>
+*     csgOfflineRender --scene <scene.csg> --export-expression <part.hpp>
+*     csgOfflineRender --scene <scene.csg|scene.csgb> --export-mesh <mesh.obj> [--mesh-resolution <cells>] [--sharp-features 0|1]
+*
+* Text scenes (.csg, see CSGSceneFile) are parsed, binary scenes (.csgb, see CSGBinaryScene) are memory mapped and rendered in place.
+*
+* Options:
+*     --width <pixels>          default 640
+*     --height <pixels>         default 480
+*     --format png|exr|raw      default png
+*     --output <directory>      default current directory, must exist
+*     --threads <count>         render threads, default one per hardware thread
+*     --renderer march|trace    sphere marching (SphereMarcher) or exact ray tracing (CSGRayTracer), default march. Scenes with
+*                               smooth operations are always marched, the ray tracer does not render the blends.
+*     --diagnostics 0|1         record the steps, evaluations and termination of every marched pixel (see MarchDiagnostics) and
+*                               print their histograms over the sequence, default 0
+*     --queue <frames>          frames allowed to wait for their encoding, default 2
+*     --radius <distance>       turntable radius, default 8
+*     --elevation <height>      turntable camera height, default 2
+*     --export <scene.csgb>     write the scene in the binary format, then render if a camera path is given
+*     --export-expression <part.hpp>
+*                               write the scene as a compile-time CSGExpression, the function is named after the file
+*     --export-mesh <mesh.obj>  write a triangle mesh of the scene (see CSGMesher), streamed to the file branch by branch
+*     --mesh-resolution <cells> cells along the largest side of the scene, a power of two, default 256
+*     --sharp-features 0|1      keep the edges and corners of the mesh, default 0
+*
+* The frames are encoded on a separate thread while the next one is rendered. For each frame, the render time and the number of
+* marching steps (or of leaf intersections when tracing) per pixel are printed, followed by a summary of the whole sequence.
+*/
+#include "renderer/opengl/Primitives/CSGSceneFile.hpp"
+#include "renderer/opengl/Primitives/CSGSceneData.hpp"
+#include "renderer/opengl/Primitives/CSGBinaryScene.hpp"
+#include "renderer/opengl/Primitives/CameraPath.hpp"
+#include "renderer/opengl/Primitives/SphereMarcher.hpp"
+#include "renderer/opengl/Primitives/CSGRayTracer.hpp"
+#include "renderer/opengl/Primitives/FrameWriter.hpp"
+#include "renderer/opengl/Primitives/CSGExpression.hpp"
+#include "renderer/opengl/Primitives/CSGMesher.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+
+static void printUsage()
+{
+	std::cerr << "Usage: csgOfflineRender --scene <scene.csg|scene.csgb> (--cameras <path.cam> | --turntable <nbFrame>)\n"
+		"       [--width <pixels>] [--height <pixels>] [--format png|exr|raw] [--output <directory>]\n"
+		"       [--threads <count>] [--renderer march|trace] [--diagnostics 0|1] [--queue <frames>] [--radius <distance>] [--elevation <height>] [--export <scene.csgb>]\n"
+		"       [--export-expression <part.hpp>] [--export-mesh <mesh.obj>] [--mesh-resolution <cells>] [--sharp-features 0|1]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	std::string scenePath;
+	std::string cameraPath;
+	std::string outputDirectory;
+	std::string formatName = "png";
+	std::string exportPath;
+	std::string expressionPath;
+	std::string meshPath;
+	int meshResolution = 256;
+	bool sharpFeatures = false;
+	int nbTurntableFrame = 0;
+	int width = 640;
+	int height = 480;
+	int nbThread = 0;
+	std::string rendererName = "march";
+	bool recordDiagnostics = false;
+	int maxPendingFrame = 2;
+	float turntableRadius = 8.f;
+	float turntableElevation = 2.f;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << option << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+		const std::string value = argv[++i];
+
+		if (option == "--scene")
+			scenePath = value;
+		else if (option == "--cameras")
+			cameraPath = value;
+		else if (option == "--turntable")
+			nbTurntableFrame = std::atoi(value.c_str());
+		else if (option == "--width")
+			width = std::atoi(value.c_str());
+		else if (option == "--height")
+			height = std::atoi(value.c_str());
+		else if (option == "--format")
+			formatName = value;
+		else if (option == "--output")
+			outputDirectory = value;
+		else if (option == "--threads")
+			nbThread = std::atoi(value.c_str());
+		else if (option == "--renderer")
+			rendererName = value;
+		else if (option == "--diagnostics")
+			recordDiagnostics = std::atoi(value.c_str()) != 0;
+		else if (option == "--queue")
+			maxPendingFrame = std::atoi(value.c_str());
+		else if (option == "--radius")
+			turntableRadius = static_cast<float>(std::atof(value.c_str()));
+		else if (option == "--elevation")
+			turntableElevation = static_cast<float>(std::atof(value.c_str()));
+		else if (option == "--export")
+			exportPath = value;
+		else if (option == "--export-expression")
+			expressionPath = value;
+		else if (option == "--export-mesh")
+			meshPath = value;
+		else if (option == "--mesh-resolution")
+			meshResolution = std::atoi(value.c_str());
+		else if (option == "--sharp-features")
+			sharpFeatures = std::atoi(value.c_str()) != 0;
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	ImageFormat format;
+	const bool hasCameras = !cameraPath.empty() || nbTurntableFrame > 0;
+	if (scenePath.empty() || (!cameraPath.empty() && nbTurntableFrame > 0) || (!hasCameras && exportPath.empty() && expressionPath.empty() && meshPath.empty())
+		|| width <= 0 || height <= 0 || !FrameWriter::parseFormat(formatName, format) || (rendererName != "march" && rendererName != "trace"))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	CSGSceneData parsedScene;
+	CSGBinaryScene mappedScene;
+	CSGSceneView sceneView;
+	std::string error;
+	const bool isBinaryScene = scenePath.size() >= 5 && scenePath.compare(scenePath.size() - 5, 5, ".csgb") == 0;
+	if (isBinaryScene)
+	{
+		if (!mappedScene.open(scenePath, error))
+		{
+			std::cerr << error << std::endl;
+			return EXIT_FAILURE;
+		}
+		sceneView = mappedScene.view();
+	}
+	else
+	{
+		CSGTree tree;
+		if (!CSGSceneFile::load(scenePath, tree, error))
+		{
+			std::cerr << scenePath << ": " << error << std::endl;
+			return EXIT_FAILURE;
+		}
+		parsedScene = CSGSceneData{tree};
+		sceneView = parsedScene.view();
+	}
+
+	if (!exportPath.empty())
+	{
+		if (!CSGBinaryScene::save(exportPath, sceneView, error))
+		{
+			std::cerr << error << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << "Scene written to " << exportPath << std::endl;
+	}
+
+	if (!expressionPath.empty())
+	{
+		std::ofstream expressionFile(expressionPath);
+		expressionFile << CSGExpression::generateSource(sceneView, std::filesystem::path(expressionPath).stem().string());
+		if (!expressionFile)
+		{
+			std::cerr << "Cannot write " << expressionPath << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << "Expression " << CSGExpression::typeName(sceneView) << " written to " << expressionPath << std::endl;
+	}
+
+	if (!meshPath.empty())
+	{
+		CSGMesher mesher{sceneView, nbThread};
+		mesher.setResolution(meshResolution);
+		mesher.setSharpFeatures(sharpFeatures);
+
+		// Chunks are written as they come, each one with its own vertices: OBJ indices are global and 1-based
+		std::ofstream meshFile(meshPath);
+		size_t nbWrittenVertex = 0;
+		MeshStatistics meshStatistics;
+		const auto meshStart = std::chrono::steady_clock::now();
+		const bool extracted = meshFile && mesher.extract([&meshFile, &nbWrittenVertex](const MeshChunk& chunk)
+		{
+			for (const glm::vec3& vertex : chunk.vertices)
+				meshFile << "v " << vertex.x << " " << vertex.y << " " << vertex.z << "\n";
+			for (size_t i = 0; i < chunk.triangles.size(); i += 3)
+			{
+				meshFile << "f " << nbWrittenVertex + chunk.triangles[i] + 1 << " " << nbWrittenVertex + chunk.triangles[i + 1] + 1 << " "
+					<< nbWrittenVertex + chunk.triangles[i + 2] + 1 << "\n";
+			}
+			nbWrittenVertex += chunk.vertices.size();
+		}, error, &meshStatistics);
+		meshFile.close();
+		if (!extracted || !meshFile)
+		{
+			std::cerr << (extracted || error.empty() ? "Cannot write " + meshPath : error) << std::endl;
+			return EXIT_FAILURE;
+		}
+		const std::chrono::duration<double> meshTime = std::chrono::steady_clock::now() - meshStart;
+		std::cout << "Mesh of " << meshStatistics.nbTriangle << " triangles written to " << meshPath << " in " << std::fixed << std::setprecision(2)
+			<< meshTime.count() << " s" << std::endl;
+	}
+
+	if (!hasCameras)
+		return EXIT_SUCCESS;
+
+	std::vector<CameraParameters> cameras;
+	if (!cameraPath.empty())
+	{
+		if (!CameraPath::load(cameraPath, cameras, error))
+		{
+			std::cerr << cameraPath << ": " << error << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	else
+		cameras = CameraPath::turntable(nbTurntableFrame, glm::vec3(0.f), turntableRadius, turntableElevation);
+
+	const SphereMarcher marcher{sceneView, nbThread};
+	const CSGRayTracer tracer{sceneView, nbThread};
+	const bool rayTracing = rendererName == "trace" && !tracer.hasSmoothOperation();
+	if (rendererName == "trace" && !rayTracing)
+		std::cerr << "The scene has smooth operations, which the ray tracer renders as hard ones: falling back to --renderer march" << std::endl;
+	FrameWriter writer{outputDirectory, format, maxPendingFrame};
+
+	std::cout << "Rendering " << cameras.size() << " frames of " << width << "x" << height << ", " << sceneView.nbNode << " nodes" << std::endl;
+
+	MarchStatistics sequenceStatistics;
+	TraceStatistics sequenceTraceStatistics;
+	MarchHistograms sequenceHistograms;
+	MarchDiagnostics diagnostics;
+	double renderSeconds = 0.;
+	const auto sequenceStart = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < cameras.size(); frame++)
+	{
+		RenderedImage image{width, height};
+		MarchStatistics frameStatistics;
+		TraceStatistics frameTraceStatistics;
+
+		const auto frameStart = std::chrono::steady_clock::now();
+		if (rayTracing)
+			tracer.render(cameras[frame], image, &frameTraceStatistics);
+		else
+			marcher.render(cameras[frame], image, &frameStatistics, recordDiagnostics ? &diagnostics : nullptr);
+		const std::chrono::duration<double> frameTime = std::chrono::steady_clock::now() - frameStart;
+
+		// The writer encodes this frame while the next one is rendered
+		writer.submit(static_cast<int>(frame), std::move(image));
+
+		renderSeconds += frameTime.count();
+		sequenceStatistics.merge(frameStatistics);
+		sequenceTraceStatistics.merge(frameTraceStatistics);
+		if (recordDiagnostics && !rayTracing)
+			sequenceHistograms.merge(diagnostics.histograms());
+		std::cout << "frame " << std::setw(5) << frame << std::fixed
+			<< "  " << std::setprecision(1) << std::setw(8) << frameTime.count() * 1000. << " ms";
+		if (rayTracing)
+		{
+			std::cout << "  " << std::setprecision(2) << std::setw(6) << frameTraceStatistics.meanLeafIntersectionPerPixel() << " leaf intersections/pixel"
+				<< "  " << std::setprecision(1) << std::setw(5) << 100. * static_cast<double>(frameTraceStatistics.nbHit) / static_cast<double>(frameTraceStatistics.nbPixel) << "% hit" << std::endl;
+			continue;
+		}
+		std::cout << "  " << std::setprecision(2) << std::setw(6) << frameStatistics.meanStepPerPixel() << " steps/pixel"
+			<< "  max " << std::setw(3) << frameStatistics.maxStep
+			<< "  " << std::setprecision(1) << std::setw(5) << 100. * static_cast<double>(frameStatistics.nbHit) / static_cast<double>(frameStatistics.nbPixel) << "% hit"
+			<< "  " << frameStatistics.nbOutOfSteps << " out of steps" << std::endl;
+	}
+	writer.finish();
+	const std::chrono::duration<double> sequenceTime = std::chrono::steady_clock::now() - sequenceStart;
+
+	const double nbFrame = static_cast<double>(std::max<size_t>(cameras.size(), 1));
+	std::cout << std::fixed << std::setprecision(1)
+		<< "Total " << sequenceTime.count() << " s, render " << renderSeconds * 1000. / nbFrame << " ms/frame"
+		<< ", encoding " << writer.getEncodingSeconds() * 1000. / nbFrame << " ms/frame (overlapped with rendering)"
+		<< std::setprecision(2) << ", " << (rayTracing ? sequenceTraceStatistics.meanLeafIntersectionPerPixel() : sequenceStatistics.meanStepPerPixel())
+		<< (rayTracing ? " leaf intersections/pixel" : " steps/pixel")
+		<< ", " << writer.getNbWritten() << " frames written to " << (outputDirectory.empty() ? "." : outputDirectory) << std::endl;
+	if (recordDiagnostics && !rayTracing)
+		std::cout << "Diagnostics of the sequence, " << sequenceHistograms.summary();
+
+	if (writer.getNbFailed() > 0)
+	{
+		std::cerr << writer.getNbFailed() << " frames could not be written" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/*
+* Test executable: runs the CSGTree and CSG rendering tests, then the randomized cross-checks of CSGFuzzer.
+* The exit code is non zero if any test fails, so it can be run by CI or ctest.
+*
+* Usage:
+*     csgTests [--seed <seed>] [--iterations <count>] [--iteration <index>]
+*
+* Options:
+*     --seed <seed>             seed of the fuzzer, default 1
+*     --iterations <count>      number of fuzzer iterations, default 2000
+*     --iteration <index>       only run this fuzzer iteration, to reproduce a reported failure "seed S, iteration I"
+*/
+#include "renderer/opengl/Primitives/CSGTreeTest.hpp"
+#include "renderer/opengl/Primitives/CSGRenderingTest.hpp"
+#include "renderer/opengl/Primitives/CSGFuzzer.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+
+static void printUsage()
+{
+	std::cerr << "Usage: csgTests [--seed <seed>] [--iterations <count>] [--iteration <index>]" << std::endl;
+}
+
+// CSGTreeTest only prints its results: capture them and look for a failed test
+static bool runTreeTests()
+{
+	std::ostringstream output;
+	std::streambuf* coutBuffer = std::cout.rdbuf(output.rdbuf());
+	CSGTreeTest{}.performAllTests();
+	std::cout.rdbuf(coutBuffer);
+
+	std::cout << output.str();
+	return output.str().find(": failure") == std::string::npos;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t seed = 1;
+	int nbIteration = 2000;
+	int singleIteration = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << option << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+		const std::string value = argv[++i];
+
+		if (option == "--seed")
+			seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+		else if (option == "--iterations")
+			nbIteration = std::atoi(value.c_str());
+		else if (option == "--iteration")
+			singleIteration = std::atoi(value.c_str());
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	bool success = true;
+	if (singleIteration < 0)
+	{
+		success = runTreeTests() && success;
+		success = CSGRenderingTest{}.performAllTests() && success;
+	}
+
+	CSGFuzzer fuzzer{seed};
+	if (singleIteration >= 0)
+	{
+		if (!fuzzer.runIteration(singleIteration))
+		{
+			std::cout << "Fuzzer failure: " << fuzzer.getFailure() << std::endl;
+			success = false;
+		}
+		else
+			std::cout << "Fuzzer iteration " << singleIteration << " (seed " << seed << "): success" << std::endl;
+	}
+	else
+		success = fuzzer.run(nbIteration, &std::cout) && success;
+
+	std::cout << (success ? "All tests passed" : "Some tests failed") << std::endl;
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}